@@ -64,4 +64,90 @@ public abstract class Machine {
    */
   public static native long tryNative(long function, long argument);
 
+  /**
+   * Reports thread-local heap statistics for the calling thread.
+   * Upon return, statistics[0] holds the number of bytes this thread
+   * has allocated from its thread-local heaps, statistics[1] the
+   * number of times those heaps have been refilled from the shared
+   * pool, and statistics[2] the current size of its thread-local
+   * heap in bytes, which the VM adjusts after each collection
+   * according to how quickly the thread allocates.
+   *
+   * @param statistics an array of at least three elements
+   */
+  public static native void allocationStatistics(long[] statistics);
+
+  /**
+   * Reports garbage collection statistics for the whole VM.  Upon
+   * return, statistics[0] and statistics[1] hold the number of minor
+   * and major collections so far, statistics[2] and statistics[3]
+   * the total time in milliseconds spent in each kind,
+   * statistics[4] and statistics[5] the longest single pause of each
+   * kind, statistics[6] the number of bytes the heap currently has
+   * allocated from the operating system, and statistics[7] the most
+   * it has ever had allocated at once.  Major collections copy the
+   * old generation to a new space unless the VM was started with
+   * -Davian.gc.compact=true, in which case they compact it in place.
+   * With -Davian.gc.concurrent=true, the old generation is also
+   * marked by a background thread while the application runs, so a
+   * major pause need only finish marking before compacting.  Arrays
+   * of at least 256KB (or whatever -Davian.gc.large.threshold says,
+   * e.g. 1m) are given pages of their own, which are never copied and
+   * are returned to the operating system as soon as they are freed.
+   *
+   * <p>If the array has at least StatisticsSize elements,
+   * statistics[8] also receives the number of bytes promoted to the
+   * old generation so far, and statistics[9 + cause] the number of
+   * collections for each of the causes listed below.
+   *
+   * @param statistics an array of at least eight elements
+   */
+  public static native void collectionStatistics(long[] statistics);
+
+  public static final int StatisticsSize = 14;
+
+  // the kinds of collection, and why each was the kind it was:
+  public static final int MinorCollection = 0;
+  public static final int MajorCollection = 1;
+
+  public static final int RequestedCause = 0;
+  public static final int LowMemoryCause = 1;
+  public static final int OversizedGen2Cause = 2;
+  public static final int UndersizedGen2Cause = 3;
+  public static final int FixieCeilingCause = 4;
+
+  // offsets of the fields of each record written by
+  // collectionRecords.  Sizes are in bytes and times in milliseconds:
+  public static final int RecordSequence = 0;
+  public static final int RecordType = 1;
+  public static final int RecordCause = 2;
+  public static final int RecordStart = 3;
+  public static final int RecordPause = 4;
+  public static final int RecordIncoming = 5;
+  public static final int RecordGen1Before = 6;
+  public static final int RecordGen1After = 7;
+  public static final int RecordGen2Before = 8;
+  public static final int RecordGen2After = 9;
+  public static final int RecordUntenuredFixies = 10;
+  public static final int RecordTenuredFixies = 11;
+  public static final int RecordPromoted = 12;
+  public static final int RecordFootprintBefore = 13;
+  public static final int RecordFootprintAfter = 14;
+  public static final int RecordSize = 15;
+
+  /**
+   * Copies records of recent collections into the specified array,
+   * RecordSize elements apiece, oldest first.  Only collections with
+   * sequence numbers (which start at one) greater than since are
+   * copied, so a monitor may pass the last sequence number it saw to
+   * get only what's new.  The VM remembers the last 64 collections;
+   * a gap in the sequence numbers means older ones were forgotten
+   * before they could be read.
+   *
+   * @param since the sequence number of the last record to skip
+   * @param records an array of RecordSize elements per record wanted
+   * @return the number of records copied
+   */
+  public static native int collectionRecords(long since, long[] records);
+
 }
@@ -73,6 +73,11 @@ typedef wchar_t char_t;
 #include <unistd.h>
 #include "sys/mman.h"
 
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
 #define ACCESS access
 #define OPEN open
 #define CLOSE close
@@ -762,19 +767,26 @@ extern "C" JNIEXPORT jint JNICALL
                                               jint offset,
                                               jint length)
 {
-  jbyte* data = static_cast<jbyte*>(malloc(length));
+  ByteArrayRange range(e, b, offset, length);
+  jbyte* data = range.acquire(false);
   if (data == 0) {
-    throwNew(e, "java/lang/OutOfMemoryError", 0);
     return 0;
   }
 
-  int r = doRead(e, fd, data, length);
-
-  e->SetByteArrayRegion(b, offset, length, data);
+  int r = READ(fd, data, length);
+  int error = errno;
 
-  free(data);
+  range.release(r > 0 ? r : 0);
 
-  return r;
+  if (r > 0) {
+    return r;
+  } else if (r == 0) {
+    return -1;
+  } else {
+    errno = error;
+    throwNewErrno(e, "java/io/IOException");
+    return 0;
+  }
 }
 
 extern "C" JNIEXPORT void JNICALL
@@ -817,19 +829,28 @@ extern "C" JNIEXPORT void JNICALL
                                                 jint offset,
                                                 jint length)
 {
-  jbyte* data = static_cast<jbyte*>(malloc(length));
-
+  ByteArrayRange range(e, b, offset, length);
+  jbyte* data = range.acquire(true);
   if (data == 0) {
-    throwNew(e, "java/lang/OutOfMemoryError", 0);
     return;
   }
 
-  e->GetByteArrayRegion(b, offset, length, data);
-  if (not e->ExceptionCheck()) {
-    doWrite(e, fd, data, length);
+  int written = 0;
+  while (written < length) {
+    int r = WRITE(fd, data + written, length - written);
+    if (r <= 0) {
+      break;
+    }
+    written += r;
   }
+  int error = errno;
+
+  range.release(0);
 
-  free(data);
+  if (written < length) {
+    errno = error;
+    throwNewErrno(e, "java/io/IOException");
+  }
 }
 
 extern "C" JNIEXPORT void JNICALL
@@ -910,13 +931,18 @@ extern "C" JNIEXPORT jint JNICALL
     return -1;
   }
 
-  uint8_t* dst
-      = reinterpret_cast<uint8_t*>(e->GetPrimitiveArrayCritical(buffer, 0));
+  ByteArrayRange range(e, buffer, offset, length);
+  jbyte* dst = range.acquire(false);
+  if (dst == 0) {
+    return -1;
+  }
 
-  int64_t bytesRead = ::read(fd, dst + offset, length);
-  e->ReleasePrimitiveArrayCritical(buffer, dst, 0);
+  int64_t bytesRead = ::read(fd, dst, length);
+  int error = errno;
+  range.release(bytesRead > 0 ? bytesRead : 0);
 
   if (bytesRead == -1) {
+    errno = error;
     throwNewErrno(e, "java/io/IOException");
     return -1;
   }
@@ -929,16 +955,19 @@ extern "C" JNIEXPORT jint JNICALL
     return -1;
   }
 
-  uint8_t* dst
-      = reinterpret_cast<uint8_t*>(e->GetPrimitiveArrayCritical(buffer, 0));
+  ByteArrayRange range(e, buffer, offset, length);
+  jbyte* dst = range.acquire(false);
+  if (dst == 0) {
+    return -1;
+  }
 
   DWORD bytesRead = 0;
-  if (!ReadFile(hFile, dst + offset, length, &bytesRead, nullptr)) {
-    e->ReleasePrimitiveArrayCritical(buffer, dst, 0);
+  if (!ReadFile(hFile, dst, length, &bytesRead, nullptr)) {
+    range.release(0);
     throwNewErrno(e, "java/io/IOException");
     return -1;
   }
-  e->ReleasePrimitiveArrayCritical(buffer, dst, 0);
+  range.release(bytesRead);
 #endif
 
   return (jint)bytesRead;
@@ -960,13 +989,18 @@ extern "C" JNIEXPORT jint JNICALL
     return -1;
   }
 
-  uint8_t* dst
-      = reinterpret_cast<uint8_t*>(e->GetPrimitiveArrayCritical(buffer, 0));
+  ByteArrayRange range(e, buffer, offset, length);
+  jbyte* src = range.acquire(true);
+  if (src == 0) {
+    return -1;
+  }
 
-  int64_t bytesWritten = ::write(fd, dst + offset, length);
-  e->ReleasePrimitiveArrayCritical(buffer, dst, 0);
+  int64_t bytesWritten = ::write(fd, src, length);
+  int error = errno;
+  range.release(0);
 
   if (bytesWritten == -1) {
+    errno = error;
     throwNewErrno(e, "java/io/IOException");
     return -1;
   }
@@ -979,16 +1013,19 @@ extern "C" JNIEXPORT jint JNICALL
     return -1;
   }
 
-  uint8_t* dst
-      = reinterpret_cast<uint8_t*>(e->GetPrimitiveArrayCritical(buffer, 0));
+  ByteArrayRange range(e, buffer, offset, length);
+  jbyte* src = range.acquire(true);
+  if (src == 0) {
+    return -1;
+  }
 
   DWORD bytesWritten = 0;
-  if (!WriteFile(hFile, dst + offset, length, &bytesWritten, nullptr)) {
-    e->ReleasePrimitiveArrayCritical(buffer, dst, 0);
+  if (!WriteFile(hFile, src, length, &bytesWritten, nullptr)) {
+    range.release(0);
     throwNewErrno(e, "java/io/IOException");
     return -1;
   }
-  e->ReleasePrimitiveArrayCritical(buffer, dst, 0);
+  range.release(0);
 #endif
 
   return (jint)bytesWritten;
@@ -1005,3 +1042,76 @@ extern "C" JNIEXPORT void JNICALL
   CloseHandle(hFile);
 #endif
 }
+
+// Copies up to count bytes from the file inPeer at inPosition to
+// outPeer at outPosition, or, if outPosition is negative, at outPeer's
+// current position (e.g. for a socket), without passing them through
+// user space.  Returns the number of bytes copied, or -1 if this
+// combination of descriptors isn't supported here, in which case the
+// caller should copy them itself.
+extern "C" JNIEXPORT jlong JNICALL
+    Java_java_io_RandomAccessFile_transfer(JNIEnv* e,
+                                           jclass,
+                                           jlong inPeer,
+                                           jlong inPosition,
+                                           jlong outPeer,
+                                           jlong outPosition,
+                                           jlong count)
+{
+#ifdef __linux__
+  int in = (int)inPeer;
+  int out = (int)outPeer;
+
+#ifdef __NR_copy_file_range
+  if (outPosition >= 0) {
+    loff_t inOffset = inPosition;
+    loff_t outOffset = outPosition;
+    long r = ::syscall(__NR_copy_file_range,
+                       in,
+                       &inOffset,
+                       out,
+                       &outOffset,
+                       static_cast<size_t>(count),
+                       0u);
+    if (r >= 0) {
+      return r;
+    } else if (errno != ENOSYS and errno != EXDEV and errno != EINVAL
+               and errno != EOPNOTSUPP) {
+      throwNewErrno(e, "java/io/IOException");
+      return 0;
+    }
+    // otherwise, fall back to sendfile
+  }
+#endif
+
+  if (outPosition >= 0 and ::lseek(out, outPosition, SEEK_SET) == -1) {
+    throwNewErrno(e, "java/io/IOException");
+    return 0;
+  }
+
+  off_t offset = inPosition;
+  ssize_t r = ::sendfile(out, in, &offset, count);
+  if (r >= 0) {
+    return r;
+  } else if (errno == EAGAIN) {
+    return 0;
+  } else if (errno == EINVAL or errno == ENOSYS) {
+    return -1;
+  } else {
+    throwNewErrno(e, "java/io/IOException");
+    return 0;
+  }
+#else
+  return -1;
+#endif
+}
+
+extern "C" JNIEXPORT jint JNICALL
+    Java_java_io_RandomAccessFile_socketDescriptor(JNIEnv* e,
+                                                   jclass,
+                                                   jobject channel)
+{
+  jclass c = e->GetObjectClass(channel);
+  jfieldID socket = e->GetFieldID(c, "socket", "I");
+  return e->GetIntField(channel, socket);
+}
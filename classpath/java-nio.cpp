@@ -36,6 +36,12 @@
 #include <netinet/ip.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef __linux__
+#define AVIAN_USE_EPOLL
+#include <sys/epoll.h>
 #endif
 
 #define java_nio_channels_SelectionKey_OP_READ 1L
@@ -360,6 +366,94 @@ int doSend(int fd, sockaddr_in* address, const void* buffer, size_t count)
                 sizeof(sockaddr_in));
 }
 
+// the most buffers we'll hand to a single vectored read or write; any
+// beyond this are left for the caller to try again with:
+const unsigned MaxVectors = 16;
+
+#ifdef PLATFORM_WINDOWS
+typedef WSABUF Vector;
+
+inline void setVector(Vector* v, void* buffer, size_t count)
+{
+  v->buf = static_cast<char*>(buffer);
+  v->len = count;
+}
+
+int doReadv(int fd, Vector* vectors, unsigned count)
+{
+  DWORD n;
+  DWORD flags = 0;
+  if (WSARecv(fd, vectors, count, &n, &flags, 0, 0) == 0) {
+    return n;
+  } else {
+    return -1;
+  }
+}
+
+int doWritev(int fd, Vector* vectors, unsigned count)
+{
+  DWORD n;
+  if (WSASend(fd, vectors, count, &n, 0, 0, 0) == 0) {
+    return n;
+  } else {
+    return -1;
+  }
+}
+#else
+typedef iovec Vector;
+
+inline void setVector(Vector* v, void* buffer, size_t count)
+{
+  v->iov_base = buffer;
+  v->iov_len = count;
+}
+
+int doReadv(int fd, Vector* vectors, unsigned count)
+{
+  return readv(fd, vectors, count);
+}
+
+int doWritev(int fd, Vector* vectors, unsigned count)
+{
+  return writev(fd, vectors, count);
+}
+#endif
+
+// fills in vectors with the remaining bytes of each of the specified
+// direct buffers, skipping empty ones, and returns how many it used:
+unsigned makeVectors(JNIEnv* e,
+                     jobjectArray buffers,
+                     jint offset,
+                     jint length,
+                     Vector* vectors)
+{
+  jclass c = e->FindClass("java/nio/Buffer");
+  if (e->ExceptionCheck())
+    return 0;
+
+  jfieldID position = e->GetFieldID(c, "position", "I");
+  if (e->ExceptionCheck())
+    return 0;
+
+  jfieldID limit = e->GetFieldID(c, "limit", "I");
+  if (e->ExceptionCheck())
+    return 0;
+
+  unsigned count = 0;
+  for (jint i = offset; i < offset + length and count < MaxVectors; ++i) {
+    jobject b = e->GetObjectArrayElement(buffers, i);
+    jint p = e->GetIntField(b, position);
+    jint remaining = e->GetIntField(b, limit) - p;
+    if (remaining > 0) {
+      setVector(vectors + (count++),
+                static_cast<uint8_t*>(e->GetDirectBufferAddress(b)) + p,
+                remaining);
+    }
+    e->DeleteLocalRef(b);
+  }
+  return count;
+}
+
 int makeSocket(JNIEnv* e, int type = SOCK_STREAM, int protocol = IPPROTO_TCP)
 {
   int s = ::socket(AF_INET, type, protocol);
@@ -517,13 +611,15 @@ extern "C" JNIEXPORT jint JNICALL
       return 0;
     }
   } else {
-    jboolean isCopy;
-    uint8_t* buf
-        = static_cast<uint8_t*>(e->GetPrimitiveArrayCritical(buffer, &isCopy));
+    ByteArrayRange range(e, buffer, offset, length);
+    uint8_t* buf = reinterpret_cast<uint8_t*>(range.acquire(false));
+    if (buf == 0) {
+      return 0;
+    }
 
-    r = ::doRead(socket, buf + offset, length);
+    r = ::doRead(socket, buf, length);
 
-    e->ReleasePrimitiveArrayCritical(buffer, buf, 0);
+    range.release(r > 0 ? r : 0);
   }
 
   if (r < 0) {
@@ -538,6 +634,58 @@ extern "C" JNIEXPORT jint JNICALL
   return r;
 }
 
+extern "C" JNIEXPORT jint JNICALL
+    Java_java_nio_channels_SocketChannel_natReadDirect(JNIEnv* e,
+                                                       jclass,
+                                                       jint socket,
+                                                       jobject buffer,
+                                                       jint offset,
+                                                       jint length)
+{
+  uint8_t* buf = static_cast<uint8_t*>(e->GetDirectBufferAddress(buffer));
+
+  int r = ::doRead(socket, buf + offset, length);
+
+  if (r < 0) {
+    if (eagain()) {
+      return 0;
+    } else {
+      throwIOException(e);
+    }
+  } else if (r == 0) {
+    return -1;
+  }
+  return r;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+    Java_java_nio_channels_SocketChannel_natReadv(JNIEnv* e,
+                                                  jclass,
+                                                  jint socket,
+                                                  jobjectArray buffers,
+                                                  jint offset,
+                                                  jint length)
+{
+  Vector vectors[MaxVectors];
+  unsigned count = makeVectors(e, buffers, offset, length, vectors);
+  if (count == 0) {
+    return 0;
+  }
+
+  int r = ::doReadv(socket, vectors, count);
+
+  if (r < 0) {
+    if (eagain()) {
+      return 0;
+    } else {
+      throwIOException(e);
+    }
+  } else if (r == 0) {
+    return -1;
+  }
+  return r;
+}
+
 extern "C" JNIEXPORT jint JNICALL
     Java_java_nio_channels_DatagramChannel_receive(JNIEnv* e,
                                                    jclass,
@@ -563,13 +711,15 @@ extern "C" JNIEXPORT jint JNICALL
       return 0;
     }
   } else {
-    jboolean isCopy;
-    uint8_t* buf
-        = static_cast<uint8_t*>(e->GetPrimitiveArrayCritical(buffer, &isCopy));
+    ByteArrayRange range(e, buffer, offset, length);
+    uint8_t* buf = reinterpret_cast<uint8_t*>(range.acquire(false));
+    if (buf == 0) {
+      return 0;
+    }
 
-    r = ::doRecv(socket, buf + offset, length, &host, &port);
+    r = ::doRecv(socket, buf, length, &host, &port);
 
-    e->ReleasePrimitiveArrayCritical(buffer, buf, 0);
+    range.release(r > 0 ? r : 0);
   }
 
   if (r < 0) {
@@ -611,13 +761,15 @@ extern "C" JNIEXPORT jint JNICALL
       return 0;
     }
   } else {
-    jboolean isCopy;
-    uint8_t* buf
-        = static_cast<uint8_t*>(e->GetPrimitiveArrayCritical(buffer, &isCopy));
+    ByteArrayRange range(e, buffer, offset, length);
+    uint8_t* buf = reinterpret_cast<uint8_t*>(range.acquire(true));
+    if (buf == 0) {
+      return 0;
+    }
 
-    r = ::doWrite(socket, buf + offset, length);
+    r = ::doWrite(socket, buf, length);
 
-    e->ReleasePrimitiveArrayCritical(buffer, buf, 0);
+    range.release(0);
   }
 
   if (r < 0) {
@@ -630,6 +782,54 @@ extern "C" JNIEXPORT jint JNICALL
   return r;
 }
 
+extern "C" JNIEXPORT jint JNICALL
+    Java_java_nio_channels_SocketChannel_natWriteDirect(JNIEnv* e,
+                                                        jclass,
+                                                        jint socket,
+                                                        jobject buffer,
+                                                        jint offset,
+                                                        jint length)
+{
+  uint8_t* buf = static_cast<uint8_t*>(e->GetDirectBufferAddress(buffer));
+
+  int r = ::doWrite(socket, buf + offset, length);
+
+  if (r < 0) {
+    if (eagain()) {
+      return 0;
+    } else {
+      throwIOException(e);
+    }
+  }
+  return r;
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+    Java_java_nio_channels_SocketChannel_natWritev(JNIEnv* e,
+                                                   jclass,
+                                                   jint socket,
+                                                   jobjectArray buffers,
+                                                   jint offset,
+                                                   jint length)
+{
+  Vector vectors[MaxVectors];
+  unsigned count = makeVectors(e, buffers, offset, length, vectors);
+  if (count == 0) {
+    return 0;
+  }
+
+  int r = ::doWritev(socket, vectors, count);
+
+  if (r < 0) {
+    if (eagain()) {
+      return 0;
+    } else {
+      throwIOException(e);
+    }
+  }
+  return r;
+}
+
 extern "C" JNIEXPORT jint JNICALL
     Java_java_nio_channels_DatagramChannel_write(JNIEnv* e,
                                                  jclass c,
@@ -669,13 +869,15 @@ extern "C" JNIEXPORT jint JNICALL
       return 0;
     }
   } else {
-    jboolean isCopy;
-    uint8_t* buf
-        = static_cast<uint8_t*>(e->GetPrimitiveArrayCritical(buffer, &isCopy));
+    ByteArrayRange range(e, buffer, offset, length);
+    uint8_t* buf = reinterpret_cast<uint8_t*>(range.acquire(true));
+    if (buf == 0) {
+      return 0;
+    }
 
-    r = ::doSend(socket, &address, buf + offset, length);
+    r = ::doSend(socket, &address, buf, length);
 
-    e->ReleasePrimitiveArrayCritical(buffer, buf, 0);
+    range.release(0);
   }
 
   if (r < 0) {
@@ -857,16 +1059,128 @@ class Pipe {
 #endif
 };
 
+#ifdef AVIAN_USE_EPOLL
+// initial number of events epoll_wait may report at once; the buffer
+// doubles whenever a wait fills it:
+const int InitialEventCapacity = 64;
+#endif
+
 struct SelectorState {
   fd_set read;
   fd_set write;
   fd_set except;
   Pipe control;
+#ifdef AVIAN_USE_EPOLL
+  // when epoll is available, sockets stay registered with the kernel
+  // between selects, and a select reports only the ready sockets
+  // instead of requiring a scan of every registered socket:
+  int epoll;
+  epoll_event* events;
+  int eventCapacity;
+#endif
   SelectorState(JNIEnv* e) : control(e)
   {
   }
 };
 
+#ifdef AVIAN_USE_EPOLL
+inline bool usesEpoll(SelectorState* s)
+{
+  return s->epoll >= 0;
+}
+
+bool initEpoll(SelectorState* s)
+{
+  s->events = 0;
+  s->eventCapacity = 0;
+  s->epoll = epoll_create1(EPOLL_CLOEXEC);
+  if (s->epoll < 0) {
+    // fall back to select
+    return true;
+  }
+
+  s->events = static_cast<epoll_event*>(
+      malloc(InitialEventCapacity * sizeof(epoll_event)));
+  if (s->events == 0) {
+    close(s->epoll);
+    s->epoll = -1;
+    return false;
+  }
+  s->eventCapacity = InitialEventCapacity;
+
+  epoll_event event;
+  memset(&event, 0, sizeof(epoll_event));
+  event.events = EPOLLIN;
+  event.data.fd = s->control.reader();
+  if (epoll_ctl(s->epoll, EPOLL_CTL_ADD, s->control.reader(), &event) != 0) {
+    close(s->epoll);
+    s->epoll = -1;
+    free(s->events);
+    s->events = 0;
+  }
+
+  return true;
+}
+
+void disposeEpoll(SelectorState* s)
+{
+  if (usesEpoll(s)) {
+    close(s->epoll);
+    free(s->events);
+  }
+}
+
+jint doEpollWait(JNIEnv* e, SelectorState* s, jlong interval)
+{
+  int timeout;
+  if (interval > 0) {
+    timeout = interval > 0x7FFFFFFF ? 0x7FFFFFFF : interval;
+  } else if (interval < 0) {
+    timeout = 0;
+  } else {
+    timeout = -1;
+  }
+
+  int r = epoll_wait(s->epoll, s->events, s->eventCapacity, timeout);
+  if (r < 0) {
+    if (errno != EINTR) {
+      throwIOException(e);
+    }
+    return 0;
+  }
+
+  // drain the wakeup pipe and drop its event, so the caller sees only
+  // socket events:
+  int count = 0;
+  for (int i = 0; i < r; ++i) {
+    if (s->events[i].data.fd == s->control.reader()) {
+      char c;
+      int n = 1;
+      while (n == 1) {
+        n = ::doRead(s->control.reader(), &c, 1);
+      }
+      if (n < 0 and not eagain()) {
+        throwIOException(e);
+        return 0;
+      }
+    } else {
+      s->events[count++] = s->events[i];
+    }
+  }
+
+  if (r == s->eventCapacity) {
+    epoll_event* events = static_cast<epoll_event*>(
+        realloc(s->events, s->eventCapacity * 2 * sizeof(epoll_event)));
+    if (events) {
+      s->events = events;
+      s->eventCapacity *= 2;
+    }
+  }
+
+  return count;
+}
+#endif
+
 }  // namespace
 
 extern "C" JNIEXPORT jlong JNICALL
@@ -882,6 +1196,14 @@ extern "C" JNIEXPORT jlong JNICALL
       FD_ZERO(&(s->read));
       FD_ZERO(&(s->write));
       FD_ZERO(&(s->except));
+#ifdef AVIAN_USE_EPOLL
+      if (not initEpoll(s)) {
+        s->control.dispose();
+        free(s);
+        throwNew(e, "java/lang/OutOfMemoryError", 0);
+        return 0;
+      }
+#endif
       return reinterpret_cast<jlong>(s);
     }
   }
@@ -908,10 +1230,25 @@ extern "C" JNIEXPORT void JNICALL
     Java_java_nio_channels_SocketSelector_natClose(JNIEnv*, jclass, jlong state)
 {
   SelectorState* s = reinterpret_cast<SelectorState*>(state);
+#ifdef AVIAN_USE_EPOLL
+  disposeEpoll(s);
+#endif
   s->control.dispose();
   free(s);
 }
 
+extern "C" JNIEXPORT jboolean JNICALL
+    Java_java_nio_channels_SocketSelector_natUsesEpoll(JNIEnv*,
+                                                       jclass,
+                                                       jlong state UNUSED)
+{
+#ifdef AVIAN_USE_EPOLL
+  return usesEpoll(reinterpret_cast<SelectorState*>(state));
+#else
+  return false;
+#endif
+}
+
 extern "C" JNIEXPORT void JNICALL
     Java_java_nio_channels_SocketSelector_natSelectClearAll(JNIEnv*,
                                                             jclass,
@@ -919,6 +1256,15 @@ extern "C" JNIEXPORT void JNICALL
                                                             jlong state)
 {
   SelectorState* s = reinterpret_cast<SelectorState*>(state);
+#ifdef AVIAN_USE_EPOLL
+  if (usesEpoll(s)) {
+    // the socket may already be closed, in which case the kernel has
+    // dropped it, so we ignore any error here:
+    epoll_event event;
+    epoll_ctl(s->epoll, EPOLL_CTL_DEL, socket, &event);
+    return;
+  }
+#endif
   FD_CLR(static_cast<unsigned>(socket), &(s->read));
   FD_CLR(static_cast<unsigned>(socket), &(s->write));
   FD_CLR(static_cast<unsigned>(socket), &(s->except));
@@ -926,7 +1272,7 @@ extern "C" JNIEXPORT void JNICALL
 
 extern "C" JNIEXPORT jint JNICALL
     Java_java_nio_channels_SocketSelector_natSelectUpdateInterestSet(
-        JNIEnv*,
+        JNIEnv* e,
         jclass,
         jint socket,
         jint interest,
@@ -934,6 +1280,40 @@ extern "C" JNIEXPORT jint JNICALL
         jint max)
 {
   SelectorState* s = reinterpret_cast<SelectorState*>(state);
+#ifdef AVIAN_USE_EPOLL
+  if (usesEpoll(s)) {
+    epoll_event event;
+    memset(&event, 0, sizeof(epoll_event));
+    if (interest & (java_nio_channels_SelectionKey_OP_READ
+                    | java_nio_channels_SelectionKey_OP_ACCEPT)) {
+      event.events |= EPOLLIN;
+    }
+    if (interest & (java_nio_channels_SelectionKey_OP_WRITE
+                    | java_nio_channels_SelectionKey_OP_CONNECT)) {
+      event.events |= EPOLLOUT;
+    }
+    event.data.fd = socket;
+
+    if (event.events == 0) {
+      // epoll reports EPOLLHUP and EPOLLERR whatever we ask for, so a
+      // socket we aren't interested in must not stay registered, or a
+      // hung-up peer would wake every select.  We add it again (below)
+      // once the interest set is non-empty:
+      if (epoll_ctl(s->epoll, EPOLL_CTL_DEL, socket, &event) != 0
+          and errno != ENOENT and errno != EBADF) {
+        throwIOException(e);
+      }
+      return max;
+    }
+
+    if (epoll_ctl(s->epoll, EPOLL_CTL_MOD, socket, &event) != 0
+        and (errno != ENOENT
+             or epoll_ctl(s->epoll, EPOLL_CTL_ADD, socket, &event) != 0)) {
+      throwIOException(e);
+    }
+    return max;
+  }
+#endif
   if (interest & (java_nio_channels_SelectionKey_OP_READ
                   | java_nio_channels_SelectionKey_OP_ACCEPT)) {
     FD_SET(static_cast<unsigned>(socket), &(s->read));
@@ -963,6 +1343,11 @@ extern "C" JNIEXPORT jint JNICALL
                                                             jlong interval)
 {
   SelectorState* s = reinterpret_cast<SelectorState*>(state);
+#ifdef AVIAN_USE_EPOLL
+  if (usesEpoll(s)) {
+    return doEpollWait(e, s, interval);
+  }
+#endif
   if (s->control.reader() >= 0) {
     int socket = s->control.reader();
     FD_SET(static_cast<unsigned>(socket), &(s->read));
@@ -1084,6 +1469,43 @@ extern "C" JNIEXPORT jint JNICALL
   return ready;
 }
 
+#ifdef AVIAN_USE_EPOLL
+// the following are only called when natUsesEpoll returns true:
+
+extern "C" JNIEXPORT jint JNICALL
+    Java_java_nio_channels_SocketSelector_natEventSocket(JNIEnv*,
+                                                         jclass,
+                                                         jlong state,
+                                                         jint index)
+{
+  return reinterpret_cast<SelectorState*>(state)->events[index].data.fd;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+    Java_java_nio_channels_SocketSelector_natEventReadyOps(JNIEnv*,
+                                                           jclass,
+                                                           jlong state,
+                                                           jint index,
+                                                           jint interest)
+{
+  SelectorState* s = reinterpret_cast<SelectorState*>(state);
+  uint32_t events = s->events[index].events;
+  jint ready = 0;
+
+  if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+    ready |= interest & (java_nio_channels_SelectionKey_OP_READ
+                         | java_nio_channels_SelectionKey_OP_ACCEPT);
+  }
+
+  if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+    ready |= interest & (java_nio_channels_SelectionKey_OP_WRITE
+                         | java_nio_channels_SelectionKey_OP_CONNECT);
+  }
+
+  return ready;
+}
+#endif
+
 extern "C" JNIEXPORT jboolean JNICALL
     Java_java_nio_ByteOrder_isNativeBigEndian(JNIEnv*, jclass)
 {
@@ -15,6 +15,35 @@
 #include "jni.h"
 #include "jni-util.h"
 
+namespace {
+
+// Returns the memory behind either the part of a byte array covered by
+// range or, if the array is null, a direct buffer, starting at offset.
+// Returns null if we couldn't allocate a buffer for the range, in
+// which case an OutOfMemoryError is pending:
+Bytef* acquire(JNIEnv* e,
+               jbyteArray array,
+               ByteArrayRange* range,
+               jobject buffer,
+               jint offset,
+               bool load)
+{
+  if (array) {
+    return reinterpret_cast<Bytef*>(range->acquire(load));
+  } else {
+    return static_cast<Bytef*>(e->GetDirectBufferAddress(buffer)) + offset;
+  }
+}
+
+void release(jbyteArray array, ByteArrayRange* range, jint count)
+{
+  if (array) {
+    range->release(count);
+  }
+}
+
+}  // namespace
+
 extern "C" JNIEXPORT jlong JNICALL
     Java_java_util_zip_Inflater_make(JNIEnv* e, jclass, jboolean nowrap)
 {
@@ -49,45 +78,50 @@ extern "C" JNIEXPORT void JNICALL
                                         jclass,
                                         jlong peer,
                                         jbyteArray input,
+                                        jobject directInput,
                                         jint inputOffset,
                                         jint inputLength,
                                         jbyteArray output,
+                                        jobject directOutput,
                                         jint outputOffset,
                                         jint outputLength,
                                         jintArray results)
 {
   z_stream* s = reinterpret_cast<z_stream*>(peer);
 
-  jbyte* in = static_cast<jbyte*>(malloc(inputLength));
+  ByteArrayRange inputRange(e, input, inputOffset, inputLength);
+  Bytef* in = acquire(e, input, &inputRange, directInput, inputOffset, true);
   if (in == 0) {
-    throwNew(e, "java/lang/OutOfMemoryError", 0);
     return;
   }
 
-  jbyte* out = static_cast<jbyte*>(malloc(outputLength));
+  ByteArrayRange outputRange(e, output, outputOffset, outputLength);
+  Bytef* out
+      = acquire(e, output, &outputRange, directOutput, outputOffset, false);
   if (out == 0) {
-    free(in);
-    throwNew(e, "java/lang/OutOfMemoryError", 0);
+    release(input, &inputRange, 0);
     return;
   }
 
-  e->GetByteArrayRegion(input, inputOffset, inputLength, in);
-
-  s->next_in = reinterpret_cast<Bytef*>(in);
+  s->next_in = in;
   s->avail_in = inputLength;
-  s->next_out = reinterpret_cast<Bytef*>(out);
+  s->next_out = out;
   s->avail_out = outputLength;
 
   int r = inflate(s, Z_SYNC_FLUSH);
+
+  // the arrays may move once we release them, so don't leave zlib
+  // pointing into them:
+  s->next_in = 0;
+  s->next_out = 0;
+
+  release(output, &outputRange, outputLength - s->avail_out);
+  release(input, &inputRange, 0);
+
   jint resultArray[3] = {r,
                          static_cast<jint>(inputLength - s->avail_in),
                          static_cast<jint>(outputLength - s->avail_out)};
 
-  free(in);
-
-  e->SetByteArrayRegion(output, outputOffset, resultArray[2], out);
-  free(out);
-
   e->SetIntArrayRegion(results, 0, 3, resultArray);
 }
 
@@ -128,9 +162,11 @@ extern "C" JNIEXPORT void JNICALL
                                         jclass,
                                         jlong peer,
                                         jbyteArray input,
+                                        jobject directInput,
                                         jint inputOffset,
                                         jint inputLength,
                                         jbyteArray output,
+                                        jobject directOutput,
                                         jint outputOffset,
                                         jint outputLength,
                                         jboolean finish,
@@ -138,35 +174,104 @@ extern "C" JNIEXPORT void JNICALL
 {
   z_stream* s = reinterpret_cast<z_stream*>(peer);
 
-  jbyte* in = static_cast<jbyte*>(malloc(inputLength));
+  ByteArrayRange inputRange(e, input, inputOffset, inputLength);
+  Bytef* in = acquire(e, input, &inputRange, directInput, inputOffset, true);
   if (in == 0) {
-    throwNew(e, "java/lang/OutOfMemoryError", 0);
     return;
   }
 
-  jbyte* out = static_cast<jbyte*>(malloc(outputLength));
+  ByteArrayRange outputRange(e, output, outputOffset, outputLength);
+  Bytef* out
+      = acquire(e, output, &outputRange, directOutput, outputOffset, false);
   if (out == 0) {
-    free(in);
-    throwNew(e, "java/lang/OutOfMemoryError", 0);
+    release(input, &inputRange, 0);
     return;
   }
 
-  e->GetByteArrayRegion(input, inputOffset, inputLength, in);
-
-  s->next_in = reinterpret_cast<Bytef*>(in);
+  s->next_in = in;
   s->avail_in = inputLength;
-  s->next_out = reinterpret_cast<Bytef*>(out);
+  s->next_out = out;
   s->avail_out = outputLength;
 
   int r = deflate(s, finish ? Z_FINISH : Z_NO_FLUSH);
+
+  s->next_in = 0;
+  s->next_out = 0;
+
+  release(output, &outputRange, outputLength - s->avail_out);
+  release(input, &inputRange, 0);
+
   jint resultArray[3] = {r,
                          static_cast<jint>(inputLength - s->avail_in),
                          static_cast<jint>(outputLength - s->avail_out)};
 
-  free(in);
+  e->SetIntArrayRegion(results, 0, 3, resultArray);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+    Java_java_util_zip_CRC32_updateBytes(JNIEnv* e,
+                                         jclass,
+                                         jint crc,
+                                         jbyteArray array,
+                                         jint offset,
+                                         jint length)
+{
+  ByteArrayRange range(e, array, offset, length);
+  Bytef* buf = reinterpret_cast<Bytef*>(range.acquire(true));
+  if (buf == 0) {
+    return crc;
+  }
 
-  e->SetByteArrayRegion(output, outputOffset, resultArray[2], out);
-  free(out);
+  crc = crc32(static_cast<uint32_t>(crc), buf, length);
 
-  e->SetIntArrayRegion(results, 0, 3, resultArray);
+  range.release(0);
+
+  return crc;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+    Java_java_util_zip_CRC32_updateDirect(JNIEnv* e,
+                                          jclass,
+                                          jint crc,
+                                          jobject buffer,
+                                          jint offset,
+                                          jint length)
+{
+  Bytef* buf = static_cast<Bytef*>(e->GetDirectBufferAddress(buffer));
+
+  return crc32(static_cast<uint32_t>(crc), buf + offset, length);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+    Java_java_util_zip_Adler32_updateBytes(JNIEnv* e,
+                                           jclass,
+                                           jint adler,
+                                           jbyteArray array,
+                                           jint offset,
+                                           jint length)
+{
+  ByteArrayRange range(e, array, offset, length);
+  Bytef* buf = reinterpret_cast<Bytef*>(range.acquire(true));
+  if (buf == 0) {
+    return adler;
+  }
+
+  adler = adler32(static_cast<uint32_t>(adler), buf, length);
+
+  range.release(0);
+
+  return adler;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+    Java_java_util_zip_Adler32_updateDirect(JNIEnv* e,
+                                            jclass,
+                                            jint adler,
+                                            jobject buffer,
+                                            jint offset,
+                                            jint length)
+{
+  Bytef* buf = static_cast<Bytef*>(e->GetDirectBufferAddress(buffer));
+
+  return adler32(static_cast<uint32_t>(adler), buf + offset, length);
 }
@@ -13,8 +13,12 @@ package java.io;
 import java.lang.IllegalArgumentException;
 import java.nio.ByteBuffer;
 import java.nio.channels.FileChannel;
+import java.nio.channels.ReadableByteChannel;
+import java.nio.channels.SocketChannel;
+import java.nio.channels.WritableByteChannel;
 
 public class RandomAccessFile implements DataInput, Closeable {
+  private static final int TransferBufferSize = 64 * 1024;
 
   private long peer;
   private File file;
@@ -85,7 +89,7 @@ public class RandomAccessFile implements DataInput, Closeable {
       return 0;
     if (position + len > this.length)
       throw new EOFException();
-    if (off < 0 || off + len > b.length)
+    if (off < 0 || len < 0 || off > b.length - len)
       throw new ArrayIndexOutOfBoundsException();
     int bytesRead = readBytes(peer, position, b, off, len);
     position += bytesRead;
@@ -115,7 +119,7 @@ public class RandomAccessFile implements DataInput, Closeable {
       return;
     if (position + len > this.length)
       throw new EOFException();
-    if (off < 0 || off + len > b.length)
+    if (off < 0 || len < 0 || off > b.length - len)
       throw new ArrayIndexOutOfBoundsException();
     int n = 0;
     do {
@@ -230,53 +234,162 @@ public class RandomAccessFile implements DataInput, Closeable {
 
   private static native void close(long peer);
 
+  private static native long transfer(long inPeer, long inPosition,
+                                      long outPeer, long outPosition,
+                                      long count)
+    throws IOException;
+
+  private static native int socketDescriptor(SocketChannel channel);
+
   public FileChannel getChannel() {
-    return new FileChannel() {
-      public void close() {
-        if (peer != 0) RandomAccessFile.close(peer);
-      }
+    return new Channel();
+  }
 
-      public boolean isOpen() {
-        return peer != 0;
-      }
+  private class Channel extends FileChannel {
+    private long peer() {
+      return peer;
+    }
 
-      public int read(ByteBuffer dst, long position) throws IOException {
-        if (!dst.hasArray()) throw new IOException("Cannot handle " + dst.getClass());
-	// TODO: this needs to be synchronized on the Buffer, no?
-        byte[] array = dst.array();
-        return readBytes(peer, position, array, dst.position(), dst.remaining());
-      }
+    public void close() {
+      if (peer != 0) RandomAccessFile.close(peer);
+    }
+
+    public boolean isOpen() {
+      return peer != 0;
+    }
+
+    public int read(ByteBuffer dst, long position) throws IOException {
+      if (!dst.hasArray()) throw new IOException("Cannot handle " + dst.getClass());
+      // TODO: this needs to be synchronized on the Buffer, no?
+      byte[] array = dst.array();
+      int count = readBytes(peer, position, array,
+                            dst.arrayOffset() + dst.position(),
+                            dst.remaining());
+      if (count > 0) dst.position(dst.position() + count);
+      return count;
+    }
+
+    public int read(ByteBuffer dst) throws IOException {
+      int count = read(dst, position);
+      if (count > 0) position += count;
+      return count;
+    }
+
+    public int write(ByteBuffer src, long position) throws IOException {
+      if (!src.hasArray()) throw new IOException("Cannot handle " + src.getClass());
+      byte[] array = src.array();
+      int count = writeBytes(peer, position, array,
+                             src.arrayOffset() + src.position(),
+                             src.remaining());
+      if (count > 0) src.position(src.position() + count);
+      return count;
+    }
+
+    public int write(ByteBuffer src) throws IOException {
+      int count = write(src, position);
+      if (count > 0) position += count;
+      return count;
+    }
+
+    public long position() throws IOException {
+      return getFilePointer();
+    }
 
-      public int read(ByteBuffer dst) throws IOException {
-        int count = read(dst, position);
-        if (count > 0) position += count;
-        return count;
+    public FileChannel position(long position) throws IOException {
+      seek(position);
+      return this;
+    }
+
+    public long size() throws IOException {
+      return length();
+    }
+
+    public long transferTo(long position, long count,
+                           WritableByteChannel target)
+      throws IOException
+    {
+      count = Math.min(count, size() - position);
+      if (count <= 0) {
+        return 0;
       }
 
-      public int write(ByteBuffer src, long position) throws IOException {
-        if (!src.hasArray()) throw new IOException("Cannot handle " + src.getClass());
-        byte[] array = src.array();
-        return writeBytes(peer, position, array, src.position(), src.remaining());
+      // let the kernel do the copying if it can:
+      long transferred = -1;
+      if (target instanceof Channel) {
+        Channel channel = (Channel) target;
+        long targetPosition = channel.position();
+        transferred = transfer
+          (peer, position, channel.peer(), targetPosition, count);
+        if (transferred > 0) {
+          channel.position(targetPosition + transferred);
+        }
+      } else if (target instanceof SocketChannel) {
+        transferred = transfer
+          (peer, position, socketDescriptor((SocketChannel) target), -1,
+           count);
       }
 
-      public int write(ByteBuffer src) throws IOException {
-        int count = write(src, position);
-        if (count > 0) position += count;
-        return count;
+      if (transferred >= 0) {
+        return transferred;
       }
 
-      public long position() throws IOException {
-        return getFilePointer();
+      ByteBuffer buffer = ByteBuffer.allocate
+        ((int) Math.min(count, TransferBufferSize));
+      long total = 0;
+      while (total < count) {
+        buffer.clear();
+        buffer.limit((int) Math.min(buffer.capacity(), count - total));
+        if (read(buffer, position + total) <= 0) {
+          break;
+        }
+
+        buffer.flip();
+        total += target.write(buffer);
+        if (buffer.hasRemaining()) {
+          break;
+        }
       }
+      return total;
+    }
 
-      public FileChannel position(long position) throws IOException {
-        seek(position);
-        return this;
+    public long transferFrom(ReadableByteChannel src, long position,
+                             long count)
+      throws IOException
+    {
+      if (src instanceof Channel) {
+        Channel channel = (Channel) src;
+        long srcPosition = channel.position();
+        long n = Math.min(count, channel.size() - srcPosition);
+        if (n <= 0) {
+          return 0;
+        }
+
+        long transferred = transfer
+          (channel.peer(), srcPosition, peer, position, n);
+        if (transferred >= 0) {
+          channel.position(srcPosition + transferred);
+          return transferred;
+        }
       }
 
-      public long size() throws IOException {
-        return length();
+      ByteBuffer buffer = ByteBuffer.allocate
+        ((int) Math.min(count, TransferBufferSize));
+      long total = 0;
+      while (total < count) {
+        buffer.clear();
+        buffer.limit((int) Math.min(buffer.capacity(), count - total));
+        int n = src.read(buffer);
+        if (n <= 0) {
+          break;
+        }
+
+        buffer.flip();
+        while (buffer.hasRemaining()) {
+          write(buffer, position + total + buffer.position());
+        }
+        total += n;
       }
-    };
+      return total;
+    }
   }
 }
@@ -151,6 +151,27 @@ public final class String
     }
   }
 
+  // Used by StringBuilder to hand over its buffer without copying or
+  // scanning it.  The caller promises that a byte array holds only
+  // ASCII and that it won't modify the first length elements again.
+  String(Object data, int length) {
+    this.data = data;
+    this.offset = 0;
+    this.length = length;
+  }
+
+  // copies this string to dst at dstOffset if it is stored as bytes,
+  // returning false (and leaving dst in an unspecified state)
+  // otherwise:
+  boolean getAsciiBytes(byte[] dst, int dstOffset) {
+    if (data instanceof byte[]) {
+      System.arraycopy(data, offset, dst, dstOffset, length);
+      return true;
+    } else {
+      return false;
+    }
+  }
+
   @Override
   public String toString() {
     return this;
@@ -164,9 +185,7 @@ public final class String
   @Override
   public int hashCode() {
     if (hashCode == 0) {
-      int h = 0;
-      for (int i = 0; i < length; ++i) h = (h * 31) + charAt(i);
-      hashCode = h;
+      hashCode = hashChars(data, offset, length);
     }
     return hashCode;
   }
@@ -177,7 +196,8 @@ public final class String
       return true;
     } else if (o instanceof String) {
       String s = (String) o;
-      return s.length == length && compareTo(s) == 0;
+      return s.length == length
+        && charsEqual(data, offset, s.data, s.offset, length);
     } else {
       return false;
     }
@@ -195,18 +215,7 @@ public final class String
   public int compareTo(String s) {
     if (this == s) return 0;
 
-    int idx = 0;
-    int result;
-
-    int end = (length < s.length ? length : s.length);
-
-    while (idx < end) {
-      if ((result = charAt(idx) - s.charAt(idx)) != 0) {
-        return result;
-      }
-      idx++;
-    }
-    return length - s.length;
+    return compareChars(data, offset, length, s.data, s.offset, s.length);
   }
 
   public int compareToIgnoreCase(String s) {
@@ -287,13 +296,11 @@ public final class String
   }
 
   public int indexOf(int c, int start) {
-    for (int i = start; i < length; ++i) {
-      if (charAt(i) == c) {
-        return i;
-      }
-    }
+    if (start < 0) start = 0;
+    if (start >= length) return -1;
 
-    return -1;
+    int i = indexOfChar(data, offset + start, length - start, c);
+    return i < 0 ? -1 : i + start;
   }
 
   public int lastIndexOf(int ch) {
@@ -305,21 +312,13 @@ public final class String
   }
 
   public int indexOf(String s, int start) {
-    if (s.length == 0) return start;
+    if (start < 0) start = 0;
+    if (s.length == 0) return Math.min(start, length);
+    if (length - start < s.length) return -1;
 
-    for (int i = start; i < length - s.length + 1; ++i) {
-      int j = 0;
-      for (; j < s.length; ++j) {
-        if (charAt(i + j) != s.charAt(j)) {
-          break;
-        }
-      }
-      if (j == s.length) {
-        return i;
-      }
-    }
-
-    return -1;
+    int i = indexOfChars
+      (data, offset + start, length - start, s.data, s.offset, s.length);
+    return i < 0 ? -1 : i + start;
   }
 
   public int lastIndexOf(String s) {
@@ -575,6 +574,25 @@ public final class String
 
   public native String intern();
 
+  // Vectorized implementations of the above, which the VM calls
+  // directly from compiled code.  Each takes a string's data, offset,
+  // and length, and none check bounds.
+
+  private static native boolean charsEqual(Object a, int aOffset, Object b,
+                                           int bOffset, int length);
+
+  private static native int compareChars(Object a, int aOffset, int aLength,
+                                         Object b, int bOffset, int bLength);
+
+  private static native int hashChars(Object data, int offset, int length);
+
+  private static native int indexOfChar(Object data, int offset, int length,
+                                        int c);
+
+  private static native int indexOfChars(Object data, int offset, int length,
+                                         Object pattern, int patternOffset,
+                                         int patternLength);
+
   public static String format(String fmt, Object... args) {
     final Formatter formatter = new Formatter();
     final String result = formatter.format(fmt, args).toString();
@@ -11,47 +11,110 @@
 package java.lang;
 
 public class StringBuilder implements CharSequence, Appendable {
-  private static final int BufferSize = 32;
-
-  private Cell chain;
+  private static final int DefaultCapacity = 16;
+
+  // Exactly one of these is non-null.  As long as every character
+  // we've held has been ASCII, we store them compactly as bytes, which
+  // is also the form String uses for ASCII text, and switch to chars
+  // when we see anything else:
+  private byte[] bytes;
+  private char[] chars;
   private int length;
-  private char[] buffer;
-  private int position;
+
+  // whether the array above also belongs to a string returned by
+  // toString, in which case we must copy it before changing it:
+  private boolean shared;
 
   public StringBuilder(String s) {
+    this(s.length() + DefaultCapacity);
     append(s);
   }
 
-  public StringBuilder(int capacity) { }
+  public StringBuilder(int capacity) {
+    bytes = new byte[capacity];
+  }
 
   public StringBuilder() {
-    this(0);
+    this(DefaultCapacity);
+  }
+
+  public int capacity() {
+    return bytes != null ? bytes.length : chars.length;
+  }
+
+  public void ensureCapacity(int capacity) {
+    if (capacity > capacity()) {
+      resize(Math.max(capacity, (capacity() * 2) + 2));
+    }
+  }
+
+  private void resize(int capacity) {
+    if (bytes != null) {
+      byte[] b = new byte[capacity];
+      System.arraycopy(bytes, 0, b, 0, length);
+      bytes = b;
+    } else {
+      char[] c = new char[capacity];
+      System.arraycopy(chars, 0, c, 0, length);
+      chars = c;
+    }
+    shared = false;
   }
 
-  private void flush() {
-    if (position > 0) {
-      chain = new Cell(new String(buffer, 0, position, false), chain);
-      buffer = null;
-      position = 0;
+  // makes room for count more characters, and makes sure we can write
+  // to the array:
+  private void reserve(int count) {
+    int needed = length + count;
+    if (needed < 0) {
+      throw new OutOfMemoryError();
+    }
+
+    if (needed > capacity()) {
+      resize(Math.max(needed, (capacity() * 2) + 2));
+    } else if (shared) {
+      resize(capacity());
     }
   }
 
+  // switches from bytes to chars, copying the first count of them:
+  private void inflate(int count) {
+    char[] c = new char[capacity()];
+    for (int i = 0; i < count; ++i) {
+      c[i] = (char) bytes[i];
+    }
+    chars = c;
+    bytes = null;
+    shared = false;
+  }
+
+  private void put(int index, char c) {
+    if (bytes != null) {
+      if (c < 0x80) {
+        bytes[index] = (byte) c;
+        return;
+      }
+      inflate(length);
+    }
+    chars[index] = c;
+  }
+
   public StringBuilder append(String s) {
     if (s == null) {
-      return append("null");
-    } else {
-      if (s.length() > 0) {
-        if (buffer != null && s.length() <= buffer.length - position) {
-          s.getChars(0, s.length(), buffer, position);
-          position += s.length();
-        } else {
-          flush();
-          chain = new Cell(s, chain);
+      s = "null";
+    }
+
+    int n = s.length();
+    if (n > 0) {
+      reserve(n);
+      if (bytes == null || ! s.getAsciiBytes(bytes, length)) {
+        if (bytes != null) {
+          inflate(length);
         }
-        length += s.length();
+        s.getChars(0, n, chars, length);
       }
-      return this;
+      length += n;
     }
+    return this;
   }
 
   public StringBuilder append(StringBuffer sb) {
@@ -67,11 +130,30 @@ public class StringBuilder implements CharSequence, Appendable {
   }
 
   public StringBuilder append(char[] b, int offset, int length) {
-    return append(new String(b, offset, length));
+    if (offset < 0 || length < 0 || offset + length > b.length) {
+      throw new IndexOutOfBoundsException();
+    }
+
+    reserve(length);
+    if (bytes != null) {
+      for (int i = 0; i < length; ++i) {
+        char c = b[offset + i];
+        if (c >= 0x80) {
+          inflate(this.length + i);
+          break;
+        }
+        bytes[this.length + i] = (byte) c;
+      }
+    }
+    if (chars != null) {
+      System.arraycopy(b, offset, chars, this.length, length);
+    }
+    this.length += length;
+    return this;
   }
 
   public StringBuilder append(char[] b) {
-    return append(new String(b));
+    return append(b, 0, b.length);
   }
 
   public StringBuilder append(Object o) {
@@ -79,16 +161,8 @@ public class StringBuilder implements CharSequence, Appendable {
   }
 
   public StringBuilder append(char v) {
-    if (buffer == null) {
-      buffer = new char[BufferSize];
-    } else if (position >= buffer.length) {
-      flush();
-      buffer = new char[BufferSize];
-    }
-
-    buffer[position++] = v;
-    ++ length;
-
+    reserve(1);
+    put(length++, v);
     return this;
   }
 
@@ -97,11 +171,34 @@ public class StringBuilder implements CharSequence, Appendable {
   }
 
   public StringBuilder append(int v) {
-    return append(String.valueOf(v));
+    return append((long) v);
   }
 
+  // formats the number in place, rather than via String.valueOf:
   public StringBuilder append(long v) {
-    return append(String.valueOf(v));
+    if (v == Long.MIN_VALUE) {
+      return append("-9223372036854775808");
+    }
+
+    long magnitude = v < 0 ? -v : v;
+    int count = v < 0 ? 2 : 1;
+    for (long m = magnitude; m >= 10; m /= 10) {
+      ++ count;
+    }
+
+    reserve(count);
+    int index = length + count;
+    length = index;
+    do {
+      put(--index, (char) ('0' + (magnitude % 10)));
+      magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (v < 0) {
+      put(--index, '-');
+    }
+
+    return this;
   }
 
   public StringBuilder append(float v) {
@@ -117,19 +214,7 @@ public class StringBuilder implements CharSequence, Appendable {
       throw new IndexOutOfBoundsException();
     }
 
-    flush();
-
-    int index = length;
-    for (Cell c = chain; c != null; c = c.next) {
-      int start = index - c.value.length();
-      index = start;
-      
-      if (i >= start) {
-        return c.value.charAt(i - start);
-      }
-    }
-
-    throw new RuntimeException();
+    return bytes != null ? (char) bytes[i] : chars[i];
   }
 
   public StringBuilder insert(int i, String s) {
@@ -137,30 +222,23 @@ public class StringBuilder implements CharSequence, Appendable {
       throw new IndexOutOfBoundsException();
     }
 
-    if (i == length) {
-      append(s);
-    } else {
-      flush();
-
-      int index = length;
-      for (Cell c = chain; c != null; c = c.next) {
-        int start = index - c.value.length();
-        index = start;
-      
-        if (i >= start) {
-          if (i == start) {
-            c.next = new Cell(s, c.next);
-          } else {
-            String v = c.value;
-            c.value = v.substring(i - start, v.length());
-            c.next = new Cell(s, new Cell(v.substring(0, i - start), c.next));
-          }
-          break;
-        }
-      }
+    if (s == null) {
+      s = "null";
+    }
 
-      length += s.length();
+    int n = s.length();
+    reserve(n);
+    if (bytes != null) {
+      System.arraycopy(bytes, i, bytes, i + n, length - i);
+      if (! s.getAsciiBytes(bytes, i)) {
+        inflate(length + n);
+        s.getChars(0, n, chars, i);
+      }
+    } else {
+      System.arraycopy(chars, i, chars, i + n, length - i);
+      s.getChars(0, n, chars, i);
     }
+    length += n;
 
     return this;
   }
@@ -170,7 +248,7 @@ public class StringBuilder implements CharSequence, Appendable {
   }
 
   public StringBuilder insert(int i, char c) {
-    return insert(i, new String(new char[] { c }, 0, 1, false));
+    return insert(i, String.valueOf(c));
   }
 
   public StringBuilder insert(int i, int v) {
@@ -186,44 +264,22 @@ public class StringBuilder implements CharSequence, Appendable {
       throw new IndexOutOfBoundsException();
     }
 
-    flush();
-
-    int index = length;
-    Cell p = null;
-    for (Cell c = chain; c != null; c = c.next) {
-      int e = index;
-      int s = index - c.value.length();
-      index = s;
-      
-      if (end >= e) {
-        if (start <= s) {
-          if (p == null) {
-            chain = c.next;
-          } else {
-            p.next = c.next;
-          }          
-        } else {
-          c.value = c.value.substring(0, start - s);
-          break;
-        }
-      } else {
-        if (start <= s) {
-          c.value = c.value.substring(end - s, e - s);
-        } else {
-          String v = c.value;
-          c.value = v.substring(end - s, e - s);
-          c.next = new Cell(v.substring(0, start - s), c.next);
-          break;
-        }        
-      }
+    reserve(0);
+    if (bytes != null) {
+      System.arraycopy(bytes, end, bytes, start, length - end);
+    } else {
+      System.arraycopy(chars, end, chars, start, length - end);
     }
-
     length -= (end - start);
 
     return this;
   }
 
   public StringBuilder deleteCharAt(int i) {
+    if (i < 0 || i >= length) {
+      throw new IndexOutOfBoundsException();
+    }
+
     return delete(i, i + 1);
   }
 
@@ -232,11 +288,11 @@ public class StringBuilder implements CharSequence, Appendable {
     insert(start, str);
     return this;
   }
-  
+
   public int indexOf(String s) {
     return indexOf(s, 0);
   }
-  
+
   public int indexOf(String s, int start) {
     int slength = s.length();
     if (slength == 0) return start;
@@ -255,7 +311,7 @@ public class StringBuilder implements CharSequence, Appendable {
 
     return -1;
   }
-  
+
   public int lastIndexOf(String s) {
     return lastIndexOf(s, length - s.length());
   }
@@ -288,29 +344,16 @@ public class StringBuilder implements CharSequence, Appendable {
       throw new IndexOutOfBoundsException();
     }
 
-    if (v == 0) {
-      length = 0;
-      chain = null;
-      return;
+    if (v > length) {
+      // the characters past the end may be left over from before, so
+      // clear them:
+      reserve(v - length);
+      for (int i = length; i < v; ++i) {
+        put(i, '\0');
+      }
     }
 
-    flush();
-
-    int index = length;
     length = v;
-    for (Cell c = chain; c != null; c = c.next) {
-      int start = index - c.value.length();
-
-      if (v > start) {
-        if (v < index) {
-          c.value = c.value.substring(0, v - start);
-        }
-        break;
-      }
-
-      chain = c.next;
-      index = start;
-    }
   }
 
   public void getChars(int srcStart, int srcEnd, char[] dst, int dstStart) {
@@ -318,42 +361,29 @@ public class StringBuilder implements CharSequence, Appendable {
       throw new IndexOutOfBoundsException();
     }
 
-    flush();
-
-    int index = length;
-    for (Cell c = chain; c != null; c = c.next) {
-      int start = index - c.value.length();
-      int end = index;
-      index = start;
-
-      if (start < srcStart) {
-        start = srcStart;
-      }
-
-      if (end > srcEnd) {
-        end = srcEnd;
-      }
-
-      if (start < end) {
-        c.value.getChars(start - index, end - index,
-                         dst, dstStart + (start - srcStart));
+    if (bytes != null) {
+      for (int i = srcStart; i < srcEnd; ++i) {
+        dst[dstStart + (i - srcStart)] = (char) bytes[i];
       }
+    } else {
+      System.arraycopy(chars, srcStart, dst, dstStart, srcEnd - srcStart);
     }
   }
 
   public String toString() {
-    char[] array = new char[length];
-    getChars(0, length, array, 0);
-    return new String(array, 0, length, false);
-  }
-
-  private static class Cell {
-    public String value;
-    public Cell next;
+    if (length == 0) {
+      return "";
+    }
 
-    public Cell(String value, Cell next) {
-      this.value = value;
-      this.next = next;
+    // when there's little enough room left over, hand the array itself
+    // to the string, and copy it ourselves if we're changed later
+    // (e.g. a builder used just to concatenate some strings, which is
+    // then thrown away).  Otherwise, copy just what we need:
+    if (capacity() - length <= (length >> 2)) {
+      shared = true;
+      return new String(bytes != null ? (Object) bytes : chars, length);
+    } else {
+      return substring(0, length);
     }
   }
 
@@ -362,23 +392,29 @@ public class StringBuilder implements CharSequence, Appendable {
   }
 
   public String substring(int start, int end) {
-    int len = end-start;
-    char[] buf = new char[len]; 
-    getChars(start, end, buf, 0);
-    return new String(buf, 0, len, false);
+    if (start < 0 || start > end || end > length) {
+      throw new IndexOutOfBoundsException();
+    }
+
+    int len = end - start;
+    if (bytes != null) {
+      byte[] buf = new byte[len];
+      System.arraycopy(bytes, start, buf, 0, len);
+      return new String(buf, len);
+    } else {
+      char[] buf = new char[len];
+      System.arraycopy(chars, start, buf, 0, len);
+      return new String(buf, len);
+    }
   }
-        
+
   public CharSequence subSequence(int start, int end) {
     return substring(start, end);
   }
 
   public void setCharAt(int index, char ch) {
     if(index < 0 || index >= length) throw new IndexOutOfBoundsException();
-    deleteCharAt(index);
-    insert(index, ch);
-  }
-
-  public void ensureCapacity(int capacity) {
-    // ignore
+    reserve(0);
+    put(index, ch);
   }
 }
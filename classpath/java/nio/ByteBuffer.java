@@ -53,6 +53,10 @@ public abstract class ByteBuffer
     return false;
   }
 
+  public boolean isDirect() {
+    return false;
+  }
+
   public ByteBuffer compact() {
     int remaining = remaining();
 
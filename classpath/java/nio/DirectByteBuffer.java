@@ -31,6 +31,10 @@ class DirectByteBuffer extends ByteBuffer {
     this(address, capacity, false);
   }
 
+  public boolean isDirect() {
+    return true;
+  }
+
   public ByteBuffer asReadOnlyBuffer() {
     ByteBuffer b = new DirectByteBuffer(address, capacity, true);
     b.position(position());
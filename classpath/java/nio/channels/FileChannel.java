@@ -13,7 +13,9 @@ package java.nio.channels;
 import java.io.IOException;
 import java.nio.ByteBuffer;
 
-public abstract class FileChannel implements Channel {
+public abstract class FileChannel
+  implements ReadableByteChannel, WritableByteChannel
+{
 
   public static enum MapMode {
     PRIVATE, READ_ONLY, READ_WRITE
@@ -32,4 +34,12 @@ public abstract class FileChannel implements Channel {
   public abstract FileChannel position(long position) throws IOException;
 
   public abstract long size() throws IOException;
+
+  public abstract long transferTo(long position, long count,
+                                  WritableByteChannel target)
+    throws IOException;
+
+  public abstract long transferFrom(ReadableByteChannel src, long position,
+                                    long count)
+    throws IOException;
 }
@@ -38,6 +38,7 @@ public class SelectionKey {
 
   public SelectionKey interestOps(int v) {
     this.interestOps = v;
+    selector.update(this);
     return this;
   }
 
@@ -30,6 +30,10 @@ public abstract class Selector {
     keys.remove(key);
   }
 
+  // called when the interest set of a key or the state of its
+  // channel changes
+  void update(SelectionKey key) { }
+
   public Set<SelectionKey> keys() {
     return keys;
   }
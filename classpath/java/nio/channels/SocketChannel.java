@@ -18,7 +18,7 @@ import java.net.Socket;
 import java.nio.ByteBuffer;
 
 public class SocketChannel extends SelectableChannel
-  implements ReadableByteChannel, GatheringByteChannel
+  implements ReadableByteChannel, ScatteringByteChannel, GatheringByteChannel
 {
   public static final int InvalidSocket = -1;
 
@@ -108,26 +108,63 @@ public class SocketChannel extends SelectableChannel
     if (! isOpen()) return -1;
     if (b.remaining() == 0) return 0;
 
-    byte[] array = b.array();
-    if (array == null) throw new NullPointerException();
+    int r;
+    if (b.isDirect()) {
+      r = natReadDirect(socket, b, b.position(), b.remaining());
+    } else {
+      byte[] array = b.array();
+      if (array == null) throw new NullPointerException();
 
-    int r = natRead(socket, array, b.arrayOffset() + b.position(), b.remaining(), blocking);
+      r = natRead(socket, array, b.arrayOffset() + b.position(), b.remaining(), blocking);
+    }
     if (r > 0) {
       b.position(b.position() + r);
     }
     return r;
   }
 
+  public long read(ByteBuffer[] dsts) throws IOException {
+    return read(dsts, 0, dsts.length);
+  }
+
+  public long read(ByteBuffer[] dsts, int offset, int length)
+    throws IOException
+  {
+    if (! isOpen()) return -1;
+
+    if (allDirect(dsts, offset, length)) {
+      long r = natReadv(socket, dsts, offset, length);
+      if (r > 0) {
+        advance(dsts, offset, length, r);
+      }
+      return r;
+    }
+
+    // otherwise, read into the first buffer with room, since reading
+    // any further might block after we've already got something:
+    for (int i = offset; i < offset + length; ++i) {
+      if (dsts[i].hasRemaining()) {
+        return read(dsts[i]);
+      }
+    }
+    return 0;
+  }
+
   public int write(ByteBuffer b) throws IOException {
     if (! connected) {
       natThrowWriteError(socket);
     }
     if (b.remaining() == 0) return 0;
 
-    byte[] array = b.array();
-    if (array == null) throw new NullPointerException();
+    int w;
+    if (b.isDirect()) {
+      w = natWriteDirect(socket, b, b.position(), b.remaining());
+    } else {
+      byte[] array = b.array();
+      if (array == null) throw new NullPointerException();
 
-    int w = natWrite(socket, array, b.arrayOffset() + b.position(), b.remaining(), blocking);
+      w = natWrite(socket, array, b.arrayOffset() + b.position(), b.remaining(), blocking);
+    }
     if (w > 0) {
       b.position(b.position() + w);
     }
@@ -141,6 +178,18 @@ public class SocketChannel extends SelectableChannel
   public long write(ByteBuffer[] srcs, int offset, int length)
     throws IOException
   {
+    if (! connected) {
+      natThrowWriteError(socket);
+    }
+
+    if (allDirect(srcs, offset, length)) {
+      long w = natWritev(socket, srcs, offset, length);
+      if (w > 0) {
+        advance(srcs, offset, length, w);
+      }
+      return w;
+    }
+
     long total = 0;
     for (int i = offset; i < offset + length; ++i) {
       total += write(srcs[i]);
@@ -151,6 +200,33 @@ public class SocketChannel extends SelectableChannel
     return total;
   }
 
+  private static boolean allDirect(ByteBuffer[] buffers, int offset,
+                                   int length)
+  {
+    if (offset < 0 || length < 0 || offset + length > buffers.length) {
+      throw new IndexOutOfBoundsException();
+    }
+
+    for (int i = offset; i < offset + length; ++i) {
+      if (! buffers[i].isDirect()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // moves the positions of the specified buffers past the count bytes
+  // just read into or written from them, in order:
+  private static void advance(ByteBuffer[] buffers, int offset, int length,
+                              long count)
+  {
+    for (int i = offset; i < offset + length && count > 0; ++i) {
+      int n = (int) Math.min(buffers[i].remaining(), count);
+      buffers[i].position(buffers[i].position() + n);
+      count -= n;
+    }
+  }
+
   private void closeSocket() {
     natCloseSocket(socket);
   }
@@ -209,6 +285,14 @@ public class SocketChannel extends SelectableChannel
     throws IOException;
   private static native int natWrite(int socket, byte[] buffer, int offset, int length, boolean blocking)
     throws IOException;
+  private static native int natReadDirect(int socket, ByteBuffer buffer, int offset, int length)
+    throws IOException;
+  private static native int natWriteDirect(int socket, ByteBuffer buffer, int offset, int length)
+    throws IOException;
+  private static native long natReadv(int socket, ByteBuffer[] buffers, int offset, int length)
+    throws IOException;
+  private static native long natWritev(int socket, ByteBuffer[] buffers, int offset, int length)
+    throws IOException;
   private static native void natThrowWriteError(int socket) throws IOException;
   private static native void natCloseSocket(int socket);
 }
@@ -12,6 +12,10 @@ package java.nio.channels;
 
 import java.io.IOException;
 import java.util.Iterator;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.Map;
+import java.util.Set;
 import java.net.Socket;
 
 class SocketSelector extends Selector {
@@ -19,10 +23,46 @@ class SocketSelector extends Selector {
   protected final Object lock = new Object();
   protected boolean woken = false;
 
+  // When the native side uses epoll, sockets stay registered between
+  // selects.  We then only tell it about keys whose interest set or
+  // channel state changed since the last select, and it reports only
+  // the sockets which are ready, so a select costs time proportional
+  // to the activity rather than to the number of keys.
+  private final boolean usesEpoll;
+  private final Map<Integer, SelectionKey> registered;
+  private final Set<SelectionKey> changed;
+
   public SocketSelector() throws IOException {
     Socket.init();
 
     state = natInit();
+
+    usesEpoll = natUsesEpoll(state);
+    if (usesEpoll) {
+      registered = new HashMap();
+      changed = new HashSet();
+    } else {
+      registered = null;
+      changed = null;
+    }
+  }
+
+  public void add(SelectionKey key) {
+    super.add(key);
+    update(key);
+  }
+
+  public void remove(SelectionKey key) {
+    super.remove(key);
+    update(key);
+  }
+
+  void update(SelectionKey key) {
+    if (usesEpoll) {
+      synchronized (lock) {
+        changed.add(key);
+      }
+    }
   }
 
   public boolean isOpen() {
@@ -70,6 +110,10 @@ class SocketSelector extends Selector {
       throw new ClosedSelectorException();
     }
 
+    if (usesEpoll) {
+      return doEpollSelect(interval);
+    }
+
     selectedKeys.clear();
 
     if (clearWoken()) interval = -1;
@@ -110,6 +154,59 @@ class SocketSelector extends Selector {
     return selectedKeys.size();
   }
 
+  private int doEpollSelect(long interval) throws IOException {
+    for (SelectionKey key: selectedKeys) {
+      key.readyOps(0);
+    }
+    selectedKeys.clear();
+
+    if (clearWoken()) interval = -1;
+
+    SelectionKey[] changes;
+    synchronized (lock) {
+      changes = changed.toArray(new SelectionKey[changed.size()]);
+      changed.clear();
+    }
+
+    for (SelectionKey key: changes) {
+      SelectableChannel c = key.channel();
+      int socket = c.socketFD();
+      if (c.isOpen() && keys.contains(key)) {
+        natSelectUpdateInterestSet(socket, key.interestOps(), state, 0);
+        registered.put(socket, key);
+      } else {
+        keys.remove(key);
+        if (registered.get(socket) == key) {
+          natSelectClearAll(socket, state);
+          registered.remove(socket);
+        }
+      }
+    }
+
+    int r = natDoSocketSelect(state, 0, interval);
+
+    for (int i = 0; i < r; ++i) {
+      SelectionKey key = registered.get(natEventSocket(state, i));
+      if (key != null) {
+        SelectableChannel c = key.channel();
+        if (! c.isOpen()) {
+          update(key);
+          continue;
+        }
+
+        int ready = natEventReadyOps(state, i, key.interestOps());
+        key.readyOps(ready);
+        if (ready != 0) {
+          c.handleReadyOps(ready);
+          selectedKeys.add(key);
+        }
+      }
+    }
+    clearWoken();
+
+    return selectedKeys.size();
+  }
+
   public synchronized void close() {
     synchronized (lock) {
       if (isOpen()) {
@@ -120,6 +217,10 @@ class SocketSelector extends Selector {
   }
 
   private static native long natInit();
+  private static native boolean natUsesEpoll(long state);
+  private static native int natEventSocket(long state, int index);
+  private static native int natEventReadyOps(long state, int index,
+                                             int interest);
   private static native void natWakeup(long state);
   private static native void natClose(long state);
   private static native void natSelectClearAll(int socket, long state);
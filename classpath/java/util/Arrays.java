@@ -297,12 +297,7 @@ public class Arrays {
     if(a.length != b.length) {
       return false;
     }
-    for(int i = 0; i < a.length; i++) {
-      if(a[i] != b[i]) {
-        return false;
-      }
-    }
-    return true;
+    return elementsEqual(a, b, a.length);
   }
 
   public static boolean equals(int[] a, int[] b) {
@@ -315,12 +310,7 @@ public class Arrays {
     if(a.length != b.length) {
       return false;
     }
-    for(int i = 0; i < a.length; i++) {
-      if(a[i] != b[i]) {
-        return false;
-      }
-    }
-    return true;
+    return elementsEqual(a, b, a.length);
   }
 
   public static boolean equals(long[] a, long[] b) {
@@ -333,12 +323,7 @@ public class Arrays {
     if(a.length != b.length) {
       return false;
     }
-    for(int i = 0; i < a.length; i++) {
-      if(a[i] != b[i]) {
-        return false;
-      }
-    }
-    return true;
+    return elementsEqual(a, b, a.length);
   }
 
   public static boolean equals(short[] a, short[] b) {
@@ -351,12 +336,7 @@ public class Arrays {
     if(a.length != b.length) {
       return false;
     }
-    for(int i = 0; i < a.length; i++) {
-      if(a[i] != b[i]) {
-        return false;
-      }
-    }
-    return true;
+    return elementsEqual(a, b, a.length);
   }
 
   public static boolean equals(char[] a, char[] b) {
@@ -369,12 +349,7 @@ public class Arrays {
     if(a.length != b.length) {
       return false;
     }
-    for(int i = 0; i < a.length; i++) {
-      if(a[i] != b[i]) {
-        return false;
-      }
-    }
-    return true;
+    return elementsEqual(a, b, a.length);
   }
 
   public static boolean equals(float[] a, float[] b) {
@@ -485,6 +460,15 @@ public class Arrays {
     };
   }
 
+  // compares the first length elements of two arrays of the same
+  // integral type:
+  private static native boolean elementsEqual(Object a, Object b, int length);
+
+  // stores the low bits of value to each element of a primitive array
+  // in the specified range:
+  private static native void fillElements(Object array, int start, int stop,
+                                          long value);
+
   private static void checkRange(int len, int start, int stop) {
     if (start < 0) {
       throw new ArrayIndexOutOfBoundsException(start);
@@ -498,107 +482,75 @@ public class Arrays {
   }
 
   public static void fill(int[] array, int value) {
-    for (int i=0;i<array.length;i++) {
-      array[i] = value;
-    }
+    fillElements(array, 0, array.length, value);
   }
 
   public static void fill(int[] array, int start, int stop, int value) {
     checkRange(array.length, start, stop);
-    for (int i=start;i<stop;i++) {
-      array[i] = value;
-    }
+    fillElements(array, start, stop, value);
   }
 
   public static void fill(char[] array, char value) {
-    for (int i=0;i<array.length;i++) {
-      array[i] = value;
-    }
+    fillElements(array, 0, array.length, value);
   }
 
   public static void fill(char[] array, int start, int stop, char value) {
     checkRange(array.length, start, stop);
-    for (int i=start;i<stop;i++) {
-      array[i] = value;
-    }
+    fillElements(array, start, stop, value);
   }
 
   public static void fill(short[] array, short value) {
-    for (int i=0;i<array.length;i++) {
-      array[i] = value;
-    }
+    fillElements(array, 0, array.length, value);
   }
 
   public static void fill(short[] array, int start, int stop, short value) {
     checkRange(array.length, start, stop);
-    for (int i=start;i<stop;i++) {
-      array[i] = value;
-    }
+    fillElements(array, start, stop, value);
   }
 
   public static void fill(byte[] array, byte value) {
-    for (int i=0;i<array.length;i++) {
-      array[i] = value;
-    }
+    fillElements(array, 0, array.length, value);
   }
   
   public static void fill(byte[] array, int start, int stop, byte value) {
     checkRange(array.length, start, stop);
-    for (int i=start;i<stop;i++) {
-      array[i] = value;
-    }
+    fillElements(array, start, stop, value);
   }
 
   public static void fill(boolean[] array, boolean value) {
-    for (int i=0;i<array.length;i++) {
-      array[i] = value;
-    }
+    fillElements(array, 0, array.length, value ? 1 : 0);
   }
 
   public static void fill(boolean[] array, int start, int stop, boolean value) {
     checkRange(array.length, start, stop);
-    for (int i=start;i<stop;i++) {
-      array[i] = value;
-    }
+    fillElements(array, start, stop, value ? 1 : 0);
   }
 
   public static void fill(long[] array, long value) {
-    for (int i=0;i<array.length;i++) {
-      array[i] = value;
-    }
+    fillElements(array, 0, array.length, value);
   }
 
   public static void fill(long[] array, int start, int stop, long value) {
     checkRange(array.length, start, stop);
-    for (int i=start;i<stop;i++) {
-      array[i] = value;
-    }
+    fillElements(array, start, stop, value);
   }
 
-   public static void fill(float[] array, float value) {
-    for (int i=0;i<array.length;i++) {
-      array[i] = value;
-    }
+  public static void fill(float[] array, float value) {
+    fillElements(array, 0, array.length, Float.floatToRawIntBits(value));
   }
 
   public static void fill(float[] array, int start, int stop, float value) {
     checkRange(array.length, start, stop);
-    for (int i=start;i<stop;i++) {
-      array[i] = value;
-    }
+    fillElements(array, start, stop, Float.floatToRawIntBits(value));
   }
 
- public static void fill(double[] array, double value) {
-    for (int i=0;i<array.length;i++) {
-      array[i] = value;
-    }
+  public static void fill(double[] array, double value) {
+    fillElements(array, 0, array.length, Double.doubleToRawLongBits(value));
   }
 
   public static void fill(double[] array, int start, int stop, double value) {
     checkRange(array.length, start, stop);
-    for (int i=start;i<stop;i++) {
-      array[i] = value;
-    }
+    fillElements(array, start, stop, Double.doubleToRawLongBits(value));
   }
 
   public static <T> void fill(T[] array, T value) {
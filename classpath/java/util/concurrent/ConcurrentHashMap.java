@@ -11,58 +11,141 @@
 package java.util.concurrent;
 
 import avian.Data;
-import avian.PersistentSet;
-import avian.PersistentSet.Path;
 
 import sun.misc.Unsafe;
 import java.util.AbstractMap;
+import java.util.ArrayList;
 import java.util.Map;
 import java.util.Set;
 import java.util.Collection;
 import java.util.Iterator;
 import java.util.NoSuchElementException;
 
+/**
+ * A hash table of bins, each a linked list of nodes.
+ *
+ * Readers never lock: they load a bin with a volatile read and walk
+ * its list, whose links and values are volatile.  A writer adding the
+ * first node to an empty bin does so with a single CAS.  Any other
+ * update to a bin happens while holding the monitor of the bin's
+ * first node, so writers to different bins do not contend.
+ *
+ * When the table fills up, the thread which claims the resize copies
+ * each bin into a table twice the size, then replaces the old bin with
+ * a forwarding node pointing at the new table.  Readers and writers
+ * which find a forwarding node simply continue in the new table, so
+ * neither waits for the resize to finish.  Bins are copied rather than
+ * relinked, so a reader still walking an old bin sees a consistent
+ * list.
+ *
+ * The element count is striped across several cells so that writers
+ * do not all contend on one word.
+ */
 public class ConcurrentHashMap<K,V>
   extends AbstractMap<K,V>
   implements ConcurrentMap<K,V>
 {
   private static final Unsafe unsafe = Unsafe.getUnsafe();
-  private static final long Content;
-  private static final Content Empty = new Content(new PersistentSet(), 0);
+  private static final long ArrayOffset
+    = unsafe.arrayBaseOffset(Object[].class);
+  private static final long ArrayScale
+    = unsafe.arrayIndexScale(Object[].class);
+  private static final long SizeControl;
+  private static final long BaseCount;
+  private static final long CellValue;
+
+  private static final int DefaultCapacity = 16;
+  private static final int MaximumCapacity = 1 << 30;
+  private static final int CounterCellCount = 16;
+
+  // hash code of forwarding nodes; real nodes have non-negative hashes
+  private static final int Moved = -1;
 
   static {
     try {
-      Content = unsafe.objectFieldOffset
-        (ConcurrentHashMap.class.getDeclaredField("content"));
+      SizeControl = unsafe.objectFieldOffset
+        (ConcurrentHashMap.class.getDeclaredField("sizeControl"));
+      BaseCount = unsafe.objectFieldOffset
+        (ConcurrentHashMap.class.getDeclaredField("baseCount"));
+      CellValue = unsafe.objectFieldOffset
+        (CounterCell.class.getDeclaredField("value"));
     } catch (NoSuchFieldException e) {
       throw new Error(e);
     }
   }
 
-  private volatile Content<K,V> content;
+  private volatile Node<K,V>[] table;
+
+  // the element count at which to resize the table, or -1 while a
+  // resize is in progress:
+  private volatile int sizeControl;
+
+  private volatile long baseCount;
+  private final CounterCell[] counterCells;
 
   public ConcurrentHashMap() {
-    content = Empty;
+    this(DefaultCapacity);
   }
 
   public ConcurrentHashMap(int initialCapacity) {
-    this();
+    if (initialCapacity < 0) {
+      throw new IllegalArgumentException();
+    }
+
+    int capacity = DefaultCapacity;
+    while (capacity < MaximumCapacity
+           && capacity - (capacity >>> 2) < initialCapacity)
+    {
+      capacity <<= 1;
+    }
+
+    table = new Node[capacity];
+    sizeControl = capacity - (capacity >>> 2);
+
+    counterCells = new CounterCell[CounterCellCount];
+    for (int i = 0; i < CounterCellCount; ++i) {
+      counterCells[i] = new CounterCell();
+    }
   }
 
   public ConcurrentHashMap(int initialCapacity,  float loadFactor) {
-    this();
+    this(initialCapacity);
   }
 
   public ConcurrentHashMap(int initialCapacity,  float loadFactor, int concurrencyLevel) {
-    this();
+    this(initialCapacity);
+  }
+
+  private static int spread(int hash) {
+    return (hash ^ (hash >>> 16)) & 0x7FFFFFFF;
+  }
+
+  private static <K,V> Node<K,V> tabAt(Node<K,V>[] table, int index) {
+    return (Node<K,V>) unsafe.getObjectVolatile
+      (table, ArrayOffset + (index * ArrayScale));
+  }
+
+  private static <K,V> void setTabAt(Node<K,V>[] table, int index,
+                                     Node<K,V> node)
+  {
+    unsafe.putObjectVolatile
+      (table, ArrayOffset + (index * ArrayScale), node);
+  }
+
+  private static <K,V> boolean casTabAt(Node<K,V>[] table, int index,
+                                        Node<K,V> expect, Node<K,V> update)
+  {
+    return unsafe.compareAndSwapObject
+      (table, ArrayOffset + (index * ArrayScale), expect, update);
   }
 
   public boolean isEmpty() {
-    return content.size == 0;
+    return sumCount() <= 0;
   }
 
   public int size() {
-    return content.size;
+    long n = sumCount();
+    return n < 0 ? 0 : n > Integer.MAX_VALUE ? Integer.MAX_VALUE : (int) n;
   }
 
   public boolean containsKey(Object key) {
@@ -79,53 +162,56 @@ public class ConcurrentHashMap<K,V>
   }
 
   public V get(Object key) {
-    Cell<K,V> cell = find(key);
-    return cell == null ? null : cell.value;
+    Node<K,V> node = find(key);
+    return node == null ? null : node.value;
   }
 
-  private Cell<K,V> find(Object key) {
-    Content<K,V> c = content;
+  private Node<K,V> find(Object key) {
+    int hash = spread(key.hashCode());
+    Node<K,V>[] table = this.table;
 
-    Path<Node<Cell<K,V>>> path = c.set.find(new Node(key.hashCode()));
-    for (Cell<K,V> cell = path.value().value; 
-         cell != null;
-         cell = cell.next)
-    {
-      if (key.equals(cell.key)) {
-        return cell;
+    while (true) {
+      Node<K,V> node = tabAt(table, hash & (table.length - 1));
+      if (node != null && node.hash == Moved) {
+        table = ((ForwardingNode<K,V>) node).nextTable;
+        continue;
+      }
+
+      for (; node != null; node = node.next) {
+        if (node.hash == hash && key.equals(node.key)) {
+          return node;
+        }
       }
+      return null;
     }
-    return null;
   }
 
   public V putIfAbsent(K key, V value) {
-    Cell<K,V> cell = put(key, value, PutCondition.IfAbsent, null);
-    return cell == null ? null : cell.value;
+    return put(key, value, PutCondition.IfAbsent, null);
   }
 
   public boolean remove(K key, V value) {
-    Cell<K,V> cell = remove(key, RemoveCondition.IfEqual, value);
-    return cell != null && cell.value.equals(value);
+    return value != null
+      && remove(key, RemoveCondition.IfEqual, value) != null;
   }
 
   public V replace(K key, V value) {
-    Cell<K,V> cell = put(key, value, PutCondition.IfPresent, null);
-    return cell == null ? null : cell.value;
+    return put(key, value, PutCondition.IfPresent, null);
   }
 
   public boolean replace(K key, V oldValue, V newValue) {
-    Cell<K,V> cell = put(key, newValue, PutCondition.IfEqual, oldValue);
-    return cell != null && cell.value.equals(oldValue);    
+    if (oldValue == null) {
+      throw new NullPointerException();
+    }
+    return put(key, newValue, PutCondition.IfEqual, oldValue) != null;
   }
 
   public V put(K key, V value) {
-    Cell<K,V> cell = put(key, value, PutCondition.Always, null);
-    return cell == null ? null : cell.value;
+    return put(key, value, PutCondition.Always, null);
   }
 
   public V remove(Object key) {
-    Cell<K,V> cell = remove(key, RemoveCondition.Always, null);
-    return cell == null ? null : cell.value;
+    return remove(key, RemoveCondition.Always, null);
   }
 
   private enum PutCondition {
@@ -134,7 +220,7 @@ public class ConcurrentHashMap<K,V>
       public <V> boolean addIfPresent(V a, V b) { return true; }
     }, IfAbsent() {
       public boolean addIfAbsent() { return true; }
-      public <V> boolean addIfPresent(V a, V b) { return false; }      
+      public <V> boolean addIfPresent(V a, V b) { return false; }
     }, IfPresent() {
       public boolean addIfAbsent() { return false; }
       public <V> boolean addIfPresent(V a, V b) { return true; }
@@ -157,67 +243,61 @@ public class ConcurrentHashMap<K,V>
     public <V> boolean remove(V a, V b) { throw new AssertionError(); }
   }
 
-  private Cell<K,V> put(K key, V value, PutCondition condition, V oldValue) {
-    Node<Cell<K,V>> node = new Node(key.hashCode());
+  // returns the value previously mapped to the key, or null if there
+  // was none.  If the condition prevents the update, the current value
+  // is returned for IfAbsent and null otherwise.
+  private V put(K key, V value, PutCondition condition, V oldValue) {
+    if (value == null) {
+      throw new NullPointerException();
+    }
 
-    loop: while (true) {
-      node.value = null;
-      Content content = this.content;
-      Path<Node<Cell<K,V>>> path = content.set.find(node);
-      for (Cell<K,V> cell = path.value().value;
-           cell != null;
-           cell = cell.next)
-      {
-        if (key.equals(cell.key)) {
-          if (! condition.addIfPresent(cell.value, oldValue)) {
-            return cell;
-          }
+    int hash = spread(key.hashCode());
+    Node<K,V>[] table = this.table;
 
-          Cell<K,V> start = null;
-          Cell<K,V> last = null;
-          for (Cell<K,V> cell2 = path.value().value;
-               true;
-               cell2 = cell2.next)
-          {
-            Cell<K,V> c;
-            c = cell2.clone();
-
-            if (last == null) {
-              last = start = c;
-            } else {
-              last.next = c;
-              last = c;
-            }
+    while (true) {
+      int index = hash & (table.length - 1);
+      Node<K,V> first = tabAt(table, index);
+      if (first == null) {
+        if (! condition.addIfAbsent()) {
+          return null;
+        }
 
-            if (cell2 == cell) {
-              c.value = value;
-              break;
+        if (casTabAt(table, index, null, new Node(hash, key, value, null))) {
+          addCount(1, 0);
+          return null;
+        }
+      } else if (first.hash == Moved) {
+        table = ((ForwardingNode<K,V>) first).nextTable;
+      } else {
+        int binCount = 0;
+        synchronized (first) {
+          if (tabAt(table, index) != first) {
+            continue;
+          }
+
+          Node<K,V> last = null;
+          for (Node<K,V> node = first; node != null; node = node.next) {
+            ++ binCount;
+            if (node.hash == hash && key.equals(node.key)) {
+              V v = node.value;
+              if (condition.addIfPresent(v, oldValue)) {
+                node.value = value;
+                return v;
+              } else {
+                return condition == PutCondition.IfAbsent ? v : null;
+              }
             }
+            last = node;
           }
 
-          node.value = start;
-          if (unsafe.compareAndSwapObject
-              (this, Content, content, new Content
-               (path.replaceWith(node), content.size)))
-          {
-            return cell;
-          } else {
-            continue loop;
+          if (! condition.addIfAbsent()) {
+            return null;
           }
-        }
-      }
 
-      // no mapping found -- add a new one if appropriate
-      if (! condition.addIfAbsent()) {
-        return null;
-      }
+          last.next = new Node(hash, key, value, null);
+        }
 
-      node.value = new Cell(key, value, null);
-      if (unsafe.compareAndSwapObject
-          (this, Content, content, new Content
-           (path.fresh() ? path.add() : path.replaceWith(node),
-            content.size + 1)))
-      {
+        addCount(1, binCount);
         return null;
       }
     }
@@ -229,64 +309,157 @@ public class ConcurrentHashMap<K,V>
     }
   }
 
-  private Cell<K,V> remove(Object key, RemoveCondition condition,
-                           V oldValue)
-  {
-    Node<Cell<K,V>> node = new Node(key.hashCode());
-
-    loop: while (true) {
-      node.value = null;
-      Content content = this.content;
-      Path<Node<Cell<K,V>>> path = content.set.find(node);
-      for (Cell<K,V> cell = path.value().value;
-           cell != null;
-           cell = cell.next)
-      {
-        if (key.equals(cell.key)) {
-          if (! condition.remove(cell.value, oldValue)) {
-            return cell;
+  // returns the value removed, or null if nothing was removed
+  private V remove(Object key, RemoveCondition condition, Object oldValue) {
+    int hash = spread(key.hashCode());
+    Node<K,V>[] table = this.table;
+
+    while (true) {
+      int index = hash & (table.length - 1);
+      Node<K,V> first = tabAt(table, index);
+      if (first == null) {
+        return null;
+      } else if (first.hash == Moved) {
+        table = ((ForwardingNode<K,V>) first).nextTable;
+      } else {
+        V v = null;
+        synchronized (first) {
+          if (tabAt(table, index) != first) {
+            continue;
           }
-          
-          Cell<K,V> start = null;
-          Cell<K,V> last = null;
-          for (Cell<K,V> cell2 = path.value().value;
-               cell2 != cell;
-               cell2 = cell2.next)
-          {
-            Cell<K,V> c = cell2.clone();
-            if (last == null) {
-              last = start = c;
-            } else {
-              last.next = c;
-              last = c;
+
+          Node<K,V> previous = null;
+          for (Node<K,V> node = first; node != null; node = node.next) {
+            if (node.hash == hash && key.equals(node.key)) {
+              if (! condition.remove(node.value, oldValue)) {
+                return null;
+              }
+
+              v = node.value;
+              if (previous == null) {
+                setTabAt(table, index, node.next);
+              } else {
+                previous.next = node.next;
+              }
+              break;
             }
+            previous = node;
           }
+        }
 
-          if (last == null) {
-            start = last = cell.next;
-          } else {
-            last.next = cell.next;
-          }
+        if (v != null) {
+          addCount(-1, 0);
+        }
+        return v;
+      }
+    }
+  }
 
-          node.value = start;
-          if (unsafe.compareAndSwapObject
-              (this, Content, content, new Content
-               (start == null ? path.remove() : path.replaceWith(node),
-                content.size - 1)))
-          {
-            return cell;
-          } else {
-            continue loop;
+  public void clear() {
+    Node<K,V>[] table = this.table;
+    long removed = 0;
+    int index = 0;
+    while (index < table.length) {
+      Node<K,V> first = tabAt(table, index);
+      if (first == null) {
+        ++ index;
+      } else if (first.hash == Moved) {
+        table = ((ForwardingNode<K,V>) first).nextTable;
+        index = 0;
+      } else {
+        synchronized (first) {
+          if (tabAt(table, index) == first) {
+            for (Node<K,V> node = first; node != null; node = node.next) {
+              ++ removed;
+            }
+            setTabAt(table, index++, null);
           }
         }
       }
+    }
 
-      return null;
+    if (removed != 0) {
+      addCount(-removed, 0);
     }
   }
 
-  public void clear() {
-    content = Empty;
+  private CounterCell counterCell() {
+    return counterCells[System.identityHashCode(Thread.currentThread())
+                        & (CounterCellCount - 1)];
+  }
+
+  private long sumCount() {
+    long sum = baseCount;
+    for (int i = 0; i < CounterCellCount; ++i) {
+      sum += counterCells[i].value;
+    }
+    return sum;
+  }
+
+  private void addCount(long delta, int binCount) {
+    long base = baseCount;
+    if (! unsafe.compareAndSwapLong(this, BaseCount, base, base + delta)) {
+      CounterCell cell = counterCell();
+      long v;
+      do {
+        v = cell.value;
+      } while (! unsafe.compareAndSwapLong(cell, CellValue, v, v + delta));
+
+      // only pay for summing the cells if this put may have pushed a
+      // bin past one node:
+      if (binCount <= 1) {
+        return;
+      }
+    }
+
+    if (delta > 0) {
+      int threshold = sizeControl;
+      if (threshold > 0 && sumCount() >= threshold
+          && table.length < MaximumCapacity
+          && unsafe.compareAndSwapInt(this, SizeControl, threshold, -1))
+      {
+        resize();
+      }
+    }
+  }
+
+  private void resize() {
+    Node<K,V>[] table = this.table;
+    int n = table.length;
+    Node<K,V>[] nextTable = new Node[n << 1];
+    ForwardingNode<K,V> forward = new ForwardingNode(nextTable);
+
+    for (int index = n - 1; index >= 0;) {
+      Node<K,V> first = tabAt(table, index);
+      if (first == null) {
+        if (casTabAt(table, index, null, forward)) {
+          -- index;
+        }
+      } else {
+        synchronized (first) {
+          if (tabAt(table, index) != first) {
+            continue;
+          }
+
+          Node<K,V> low = null;
+          Node<K,V> high = null;
+          for (Node<K,V> node = first; node != null; node = node.next) {
+            if ((node.hash & n) == 0) {
+              low = new Node(node.hash, node.key, node.value, low);
+            } else {
+              high = new Node(node.hash, node.key, node.value, high);
+            }
+          }
+
+          setTabAt(nextTable, index, low);
+          setTabAt(nextTable, index + n, high);
+          setTabAt(table, index--, forward);
+        }
+      }
+    }
+
+    this.table = nextTable;
+    sizeControl = (n << 1) - (n >>> 1);
   }
 
   public Set<Map.Entry<K, V>> entrySet() {
@@ -307,12 +480,13 @@ public class ConcurrentHashMap<K,V>
     }
 
     public Map.Entry<K,V> find(Object key) {
-      return new MyEntry(ConcurrentHashMap.this.find(key));
+      Node<K,V> node = ConcurrentHashMap.this.find(key);
+      return node == null ? null : new MyEntry(node.key, node.value);
     }
 
     public Map.Entry<K,V> remove(Object key) {
-      return new MyEntry
-        (ConcurrentHashMap.this.remove(key, RemoveCondition.Always, null));
+      V v = ConcurrentHashMap.this.remove(key, RemoveCondition.Always, null);
+      return v == null ? null : new MyEntry((K) key, v);
     }
 
     public void clear() {
@@ -320,62 +494,44 @@ public class ConcurrentHashMap<K,V>
     }
 
     public Iterator<Map.Entry<K,V>> iterator() {
-      return new MyIterator(content);
+      return new MyIterator(table);
     }
   }
 
-  private static class Content<K,V> {
-    private final PersistentSet<Node<Cell<K,V>>> set;
-    private final int size;
-
-    public Content(PersistentSet<Node<Cell<K,V>>> set,
-                   int size)
-    {
-      this.set = set;
-      this.size = size;
-    }
-  }
-
-  private static class Cell<K,V> implements Cloneable {
+  private static class Node<K,V> {
+    public final int hash;
     public final K key;
-    public V value;
-    public Cell<K,V> next;
+    public volatile V value;
+    public volatile Node<K,V> next;
 
-    public Cell(K key, V value, Cell<K,V> next) {
+    public Node(int hash, K key, V value, Node<K,V> next) {
+      this.hash = hash;
       this.key = key;
       this.value = value;
       this.next = next;
     }
-
-    public Cell<K,V> clone() {
-      try {
-        return (Cell<K,V>) super.clone();
-      } catch (CloneNotSupportedException e) {
-        throw new AssertionError();
-      }
-    }
   }
 
-  private static class Node<T> implements Comparable<Node<T>> {
-    public final int key;
-    public T value;
+  private static class ForwardingNode<K,V> extends Node<K,V> {
+    public final Node<K,V>[] nextTable;
 
-    public Node(int key) {
-      this.key = key;
+    public ForwardingNode(Node<K,V>[] nextTable) {
+      super(Moved, null, null, null);
+      this.nextTable = nextTable;
     }
+  }
 
-    public int compareTo(Node<T> n) {
-      return key - n.key;
-    }
+  private static class CounterCell {
+    public volatile long value;
   }
 
   private class MyEntry implements Map.Entry<K,V> {
     private final K key;
     private V value;
-    
-    public MyEntry(Cell<K,V> cell) {
-      key = cell.key;
-      value = cell.value;
+
+    public MyEntry(K key, V value) {
+      this.key = key;
+      this.value = value;
     }
 
     public K getKey() {
@@ -387,49 +543,71 @@ public class ConcurrentHashMap<K,V>
     }
 
     public V setValue(V value) {
-      V v = value;
+      V v = this.value;
       this.value = value;
       put(key, value);
       return v;
     }
   }
 
+  // Walks the bins of a table, following forwarding nodes into the
+  // tables they point to.  Bin i of a table of length n becomes bins i
+  // and i + n of the next table, so we visit both of those instead.
   private class MyIterator implements Iterator<Map.Entry<K, V>> {
-    private final Content<K,V> content;
-    private final Iterator<Node<Cell<K, V>>> iterator;
-    private Cell<K, V> currentCell;
-    private Cell<K, V> nextCell;
-
-    public MyIterator(Content<K,V> content) {
-      this.content = content;
-      this.iterator = content.set.iterator();
+    private final ArrayList<Object> pending = new ArrayList();
+    private Node<K,V>[] table;
+    private int index;
+    private int end;
+    private Node<K, V> currentNode;
+    private Node<K, V> nextNode;
+
+    public MyIterator(Node<K,V>[] table) {
+      this.table = table;
+      this.end = table.length;
       hasNext();
     }
 
     public Map.Entry<K, V> next() {
       if (hasNext()) {
-        currentCell = nextCell;
+        currentNode = nextNode;
 
-        nextCell = nextCell.next;
+        nextNode = nextNode.next;
 
-        return new MyEntry(currentCell);
+        return new MyEntry(currentNode.key, currentNode.value);
       } else {
         throw new NoSuchElementException();
       }
     }
 
     public boolean hasNext() {
-      if (nextCell == null && iterator.hasNext()) {
-        nextCell = iterator.next().value;
+      while (nextNode == null) {
+        if (index < end) {
+          Node<K,V> node = tabAt(table, index++);
+          if (node != null && node.hash == Moved) {
+            pending.add(((ForwardingNode<K,V>) node).nextTable);
+            pending.add(index - 1 + table.length);
+            pending.add(((ForwardingNode<K,V>) node).nextTable);
+            pending.add(index - 1);
+          } else {
+            nextNode = node;
+          }
+        } else if (pending.size() > 0) {
+          int i = (Integer) pending.remove(pending.size() - 1);
+          table = (Node<K,V>[]) pending.remove(pending.size() - 1);
+          index = i;
+          end = i + 1;
+        } else {
+          return false;
+        }
       }
-      return nextCell != null;
+      return true;
     }
 
     public void remove() {
-      if (currentCell != null) {
+      if (currentNode != null) {
         ConcurrentHashMap.this.remove
-          (currentCell.key, RemoveCondition.Always, null);
-        currentCell = null;
+          (currentNode.key, RemoveCondition.Always, null);
+        currentNode = null;
       } else {
         throw new IllegalStateException();
       }
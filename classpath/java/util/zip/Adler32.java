@@ -0,0 +1,72 @@
+/* Copyright (c) 2008-2015, Avian Contributors
+
+   Permission to use, copy, modify, and/or distribute this software
+   for any purpose with or without fee is hereby granted, provided
+   that the above copyright notice and this permission notice appear
+   in all copies.
+
+   There is NO WARRANTY for this software.  See license.txt for
+   details. */
+
+package java.util.zip;
+
+import java.nio.ByteBuffer;
+
+public class Adler32 implements Checksum {
+  private static final int Base = 65521;
+
+  private int adler = 1;
+
+  public void reset() {
+    adler = 1;
+  }
+
+  public void update(int b) {
+    int low = ((adler & 0xFFFF) + (b & 0xFF)) % Base;
+    int high = ((adler >>> 16) + low) % Base;
+    adler = (high << 16) | low;
+  }
+
+  public void update(byte[] array, int offset, int length) {
+    if (offset < 0 || length < 0 || offset > array.length - length) {
+      throw new ArrayIndexOutOfBoundsException();
+    }
+
+    adler = updateBytes(adler, array, offset, length);
+  }
+
+  public void update(byte[] array) {
+    update(array, 0, array.length);
+  }
+
+  public void update(ByteBuffer buffer) {
+    int position = buffer.position();
+    int length = buffer.remaining();
+
+    if (buffer.isDirect()) {
+      adler = updateDirect(adler, buffer, position, length);
+    } else if (buffer.hasArray()) {
+      adler = updateBytes
+        (adler, buffer.array(), buffer.arrayOffset() + position, length);
+    } else {
+      byte[] chunk = new byte[Math.min(length, 8192)];
+      while (buffer.hasRemaining()) {
+        int n = Math.min(buffer.remaining(), chunk.length);
+        buffer.get(chunk, 0, n);
+        adler = updateBytes(adler, chunk, 0, n);
+      }
+    }
+
+    buffer.position(position + length);
+  }
+
+  public long getValue() {
+    return adler & 0xFFFFFFFFL;
+  }
+
+  private static native int updateBytes(int adler, byte[] array, int offset,
+                                        int length);
+
+  private static native int updateDirect(int adler, ByteBuffer buffer,
+                                         int offset, int length);
+}
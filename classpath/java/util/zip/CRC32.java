@@ -10,60 +10,78 @@
 
 package java.util.zip;
 
-public class CRC32 {
-  private static final int Polynomial = 0x04C11DB7;
-  private static final int Width = 32;
-  private static final int Top = 1 << (Width - 1);
-  private static final int InitialRemainder = 0xFFFFFFFF;
-  private static final long ResultXor = 0xFFFFFFFFL;
+import java.nio.ByteBuffer;
 
+public class CRC32 implements Checksum {
+  private static final int Polynomial = 0xEDB88320; // reflected 0x04C11DB7
+
+  // used for single bytes only; anything longer goes to zlib, which
+  // processes several bytes per step:
   private static final int[] table = new int[256];
 
   static {
     for (int dividend = 0; dividend < 256; ++ dividend) {
-      int remainder = dividend << (Width - 8);
+      int remainder = dividend;
       for (int bit = 8; bit > 0; --bit) {
-        remainder = ((remainder & Top) != 0)
-          ? (remainder << 1) ^ Polynomial
-          : (remainder << 1);
+        remainder = ((remainder & 1) != 0)
+          ? (remainder >>> 1) ^ Polynomial
+          : (remainder >>> 1);
       }
       table[dividend] = remainder;
     }
   }
 
-  private int remainder = InitialRemainder;
+  private int crc;
 
   public void reset() {
-    remainder = InitialRemainder;
+    crc = 0;
   }
 
   public void update(int b) {
-    remainder = table[reflect(b, 8) ^ (remainder >>> (Width - 8))]
-      ^ (remainder << 8);
+    int remainder = ~crc;
+    crc = ~(table[(remainder ^ b) & 0xFF] ^ (remainder >>> 8));
   }
 
   public void update(byte[] array, int offset, int length) {
-    for (int i = 0; i < length; ++i) {
-      update(array[offset + i] & 0xFF);
+    if (offset < 0 || length < 0 || offset > array.length - length) {
+      throw new ArrayIndexOutOfBoundsException();
     }
+
+    crc = updateBytes(crc, array, offset, length);
   }
 
   public void update(byte[] array) {
     update(array, 0, array.length);
   }
 
-  public long getValue() {
-    return (reflect(remainder, Width) ^ ResultXor) & 0xFFFFFFFFL;
-  }
+  public void update(ByteBuffer buffer) {
+    int position = buffer.position();
+    int length = buffer.remaining();
 
-  private static int reflect(int x, int n) {
-    int reflection = 0;
-    for (int i = 0; i < n; ++i) {
-      if ((x & 1) != 0) {
-        reflection |= (1 << ((n - 1) - i));
+    if (buffer.isDirect()) {
+      crc = updateDirect(crc, buffer, position, length);
+    } else if (buffer.hasArray()) {
+      crc = updateBytes
+        (crc, buffer.array(), buffer.arrayOffset() + position, length);
+    } else {
+      byte[] chunk = new byte[Math.min(length, 8192)];
+      while (buffer.hasRemaining()) {
+        int n = Math.min(buffer.remaining(), chunk.length);
+        buffer.get(chunk, 0, n);
+        crc = updateBytes(crc, chunk, 0, n);
       }
-      x = (x >>> 1);
     }
-    return reflection;
+
+    buffer.position(position + length);
   }
+
+  public long getValue() {
+    return crc & 0xFFFFFFFFL;
+  }
+
+  private static native int updateBytes(int crc, byte[] array, int offset,
+                                        int length);
+
+  private static native int updateDirect(int crc, ByteBuffer buffer,
+                                         int offset, int length);
 }
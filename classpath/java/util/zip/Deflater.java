@@ -10,6 +10,8 @@
 
 package java.util.zip;
 
+import java.nio.ByteBuffer;
+
 public class Deflater {
   private static final int DEFAULT_LEVEL = 6; // default compression level (6 is default for gzip)
   private static final int Z_OK = 0;
@@ -22,12 +24,16 @@ public class Deflater {
 
   private long peer;
   private byte[] input;
+  // the buffer passed to setInput(ByteBuffer), if any, whose position
+  // we advance as we consume it.  If it is direct, input is null:
+  private ByteBuffer inputBuffer;
   private int offset;
   private int length;
   private boolean needDictionary;
   private boolean finished;
   private final boolean nowrap;
   private boolean finish;
+  private final int[] results = new int[3];
 
   public Deflater(int level, boolean nowrap) {
     this.nowrap = nowrap;
@@ -80,15 +86,31 @@ public class Deflater {
   }
 
   public void setInput(byte[] input, int offset, int length) {
+    Inflater.checkBounds(input, offset, length);
+
     this.input = input;
+    this.inputBuffer = null;
     this.offset = offset;
     this.length = length;
   }
 
+  public void setInput(ByteBuffer input) {
+    if (input.isDirect()) {
+      this.input = null;
+      this.offset = input.position();
+    } else {
+      this.input = input.array();
+      this.offset = input.arrayOffset() + input.position();
+    }
+    this.inputBuffer = input;
+    this.length = input.remaining();
+  }
+
   public void reset() {
     dispose();
     peer = make(nowrap, DEFAULT_LEVEL);
     input = null;
+    inputBuffer = null;
     offset = length = 0;
     finish = false;
     needDictionary = finished = false;
@@ -99,6 +121,29 @@ public class Deflater {
   }
 
   public int deflate(byte[] output, int offset, int length) {
+    Inflater.checkBounds(output, offset, length);
+
+    return deflate(output, null, offset, length);
+  }
+
+  public int deflate(ByteBuffer output) {
+    int position = output.position();
+    int count;
+    if (output.isDirect()) {
+      count = deflate(null, output, position, output.remaining());
+    } else {
+      count = deflate(output.array(), null, output.arrayOffset() + position,
+                      output.remaining());
+    }
+    output.position(position + count);
+    return count;
+  }
+
+  // Exactly one of outputArray and outputBuffer is non-null, and
+  // likewise for input and the direct input buffer we pass along:
+  private int deflate(byte[] outputArray, ByteBuffer outputBuffer,
+                      int offset, int length)
+  {
     final int zlibResult = 0;
     final int inputCount = 1;
     final int outputCount = 2;
@@ -107,14 +152,14 @@ public class Deflater {
       throw new IllegalStateException();      
     }
 
-    if (input == null || output == null) {
+    if (input == null && inputBuffer == null) {
       throw new NullPointerException();
     }
 
-    int[] results = new int[3];
     deflate(peer, 
-            input, this.offset, this.length,
-            output, offset, length, finish, results);
+            input, input == null ? inputBuffer : null,
+            this.offset, this.length,
+            outputArray, outputBuffer, offset, length, finish, results);
 
     if (results[zlibResult] < 0) {
       throw new AssertionError();
@@ -132,6 +177,9 @@ public class Deflater {
 
     this.offset += results[inputCount];
     this.length -= results[inputCount];
+    if (inputBuffer != null) {
+      inputBuffer.position(inputBuffer.position() + results[inputCount]);
+    }
     
     return results[outputCount];
   }
@@ -142,8 +190,9 @@ public class Deflater {
 
   private static native void deflate
     (long peer,
-     byte[] input, int inputOffset, int inputLength,
-     byte[] output, int outputOffset, int outputLength,
+     byte[] input, ByteBuffer directInput, int inputOffset, int inputLength,
+     byte[] output, ByteBuffer directOutput, int outputOffset,
+     int outputLength,
      boolean finish,
      int[] results);
 
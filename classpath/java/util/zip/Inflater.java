@@ -10,6 +10,8 @@
 
 package java.util.zip;
 
+import java.nio.ByteBuffer;
+
 public class Inflater {
   private static final int Z_OK = 0;
   private static final int Z_STREAM_END = 1;
@@ -21,11 +23,15 @@ public class Inflater {
 
   private long peer;
   private byte[] input;
+  // the buffer passed to setInput(ByteBuffer), if any, whose position
+  // we advance as we consume it.  If it is direct, input is null:
+  private ByteBuffer inputBuffer;
   private int offset;
   private int length;
   private boolean needDictionary;
   private boolean finished;
   private final boolean nowrap;
+  private final int[] results = new int[3];
 
   public Inflater(boolean nowrap) {
     this.nowrap = nowrap;
@@ -44,6 +50,14 @@ public class Inflater {
 
   private static native long make(boolean nowrap);
 
+  // the natives may work on large arrays in place, in which case they
+  // can't check these for us:
+  static void checkBounds(byte[] array, int offset, int length) {
+    if (offset < 0 || length < 0 || offset > array.length - length) {
+      throw new ArrayIndexOutOfBoundsException();
+    }
+  }
+
   public boolean finished() {
     return finished;
   }
@@ -65,15 +79,31 @@ public class Inflater {
   }
 
   public void setInput(byte[] input, int offset, int length) {
+    checkBounds(input, offset, length);
+
     this.input = input;
+    this.inputBuffer = null;
     this.offset = offset;
     this.length = length;
   }
 
+  public void setInput(ByteBuffer input) {
+    if (input.isDirect()) {
+      this.input = null;
+      this.offset = input.position();
+    } else {
+      this.input = input.array();
+      this.offset = input.arrayOffset() + input.position();
+    }
+    this.inputBuffer = input;
+    this.length = input.remaining();
+  }
+
   public void reset() {
     dispose();
     peer = make(nowrap);
     input = null;
+    inputBuffer = null;
     offset = length = 0;
     needDictionary = finished = false;
   }
@@ -84,6 +114,30 @@ public class Inflater {
 
   public int inflate(byte[] output, int offset, int length)
     throws DataFormatException
+  {
+    checkBounds(output, offset, length);
+
+    return inflate(output, null, offset, length);
+  }
+
+  public int inflate(ByteBuffer output) throws DataFormatException {
+    int position = output.position();
+    int count;
+    if (output.isDirect()) {
+      count = inflate(null, output, position, output.remaining());
+    } else {
+      count = inflate(output.array(), null, output.arrayOffset() + position,
+                      output.remaining());
+    }
+    output.position(position + count);
+    return count;
+  }
+
+  // Exactly one of outputArray and outputBuffer is non-null, and
+  // likewise for input and the direct input buffer we pass along:
+  private int inflate(byte[] outputArray, ByteBuffer outputBuffer,
+                      int offset, int length)
+    throws DataFormatException
   {
     final int zlibResult = 0;
     final int inputCount = 1;
@@ -93,13 +147,13 @@ public class Inflater {
       throw new IllegalStateException();      
     }
 
-    if (input == null || output == null) {
+    if (input == null && inputBuffer == null) {
       throw new NullPointerException();
     }
 
-    int[] results = new int[3];
-    inflate(peer, input, this.offset, this.length,
-            output, offset, length, results);
+    inflate(peer, input, input == null ? inputBuffer : null,
+            this.offset, this.length,
+            outputArray, outputBuffer, offset, length, results);
 
     if (results[zlibResult] < 0) {
       throw new DataFormatException();
@@ -117,14 +171,18 @@ public class Inflater {
 
     this.offset += results[inputCount];
     this.length -= results[inputCount];
+    if (inputBuffer != null) {
+      inputBuffer.position(inputBuffer.position() + results[inputCount]);
+    }
     
     return results[outputCount];
   }
 
   private static native void inflate
     (long peer,
-     byte[] input, int inputOffset, int inputLength,
-     byte[] output, int outputOffset, int outputLength,
+     byte[] input, ByteBuffer directInput, int inputOffset, int inputLength,
+     byte[] output, ByteBuffer directOutput, int outputOffset,
+     int outputLength,
      int[] results);
 
   public void end() {
@@ -124,4 +124,81 @@ inline void* allocate(JNIEnv* e, unsigned size)
   return p;
 }
 
+// Gives native code access to bytes [offset, offset + length) of a Java
+// byte array for the duration of a system call or the like.
+//
+// GetPrimitiveArrayCritical only hands out the array itself if the VM
+// has fixed it in place; otherwise it copies the whole array out, and
+// unless released with JNI_ABORT, the whole array back, however little
+// of it we need.  We can't tell from here which we'll get, so we only
+// ask for critical access when the range covers most of the array,
+// where even the copy costs little more than copying the range would.
+// For anything else we copy just the range, into a buffer on the stack
+// if it fits there.
+class ByteArrayRange {
+ public:
+  static const jint BufferSize = 8 * 1024;
+
+  ByteArrayRange(JNIEnv* e, jbyteArray array, jint offset, jint length)
+      : e(e),
+        array(array),
+        offset(offset),
+        length(length),
+        critical(false),
+        data(0),
+        heap(0)
+  {
+  }
+
+  // Returns a pointer to the first byte of the range, which holds its
+  // contents if load is true, or null if we couldn't allocate a buffer
+  // (in which case an OutOfMemoryError is pending).
+  jbyte* acquire(bool load)
+  {
+    jsize arrayLength = e->GetArrayLength(array);
+    critical = length > BufferSize
+               and length >= arrayLength - (arrayLength / 4);
+    if (critical) {
+      data = static_cast<jbyte*>(e->GetPrimitiveArrayCritical(array, 0));
+      return data + offset;
+    } else if (length <= BufferSize) {
+      data = buffer;
+    } else {
+      data = heap = static_cast<jbyte*>(allocate(e, length));
+      if (data == 0) {
+        return 0;
+      }
+    }
+
+    if (load and length) {
+      e->GetByteArrayRegion(array, offset, length, data);
+    }
+    return data;
+  }
+
+  // Gives up the pointer returned by acquire, storing the first count
+  // bytes of the range back into the array.
+  void release(jint count)
+  {
+    if (critical) {
+      e->ReleasePrimitiveArrayCritical(array, data, count ? 0 : JNI_ABORT);
+    } else {
+      if (count > 0) {
+        e->SetByteArrayRegion(array, offset, count, data);
+      }
+      free(heap);
+    }
+  }
+
+ private:
+  JNIEnv* e;
+  jbyteArray array;
+  jint offset;
+  jint length;
+  bool critical;
+  jbyte* data;
+  jbyte* heap;
+  jbyte buffer[BufferSize];
+};
+
 #endif  // JNI_UTIL
@@ -83,6 +83,21 @@ class Compiler {
   static const unsigned TailJump = 1 << 2;
   static const unsigned LongJumpOrCall = 1 << 3;
 
+  // How the register allocator chooses a register to take from another
+  // value when every suitable one is occupied and equally cheap to
+  // steal: the first one found, or the one whose value is next read in
+  // the fewest loops (see addLoop), and of those, furthest ahead, so
+  // that the reload lands where it runs least often.
+  enum EvictionPolicy { EvictFirst, EvictFurthestUse };
+
+  class Statistics {
+   public:
+    // moves the register allocator made from registers to the stack
+    // frame, and back again:
+    unsigned spills;
+    unsigned reloads;
+  };
+
   class State {
   };
 
@@ -94,6 +109,13 @@ class Compiler {
                     unsigned localFootprint,
                     unsigned alignedFrameSize) = 0;
 
+  virtual void setEvictionPolicy(EvictionPolicy policy) = 0;
+
+  // Tells the compiler that the logical instructions from start to end
+  // inclusive form the body of a loop.  Loops may nest, and must all
+  // be added after init and before the code they span is compiled.
+  virtual void addLoop(unsigned start, unsigned end) = 0;
+
   virtual void extendLogicalCode(unsigned more) = 0;
 
   virtual void visitLogicalIp(unsigned logicalIp) = 0;
@@ -106,6 +128,8 @@ class Compiler {
 
   virtual ir::Value* constant(int64_t value, ir::Type type) = 0;
   virtual ir::Value* promiseConstant(Promise* value, ir::Type type) = 0;
+  // Returns true if value is a resolved constant, storing it in result.
+  virtual bool constantValue(ir::Value* value, int64_t* result) = 0;
   virtual ir::Value* address(ir::Type type, Promise* address) = 0;
   virtual ir::Value* memory(ir::Value* base,
                             ir::Type type,
@@ -185,6 +209,8 @@ class Compiler {
   virtual unsigned poolSize() = 0;
   virtual void write() = 0;
 
+  virtual Statistics statistics() = 0;
+
   virtual void dispose() = 0;
 };
 
@@ -0,0 +1,106 @@
+/* Copyright (c) 2008-2015, Avian Contributors
+
+   Permission to use, copy, modify, and/or distribute this software
+   for any purpose with or without fee is hereby granted, provided
+   that the above copyright notice and this permission notice appear
+   in all copies.
+
+   There is NO WARRANTY for this software.  See license.txt for
+   details. */
+
+#ifndef AVIAN_GC_H
+#define AVIAN_GC_H
+
+#include <stdint.h>
+
+/* Garbage collection statistics for programs which embed the VM.
+   These mirror avian.Machine.collectionStatistics and
+   collectionRecords.  Each function takes the JavaVM* produced by
+   JNI_CreateJavaVM and may be called from any thread, whether or not
+   it is attached to the VM. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+  AVIAN_MINOR_COLLECTION,
+  AVIAN_MAJOR_COLLECTION
+};
+
+/* why each collection was the type it was: either because the VM
+   asked for that type, or because the heap chose a major collection
+   instead, since memory was low, the old generation was much bigger
+   than what it held or too small for what might be promoted to it,
+   or old fixed (i.e. large) objects had outgrown their ceiling: */
+enum {
+  AVIAN_REQUESTED_CAUSE,
+  AVIAN_LOW_MEMORY_CAUSE,
+  AVIAN_OVERSIZED_GEN2_CAUSE,
+  AVIAN_UNDERSIZED_GEN2_CAUSE,
+  AVIAN_FIXIE_CEILING_CAUSE,
+  AVIAN_CAUSE_COUNT
+};
+
+/* the VM remembers this many of its most recent collections: */
+#define AVIAN_COLLECTION_RECORD_COUNT 64
+
+/* sizes are in bytes and times in milliseconds throughout: */
+struct AvianCollectionStatistics {
+  /* indexed by AVIAN_MINOR_COLLECTION or AVIAN_MAJOR_COLLECTION: */
+  uint32_t collections[2];
+  int64_t totalMilliseconds[2];
+  int64_t maxMilliseconds[2];
+
+  /* indexed by cause: */
+  uint32_t causes[AVIAN_CAUSE_COUNT];
+
+  uint64_t footprint;
+  uint64_t peakFootprint;
+  uint64_t promoted;
+};
+
+struct AvianCollectionRecord {
+  /* 1 for the first collection, 2 for the next, and so on: */
+  uint64_t sequence;
+  int32_t type;
+  int32_t cause;
+  int64_t start;
+  int64_t milliseconds;
+
+  /* bytes of objects allocated since the previous collection, and in
+     use in each generation before and after this one: */
+  uint64_t incoming;
+  uint64_t gen1Before;
+  uint64_t gen1After;
+  uint64_t gen2Before;
+  uint64_t gen2After;
+
+  /* bytes of young and old fixed objects which survived: */
+  uint64_t untenuredFixies;
+  uint64_t tenuredFixies;
+
+  /* bytes of objects promoted from gen1 to gen2: */
+  uint64_t promoted;
+
+  /* bytes allocated by the heap before and after: */
+  uint64_t footprintBefore;
+  uint64_t footprintAfter;
+};
+
+void avianCollectionStatistics(void* vm,
+                               struct AvianCollectionStatistics* statistics);
+
+/* copies the records of up to count collections with sequence numbers
+   greater than since into records, oldest first, and returns how many
+   it copied: */
+unsigned avianCollectionRecords(void* vm,
+                                uint64_t since,
+                                struct AvianCollectionRecord* records,
+                                unsigned count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AVIAN_GC_H */
@@ -22,10 +22,28 @@ const unsigned TenureThreshold = 3;
 
 const unsigned FixieTenureThreshold = TenureThreshold + 2;
 
+// fixed objects at least this big are allocated in the large object
+// space unless the heap is told otherwise (see makeHeap):
+const unsigned DefaultLargeObjectThresholdInBytes = 256 * 1024;
+
 class Heap : public avian::util::Allocator {
  public:
   enum CollectionType { MinorCollection, MajorCollection };
 
+  // why a collection was the type it was: either because the client
+  // asked for that type, or because the heap chose a major collection
+  // instead of the minor one requested, since memory was low, gen2
+  // was much bigger than what it held or too small for what might be
+  // tenured, or tenured fixed objects had outgrown their ceiling:
+  enum CollectionCause {
+    RequestedCause,
+    LowMemoryCause,
+    OversizedGen2Cause,
+    UndersizedGen2Cause,
+    FixieCeilingCause,
+    CauseCount
+  };
+
   enum Status { Null, Reachable, Unreachable, Tenured };
 
   class Visitor {
@@ -46,24 +64,97 @@ class Heap : public avian::util::Allocator {
     virtual unsigned sizeInWords(void*) = 0;
     virtual unsigned copiedSizeInWords(void*) = 0;
     virtual void copy(void*, void*) = 0;
+    // as above, but for an original whose first word has been
+    // overwritten by a collector thread copying it in parallel with
+    // others, which must be read from header instead:
+    virtual unsigned copiedSizeInWords(void* original, uintptr_t header) = 0;
+    virtual void copy(void* original, void* copy, uintptr_t header) = 0;
+    // called when compaction slides an object whose identity hash has
+    // been taken: moved is a verbatim copy of original's first
+    // sizeInWords words, with room for one more:
+    virtual void extend(void* original, void* moved, unsigned sizeInWords)
+        = 0;
     virtual void walk(void*, Walker*) = 0;
   };
 
+  class Statistics {
+   public:
+    // indexed by CollectionType:
+    unsigned collections[2];
+    int64_t totalMilliseconds[2];
+    int64_t maxMilliseconds[2];
+
+    // bytes currently allocated by the heap, and the most it has ever
+    // had allocated at once:
+    uint64_t footprint;
+    uint64_t peakFootprint;
+
+    // collections so far for each CollectionCause, and bytes of
+    // objects copied from gen1 to gen2 in all of them:
+    unsigned causes[CauseCount];
+    uint64_t promoted;
+  };
+
+  // what happened in a single collection.  The heap keeps records of
+  // the last RecordCount collections (see records):
+  class Record {
+   public:
+    // 1 for the first collection, 2 for the next, and so on:
+    uint64_t sequence;
+    CollectionType type;
+    CollectionCause cause;
+
+    // when the collection started, according to System::now, and how
+    // long it took, both in milliseconds:
+    int64_t start;
+    int64_t milliseconds;
+
+    // bytes of objects allocated by the client since the previous
+    // collection, and in use in each generation before and after:
+    uint64_t incoming;
+    uint64_t gen1Before;
+    uint64_t gen1After;
+    uint64_t gen2Before;
+    uint64_t gen2After;
+
+    // bytes of untenured and tenured fixed objects which survived:
+    uint64_t untenuredFixies;
+    uint64_t tenuredFixies;
+
+    // bytes of objects copied from gen1 to gen2:
+    uint64_t promoted;
+
+    // bytes allocated by the heap before and after:
+    uint64_t footprintBefore;
+    uint64_t footprintAfter;
+  };
+
+  static const unsigned RecordCount = 64;
+
   virtual void setClient(Client* client) = 0;
   virtual void setImmortalHeap(uintptr_t* start, unsigned sizeInWords) = 0;
-  virtual unsigned remaining() = 0;
-  virtual unsigned limit() = 0;
-  virtual bool limitExceeded(int pendingAllocation = 0) = 0;
+  // sizes in bytes are 64 bits wide so that the heap may be larger
+  // than 4GB on a 64-bit system:
+  virtual uint64_t remaining() = 0;
+  virtual uint64_t limit() = 0;
+  virtual bool limitExceeded(int64_t pendingAllocation = 0) = 0;
   virtual void collect(CollectionType type,
                        unsigned footprint,
-                       int pendingAllocation) = 0;
-  virtual unsigned fixedFootprint(unsigned sizeInWords, bool objectMask) = 0;
+                       int64_t pendingAllocation) = 0;
+  virtual uint64_t fixedFootprint(unsigned sizeInWords, bool objectMask) = 0;
   virtual void* allocateFixed(avian::util::Alloc* allocator,
                               unsigned sizeInWords,
                               bool objectMask) = 0;
   virtual void* allocateImmortalFixed(avian::util::Alloc* allocator,
                                       unsigned sizeInWords,
                                       bool objectMask) = 0;
+  // large objects are fixed objects which get pages of their own,
+  // mapped fresh (and thus already zeroed) for each one and unmapped
+  // as soon as it dies.  Like other fixed objects, they are marked in
+  // place and never copied.  tryAllocateLarge returns null if the
+  // heap limit would be exceeded or the system is out of pages:
+  virtual unsigned largeObjectThreshold() = 0;
+  virtual void* tryAllocateLarge(unsigned sizeInWords, bool objectMask) = 0;
   virtual void mark(void* p, unsigned offset, unsigned count) = 0;
   virtual void pad(void* p) = 0;
   virtual void* follow(void* p) = 0;
@@ -77,11 +168,34 @@ class Heap : public avian::util::Allocator {
   virtual void postVisit() = 0;
   virtual Status status(void* p) = 0;
   virtual CollectionType collectionType() = 0;
+  virtual void statistics(Statistics* statistics) = 0;
+  // copies the records of up to count collections with sequence
+  // numbers greater than since into records, oldest first, and
+  // returns how many it copied.  This may be called from any thread,
+  // even during a collection:
+  virtual unsigned records(uint64_t since, Record* records, unsigned count)
+      = 0;
   virtual void disposeFixies() = 0;
   virtual void dispose() = 0;
 };
 
-Heap* makeHeap(System* system, unsigned limit);
+// collectorCount is the number of threads to use for minor
+// collections, including the thread which triggers the collection;
+// values greater than one enable parallel copying where supported.
+// If compactGen2 is true, major collections mark gen2 and slide it
+// down in place rather than copying it to a new segment.  If
+// concurrentGen2 is true (which implies compactGen2), gen2 is marked
+// by a background thread while the client runs, so that the pause
+// for a major collection need only finish marking before compacting.
+// largeObjectThreshold is the size in bytes at which fixed objects go
+// to the large object space instead of the client's allocator:
+Heap* makeHeap(System* system,
+               uint64_t limit,
+               unsigned collectorCount = 1,
+               bool compactGen2 = false,
+               bool concurrentGen2 = false,
+               unsigned largeObjectThreshold
+               = DefaultLargeObjectThresholdInBytes);
 
 }  // namespace vm
 
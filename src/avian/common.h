@@ -323,52 +323,52 @@ inline bool fitsInInt32(int64_t v)
   return v == static_cast<int32_t>(v);
 }
 template <class T>
-inline unsigned wordOf(unsigned i)
+inline uintptr_t wordOf(uintptr_t i)
 {
   return i / (sizeof(T) * 8);
 }
 
-inline unsigned wordOf(unsigned i)
+inline uintptr_t wordOf(uintptr_t i)
 {
   return wordOf<uintptr_t>(i);
 }
 
 template <class T>
-inline unsigned bitOf(unsigned i)
+inline unsigned bitOf(uintptr_t i)
 {
   return i % (sizeof(T) * 8);
 }
 
-inline unsigned bitOf(unsigned i)
+inline unsigned bitOf(uintptr_t i)
 {
   return bitOf<uintptr_t>(i);
 }
 
 template <class T>
-inline unsigned indexOf(unsigned word, unsigned bit)
+inline uintptr_t indexOf(uintptr_t word, unsigned bit)
 {
   return (word * (sizeof(T) * 8)) + bit;
 }
 
-inline unsigned indexOf(unsigned word, unsigned bit)
+inline uintptr_t indexOf(uintptr_t word, unsigned bit)
 {
   return indexOf<uintptr_t>(word, bit);
 }
 
 template <class T>
-inline void markBit(T* map, unsigned i)
+inline void markBit(T* map, uintptr_t i)
 {
   map[wordOf<T>(i)] |= static_cast<T>(1) << bitOf<T>(i);
 }
 
 template <class T>
-inline void clearBit(T* map, unsigned i)
+inline void clearBit(T* map, uintptr_t i)
 {
   map[wordOf<T>(i)] &= ~(static_cast<T>(1) << bitOf<T>(i));
 }
 
 template <class T>
-inline unsigned getBit(T* map, unsigned i)
+inline unsigned getBit(T* map, uintptr_t i)
 {
   return (map[wordOf<T>(i)] & (static_cast<T>(1) << bitOf<T>(i)))
          >> bitOf<T>(i);
@@ -379,30 +379,33 @@ inline unsigned getBit(T* map, unsigned i)
 // a time:
 
 template <class T>
-inline void clearBits(T* map, unsigned bitsPerRecord, unsigned index)
+inline void clearBits(T* map, unsigned bitsPerRecord, uintptr_t index)
 {
-  for (unsigned i = index, limit = index + bitsPerRecord; i < limit; ++i) {
+  for (uintptr_t i = index, limit = index + bitsPerRecord; i < limit; ++i) {
     clearBit<T>(map, i);
   }
 }
 
 template <class T>
-inline void setBits(T* map, unsigned bitsPerRecord, int index, unsigned v)
+inline void setBits(T* map,
+                    unsigned bitsPerRecord,
+                    uintptr_t index,
+                    unsigned v)
 {
-  for (int i = index + bitsPerRecord - 1; i >= index; --i) {
+  for (uintptr_t i = index + bitsPerRecord; i > index; --i) {
     if (v & 1)
-      markBit<T>(map, i);
+      markBit<T>(map, i - 1);
     else
-      clearBit<T>(map, i);
+      clearBit<T>(map, i - 1);
     v >>= 1;
   }
 }
 
 template <class T>
-inline unsigned getBits(T* map, unsigned bitsPerRecord, unsigned index)
+inline unsigned getBits(T* map, unsigned bitsPerRecord, uintptr_t index)
 {
   unsigned v = 0;
-  for (unsigned i = index, limit = index + bitsPerRecord; i < limit; ++i) {
+  for (uintptr_t i = index, limit = index + bitsPerRecord; i < limit; ++i) {
     v <<= 1;
     v |= getBit<T>(map, i);
   }
@@ -21,6 +21,10 @@
 #define CLASSPATH_PROPERTY "java.class.path"
 #define JAVA_HOME_PROPERTY "java.home"
 #define REENTRANT_PROPERTY "avian.reentrant"
+#define GC_THREADS_PROPERTY "avian.gc.threads"
+#define GC_COMPACT_PROPERTY "avian.gc.compact"
+#define GC_CONCURRENT_PROPERTY "avian.gc.concurrent"
+#define GC_LARGE_OBJECT_THRESHOLD_PROPERTY "avian.gc.large.threshold"
 #define BOOTCLASSPATH_PREPEND_OPTION "bootclasspath/p"
 #define BOOTCLASSPATH_OPTION "bootclasspath"
 #define BOOTCLASSPATH_APPEND_OPTION "bootclasspath/a"
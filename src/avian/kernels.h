@@ -0,0 +1,78 @@
+/* Copyright (c) 2008-2015, Avian Contributors
+
+   Permission to use, copy, modify, and/or distribute this software
+   for any purpose with or without fee is hereby granted, provided
+   that the above copyright notice and this permission notice appear
+   in all copies.
+
+   There is NO WARRANTY for this software.  See license.txt for
+   details. */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "avian/machine.h"
+
+namespace vm {
+
+// Vectorized implementations of hot String and Arrays methods, shared
+// by the builtin natives the interpreter calls and the thunks the JIT
+// compiler calls in their place.  None of these allocate or throw, so
+// callers must check bounds first.
+//
+// The string kernels take character data as either a byte array or a
+// char array, as java.lang.String stores it, with offsets and lengths
+// counted in characters.  A byte is widened to a char just as
+// String.charAt does.
+
+bool charsEqual(Thread* t,
+                object a,
+                int32_t aOffset,
+                object b,
+                int32_t bOffset,
+                int32_t length);
+
+// returns the difference between the first pair of characters which
+// differ, or else the difference between the lengths:
+int32_t compareChars(Thread* t,
+                     object a,
+                     int32_t aOffset,
+                     int32_t aLength,
+                     object b,
+                     int32_t bOffset,
+                     int32_t bLength);
+
+// returns the same value String.hashCode is specified to:
+int32_t hashChars(Thread* t, object data, int32_t offset, int32_t length);
+
+// these return the index of the first match relative to offset, or -1
+// if there is none:
+int32_t indexOfChar(Thread* t,
+                    object data,
+                    int32_t offset,
+                    int32_t length,
+                    int32_t c);
+
+int32_t indexOfChars(Thread* t,
+                     object data,
+                     int32_t offset,
+                     int32_t length,
+                     object pattern,
+                     int32_t patternOffset,
+                     int32_t patternLength);
+
+// compares the first length elements of two arrays of the same
+// primitive type bit for bit:
+bool elementsEqual(Thread* t, object a, object b, int32_t length);
+
+// stores the low bits of value to each element of a primitive array
+// from start up to, but not including, stop:
+void fillElements(Thread* t,
+                  object array,
+                  int32_t start,
+                  int32_t stop,
+                  int64_t value);
+
+}  // namespace vm
+
+#endif  // KERNELS_H
@@ -139,18 +139,49 @@ const uintptr_t HashTakenMark = 1;
 const uintptr_t ExtendedMark = 2;
 const uintptr_t FixedMark = 3;
 
+// initial size of each thread-local heap; this also serves as the
+// threshold above which objects are allocated as fixed rather than
+// movable:
 const unsigned ThreadHeapSizeInBytes = 64 * 1024;
 const unsigned ThreadHeapSizeInWords = ThreadHeapSizeInBytes / BytesPerWord;
 
+// bounds within which each thread's heap is resized after a
+// collection according to how often it was refilled:
+const unsigned ThreadHeapMinimumSizeInWords = (16 * 1024) / BytesPerWord;
+const unsigned ThreadHeapMaximumSizeInWords = (512 * 1024) / BytesPerWord;
+
+// number of refills between collections at or above which a thread's
+// heap is doubled in size:
+const unsigned ThreadHeapGrowThreshold = 2;
+
 const unsigned ThreadBackupHeapSizeInBytes = 2 * 1024;
 const unsigned ThreadBackupHeapSizeInWords = ThreadBackupHeapSizeInBytes
                                              / BytesPerWord;
 
 const unsigned ThreadHeapPoolSize = 64;
 
+// total size of the thread-local heaps which may be handed out
+// between collections:
+const unsigned ThreadHeapPoolFootprintInWords = ThreadHeapPoolSize
+                                                * ThreadHeapSizeInWords;
+
+// number of slots in the machine-wide thin lock table (must be a
+// power of two):
+const unsigned ThinLockTableSize = 1024;
+
+// maximum number of distinct objects a thread may hold thin locks on
+// at once before falling back to inflated monitors:
+const unsigned ThinLockRecordCount = 8;
+
 const unsigned FixedFootprintThresholdInBytes = ThreadHeapPoolSize
                                                 * ThreadHeapSizeInBytes;
 
+// large objects (see Heap::largeObjectThreshold) cost nothing to keep
+// around besides the memory they occupy, so we allow a good deal more
+// of them to accumulate between collections than other fixed objects:
+const unsigned LargeFootprintThresholdInBytes
+    = 16 * FixedFootprintThresholdInBytes;
+
 // number of zombie threads which may accumulate before we force a GC
 // to clean them up:
 const unsigned ZombieCollectionThreshold = 16;
@@ -1014,7 +1045,8 @@ class Machine {
   enum AllocationType {
     MovableAllocation,
     FixedAllocation,
-    ImmortalAllocation
+    ImmortalAllocation,
+    LargeAllocation
   };
 
   Machine(System* system,
@@ -1056,7 +1088,8 @@ class Machine {
   unsigned activeCount;
   unsigned liveCount;
   unsigned daemonCount;
-  unsigned fixedFootprint;
+  uint64_t fixedFootprint;
+  uint64_t largeFootprint;
   unsigned stackSizeInBytes;
   System::Local* localThread;
   System::Monitor* stateLock;
@@ -1064,6 +1097,7 @@ class Machine {
   System::Monitor* classLock;
   System::Monitor* referenceLock;
   System::Monitor* shutdownLock;
+  System::Monitor* thinLockMonitor;
   System::Library* libraries;
   FILE* errorLog;
   BootImage* bootimage;
@@ -1081,8 +1115,11 @@ class Machine {
   bool alive;
   JavaVMVTable javaVMVTable;
   JNIEnvVTable jniEnvVTable;
+  uintptr_t lockTable[ThinLockTableSize];
   uintptr_t* heapPool[ThreadHeapPoolSize];
+  unsigned heapPoolSizes[ThreadHeapPoolSize];
   unsigned heapPoolIndex;
+  uintptr_t heapPoolFootprint;
   size_t bootimageSize;
 };
 
@@ -1298,6 +1335,16 @@ class Thread {
     void* stack;
   };
 
+  class LockRecord {
+   public:
+    Thread* owner;
+    object target;
+    uintptr_t* slot;
+    LockRecord* next;
+    unsigned depth;
+    bool contended;
+  };
+
   class Runnable : public System::Runnable {
    public:
     Runnable(Thread* t) : t(t)
@@ -1343,13 +1390,17 @@ class Thread {
   Thread* child;
   Thread* waitNext;
   State state;
-  unsigned criticalLevel;
   System::Thread* systemThread;
   System::Monitor* lock;
   GcThread* javaThread;
   GcThrowable* exception;
   unsigned heapIndex;
   unsigned heapOffset;
+  unsigned heapSizeInWords;
+  unsigned defaultHeapSizeInWords;
+  unsigned heapRefillCount;
+  uint64_t heapRefills;
+  uint64_t heapAllocatedWords;
   Protector* protector;
   ClassInitStack* classInitStack;
   LibraryLoadStack* libraryLoadStack;
@@ -1360,6 +1411,7 @@ class Thread {
   uintptr_t* heap;
   uintptr_t backupHeap[ThreadBackupHeapSizeInWords];
   unsigned backupHeapIndex;
+  LockRecord lockRecords[ThinLockRecordCount];
 
  private:
   unsigned flags;
@@ -1525,7 +1577,9 @@ inline void release(Thread* t, Reference* r)
   }
 }
 
-void collect(Thread* t, Heap::CollectionType type, int pendingAllocation = 0);
+void collect(Thread* t,
+             Heap::CollectionType type,
+             int64_t pendingAllocation = 0);
 
 void shutDown(Thread* t);
 
@@ -1617,7 +1671,7 @@ inline Aborter* getAborter(Thread* t)
 inline bool ensure(Thread* t, unsigned sizeInBytes)
 {
   if (t->heapIndex + ceilingDivide(sizeInBytes, BytesPerWord)
-      > ThreadHeapSizeInWords) {
+      > t->heapSizeInWords) {
     if (sizeInBytes <= ThreadBackupHeapSizeInBytes) {
       expect(t, (t->getFlags() & Thread::UseBackupHeapFlag) == 0);
 
@@ -1644,7 +1698,7 @@ inline object allocateSmall(Thread* t, unsigned sizeInBytes)
 {
   assertT(t,
           t->heapIndex + ceilingDivide(sizeInBytes, BytesPerWord)
-          <= ThreadHeapSizeInWords);
+          <= t->heapSizeInWords);
 
   object o = reinterpret_cast<object>(t->heap + t->heapIndex);
   t->heapIndex += ceilingDivide(sizeInBytes, BytesPerWord);
@@ -1655,11 +1709,14 @@ inline object allocate(Thread* t, unsigned sizeInBytes, bool objectMask)
 {
   stress(t);
 
-  if (UNLIKELY(t->heapIndex + ceilingDivide(sizeInBytes, BytesPerWord)
-               > ThreadHeapSizeInWords or t->m->exclusive)) {
+  // thread-local heaps may grow beyond ThreadHeapSizeInBytes, but
+  // anything bigger than that must still be allocated fixed (or
+  // large), so it always takes the slow path:
+  if (UNLIKELY(ceilingDivide(sizeInBytes, BytesPerWord) > ThreadHeapSizeInWords
+               or t->heapIndex + ceilingDivide(sizeInBytes, BytesPerWord)
+                  > t->heapSizeInWords or t->m->exclusive)) {
     return allocate2(t, sizeInBytes, objectMask);
   } else {
-    assertT(t, t->criticalLevel == 0);
     return allocateSmall(t, sizeInBytes);
   }
 }
@@ -2168,7 +2225,7 @@ inline uint32_t objectHash(Thread* t, object o)
   if (objectExtended(t, o)) {
     return extendedWord(t, o, baseSize(t, o, objectClass(t, o)));
   } else {
-    if (not objectFixed(t, o)) {
+    if (not(objectFixed(t, o) or hashTaken(t, o))) {
       markHashTaken(t, o);
     }
     return takeHash(t, o);
@@ -3086,6 +3143,129 @@ class ObjectMonitorResource {
 
 GcMonitor* objectMonitor(Thread* t, object o, bool createNew);
 
+// Objects are locked without allocating a monitor whenever possible:
+// a thread publishes one of its LockRecords in the machine-wide
+// lockTable slot chosen by the object's identity hash, and that's
+// all.  Records for distinct objects which hash to the same slot are
+// chained together, guarded by a spin lock in the low bit of the slot
+// which is only ever held for a few instructions.  We only inflate the
+// lock to a GcMonitor when another thread actually holds the object's
+// thin lock, the thread has run out of records, or someone waits on
+// the object.  Once an object has a monitor, every thread uses it, and
+// a thread acquiring a monitor waits for anybody still holding the
+// object's thin lock to release it (see acquireInflated).
+
+const uintptr_t ThinLockBusyMark = 1;
+
+inline Thread::LockRecord* thinLockRecord(Thread* t, object o)
+{
+  for (unsigned i = 0; i < ThinLockRecordCount; ++i) {
+    if (t->lockRecords[i].target == o) {
+      return t->lockRecords + i;
+    }
+  }
+  return 0;
+}
+
+inline uintptr_t* thinLockSlot(Thread* t, object o)
+{
+  return t->m->lockTable + (objectHash(t, o) & (ThinLockTableSize - 1));
+}
+
+// Locks the specified slot, returning the head of its chain.
+inline Thread::LockRecord* thinLockLockSlot(Thread* t, uintptr_t* slot)
+{
+  while (true) {
+    uintptr_t head = *slot;
+    if ((head & ThinLockBusyMark) == 0
+        and atomicCompareAndSwap(slot, head, head | ThinLockBusyMark)) {
+      return reinterpret_cast<Thread::LockRecord*>(head);
+    }
+
+    t->m->system->yield();
+  }
+}
+
+inline void thinLockUnlockSlot(uintptr_t* slot, Thread::LockRecord* head)
+{
+  storeStoreMemoryBarrier();
+
+  *slot = reinterpret_cast<uintptr_t>(head);
+}
+
+inline Thread::LockRecord* thinLockFind(Thread::LockRecord* head, object o)
+{
+  for (Thread::LockRecord* r = head; r; r = r->next) {
+    if (r->target == o) {
+      return r;
+    }
+  }
+  return 0;
+}
+
+inline bool thinLockHeldByOther(Thread* t, uintptr_t* slot, object o)
+{
+  Thread::LockRecord* head = thinLockLockSlot(t, slot);
+  Thread::LockRecord* r = thinLockFind(head, o);
+  thinLockUnlockSlot(slot, head);
+
+  return r and r->owner != t;
+}
+
+inline bool thinLockTryAcquire(Thread* t, uintptr_t* slot, object o)
+{
+  for (unsigned i = 0; i < ThinLockRecordCount; ++i) {
+    Thread::LockRecord* r = t->lockRecords + i;
+    if (r->target == 0) {
+      Thread::LockRecord* head = thinLockLockSlot(t, slot);
+
+      if (thinLockFind(head, o)) {
+        thinLockUnlockSlot(slot, head);
+        return false;
+      }
+
+      r->target = o;
+      r->slot = slot;
+      r->next = head;
+      r->depth = 1;
+      r->contended = false;
+
+      thinLockUnlockSlot(slot, r);
+      return true;
+    }
+  }
+  return false;
+}
+
+void thinLockNotify(Thread* t);
+
+inline void thinLockRelease(Thread* t, Thread::LockRecord* r)
+{
+  uintptr_t* slot = r->slot;
+  Thread::LockRecord* head = thinLockLockSlot(t, slot);
+
+  Thread::LockRecord** p = &head;
+  while (*p != r) {
+    p = &((*p)->next);
+  }
+  *p = r->next;
+
+  bool contended = r->contended;
+  r->target = 0;
+  r->slot = 0;
+  r->next = 0;
+
+  thinLockUnlockSlot(slot, head);
+
+  if (UNLIKELY(contended)) {
+    thinLockNotify(t);
+  }
+}
+
+void acquireInflated(Thread* t, object o, GcMonitor* m);
+
+GcMonitor* inflate(Thread* t, object o, Thread::LockRecord* r);
+
 inline void acquire(Thread* t, object o)
 {
   unsigned hash;
@@ -3093,13 +3273,33 @@ inline void acquire(Thread* t, object o)
     hash = objectHash(t, o);
   }
 
-  GcMonitor* m = objectMonitor(t, o, true);
+  Thread::LockRecord* r = thinLockRecord(t, o);
+  if (r) {
+    ++r->depth;
+    return;
+  }
 
-  if (DebugMonitors) {
-    fprintf(stderr, "thread %p acquires %p for %x\n", t, m, hash);
+  uintptr_t* slot = thinLockSlot(t, o);
+
+  GcMonitor* m = objectMonitor(t, o, false);
+
+  if (m == 0 and thinLockTryAcquire(t, slot, o)) {
+    // make sure nobody inflated the lock before we published our
+    // record:
+    storeLoadMemoryBarrier();
+
+    m = objectMonitor(t, o, false);
+    if (m == 0) {
+      if (DebugMonitors) {
+        fprintf(stderr, "thread %p thin-acquires %x\n", t, hash);
+      }
+      return;
+    }
+
+    thinLockRelease(t, thinLockRecord(t, o));
   }
 
-  monitorAcquire(t, m);
+  acquireInflated(t, o, m);
 }
 
 inline void release(Thread* t, object o)
@@ -3109,6 +3309,18 @@ inline void release(Thread* t, object o)
     hash = objectHash(t, o);
   }
 
+  Thread::LockRecord* r = thinLockRecord(t, o);
+  if (r) {
+    if (DebugMonitors) {
+      fprintf(stderr, "thread %p thin-releases %x\n", t, hash);
+    }
+
+    if (--r->depth == 0) {
+      thinLockRelease(t, r);
+    }
+    return;
+  }
+
   GcMonitor* m = objectMonitor(t, o, false);
 
   if (DebugMonitors) {
@@ -3118,6 +3330,17 @@ inline void release(Thread* t, object o)
   monitorRelease(t, m);
 }
 
+inline bool holdsLock(Thread* t, object o)
+{
+  if (thinLockRecord(t, o)) {
+    return true;
+  }
+
+  GcMonitor* m = objectMonitor(t, o, false);
+
+  return m and m->owner() == t;
+}
+
 inline void wait(Thread* t, object o, int64_t milliseconds)
 {
   unsigned hash;
@@ -3125,7 +3348,9 @@ inline void wait(Thread* t, object o, int64_t milliseconds)
     hash = objectHash(t, o);
   }
 
-  GcMonitor* m = objectMonitor(t, o, false);
+  // a thin lock must be inflated before we can wait on it:
+  Thread::LockRecord* r = thinLockRecord(t, o);
+  GcMonitor* m = r ? inflate(t, o, r) : objectMonitor(t, o, false);
 
   if (DebugMonitors) {
     fprintf(stderr,
@@ -3167,6 +3392,11 @@ inline void notify(Thread* t, object o)
     hash = objectHash(t, o);
   }
 
+  if (thinLockRecord(t, o)) {
+    // nobody can be waiting on an object which has not been inflated
+    return;
+  }
+
   GcMonitor* m = objectMonitor(t, o, false);
 
   if (DebugMonitors) {
@@ -3182,6 +3412,10 @@ inline void notify(Thread* t, object o)
 
 inline void notifyAll(Thread* t, object o)
 {
+  if (thinLockRecord(t, o)) {
+    return;
+  }
+
   GcMonitor* m = objectMonitor(t, o, false);
 
   if (DebugMonitors) {
@@ -351,6 +351,112 @@ extern "C" AVIAN_EXPORT int64_t JNICALL
   return reinterpret_cast<int64_t (*)(int64_t)>(function)(argument);
 }
 
+extern "C" AVIAN_EXPORT void JNICALL
+    Avian_avian_Machine_allocationStatistics(Thread* t,
+                                             object,
+                                             uintptr_t* arguments)
+{
+  GcLongArray* statistics
+      = cast<GcLongArray>(t, reinterpret_cast<object>(*arguments));
+
+  if (UNLIKELY(statistics == 0)) {
+    throwNew(t, GcNullPointerException::Type);
+  }
+
+  if (UNLIKELY(statistics->length() < 3)) {
+    throwNew(t, GcArrayIndexOutOfBoundsException::Type);
+  }
+
+  statistics->body()[0] = (t->heapAllocatedWords + t->heapOffset
+                           + t->heapIndex) * BytesPerWord;
+  statistics->body()[1] = t->heapRefills;
+  statistics->body()[2] = t->heapSizeInWords * BytesPerWord;
+}
+
+extern "C" AVIAN_EXPORT void JNICALL
+    Avian_avian_Machine_collectionStatistics(Thread* t,
+                                             object,
+                                             uintptr_t* arguments)
+{
+  GcLongArray* statistics
+      = cast<GcLongArray>(t, reinterpret_cast<object>(*arguments));
+
+  if (UNLIKELY(statistics == 0)) {
+    throwNew(t, GcNullPointerException::Type);
+  }
+
+  if (UNLIKELY(statistics->length() < 8)) {
+    throwNew(t, GcArrayIndexOutOfBoundsException::Type);
+  }
+
+  Heap::Statistics s;
+  t->m->heap->statistics(&s);
+
+  statistics->body()[0] = s.collections[Heap::MinorCollection];
+  statistics->body()[1] = s.collections[Heap::MajorCollection];
+  statistics->body()[2] = s.totalMilliseconds[Heap::MinorCollection];
+  statistics->body()[3] = s.totalMilliseconds[Heap::MajorCollection];
+  statistics->body()[4] = s.maxMilliseconds[Heap::MinorCollection];
+  statistics->body()[5] = s.maxMilliseconds[Heap::MajorCollection];
+  statistics->body()[6] = s.footprint;
+  statistics->body()[7] = s.peakFootprint;
+
+  if (statistics->length() >= 9 + Heap::CauseCount) {
+    statistics->body()[8] = s.promoted;
+    for (unsigned i = 0; i < Heap::CauseCount; ++i) {
+      statistics->body()[9 + i] = s.causes[i];
+    }
+  }
+}
+
+extern "C" AVIAN_EXPORT int64_t JNICALL
+    Avian_avian_Machine_collectionRecords(Thread* t,
+                                          object,
+                                          uintptr_t* arguments)
+{
+  // see the Record* constants in avian.Machine:
+  const unsigned RecordSize = 15;
+
+  uint64_t since;
+  memcpy(&since, arguments, 8);
+  GcLongArray* array
+      = cast<GcLongArray>(t, reinterpret_cast<object>(arguments[2]));
+
+  if (UNLIKELY(array == 0)) {
+    throwNew(t, GcNullPointerException::Type);
+  }
+
+  unsigned capacity = array->length() / RecordSize;
+  if (capacity > Heap::RecordCount) {
+    capacity = Heap::RecordCount;
+  }
+
+  Heap::Record records[Heap::RecordCount];
+  unsigned count = t->m->heap->records(since, records, capacity);
+
+  for (unsigned i = 0; i < count; ++i) {
+    Heap::Record* r = records + i;
+    int64_t* body = array->body().begin() + (i * RecordSize);
+    body[0] = r->sequence;
+    body[1] = r->type;
+    body[2] = r->cause;
+    body[3] = r->start;
+    body[4] = r->milliseconds;
+    body[5] = r->incoming;
+    body[6] = r->gen1Before;
+    body[7] = r->gen1After;
+    body[8] = r->gen2Before;
+    body[9] = r->gen2After;
+    body[10] = r->untenuredFixies;
+    body[11] = r->tenuredFixies;
+    body[12] = r->promoted;
+    body[13] = r->footprintBefore;
+    body[14] = r->footprintAfter;
+  }
+
+  return count;
+}
+
 extern "C" AVIAN_EXPORT void JNICALL
     Avian_java_lang_Runtime_exit(Thread* t, object, uintptr_t* arguments)
 {
@@ -11,6 +11,7 @@
 #include "avian/machine.h"
 #include "avian/classpath-common.h"
 #include "avian/process.h"
+#include "avian/kernels.h"
 
 #include <avian/util/runtime-array.h>
 
@@ -423,6 +424,84 @@ extern "C" AVIAN_EXPORT int64_t JNICALL
   return reinterpret_cast<int64_t>(intern(t, this_));
 }
 
+extern "C" AVIAN_EXPORT int64_t JNICALL
+    Avian_java_lang_String_charsEqual(Thread* t, object, uintptr_t* arguments)
+{
+  return charsEqual(t,
+                    reinterpret_cast<object>(arguments[0]),
+                    arguments[1],
+                    reinterpret_cast<object>(arguments[2]),
+                    arguments[3],
+                    arguments[4]);
+}
+
+extern "C" AVIAN_EXPORT int64_t JNICALL
+    Avian_java_lang_String_compareChars(Thread* t, object, uintptr_t* arguments)
+{
+  return compareChars(t,
+                      reinterpret_cast<object>(arguments[0]),
+                      arguments[1],
+                      arguments[2],
+                      reinterpret_cast<object>(arguments[3]),
+                      arguments[4],
+                      arguments[5]);
+}
+
+extern "C" AVIAN_EXPORT int64_t JNICALL
+    Avian_java_lang_String_hashChars(Thread* t, object, uintptr_t* arguments)
+{
+  return hashChars(
+      t, reinterpret_cast<object>(arguments[0]), arguments[1], arguments[2]);
+}
+
+extern "C" AVIAN_EXPORT int64_t JNICALL
+    Avian_java_lang_String_indexOfChar(Thread* t, object, uintptr_t* arguments)
+{
+  return indexOfChar(t,
+                     reinterpret_cast<object>(arguments[0]),
+                     arguments[1],
+                     arguments[2],
+                     arguments[3]);
+}
+
+extern "C" AVIAN_EXPORT int64_t JNICALL
+    Avian_java_lang_String_indexOfChars(Thread* t, object, uintptr_t* arguments)
+{
+  return indexOfChars(t,
+                      reinterpret_cast<object>(arguments[0]),
+                      arguments[1],
+                      arguments[2],
+                      reinterpret_cast<object>(arguments[3]),
+                      arguments[4],
+                      arguments[5]);
+}
+
+extern "C" AVIAN_EXPORT int64_t JNICALL
+    Avian_java_util_Arrays_elementsEqual(Thread* t,
+                                         object,
+                                         uintptr_t* arguments)
+{
+  return elementsEqual(t,
+                       reinterpret_cast<object>(arguments[0]),
+                       reinterpret_cast<object>(arguments[1]),
+                       arguments[2]);
+}
+
+extern "C" AVIAN_EXPORT void JNICALL
+    Avian_java_util_Arrays_fillElements(Thread* t,
+                                        object,
+                                        uintptr_t* arguments)
+{
+  int64_t value;
+  memcpy(&value, arguments + 3, 8);
+
+  fillElements(t,
+               reinterpret_cast<object>(arguments[0]),
+               arguments[1],
+               arguments[2],
+               value);
+}
+
 extern "C" AVIAN_EXPORT int64_t JNICALL
     Avian_java_lang_System_getVMProperties(Thread* t, object, uintptr_t*)
 {
@@ -609,10 +688,7 @@ extern "C" AVIAN_EXPORT int64_t JNICALL
 extern "C" AVIAN_EXPORT int64_t JNICALL
     Avian_java_lang_Thread_holdsLock(Thread* t, object, uintptr_t* arguments)
 {
-  GcMonitor* m
-      = objectMonitor(t, reinterpret_cast<object>(arguments[0]), false);
-
-  return m and m->owner() == t;
+  return holdsLock(t, reinterpret_cast<object>(arguments[0]));
 }
 
 extern "C" AVIAN_EXPORT void JNICALL
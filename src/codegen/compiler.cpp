@@ -642,6 +642,14 @@ void move(Context* c, Value* value, Site* src, Site* dst)
 
   assertT(c, value->findSite(dst));
 
+  if (src->type(c) == lir::Operand::Type::RegisterPair
+      and dst->type(c) == lir::Operand::Type::Memory) {
+    ++c->statistics.spills;
+  } else if (src->type(c) == lir::Operand::Type::Memory
+             and dst->type(c) == lir::Operand::Type::RegisterPair) {
+    ++c->statistics.reloads;
+  }
+
   src->freeze(c, value);
   dst->freeze(c, value);
 
@@ -1449,6 +1457,7 @@ void append(Context* c, Event* e)
     c->firstEvent = e;
   }
   c->lastEvent = e;
+  e->sequence = c->eventCount++;
 
   Event* p = c->predecessor;
   if (p) {
@@ -2260,6 +2269,27 @@ class MyCompiler : public Compiler {
     compiler::restoreState(&c, static_cast<ForkState*>(state));
   }
 
+  virtual void setEvictionPolicy(EvictionPolicy policy)
+  {
+    c.evictionPolicy = policy;
+  }
+
+  virtual void addLoop(unsigned start, unsigned end)
+  {
+    assertT(&c, start <= end and end < c.logicalCode.count());
+
+    if (c.loopDepths == 0) {
+      c.loopDepthCount = c.logicalCode.count();
+      c.loopDepths = static_cast<unsigned*>(
+          c.zone->allocate(sizeof(unsigned) * c.loopDepthCount));
+      memset(c.loopDepths, 0, sizeof(unsigned) * c.loopDepthCount);
+    }
+
+    for (unsigned i = start; i <= end; ++i) {
+      ++c.loopDepths[i];
+    }
+  }
+
   virtual void init(unsigned logicalCodeLength,
                     unsigned parameterFootprint,
                     unsigned localFootprint,
@@ -2397,6 +2427,31 @@ class MyCompiler : public Compiler {
     return compiler::value(&c, type, compiler::constantSite(&c, value));
   }
 
+  virtual bool constantValue(ir::Value* value, int64_t* result)
+  {
+    Value* v = static_cast<Value*>(value);
+    ConstantSite* s = findConstantSite(&c, v);
+    if (s == 0 or not s->value->resolved()) {
+      return false;
+    }
+
+    int64_t constant = s->value->value();
+    if (v->nextWord != v) {
+      // the value has been split into words, as large values are on
+      // 32-bit targets:
+      ConstantSite* high = findConstantSite(&c, v->nextWord);
+      if (high == 0 or not high->value->resolved()) {
+        return false;
+      }
+
+      constant = (static_cast<uint64_t>(constant) & 0xFFFFFFFF)
+                 | (static_cast<uint64_t>(high->value->value()) << 32);
+    }
+
+    *result = constant;
+    return true;
+  }
+
   virtual ir::Value* address(ir::Type type, Promise* address)
   {
     return value(&c, type, compiler::addressSite(&c, address));
@@ -2901,6 +2956,11 @@ class MyCompiler : public Compiler {
                                + c.assembler->footerSize();
   }
 
+  virtual Statistics statistics()
+  {
+    return c.statistics;
+  }
+
   virtual unsigned poolSize()
   {
     return c.constantCount * TargetBytesPerWord;
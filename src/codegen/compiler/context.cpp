@@ -51,8 +51,15 @@ Context::Context(vm::System* system,
       alignedFrameSize(0),
       availableGeneralRegisterCount(regFile->generalRegisters.limit
                                     - regFile->generalRegisters.start),
+      eventCount(0),
+      evictionPolicy(Compiler::EvictFirst),
+      loopDepths(0),
+      loopDepthCount(0),
       targetInfo(arch->targetInfo())
 {
+  statistics.spills = 0;
+  statistics.reloads = 0;
+
   for (Register i : regFile->generalRegisters) {
     new (registerResources + i.index()) RegisterResource(arch->reserved(i));
 
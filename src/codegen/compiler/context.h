@@ -128,6 +128,13 @@ class Context {
   unsigned machineCodeSize;
   unsigned alignedFrameSize;
   unsigned availableGeneralRegisterCount;
+  unsigned eventCount;
+  Compiler::EvictionPolicy evictionPolicy;
+  // number of loops enclosing each logical instruction, or null if no
+  // loops have been added:
+  unsigned* loopDepths;
+  unsigned loopDepthCount;
+  Compiler::Statistics statistics;
   ir::TargetInfo targetInfo;
 };
 
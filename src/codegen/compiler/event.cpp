@@ -123,7 +123,8 @@ Event::Event(Context* c)
       visitLinks(0),
       block(0),
       logicalInstruction(c->logicalCode[c->logicalIp]),
-      readCount(0)
+      readCount(0),
+      sequence(0)
 {
 }
 
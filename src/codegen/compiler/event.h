@@ -88,6 +88,9 @@ class Event {
   Block* block;
   LogicalInstruction* logicalInstruction;
   unsigned readCount;
+  // position in the method's event list, which is also the order in
+  // which events are compiled:
+  unsigned sequence;
 };
 
 void finishAddRead(Context* c, Value* v, Read* r);
@@ -15,6 +15,8 @@
 #include "codegen/compiler/site.h"
 #include "codegen/compiler/resource.h"
 #include "codegen/compiler/read.h"
+#include "codegen/compiler/event.h"
+#include "codegen/compiler/ir.h"
 
 namespace avian {
 namespace codegen {
@@ -56,6 +58,47 @@ unsigned resourceCost(Context* c,
   }
 }
 
+// Returns the next event to read the value occupying the specified
+// register, or null if the register is free or its value is never
+// read again.
+Event* nextUse(Context* c, RegisterResource* r)
+{
+  if (r->value) {
+    Read* read = live(c, r->value);
+    if (read) {
+      return read->event;
+    }
+  }
+  return 0;
+}
+
+unsigned loopDepth(Context* c, Event* e)
+{
+  int ip = e->logicalInstruction->index;
+  return (ip >= 0 and static_cast<unsigned>(ip) < c->loopDepthCount)
+             ? c->loopDepths[ip]
+             : 0;
+}
+
+// Returns true if we would rather evict a value next read by event a
+// than one next read by event b: the value's reload will happen in
+// fewer loops, or in as many but further ahead.
+bool preferEviction(Context* c, Event* a, Event* b)
+{
+  if (b == 0) {
+    return false;
+  } else if (a == 0) {
+    return true;
+  }
+
+  unsigned aDepth = loopDepth(c, a);
+  unsigned bDepth = loopDepth(c, b);
+  if (aDepth != bDepth) {
+    return aDepth < bDepth;
+  }
+  return a->sequence > b->sequence;
+}
+
 bool pickRegisterTarget(Context* c,
                         Register i,
                         Value* v,
@@ -80,6 +123,13 @@ bool pickRegisterTarget(Context* c,
     } else if (myCost < *cost) {
       *cost = myCost;
       *target = i;
+    } else if (myCost == *cost and myCost < Target::Impossible
+               and c->evictionPolicy == Compiler::EvictFurthestUse
+               and preferEviction(
+                       c,
+                       nextUse(c, r),
+                       nextUse(c, c->registerResources + target->index()))) {
+      *target = i;
     }
   }
   return false;
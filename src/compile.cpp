@@ -14,6 +14,7 @@
 #include "avian/process.h"
 #include "avian/target.h"
 #include "avian/arch.h"
+#include "avian/kernels.h"
 
 #include <avian/system/memory.h>
 
@@ -67,6 +68,14 @@ const bool DebugInstructions = false;
 #ifndef AVIAN_AOT_ONLY
 const bool DebugFrameMaps = false;
 const bool CheckArrayBounds = true;
+
+// omit the bounds check (and the exception bookkeeping) for array
+// accesses proven in range by findSafeArrayAccesses:
+const bool EliminateBoundsChecks = true;
+
+// number of array accesses remembered per extended basic block by
+// findSafeArrayAccesses:
+const unsigned CheckedAccessCount = 8;
 const unsigned ExecutableAreaSizeInBytes = 30 * 1024 * 1024;
 #endif
 
@@ -80,6 +89,31 @@ const unsigned MaxNativeCallFootprint = TargetBytesPerWord == 8 ? 4 : 5;
 
 const unsigned InitialZoneCapacityInBytes = 64 * 1024;
 
+// number of receiver classes remembered at each invokeinterface call
+// site before it is considered megamorphic:
+const unsigned InterfaceCallCacheSize = 4;
+
+// number of (class, method) pairs remembered by the machine-wide
+// interface dispatch table (must be a power of two):
+const unsigned InterfaceDispatchTableSize = 4096;
+
+// number of compiled methods whose bytecode is remembered for inlining
+// at call sites compiled later (must be a power of two):
+const unsigned InlineTableSize = 1024;
+
+// maximum length in bytes of the bytecode of a method we'll inline at
+// a statically bound call site, and the most operand stack entries and
+// local variable slots it may use:
+const unsigned InlineSizeLimit = 32;
+const unsigned InlineStackLimit = 8;
+const unsigned InlineLocalLimit = 8;
+
+// default number of invocations and of loop back edges after which a
+// method is reported as hot when profiling is enabled (see
+// ProfilePolicy):
+const unsigned HotInvocationThreshold = 10000;
+const unsigned HotBackEdgeThreshold = 100000;
+
 enum ThunkIndex {
   compileMethodIndex,
   compileVirtualMethodIndex,
@@ -933,6 +967,201 @@ class BootContext {
   JavaVM* hostVM;
 };
 
+// Setting avian.optimize to "true" applies the optimizations
+// described with ValueCache to every method compiled.
+//
+// Setting avian.jit.hotMethods to a file name compiles each method
+// with calls which count its invocations and loop back edges, and logs
+// the method to that file once either count passes its threshold
+// (which avian.jit.hotThreshold may override).  Those are the methods
+// worth compiling with avian.optimize.
+class ProfilePolicy {
+ public:
+  ProfilePolicy()
+      : optimizeAll(false),
+        hotMethodLog(0),
+        invocationThreshold(HotInvocationThreshold),
+        backEdgeThreshold(HotBackEdgeThreshold)
+  {
+  }
+
+  bool optimizeAll;
+  FILE* hotMethodLog;
+  unsigned invocationThreshold;
+  unsigned backEdgeThreshold;
+};
+
+ProfilePolicy* profilePolicy(MyThread* t);
+
+// The register allocator steals the first cheapest register it finds
+// by default.  Setting avian.jit.evictFurthest to "true" makes it
+// prefer, among equally cheap registers, the one whose value is next
+// needed outside the most deeply nested loop (see findLoops), and
+// then the furthest ahead, which tends to reduce the spills and
+// reloads in methods under register pressure, and moves the reloads
+// out of inner loops.  Setting avian.jit.spills to a file name logs
+// the number of each for every method compiled.
+avian::codegen::Compiler::EvictionPolicy evictionPolicy(MyThread* t);
+
+// Optional optimizations
+//
+// Methods compiled with Context::optimize set (every method, if
+// avian.optimize is "true") send their integer arithmetic through
+// binaryOp and unaryOp below rather than straight to the Compiler.
+// These fold operations on constants, drop identities such as x + 0,
+// turn multiplication, division and remainder by powers of two into
+// shifts and masks, and reuse the result of an operation already
+// computed from the same operands earlier in the extended basic block.
+//
+// What is known is kept in a ValueCache and forgotten at every block
+// entry, since the compiler keeps using the same ir::Value for a stack
+// slot or local after a junction, whichever way control arrived.
+// Within a block, though, each value stands for a single result, and
+// each load of a local stands for whatever the local held when it was
+// last assigned, which is enough to recognize a repeated computation.
+
+const unsigned ValueCacheSize = 32;
+
+class ValueCache {
+ public:
+  // operations which may be cached besides the lir::TernaryOperations:
+  enum { Negate = lir::TernaryOperationCount, ArrayLength };
+
+  // a value pushed in this block which the compiler knows is constant
+  class Constant {
+   public:
+    ir::Value* value;
+    int64_t constant;
+  };
+
+  // a value pushed by loading a local, and the value the local holds
+  class Alias {
+   public:
+    ir::Value* value;
+    ir::Value* original;
+  };
+
+  // an operand of a cached operation, which is either a constant (if
+  // value is null) or a value
+  class Operand {
+   public:
+    Operand() : value(0), constant(0)
+    {
+    }
+
+    bool operator==(const Operand& o) const
+    {
+      return value == o.value and constant == o.constant;
+    }
+
+    ir::Value* value;
+    int64_t constant;
+  };
+
+  class Entry {
+   public:
+    unsigned operation;
+    unsigned size;
+    Operand a;
+    Operand b;
+    ir::Value* result;
+  };
+
+  ValueCache(Slice<bool> blockEntries, unsigned end)
+      : blockEntries(blockEntries),
+        end(end),
+        nextIp(0),
+        constantCount(0),
+        aliasCount(0),
+        entryCount(0)
+  {
+  }
+
+  // Called as the instruction at ip is compiled.  Unless it can only
+  // be reached by falling through from the instruction compiled just
+  // before it, everything known so far is forgotten.
+  void visit(MyThread* t, GcCode* code, unsigned ip);
+
+  void pushed(avian::codegen::Compiler* c, ir::Value* value)
+  {
+    int64_t constant;
+    if (c->constantValue(value, &constant)) {
+      Constant* e = constants + (constantCount++ % ValueCacheSize);
+      e->value = value;
+      e->constant = constant;
+    }
+  }
+
+  void loaded(ir::Value* value, ir::Value* original)
+  {
+    Alias* e = aliases + (aliasCount++ % ValueCacheSize);
+    e->value = value;
+    e->original = original;
+  }
+
+  bool constant(ir::Value* value, int64_t* result)
+  {
+    for (unsigned i = 0; i < min(constantCount, ValueCacheSize); ++i) {
+      if (constants[i].value == value) {
+        *result = constants[i].constant;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  Operand operand(ir::Value* value)
+  {
+    Operand o;
+    if (not constant(value, &(o.constant))) {
+      o.value = value;
+      for (unsigned i = 0; i < min(aliasCount, ValueCacheSize); ++i) {
+        if (aliases[i].value == value) {
+          o.value = aliases[i].original;
+          break;
+        }
+      }
+    }
+    return o;
+  }
+
+  ir::Value* find(unsigned operation, unsigned size, Operand a, Operand b)
+  {
+    for (unsigned i = 0; i < min(entryCount, ValueCacheSize); ++i) {
+      Entry* e = entries + i;
+      if (e->operation == operation and e->size == size and e->a == a
+          and e->b == b) {
+        return e->result;
+      }
+    }
+    return 0;
+  }
+
+  void add(unsigned operation,
+           unsigned size,
+           Operand a,
+           Operand b,
+           ir::Value* result)
+  {
+    Entry* e = entries + (entryCount++ % ValueCacheSize);
+    e->operation = operation;
+    e->size = size;
+    e->a = a;
+    e->b = b;
+    e->result = result;
+  }
+
+  Slice<bool> blockEntries;
+  unsigned end;
+  unsigned nextIp;
+  unsigned constantCount;
+  unsigned aliasCount;
+  unsigned entryCount;
+  Constant constants[ValueCacheSize];
+  Alias aliases[ValueCacheSize];
+  Entry entries[ValueCacheSize];
+};
+
 class Context {
  public:
   class MyResource : public Thread::AutoResource {
@@ -958,6 +1187,7 @@ class Context {
     virtual void visit(Heap::Visitor* v)
     {
       v->visit(&(c->method));
+      v->visit(&(c->profile));
 
       for (PoolElement* p = c->objectPool; p; p = p->next) {
         v->visit(&(p->target));
@@ -1174,12 +1404,16 @@ class Context {
         objectPool(0),
         subroutineCount(0),
         traceLog(0),
+        profile(0),
         visitTable(
             Slice<uint16_t>::allocAndSet(&zone, method->code()->length(), 0)),
         rootTable(Slice<uintptr_t>::allocAndSet(
             &zone,
             method->code()->length() * frameMapSizeInWords(t, method),
             ~(uintptr_t)0)),
+        safeArrayAccesses(
+            Slice<bool>::allocAndSet(&zone, method->code()->length(), false)),
+        values(0),
         executableAllocator(0),
         executableStart(0),
         executableSize(0),
@@ -1187,6 +1421,7 @@ class Context {
         traceLogCount(0),
         dirtyRoots(false),
         leaf(true),
+        optimize(false),
         eventLog(t->m->system, t->m->heap, 1024),
         protector(this),
         resource(this),
@@ -1207,8 +1442,11 @@ class Context {
         objectPool(0),
         subroutineCount(0),
         traceLog(0),
+        profile(0),
         visitTable(0, 0),
         rootTable(0, 0),
+        safeArrayAccesses(0, 0),
+        values(0),
         executableAllocator(0),
         executableStart(0),
         executableSize(0),
@@ -1216,6 +1454,7 @@ class Context {
         traceLogCount(0),
         dirtyRoots(false),
         leaf(true),
+        optimize(false),
         eventLog(t->m->system, t->m->heap, 0),
         protector(this),
         resource(this),
@@ -1269,8 +1508,11 @@ class Context {
   PoolElement* objectPool;
   unsigned subroutineCount;
   TraceElement* traceLog;
+  GcMethodProfile* profile;
   Slice<uint16_t> visitTable;
   Slice<uintptr_t> rootTable;
+  Slice<bool> safeArrayAccesses;
+  ValueCache* values;
   Alloc* executableAllocator;
   void* executableStart;
   unsigned executableSize;
@@ -1278,6 +1520,7 @@ class Context {
   unsigned traceLogCount;
   bool dirtyRoots;
   bool leaf;
+  bool optimize;
   Vector eventLog;
   MyProtector protector;
   MyResource resource;
@@ -1677,6 +1920,9 @@ class Frame {
   void push(ir::Type type, ir::Value* o)
   {
     assertT(t, type == o->type);
+    if (context->values) {
+      context->values->pushed(c, o);
+    }
     c->push(o->type, o);
     assertT(t, sp + 1 <= frameSize());
     set(sp++, type);
@@ -1693,6 +1939,9 @@ class Frame {
   void pushLarge(ir::Type type, ir::Value* o)
   {
     assertT(t, o->type == type);
+    if (context->values) {
+      context->values->pushed(c, o);
+    }
     c->push(type, o);
     assertT(t, sp + 2 <= frameSize());
     set(sp++, type);
@@ -1727,7 +1976,11 @@ class Frame {
   void load(ir::Type type, unsigned index)
   {
     assertT(t, index < localSize());
-    push(type, loadLocal(context, 1, type, index));
+    ir::Value* value = loadLocal(context, 1, type, index);
+    push(type, value);
+    if (context->values) {
+      context->values->loaded(c->peek(1, 0), value);
+    }
   }
 
   void loadLarge(ir::Type type, unsigned index)
@@ -2462,27 +2715,91 @@ int64_t prepareMethodForCall(MyThread* t, GcMethod* target)
   }
 }
 
-int64_t findInterfaceMethodFromInstance(MyThread* t,
-                                        GcMethod* method,
-                                        object instance)
+GcMethod* findInterfaceMethodFromTable(MyThread* t,
+                                       GcMethod* method,
+                                       GcClass* class_)
 {
-  if (instance) {
-    return prepareMethodForCall(
-        t, findInterfaceMethod(t, method, objectClass(t, instance)));
-  } else {
-    throwNew(t, GcNullPointerException::Type);
+  unsigned index = (objectHash(t, class_) ^ (objectHash(t, method) * 31))
+                   & (InterfaceDispatchTableSize - 1);
+
+  GcArray* table = compileRoots(t)->interfaceDispatchTable();
+  if (table) {
+    GcTriple* entry = cast<GcTriple>(t, table->body()[index]);
+    if (entry and entry->first() == class_ and entry->second() == method) {
+      return cast<GcMethod>(t, entry->third());
+    }
+  }
+
+  PROTECT(t, method);
+  PROTECT(t, class_);
+
+  GcMethod* target = findInterfaceMethod(t, method, class_);
+  PROTECT(t, target);
+
+  if (table == 0) {
+    table = makeArray(t, InterfaceDispatchTableSize);
+    compileRoots(t)->setInterfaceDispatchTable(t, table);
   }
+
+  // entries are immutable once published, so a racing reader sees
+  // either the old entry or the new one, never a mix of both:
+  GcTriple* entry = makeTriple(t, class_, method, target);
+  compileRoots(t)->interfaceDispatchTable()->setBodyElement(t, index, entry);
+
+  return target;
 }
 
-int64_t findInterfaceMethodFromInstanceAndReference(MyThread* t,
-                                                    GcPair* pair,
-                                                    object instance)
+GcMethod* updateInterfaceCallCache(MyThread* t,
+                                   GcInterfaceCallCache* cache,
+                                   object instance)
 {
+  PROTECT(t, cache);
   PROTECT(t, instance);
 
-  GcMethod* method = resolveMethod(t, pair);
+  GcMethod* method;
+  if (objectClass(t, cache->target()) == type(t, GcPair::Type)) {
+    method = resolveMethod(t, cast<GcPair>(t, cache->target()));
+    cache->setTarget(t, method);
+  } else {
+    method = cast<GcMethod>(t, cache->target());
+  }
+
+  GcMethod* target
+      = findInterfaceMethodFromTable(t, method, objectClass(t, instance));
+
+  for (unsigned i = 0; i < cache->length(); ++i) {
+    if (cache->body()[i] == 0) {
+      PROTECT(t, target);
+
+      GcPair* entry = makePair(t, objectClass(t, instance), target);
+      cache->setBodyElement(t, i, entry);
+      break;
+    }
+  }
+
+  return target;
+}
+
+int64_t findInterfaceMethodFromCache(MyThread* t,
+                                     GcInterfaceCallCache* cache,
+                                     object instance)
+{
+  if (LIKELY(instance)) {
+    GcClass* class_ = objectClass(t, instance);
+    for (unsigned i = 0; i < cache->length(); ++i) {
+      GcPair* entry = cast<GcPair>(t, cache->body()[i]);
+      if (entry == 0) {
+        break;
+      } else if (entry->first() == class_) {
+        return prepareMethodForCall(t, cast<GcMethod>(t, entry->second()));
+      }
+    }
 
-  return findInterfaceMethodFromInstance(t, method, instance);
+    return prepareMethodForCall(
+        t, updateInterfaceCallCache(t, cache, instance));
+  } else {
+    throwNew(t, GcNullPointerException::Type);
+  }
 }
 
 void checkMethod(Thread* t, GcMethod* method, bool shouldBeStatic)
@@ -3058,6 +3375,68 @@ uint64_t instanceOf64(Thread* t, GcClass* class_, object o)
   return instanceOf(t, class_, o);
 }
 
+uint64_t charsEqual64(Thread* t,
+                      object a,
+                      int32_t aOffset,
+                      object b,
+                      int32_t bOffset,
+                      int32_t length)
+{
+  return charsEqual(t, a, aOffset, b, bOffset, length);
+}
+
+uint64_t compareChars64(Thread* t,
+                        object a,
+                        int32_t aOffset,
+                        int32_t aLength,
+                        object b,
+                        int32_t bOffset,
+                        int32_t bLength)
+{
+  return static_cast<uint32_t>(
+      compareChars(t, a, aOffset, aLength, b, bOffset, bLength));
+}
+
+uint64_t hashChars64(Thread* t, object data, int32_t offset, int32_t length)
+{
+  return static_cast<uint32_t>(hashChars(t, data, offset, length));
+}
+
+uint64_t indexOfChar64(Thread* t,
+                       object data,
+                       int32_t offset,
+                       int32_t length,
+                       int32_t c)
+{
+  return static_cast<uint32_t>(indexOfChar(t, data, offset, length, c));
+}
+
+uint64_t indexOfChars64(Thread* t,
+                        object data,
+                        int32_t offset,
+                        int32_t length,
+                        object pattern,
+                        int32_t patternOffset,
+                        int32_t patternLength)
+{
+  return static_cast<uint32_t>(indexOfChars(
+      t, data, offset, length, pattern, patternOffset, patternLength));
+}
+
+uint64_t elementsEqual64(Thread* t, object a, object b, int32_t length)
+{
+  return elementsEqual(t, a, b, length);
+}
+
+void fillElements64(Thread* t,
+                    object array,
+                    int32_t start,
+                    int32_t stop,
+                    int64_t value)
+{
+  fillElements(t, array, start, stop, value);
+}
+
 uint64_t instanceOfFromReference(Thread* t, GcPair* pair, object o)
 {
   PROTECT(t, o);
@@ -3145,6 +3524,10 @@ void logCompile(MyThread* t,
                 const char* name,
                 const char* spec);
 
+FILE* spillLog = 0;
+
+void logSpills(MyThread* t, Context* context);
+
 unsigned simpleFrameMapTableSize(MyThread* t, GcMethod* method, GcIntArray* map)
 {
   int size = frameMapSizeInBits(t, method);
@@ -3205,12 +3588,21 @@ ir::Value* popField(MyThread* t, Frame* frame, int code)
 
 void compileSafePoint(MyThread* t, Compiler* c, Frame* frame)
 {
-  c->nativeCall(
-      c->constant(getThunk(t, idleIfNecessaryThunk), ir::Type::iptr()),
-      0,
-      frame->trace(0, 0),
-      ir::Type::void_(),
-      args(c->threadRegister()));
+  if (frame->context->profile) {
+    c->nativeCall(
+        c->constant(getThunk(t, countBackEdgeThunk), ir::Type::iptr()),
+        0,
+        frame->trace(0, 0),
+        ir::Type::void_(),
+        args(c->threadRegister(), frame->append(frame->context->profile)));
+  } else {
+    c->nativeCall(
+        c->constant(getThunk(t, idleIfNecessaryThunk), ir::Type::iptr()),
+        0,
+        frame->trace(0, 0),
+        ir::Type::void_(),
+        args(c->threadRegister()));
+  }
 }
 
 void compileDirectInvoke(MyThread* t,
@@ -3461,276 +3853,1809 @@ bool inTryBlock(MyThread* t UNUSED, GcCode* code, unsigned ip)
   return false;
 }
 
-bool needsReturnBarrier(MyThread* t UNUSED, GcMethod* method)
+// Bounds check elimination
+//
+// Before a method is compiled, findSafeArrayAccesses scans its
+// bytecode for array loads and stores which can be proven to use an
+// index in range, which also means the array can't be null.  Two
+// kinds of proof are used:
+//
+//  * A loop of the shape javac produces for "for (int i = 0; i <
+//    a.length; ++i)", or for an enhanced for loop over an array,
+//    where i starts at a non-negative constant, is incremented by one
+//    exactly once per iteration, and neither i nor a is otherwise
+//    assigned in the loop.  Any a[i] in the body ahead of the
+//    increment is in range.
+//
+//  * A repeated access within an extended basic block: once a[i] has
+//    been checked, neither a[i] again nor a[j] for constants 0 <= j <=
+//    i needs another check until a or i is assigned.
+//
+// Anything the scan doesn't understand leaves the check in place, so
+// every access which could throw still does, at the same instruction.
+
+unsigned instructionLength(MyThread* t, GcCode* code, unsigned ip)
 {
-  return (method->flags() & ConstructorFlag)
-         and (method->class_()->vmFlags() & HasFinalMemberFlag);
+  switch (code->body()[ip]) {
+  case bipush:
+  case ldc:
+  case iload:
+  case lload:
+  case fload:
+  case dload:
+  case aload:
+  case istore:
+  case lstore:
+  case fstore:
+  case dstore:
+  case astore:
+  case ret:
+  case newarray:
+    return 2;
+
+  case sipush:
+  case ldc_w:
+  case ldc2_w:
+  case iinc:
+  case ifeq:
+  case ifne:
+  case iflt:
+  case ifge:
+  case ifgt:
+  case ifle:
+  case if_icmpeq:
+  case if_icmpne:
+  case if_icmplt:
+  case if_icmpge:
+  case if_icmpgt:
+  case if_icmple:
+  case if_acmpeq:
+  case if_acmpne:
+  case goto_:
+  case jsr:
+  case getstatic:
+  case putstatic:
+  case getfield:
+  case putfield:
+  case invokevirtual:
+  case invokespecial:
+  case invokestatic:
+  case new_:
+  case anewarray:
+  case checkcast:
+  case instanceof:
+  case ifnull:
+  case ifnonnull:
+    return 3;
+
+  case multianewarray:
+    return 4;
+
+  case invokeinterface:
+  case invokedynamic:
+  case goto_w:
+  case jsr_w:
+    return 5;
+
+  case wide:
+    return code->body()[ip + 1] == iinc ? 6 : 4;
+
+  case tableswitch: {
+    // skip the padding and the default offset:
+    unsigned p = ((ip + 4) & ~3) + 4;
+    int32_t bottom = codeReadInt32(t, code, p);
+    int32_t top = codeReadInt32(t, code, p);
+    return p + ((top - bottom + 1) * 4) - ip;
+  }
+
+  case lookupswitch: {
+    unsigned p = ((ip + 4) & ~3) + 4;
+    int32_t pairCount = codeReadInt32(t, code, p);
+    return p + (pairCount * 8) - ip;
+  }
+
+  default:
+    return 1;
+  }
 }
 
-bool returnsNext(MyThread* t, GcCode* code, unsigned ip)
+// Returns the number of targets of the branch, switch, or jsr at ip,
+// storing them in targets unless it is null.
+unsigned branchTargets(MyThread* t, GcCode* code, unsigned ip, unsigned* targets)
 {
+  unsigned p = ip + 1;
   switch (code->body()[ip]) {
-  case return_:
-  case areturn:
-  case ireturn:
-  case freturn:
-  case lreturn:
-  case dreturn:
-    return true;
+  case ifeq:
+  case ifne:
+  case iflt:
+  case ifge:
+  case ifgt:
+  case ifle:
+  case if_icmpeq:
+  case if_icmpne:
+  case if_icmplt:
+  case if_icmpge:
+  case if_icmpgt:
+  case if_icmple:
+  case if_acmpeq:
+  case if_acmpne:
+  case goto_:
+  case jsr:
+  case ifnull:
+  case ifnonnull:
+    if (targets) {
+      targets[0] = ip + codeReadInt16(t, code, p);
+    }
+    return 1;
 
-  case goto_: {
-    uint32_t offset = codeReadInt16(t, code, ++ip);
-    uint32_t newIp = (ip - 3) + offset;
-    assertT(t, newIp < code->length());
+  case goto_w:
+  case jsr_w:
+    if (targets) {
+      targets[0] = ip + codeReadInt32(t, code, p);
+    }
+    return 1;
 
-    return returnsNext(t, code, newIp);
+  case tableswitch: {
+    p = (ip + 4) & ~3;
+    int32_t default_ = codeReadInt32(t, code, p);
+    int32_t bottom = codeReadInt32(t, code, p);
+    int32_t top = codeReadInt32(t, code, p);
+    unsigned count = top - bottom + 2;
+    if (targets) {
+      targets[0] = ip + default_;
+      for (unsigned i = 1; i < count; ++i) {
+        targets[i] = ip + codeReadInt32(t, code, p);
+      }
+    }
+    return count;
   }
 
-  case goto_w: {
-    uint32_t offset = codeReadInt32(t, code, ++ip);
-    uint32_t newIp = (ip - 5) + offset;
-    assertT(t, newIp < code->length());
+  case lookupswitch: {
+    p = (ip + 4) & ~3;
+    int32_t default_ = codeReadInt32(t, code, p);
+    int32_t pairCount = codeReadInt32(t, code, p);
+    unsigned count = pairCount + 1;
+    if (targets) {
+      targets[0] = ip + default_;
+      for (unsigned i = 1; i < count; ++i) {
+        p += 4;  // skip the key
+        targets[i] = ip + codeReadInt32(t, code, p);
+      }
+    }
+    return count;
+  }
 
-    return returnsNext(t, code, newIp);
+  default:
+    return 0;
   }
+}
+
+// Returns true if execution never falls through from the instruction
+// at ip to the next one (or, for jsr, only does so by way of a ret).
+bool endsBlock(MyThread* t UNUSED, GcCode* code, unsigned ip)
+{
+  switch (code->body()[ip]) {
+  case goto_:
+  case goto_w:
+  case jsr:
+  case jsr_w:
+  case ret:
+  case tableswitch:
+  case lookupswitch:
+  case athrow:
+  case ireturn:
+  case lreturn:
+  case freturn:
+  case dreturn:
+  case areturn:
+  case return_:
+    return true;
+
+  case wide:
+    return code->body()[ip + 1] == ret;
 
   default:
     return false;
   }
 }
 
-bool isTailCall(MyThread* t,
-                GcCode* code,
-                unsigned ip,
-                GcMethod* caller,
-                int calleeReturnCode,
-                GcByteArray* calleeClassName,
-                GcByteArray* calleeMethodName,
-                GcByteArray* calleeMethodSpec)
+// Returns true if the instruction at ip is the instruction op, or one
+// of its four short forms starting at op0, applied to a single-word
+// local, storing the local's index in index.
+bool localOperand(MyThread* t,
+                  GcCode* code,
+                  unsigned ip,
+                  unsigned op,
+                  unsigned op0,
+                  unsigned* index)
 {
-  return avian::codegen::TailCalls
-         and ((caller->flags() & ACC_SYNCHRONIZED) == 0)
-         and (not inTryBlock(t, code, ip - 1))
-         and (not needsReturnBarrier(t, caller))
-         and (caller->returnCode() == VoidField
-              or caller->returnCode() == calleeReturnCode)
-         and returnsNext(t, code, ip)
-         and t->m->classpath->canTailCall(t,
-                                          caller,
-                                          calleeClassName,
-                                          calleeMethodName,
-                                          calleeMethodSpec);
+  unsigned instruction = code->body()[ip];
+  if (instruction == op) {
+    *index = code->body()[ip + 1];
+    return true;
+  } else if (instruction >= op0 and instruction < op0 + 4) {
+    *index = instruction - op0;
+    return true;
+  } else if (instruction == wide and code->body()[ip + 1] == op) {
+    unsigned p = ip + 2;
+    *index = static_cast<uint16_t>(codeReadInt16(t, code, p));
+    return true;
+  } else {
+    return false;
+  }
 }
 
-bool isTailCall(MyThread* t,
-                GcCode* code,
-                unsigned ip,
-                GcMethod* caller,
-                GcMethod* callee)
+bool incrementOperand(MyThread* t,
+                      GcCode* code,
+                      unsigned ip,
+                      unsigned* index,
+                      int* count)
 {
-  return isTailCall(t,
-                    code,
-                    ip,
-                    caller,
-                    callee->returnCode(),
-                    callee->class_()->name(),
-                    callee->name(),
-                    callee->spec());
+  if (code->body()[ip] == iinc) {
+    *index = code->body()[ip + 1];
+    *count = static_cast<int8_t>(code->body()[ip + 2]);
+    return true;
+  } else if (code->body()[ip] == wide and code->body()[ip + 1] == iinc) {
+    unsigned p = ip + 2;
+    *index = static_cast<uint16_t>(codeReadInt16(t, code, p));
+    *count = codeReadInt16(t, code, p);
+    return true;
+  } else {
+    return false;
+  }
 }
 
-bool isReferenceTailCall(MyThread* t,
-                         GcCode* code,
-                         unsigned ip,
-                         GcMethod* caller,
-                         GcReference* calleeReference)
+// Returns the number of consecutive locals, starting at the one
+// stored in index, which the instruction at ip assigns.
+unsigned writtenLocals(MyThread* t, GcCode* code, unsigned ip, unsigned* index)
 {
-  return isTailCall(t,
-                    code,
-                    ip,
-                    caller,
-                    methodReferenceReturnCode(t, calleeReference),
-                    calleeReference->class_(),
-                    calleeReference->name(),
-                    calleeReference->spec());
+  int count;
+  if (localOperand(t, code, ip, istore, istore_0, index)
+      or localOperand(t, code, ip, fstore, fstore_0, index)
+      or localOperand(t, code, ip, astore, astore_0, index)
+      or incrementOperand(t, code, ip, index, &count)) {
+    return 1;
+  } else if (localOperand(t, code, ip, lstore, lstore_0, index)
+             or localOperand(t, code, ip, dstore, dstore_0, index)) {
+    return 2;
+  } else {
+    return 0;
+  }
 }
 
-lir::TernaryOperation toCompilerJumpOp(MyThread* t, unsigned instruction)
+bool nonNegativeConstant(MyThread* t, GcCode* code, unsigned ip)
 {
-  switch (instruction) {
-  case ifeq:
-  case if_icmpeq:
-  case if_acmpeq:
-  case ifnull:
-    return lir::JumpIfEqual;
-  case ifne:
-  case if_icmpne:
-  case if_acmpne:
-  case ifnonnull:
-    return lir::JumpIfNotEqual;
-  case ifgt:
-  case if_icmpgt:
-    return lir::JumpIfGreater;
-  case ifge:
-  case if_icmpge:
-    return lir::JumpIfGreaterOrEqual;
-  case iflt:
-  case if_icmplt:
-    return lir::JumpIfLess;
-  case ifle:
-  case if_icmple:
-    return lir::JumpIfLessOrEqual;
+  unsigned p = ip + 1;
+  switch (code->body()[ip]) {
+  case iconst_0:
+  case iconst_1:
+  case iconst_2:
+  case iconst_3:
+  case iconst_4:
+  case iconst_5:
+    return true;
+
+  case bipush:
+    return static_cast<int8_t>(code->body()[p]) >= 0;
+
+  case sipush:
+    return codeReadInt16(t, code, p) >= 0;
+
   default:
-    abort(t);
+    return false;
   }
 }
 
-bool integerBranch(MyThread* t,
-                   Frame* frame,
-                   GcCode* code,
-                   unsigned& ip,
-                   ir::Value* a,
-                   ir::Value* b,
-                   unsigned* newIpp)
-{
-  if (ip + 3 > code->length()) {
-    return false;
+class InstructionMap {
+ public:
+  InstructionMap(Slice<bool> entries)
+      : starts(0),
+        instructionCount(0),
+        sources(0),
+        targets(0),
+        edgeCount(0),
+        entries(entries)
+  {
   }
 
-  avian::codegen::Compiler* c = frame->c;
-  unsigned instruction = code->body()[ip++];
-  uint32_t offset = codeReadInt16(t, code, ip);
-  uint32_t newIp = (ip - 3) + offset;
-  assertT(t, newIp < code->length());
+  // returns the position of the instruction at ip in starts
+  unsigned indexOf(unsigned ip)
+  {
+    unsigned bottom = 0;
+    unsigned top = instructionCount;
+    while (top - bottom > 1) {
+      unsigned middle = (bottom + top) / 2;
+      if (starts[middle] <= ip) {
+        bottom = middle;
+      } else {
+        top = middle;
+      }
+    }
+    return bottom;
+  }
 
-  ir::Value* target = frame->machineIpValue(newIp);
+  unsigned* starts;
+  unsigned instructionCount;
+  unsigned* sources;
+  unsigned* targets;
+  unsigned edgeCount;
+  // true where control may arrive other than by falling through from
+  // the previous instruction:
+  Slice<bool> entries;
+};
 
-  switch (instruction) {
-  case ifeq:
-  case ifne:
-  case ifgt:
-  case ifge:
-  case iflt:
-  case ifle:
-    c->condJump(toCompilerJumpOp(t, instruction), a, b, target);
-    break;
+// The test at the head or foot of a counted loop: "iload i; aload a;
+// arraylength; <branch>" or, with the length cached in a local n,
+// "iload i; iload n; <branch>".
+class LoopGuard {
+ public:
+  unsigned start;
+  unsigned branch;
+  unsigned index;
+  unsigned array;
+  unsigned length;
+  bool lengthInLocal;
+};
 
-  default:
-    ip -= 3;
+bool matchLoopGuard(MyThread* t,
+                    GcCode* code,
+                    unsigned ip,
+                    unsigned op,
+                    LoopGuard* guard)
+{
+  unsigned p = ip;
+  if (not localOperand(t, code, p, iload, iload_0, &(guard->index))) {
     return false;
   }
+  p += instructionLength(t, code, p);
 
-  *newIpp = newIp;
+  if (p < code->length()
+      and localOperand(t, code, p, aload, aload_0, &(guard->array))) {
+    p += instructionLength(t, code, p);
+    if (p >= code->length() or code->body()[p] != arraylength) {
+      return false;
+    }
+    ++p;
+    guard->lengthInLocal = false;
+  } else if (p < code->length()
+             and localOperand(t, code, p, iload, iload_0, &(guard->length))) {
+    p += instructionLength(t, code, p);
+    guard->lengthInLocal = true;
+  } else {
+    return false;
+  }
+
+  if (p >= code->length() or code->body()[p] != op) {
+    return false;
+  }
+
+  guard->start = ip;
+  guard->branch = p;
   return true;
 }
 
-lir::TernaryOperation toCompilerFloatJumpOp(MyThread* t,
-                                            unsigned instruction,
-                                            bool lessIfUnordered)
+// Returns true if the loop entered through the instruction at entry is
+// preceded by "<constant>; istore i", and, if the guard compares
+// against a cached length, by "aload a; arraylength; istore n" before
+// that, in which case the array local is stored in the guard.
+bool matchLoopEntry(MyThread* t,
+                    GcCode* code,
+                    InstructionMap* map,
+                    unsigned entry,
+                    LoopGuard* guard)
 {
-  switch (instruction) {
-  case ifeq:
-    return lir::JumpIfFloatEqual;
-  case ifne:
-    return lir::JumpIfFloatNotEqual;
-  case ifgt:
-    if (lessIfUnordered) {
-      return lir::JumpIfFloatGreater;
-    } else {
-      return lir::JumpIfFloatGreaterOrUnordered;
-    }
-  case ifge:
-    if (lessIfUnordered) {
-      return lir::JumpIfFloatGreaterOrEqual;
-    } else {
-      return lir::JumpIfFloatGreaterOrEqualOrUnordered;
-    }
-  case iflt:
-    if (lessIfUnordered) {
-      return lir::JumpIfFloatLessOrUnordered;
-    } else {
-      return lir::JumpIfFloatLess;
+  unsigned k = map->indexOf(entry);
+  if (k < 2) {
+    return false;
+  }
+
+  unsigned store = map->starts[k - 1];
+  unsigned constant = map->starts[k - 2];
+  unsigned index;
+  if (map->entries[store]
+      or not localOperand(t, code, store, istore, istore_0, &index)
+      or index != guard->index or not nonNegativeConstant(t, code, constant)) {
+    return false;
+  }
+
+  if (guard->lengthInLocal) {
+    if (k < 5) {
+      return false;
     }
-  case ifle:
-    if (lessIfUnordered) {
-      return lir::JumpIfFloatLessOrEqualOrUnordered;
-    } else {
-      return lir::JumpIfFloatLessOrEqual;
+
+    unsigned lengthStore = map->starts[k - 3];
+    unsigned lengthLoad = map->starts[k - 4];
+    unsigned arrayLoad = map->starts[k - 5];
+    if (map->entries[constant] or map->entries[lengthStore]
+        or map->entries[lengthLoad]
+        or not localOperand(t, code, lengthStore, istore, istore_0, &index)
+        or index != guard->length or index == guard->index
+        or code->body()[lengthLoad] != arraylength
+        or not localOperand(
+               t, code, arrayLoad, aload, aload_0, &(guard->array))) {
+      return false;
     }
-  default:
-    abort(t);
   }
+
+  return true;
 }
 
-bool floatBranch(MyThread* t,
-                 Frame* frame,
-                 GcCode* code,
-                 unsigned& ip,
-                 bool lessIfUnordered,
-                 ir::Value* a,
-                 ir::Value* b,
-                 unsigned* newIpp)
+// Accesses whose index is loaded from local index at an ip in [start,
+// end), and whose array is loaded from local array within [loopStart,
+// loopEnd), are in range.
+class RangeFact {
+ public:
+  unsigned index;
+  unsigned array;
+  unsigned loopStart;
+  unsigned loopEnd;
+  unsigned start;
+  unsigned end;
+};
+
+bool writes(unsigned first, unsigned count, unsigned index)
 {
-  if (ip + 3 > code->length()) {
+  return index >= first and index < first + count;
+}
+
+// Returns true if the backward branch with the specified index in the
+// instruction map closes a counted loop over an array, describing the
+// loop in fact.
+bool findRangeFact(MyThread* t,
+                   GcCode* code,
+                   InstructionMap* map,
+                   unsigned edge,
+                   RangeFact* fact)
+{
+  unsigned back = map->sources[edge];
+  unsigned head = map->targets[edge];
+  bool testAtHead = code->body()[back] == goto_;
+  LoopGuard guard;
+  unsigned entry;
+  unsigned start;
+
+  if (testAtHead) {
+    // "head: <guard> if_icmpge exit; ...; goto head; exit:"
+    if (not matchLoopGuard(t, code, head, if_icmpge, &guard)) {
+      return false;
+    }
+
+    unsigned p = guard.branch + 1;
+    unsigned exit = guard.branch + codeReadInt16(t, code, p);
+    if (exit <= back) {
+      return false;
+    }
+
+    entry = head;
+    start = guard.branch + 3;
+  } else if (code->body()[back] == if_icmplt) {
+    // "goto test; head: ...; test: <guard> if_icmplt head"
+    unsigned k = map->indexOf(back);
+    if (not((k >= 3
+             and matchLoopGuard(
+                     t, code, map->starts[k - 3], if_icmplt, &guard)
+             and guard.branch == back)
+            or (k >= 2
+                and matchLoopGuard(
+                        t, code, map->starts[k - 2], if_icmplt, &guard)
+                and guard.branch == back))) {
+      return false;
+    }
+
+    k = map->indexOf(head);
+    if (k == 0) {
+      return false;
+    }
+
+    entry = map->starts[k - 1];
+    unsigned p = entry + 1;
+    if (map->entries[entry] or code->body()[entry] != goto_
+        or entry + codeReadInt16(t, code, p) != guard.start) {
+      return false;
+    }
+
+    start = head;
+  } else {
     return false;
   }
 
-  avian::codegen::Compiler* c = frame->c;
-  unsigned instruction = code->body()[ip++];
-  uint32_t offset = codeReadInt16(t, code, ip);
-  uint32_t newIp = (ip - 3) + offset;
-  assertT(t, newIp < code->length());
+  if (not matchLoopEntry(t, code, map, entry, &guard)) {
+    return false;
+  }
 
-  ir::Value* target = frame->machineIpValue(newIp);
+  // the index must be incremented by one exactly once and the index,
+  // array, and length must not otherwise be assigned in the loop:
+  unsigned end = back + instructionLength(t, code, back);
+  unsigned increment = 0;
+  for (unsigned ip = head; ip < end; ip += instructionLength(t, code, ip)) {
+    switch (code->body()[ip]) {
+    case jsr:
+    case jsr_w:
+    case ret:
+      return false;
 
-  switch (instruction) {
-  case ifeq:
-  case ifne:
-  case ifgt:
-  case ifge:
-  case iflt:
-  case ifle:
-    c->condJump(
-        toCompilerFloatJumpOp(t, instruction, lessIfUnordered), a, b, target);
-    break;
+    case wide:
+      if (code->body()[ip + 1] == ret) {
+        return false;
+      }
+      break;
 
-  default:
-    ip -= 3;
+    default:
+      break;
+    }
+
+    unsigned index;
+    int count;
+    if (increment == 0 and incrementOperand(t, code, ip, &index, &count)
+        and index == guard.index and count == 1) {
+      increment = ip;
+    } else {
+      unsigned written = writtenLocals(t, code, ip, &index);
+      if (writes(index, written, guard.index)
+          or writes(index, written, guard.array)
+          or (guard.lengthInLocal and writes(index, written, guard.length))) {
+        return false;
+      }
+    }
+  }
+
+  if (increment < start
+      or increment >= (testAtHead ? back : guard.start)) {
     return false;
   }
 
-  *newIpp = newIp;
+  // control may only enter the loop through its entry, and may not
+  // reach the body from past the increment except through the guard:
+  for (unsigned i = 0; i < map->edgeCount; ++i) {
+    unsigned source = map->sources[i];
+    unsigned target = map->targets[i];
+    if (target < head or target >= end) {
+      continue;
+    }
+
+    if (source < head or source >= end) {
+      if (testAtHead or source != entry) {
+        return false;
+      }
+    } else if ((target > guard.start and target <= guard.branch)
+               or (source >= increment and target > head
+                   and target <= increment)
+               or ((not testAtHead) and target == head and source != back)) {
+      return false;
+    }
+  }
+
+  GcExceptionHandlerTable* table
+      = cast<GcExceptionHandlerTable>(t, code->exceptionHandlerTable());
+  if (table) {
+    for (unsigned i = 0; i < table->length(); ++i) {
+      unsigned handler = exceptionHandlerIp(table->body()[i]);
+      if (handler >= head and handler < end) {
+        return false;
+      }
+    }
+  }
+
+  fact->index = guard.index;
+  fact->array = guard.array;
+  fact->loopStart = head;
+  fact->loopEnd = end;
+  fact->start = start;
+  fact->end = increment;
   return true;
 }
 
-ir::Value* popLongAddress(Frame* frame)
+void assignLocals(unsigned* versions,
+                  unsigned localCount,
+                  unsigned* version,
+                  unsigned index,
+                  unsigned count)
 {
-  return TargetBytesPerWord == 8
-             ? frame->popLarge(ir::Type::i8())
-             : frame->c->load(ir::ExtendMode::Signed,
-                              frame->popLarge(ir::Type::i8()),
-                              ir::Type::iptr());
+  for (unsigned i = index; i < index + count and i < localCount; ++i) {
+    versions[i] = ++(*version);
+  }
 }
 
-bool intrinsic(MyThread* t UNUSED, Frame* frame, GcMethod* target)
+// What is known about a value on the operand stack while scanning an
+// extended basic block.
+class AccessOperand {
+ public:
+  enum Kind { Unknown, Local, Constant };
+
+  AccessOperand() : kind(Unknown), local(0), version(0), ip(0), value(0)
+  {
+  }
+
+  AccessOperand(unsigned local, unsigned version, unsigned ip)
+      : kind(Local), local(local), version(version), ip(ip), value(0)
+  {
+  }
+
+  AccessOperand(int32_t value)
+      : kind(Constant), local(0), version(0), ip(0), value(value)
+  {
+  }
+
+  Kind kind;
+  unsigned local;
+  unsigned version;
+  unsigned ip;
+  int32_t value;
+};
+
+bool sameValue(const AccessOperand& a, const AccessOperand& b)
 {
-#define MATCH(name, constant)         \
-  (name->length() == sizeof(constant) \
-   and ::strcmp(reinterpret_cast<char*>(name->body().begin()), constant) == 0)
+  return a.kind == AccessOperand::Local and b.kind == AccessOperand::Local
+         and a.local == b.local and a.version == b.version;
+}
 
-  GcByteArray* className = target->class_()->name();
-  if (UNLIKELY(MATCH(className, "java/lang/Math"))) {
-    avian::codegen::Compiler* c = frame->c;
-    if (MATCH(target->name(), "sqrt") and MATCH(target->spec(), "(D)D")) {
-      frame->pushLarge(
-          ir::Type::f8(),
-          c->unaryOp(lir::FloatSquareRoot, frame->popLarge(ir::Type::f8())));
-      return true;
-    } else if (MATCH(target->name(), "abs")) {
-      if (MATCH(target->spec(), "(I)I")) {
-        frame->push(ir::Type::i4(),
-                    c->unaryOp(lir::Absolute, frame->pop(ir::Type::i4())));
-        return true;
-      } else if (MATCH(target->spec(), "(J)J")) {
+// A model of the top of the operand stack.  Anything popped from below
+// what has been pushed since the start of the block is unknown.
+class OperandStack {
+ public:
+  OperandStack(AccessOperand* slots, unsigned capacity)
+      : slots(slots), capacity(capacity), size(0)
+  {
+  }
+
+  AccessOperand peek(unsigned depth)
+  {
+    return depth < size ? slots[size - depth - 1] : AccessOperand();
+  }
+
+  void push(const AccessOperand& operand)
+  {
+    if (size == capacity) {
+      size = 0;
+    }
+    slots[size++] = operand;
+  }
+
+  void pushUnknown(unsigned count)
+  {
+    for (unsigned i = 0; i < count; ++i) {
+      push(AccessOperand());
+    }
+  }
+
+  void pop(unsigned count)
+  {
+    size = count < size ? size - count : 0;
+  }
+
+  void clear()
+  {
+    size = 0;
+  }
+
+  AccessOperand* slots;
+  unsigned capacity;
+  unsigned size;
+};
+
+class CheckedAccess {
+ public:
+  AccessOperand array;
+  AccessOperand subscript;
+};
+
+// Returns true if the stack effect, in words, of the instruction at ip
+// is known and doesn't involve locals or array accesses, storing the
+// numbers of words popped and pushed.
+bool plainStackEffect(MyThread* t,
+                      GcCode* code,
+                      unsigned ip,
+                      unsigned* popped,
+                      unsigned* pushed)
+{
+  unsigned instruction = code->body()[ip];
+  *popped = 0;
+  *pushed = 0;
+
+  switch (instruction) {
+  case nop:
+  case goto_:
+  case goto_w:
+  case return_:
+    return true;
+
+  case aconst_null:
+  case fconst_0:
+  case fconst_1:
+  case fconst_2:
+  case ldc:
+  case ldc_w:
+  case new_:
+  case fload:
+  case fload_0:
+  case fload_1:
+  case fload_2:
+  case fload_3:
+    *pushed = 1;
+    return true;
+
+  case lconst_0:
+  case lconst_1:
+  case dconst_0:
+  case dconst_1:
+  case ldc2_w:
+  case lload:
+  case lload_0:
+  case lload_1:
+  case lload_2:
+  case lload_3:
+  case dload:
+  case dload_0:
+  case dload_1:
+  case dload_2:
+  case dload_3:
+    *pushed = 2;
+    return true;
+
+  case pop_:
+  case ifeq:
+  case ifne:
+  case iflt:
+  case ifge:
+  case ifgt:
+  case ifle:
+  case ifnull:
+  case ifnonnull:
+  case monitorenter:
+  case monitorexit:
+  case tableswitch:
+  case lookupswitch:
+  case ireturn:
+  case freturn:
+  case areturn:
+  case athrow:
+    *popped = 1;
+    return true;
+
+  case pop2:
+  case if_icmpeq:
+  case if_icmpne:
+  case if_icmplt:
+  case if_icmpge:
+  case if_icmpgt:
+  case if_icmple:
+  case if_acmpeq:
+  case if_acmpne:
+  case lreturn:
+  case dreturn:
+    *popped = 2;
+    return true;
+
+  case ineg:
+  case fneg:
+  case i2f:
+  case f2i:
+  case i2b:
+  case i2c:
+  case i2s:
+  case arraylength:
+  case checkcast:
+  case instanceof:
+  case newarray:
+  case anewarray:
+    *popped = 1;
+    *pushed = 1;
+    return true;
+
+  case i2l:
+  case i2d:
+  case f2l:
+  case f2d:
+    *popped = 1;
+    *pushed = 2;
+    return true;
+
+  case iadd:
+  case isub:
+  case imul:
+  case idiv:
+  case irem:
+  case iand:
+  case ior:
+  case ixor:
+  case ishl:
+  case ishr:
+  case iushr:
+  case fadd:
+  case fsub:
+  case fmul:
+  case fdiv:
+  case frem:
+  case fcmpl:
+  case fcmpg:
+  case l2i:
+  case l2f:
+  case d2i:
+  case d2f:
+    *popped = 2;
+    *pushed = 1;
+    return true;
+
+  case lneg:
+  case dneg:
+  case l2d:
+  case d2l:
+    *popped = 2;
+    *pushed = 2;
+    return true;
+
+  case lshl:
+  case lshr:
+  case lushr:
+    *popped = 3;
+    *pushed = 2;
+    return true;
+
+  case ladd:
+  case lsub:
+  case lmul:
+  case ldiv_:
+  case lrem:
+  case land:
+  case lor:
+  case lxor:
+  case dadd:
+  case dsub:
+  case dmul:
+  case ddiv:
+  case drem:
+    *popped = 4;
+    *pushed = 2;
+    return true;
+
+  case lcmp:
+  case dcmpl:
+  case dcmpg:
+    *popped = 4;
+    *pushed = 1;
+    return true;
+
+  case getstatic:
+  case getfield: {
+    unsigned p = ip + 1;
+    uint16_t index = codeReadInt16(t, code, p);
+    object reference = singletonObject(t, code->pool(), index - 1);
+
+    bool large;
+    if (objectClass(t, reference) == type(t, GcField::Type)) {
+      unsigned fieldCode = cast<GcField>(t, reference)->code();
+      large = fieldCode == LongField or fieldCode == DoubleField;
+    } else {
+      uint8_t spec = cast<GcReference>(t, reference)->spec()->body()[0];
+      large = spec == 'J' or spec == 'D';
+    }
+
+    *popped = instruction == getfield ? 1 : 0;
+    *pushed = large ? 2 : 1;
+    return true;
+  }
+
+  default:
+    return false;
+  }
+}
+
+// Marks in entries (which must have room for code->length() + 1
+// elements) each instruction control may reach other than by falling
+// through from the one before it.  Returns false if a branch target
+// lies outside the method.
+bool findBlockEntries(MyThread* t, GcCode* code, Slice<bool> entries)
+{
+  unsigned length = code->length();
+  for (unsigned ip = 0; ip < length; ip += instructionLength(t, code, ip)) {
+    unsigned count = branchTargets(t, code, ip, 0);
+    if (count) {
+      THREAD_RUNTIME_ARRAY(t, unsigned, targets, count);
+      branchTargets(t, code, ip, RUNTIME_ARRAY_BODY(targets));
+      for (unsigned i = 0; i < count; ++i) {
+        if (RUNTIME_ARRAY_BODY(targets)[i] >= length) {
+          return false;
+        }
+        entries[RUNTIME_ARRAY_BODY(targets)[i]] = true;
+      }
+    }
+
+    if (endsBlock(t, code, ip)) {
+      entries[ip + instructionLength(t, code, ip)] = true;
+    }
+  }
+
+  GcExceptionHandlerTable* table
+      = cast<GcExceptionHandlerTable>(t, code->exceptionHandlerTable());
+  if (table) {
+    for (unsigned i = 0; i < table->length(); ++i) {
+      unsigned handler = exceptionHandlerIp(table->body()[i]);
+      if (handler < length) {
+        entries[handler] = true;
+      }
+    }
+  }
+
+  return true;
+}
+
+void findSafeArrayAccesses(MyThread* t, Context* context)
+{
+  GcCode* code = context->method->code();
+  unsigned length = code->length();
+  Zone* zone = &(context->zone);
+
+  InstructionMap map(Slice<bool>::allocAndSet(zone, length + 1, false));
+  for (unsigned ip = 0; ip < length; ip += instructionLength(t, code, ip)) {
+    ++map.instructionCount;
+    map.edgeCount += branchTargets(t, code, ip, 0);
+  }
+
+  map.starts = static_cast<unsigned*>(
+      zone->allocate(map.instructionCount * sizeof(unsigned)));
+  map.sources
+      = static_cast<unsigned*>(zone->allocate(map.edgeCount * sizeof(unsigned)));
+  map.targets
+      = static_cast<unsigned*>(zone->allocate(map.edgeCount * sizeof(unsigned)));
+
+  if (not findBlockEntries(t, code, map.entries)) {
+    // malformed; leave every check in place
+    return;
+  }
+
+  { unsigned instruction = 0;
+    unsigned edge = 0;
+    for (unsigned ip = 0; ip < length; ip += instructionLength(t, code, ip)) {
+      map.starts[instruction++] = ip;
+
+      unsigned count = branchTargets(t, code, ip, map.targets + edge);
+      for (unsigned i = edge; i < edge + count; ++i) {
+        map.sources[i] = ip;
+      }
+      edge += count;
+    }
+  }
+
+  RangeFact* facts = static_cast<RangeFact*>(
+      zone->allocate(map.edgeCount * sizeof(RangeFact)));
+  unsigned factCount = 0;
+  for (unsigned i = 0; i < map.edgeCount; ++i) {
+    if (map.targets[i] <= map.sources[i]
+        and findRangeFact(t, code, &map, i, facts + factCount)) {
+      ++factCount;
+    }
+  }
+
+  // walk each extended basic block, following which locals the array
+  // and index operands of each access were loaded from:
+  unsigned localCount = code->maxLocals();
+  unsigned* versions = static_cast<unsigned*>(
+      zone->allocate(localCount * sizeof(unsigned)));
+  memset(versions, 0, localCount * sizeof(unsigned));
+  unsigned version = 0;
+
+  OperandStack stack(static_cast<AccessOperand*>(zone->allocate(
+                         (code->maxStack() + 1) * sizeof(AccessOperand))),
+                     code->maxStack() + 1);
+
+  CheckedAccess checked[CheckedAccessCount];
+  unsigned checkedCount = 0;
+  unsigned nextChecked = 0;
+
+  for (unsigned ip = 0; ip < length; ip += instructionLength(t, code, ip)) {
+    if (map.entries[ip]) {
+      stack.clear();
+      checkedCount = 0;
+      nextChecked = 0;
+    }
+
+    unsigned instruction = code->body()[ip];
+    unsigned index;
+    unsigned popped;
+    unsigned pushed;
+    int count;
+
+    if (localOperand(t, code, ip, iload, iload_0, &index)
+        or localOperand(t, code, ip, aload, aload_0, &index)) {
+      if (index < localCount) {
+        stack.push(AccessOperand(index, versions[index], ip));
+      } else {
+        stack.pushUnknown(1);
+      }
+    } else if (localOperand(t, code, ip, istore, istore_0, &index)
+               or localOperand(t, code, ip, fstore, fstore_0, &index)
+               or localOperand(t, code, ip, astore, astore_0, &index)) {
+      assignLocals(versions, localCount, &version, index, 1);
+      stack.pop(1);
+    } else if (localOperand(t, code, ip, lstore, lstore_0, &index)
+               or localOperand(t, code, ip, dstore, dstore_0, &index)) {
+      assignLocals(versions, localCount, &version, index, 2);
+      stack.pop(2);
+    } else if (incrementOperand(t, code, ip, &index, &count)) {
+      assignLocals(versions, localCount, &version, index, 1);
+    } else {
+      switch (instruction) {
+      case iconst_m1:
+      case iconst_0:
+      case iconst_1:
+      case iconst_2:
+      case iconst_3:
+      case iconst_4:
+      case iconst_5:
+        stack.push(AccessOperand(static_cast<int32_t>(instruction) - iconst_0));
+        break;
+
+      case bipush:
+        stack.push(
+            AccessOperand(static_cast<int32_t>(
+                static_cast<int8_t>(code->body()[ip + 1]))));
+        break;
+
+      case sipush: {
+        unsigned p = ip + 1;
+        stack.push(
+            AccessOperand(static_cast<int32_t>(codeReadInt16(t, code, p))));
+      } break;
+
+      case aaload:
+      case baload:
+      case caload:
+      case daload:
+      case faload:
+      case iaload:
+      case laload:
+      case saload:
+      case aastore:
+      case bastore:
+      case castore:
+      case dastore:
+      case fastore:
+      case iastore:
+      case lastore:
+      case sastore: {
+        bool load = instruction <= saload;
+        unsigned valueSize
+            = load ? 0 : (instruction == lastore or instruction == dastore
+                              ? 2
+                              : 1);
+        AccessOperand array = stack.peek(valueSize + 1);
+        AccessOperand subscript = stack.peek(valueSize);
+
+        bool safe = false;
+        for (unsigned i = 0; i < factCount and not safe; ++i) {
+          RangeFact* f = facts + i;
+          safe = subscript.kind == AccessOperand::Local
+                 and array.kind == AccessOperand::Local
+                 and subscript.local == f->index and array.local == f->array
+                 and subscript.ip >= f->start and subscript.ip < f->end
+                 and array.ip >= f->loopStart and array.ip < f->loopEnd;
+        }
+
+        for (unsigned i = 0; i < checkedCount and not safe; ++i) {
+          CheckedAccess* c = checked + i;
+          safe = sameValue(array, c->array)
+                 and (sameValue(subscript, c->subscript)
+                      or (subscript.kind == AccessOperand::Constant
+                          and c->subscript.kind == AccessOperand::Constant
+                          and subscript.value >= 0
+                          and subscript.value <= c->subscript.value));
+        }
+
+        context->safeArrayAccesses[ip] = safe;
+
+        // past this point in the block the access is known to have
+        // succeeded:
+        if (array.kind == AccessOperand::Local
+            and (subscript.kind == AccessOperand::Local
+                 or (subscript.kind == AccessOperand::Constant
+                     and subscript.value >= 0))) {
+          checked[nextChecked].array = array;
+          checked[nextChecked].subscript = subscript;
+          nextChecked = (nextChecked + 1) % CheckedAccessCount;
+          if (checkedCount < CheckedAccessCount) {
+            ++checkedCount;
+          }
+        }
+
+        stack.pop(valueSize + 2);
+        if (load) {
+          stack.pushUnknown(instruction == laload or instruction == daload ? 2
+                                                                          : 1);
+        }
+      } break;
+
+      case dup:
+        stack.push(stack.peek(0));
+        break;
+
+      case dup_x1: {
+        AccessOperand a = stack.peek(0);
+        AccessOperand b = stack.peek(1);
+        stack.pop(2);
+        stack.push(a);
+        stack.push(b);
+        stack.push(a);
+      } break;
+
+      case dup_x2: {
+        AccessOperand a = stack.peek(0);
+        AccessOperand b = stack.peek(1);
+        AccessOperand c = stack.peek(2);
+        stack.pop(3);
+        stack.push(a);
+        stack.push(c);
+        stack.push(b);
+        stack.push(a);
+      } break;
+
+      case dup2: {
+        AccessOperand a = stack.peek(0);
+        AccessOperand b = stack.peek(1);
+        stack.push(b);
+        stack.push(a);
+      } break;
+
+      case dup2_x1: {
+        AccessOperand a = stack.peek(0);
+        AccessOperand b = stack.peek(1);
+        AccessOperand c = stack.peek(2);
+        stack.pop(3);
+        stack.push(b);
+        stack.push(a);
+        stack.push(c);
+        stack.push(b);
+        stack.push(a);
+      } break;
+
+      case dup2_x2: {
+        AccessOperand a = stack.peek(0);
+        AccessOperand b = stack.peek(1);
+        AccessOperand c = stack.peek(2);
+        AccessOperand d = stack.peek(3);
+        stack.pop(4);
+        stack.push(b);
+        stack.push(a);
+        stack.push(d);
+        stack.push(c);
+        stack.push(b);
+        stack.push(a);
+      } break;
+
+      case swap: {
+        AccessOperand a = stack.peek(0);
+        AccessOperand b = stack.peek(1);
+        stack.pop(2);
+        stack.push(a);
+        stack.push(b);
+      } break;
+
+      default:
+        if (plainStackEffect(t, code, ip, &popped, &pushed)) {
+          stack.pop(popped);
+          stack.pushUnknown(pushed);
+        } else {
+          stack.clear();
+        }
+        break;
+      }
+    }
+  }
+}
+
+// Reports to the compiler each loop in the method, which we take to be
+// the code from the target of a backward branch to the last branch
+// back to it, as javac lays out loops.  The register allocator uses
+// this to keep reloads out of loops when it can (see evictionPolicy).
+void findLoops(MyThread* t, Context* context)
+{
+  GcCode* code = context->method->code();
+  unsigned length = code->length();
+
+  // the end of the last backward branch to each instruction, if any:
+  unsigned* ends
+      = static_cast<unsigned*>(context->zone.allocate(length * sizeof(unsigned)));
+  memset(ends, 0, length * sizeof(unsigned));
+
+  for (unsigned ip = 0; ip < length; ip += instructionLength(t, code, ip)) {
+    unsigned count = branchTargets(t, code, ip, 0);
+    if (count) {
+      THREAD_RUNTIME_ARRAY(t, unsigned, targets, count);
+      branchTargets(t, code, ip, RUNTIME_ARRAY_BODY(targets));
+      for (unsigned i = 0; i < count; ++i) {
+        unsigned target = RUNTIME_ARRAY_BODY(targets)[i];
+        if (target <= ip and ends[target] < ip + 1) {
+          ends[target] = ip + 1;
+        }
+      }
+    }
+  }
+
+  for (unsigned ip = 0; ip < length; ++ip) {
+    if (ends[ip]) {
+      context->compiler->addLoop(ip, ends[ip] - 1);
+    }
+  }
+}
+
+// Optional optimizations (see ValueCache)
+
+void ValueCache::visit(MyThread* t, GcCode* code, unsigned ip)
+{
+  if (ip != nextIp or blockEntries[ip]) {
+    constantCount = 0;
+    aliasCount = 0;
+    entryCount = 0;
+  }
+
+  // the compiler visits branch targets before the code following a
+  // branch, so nothing carries over past one:
+  if (branchTargets(t, code, ip, 0) or endsBlock(t, code, ip)) {
+    nextIp = end;
+  } else {
+    nextIp = ip + instructionLength(t, code, ip);
+  }
+}
+
+int64_t normalize(int64_t v, unsigned size)
+{
+  return size == 4 ? static_cast<int32_t>(v) : v;
+}
+
+// Returns true if v is a positive power of two, storing its base two
+// logarithm in exponent.
+bool powerOfTwo(int64_t v, unsigned* exponent)
+{
+  if (v <= 0 or (v & (v - 1))) {
+    return false;
+  }
+
+  unsigned n = 0;
+  while (v > 1) {
+    v >>= 1;
+    ++n;
+  }
+  *exponent = n;
+  return true;
+}
+
+// Computes the result of op applied to constants, with a as the second
+// operand and b the first, as for Compiler::binaryOp.  Returns false
+// if the operation would throw instead.
+bool foldBinaryOp(lir::TernaryOperation op,
+                  unsigned size,
+                  int64_t a,
+                  int64_t b,
+                  int64_t* result)
+{
+  unsigned shiftMask = size * 8 - 1;
+  uint64_t x = b;
+  uint64_t y = a;
+  uint64_t r;
+
+  switch (op) {
+  case lir::Add:
+    r = x + y;
+    break;
+  case lir::Subtract:
+    r = x - y;
+    break;
+  case lir::Multiply:
+    r = x * y;
+    break;
+  case lir::And:
+    r = x & y;
+    break;
+  case lir::Or:
+    r = x | y;
+    break;
+  case lir::Xor:
+    r = x ^ y;
+    break;
+  case lir::ShiftLeft:
+    r = x << (a & shiftMask);
+    break;
+  case lir::ShiftRight:
+    r = normalize(b, size) >> (a & shiftMask);
+    break;
+  case lir::UnsignedShiftRight:
+    r = (size == 4 ? x & 0xFFFFFFFF : x) >> (a & shiftMask);
+    break;
+  case lir::Divide:
+  case lir::Remainder:
+    a = normalize(a, size);
+    b = normalize(b, size);
+    if (a == 0) {
+      return false;
+    } else if (a == -1) {
+      // avoid overflow on the most negative value
+      r = (op == lir::Divide ? 0 - x : 0);
+    } else {
+      r = (op == lir::Divide ? b / a : b % a);
+    }
+    break;
+  default:
+    return false;
+  }
+
+  *result = normalize(r, size);
+  return true;
+}
+
+// Returns an equivalent of "v op k" for the constant k which is
+// cheaper to compute, or null if there is none.
+ir::Value* simplifyBinaryOp(avian::codegen::Compiler* c,
+                            lir::TernaryOperation op,
+                            ir::Type type,
+                            int64_t k,
+                            ir::Value* v)
+{
+  unsigned bits = type.rawSize() * 8;
+  k = normalize(k, type.rawSize());
+  unsigned n;
+
+  switch (op) {
+  case lir::Add:
+  case lir::Subtract:
+  case lir::Or:
+  case lir::Xor:
+    return k == 0 ? v : 0;
+
+  case lir::ShiftLeft:
+  case lir::ShiftRight:
+  case lir::UnsignedShiftRight:
+    return (k & (bits - 1)) == 0 ? v : 0;
+
+  case lir::And:
+    if (k == -1) {
+      return v;
+    } else if (k == 0) {
+      return c->constant(0, type);
+    }
+    return 0;
+
+  case lir::Multiply:
+    if (k == 0) {
+      return c->constant(0, type);
+    } else if (k == 1) {
+      return v;
+    } else if (k == -1) {
+      return c->unaryOp(lir::Negate, v);
+    } else if (powerOfTwo(k, &n)) {
+      return c->binaryOp(
+          lir::ShiftLeft, type, c->constant(n, ir::Type::i4()), v);
+    }
+    return 0;
+
+  case lir::Divide:
+  case lir::Remainder:
+    if (k == 1 or k == -1) {
+      if (op == lir::Remainder) {
+        return c->constant(0, type);
+      } else {
+        return k == 1 ? v : c->unaryOp(lir::Negate, v);
+      }
+    } else if (powerOfTwo(k, &n)) {
+      // round towards zero by adding k - 1 to negative dividends
+      // before shifting or masking:
+      ir::Value* bias = c->binaryOp(
+          lir::UnsignedShiftRight,
+          type,
+          c->constant(bits - n, ir::Type::i4()),
+          c->binaryOp(lir::ShiftRight,
+                      type,
+                      c->constant(bits - 1, ir::Type::i4()),
+                      v));
+      ir::Value* biased = c->binaryOp(lir::Add, type, bias, v);
+
+      if (op == lir::Divide) {
+        return c->binaryOp(
+            lir::ShiftRight, type, c->constant(n, ir::Type::i4()), biased);
+      } else {
+        return c->binaryOp(
+            lir::Subtract,
+            type,
+            c->binaryOp(lir::And, type, c->constant(-k, type), biased),
+            v);
+      }
+    }
+    return 0;
+
+  default:
+    return 0;
+  }
+}
+
+bool commutative(lir::TernaryOperation op)
+{
+  switch (op) {
+  case lir::Add:
+  case lir::Multiply:
+  case lir::And:
+  case lir::Or:
+  case lir::Xor:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+// Returns true if v is known to be a non-zero constant, so that
+// dividing by it can't throw.
+bool nonZeroConstant(Context* context, ir::Value* v)
+{
+  int64_t k;
+  return context->values and context->values->constant(v, &k)
+         and normalize(k, v->type.rawSize()) != 0;
+}
+
+ir::Value* binaryOp(Context* context,
+                    lir::TernaryOperation op,
+                    ir::Type type,
+                    ir::Value* a,
+                    ir::Value* b)
+{
+  avian::codegen::Compiler* c = context->compiler;
+  ValueCache* values = context->values;
+  if (values == 0 or (type != ir::Type::i4() and type != ir::Type::i8())) {
+    return c->binaryOp(op, type, a, b);
+  }
+
+  unsigned size = type.rawSize();
+  ValueCache::Operand ao = values->operand(a);
+  ValueCache::Operand bo = values->operand(b);
+
+  int64_t result;
+  if (ao.value == 0 and bo.value == 0
+      and foldBinaryOp(op, size, ao.constant, bo.constant, &result)) {
+    return c->constant(result, type);
+  }
+
+  ir::Value* r = values->find(op, size, ao, bo);
+  if (r == 0 and commutative(op)) {
+    r = values->find(op, size, bo, ao);
+  }
+
+  if (r == 0) {
+    if (ao.value == 0) {
+      r = simplifyBinaryOp(c, op, type, ao.constant, b);
+    } else if (bo.value == 0 and commutative(op)) {
+      r = simplifyBinaryOp(c, op, type, bo.constant, a);
+    }
+
+    if (r == 0) {
+      r = c->binaryOp(op, type, a, b);
+    }
+
+    values->add(op, size, ao, bo, r);
+  }
+
+  return r;
+}
+
+ir::Value* unaryOp(Context* context, lir::BinaryOperation op, ir::Value* a)
+{
+  avian::codegen::Compiler* c = context->compiler;
+  ValueCache* values = context->values;
+  if (values == 0 or op != lir::Negate
+      or (a->type != ir::Type::i4() and a->type != ir::Type::i8())) {
+    return c->unaryOp(op, a);
+  }
+
+  unsigned size = a->type.rawSize();
+  ValueCache::Operand ao = values->operand(a);
+  if (ao.value == 0) {
+    return c->constant(normalize(0 - static_cast<uint64_t>(ao.constant), size),
+                       a->type);
+  }
+
+  ValueCache::Operand none;
+  ir::Value* r = values->find(ValueCache::Negate, size, ao, none);
+  if (r == 0) {
+    r = c->unaryOp(op, a);
+    values->add(ValueCache::Negate, size, ao, none, r);
+  }
+  return r;
+}
+
+ir::Value* arrayLength(Context* context, ir::Value* array)
+{
+  avian::codegen::Compiler* c = context->compiler;
+  ValueCache* values = context->values;
+
+  ValueCache::Operand ao;
+  ValueCache::Operand none;
+  if (values) {
+    // an array's length never changes, and if the array were null the
+    // first load would already have thrown:
+    ao = values->operand(array);
+    ir::Value* r = values->find(ValueCache::ArrayLength, 4, ao, none);
+    if (r) {
+      return r;
+    }
+  }
+
+  ir::Value* r = c->load(
+      ir::ExtendMode::Signed,
+      c->memory(array, ir::Type::iptr(), TargetArrayLength),
+      ir::Type::i4());
+
+  if (values) {
+    values->add(ValueCache::ArrayLength, 4, ao, none, r);
+  }
+  return r;
+}
+
+bool needsReturnBarrier(MyThread* t UNUSED, GcMethod* method)
+{
+  return (method->flags() & ConstructorFlag)
+         and (method->class_()->vmFlags() & HasFinalMemberFlag);
+}
+
+bool returnsNext(MyThread* t, GcCode* code, unsigned ip)
+{
+  switch (code->body()[ip]) {
+  case return_:
+  case areturn:
+  case ireturn:
+  case freturn:
+  case lreturn:
+  case dreturn:
+    return true;
+
+  case goto_: {
+    uint32_t offset = codeReadInt16(t, code, ++ip);
+    uint32_t newIp = (ip - 3) + offset;
+    assertT(t, newIp < code->length());
+
+    return returnsNext(t, code, newIp);
+  }
+
+  case goto_w: {
+    uint32_t offset = codeReadInt32(t, code, ++ip);
+    uint32_t newIp = (ip - 5) + offset;
+    assertT(t, newIp < code->length());
+
+    return returnsNext(t, code, newIp);
+  }
+
+  default:
+    return false;
+  }
+}
+
+bool isTailCall(MyThread* t,
+                GcCode* code,
+                unsigned ip,
+                GcMethod* caller,
+                int calleeReturnCode,
+                GcByteArray* calleeClassName,
+                GcByteArray* calleeMethodName,
+                GcByteArray* calleeMethodSpec)
+{
+  return avian::codegen::TailCalls
+         and ((caller->flags() & ACC_SYNCHRONIZED) == 0)
+         and (not inTryBlock(t, code, ip - 1))
+         and (not needsReturnBarrier(t, caller))
+         and (caller->returnCode() == VoidField
+              or caller->returnCode() == calleeReturnCode)
+         and returnsNext(t, code, ip)
+         and t->m->classpath->canTailCall(t,
+                                          caller,
+                                          calleeClassName,
+                                          calleeMethodName,
+                                          calleeMethodSpec);
+}
+
+bool isTailCall(MyThread* t,
+                GcCode* code,
+                unsigned ip,
+                GcMethod* caller,
+                GcMethod* callee)
+{
+  return isTailCall(t,
+                    code,
+                    ip,
+                    caller,
+                    callee->returnCode(),
+                    callee->class_()->name(),
+                    callee->name(),
+                    callee->spec());
+}
+
+bool isReferenceTailCall(MyThread* t,
+                         GcCode* code,
+                         unsigned ip,
+                         GcMethod* caller,
+                         GcReference* calleeReference)
+{
+  return isTailCall(t,
+                    code,
+                    ip,
+                    caller,
+                    methodReferenceReturnCode(t, calleeReference),
+                    calleeReference->class_(),
+                    calleeReference->name(),
+                    calleeReference->spec());
+}
+
+lir::TernaryOperation toCompilerJumpOp(MyThread* t, unsigned instruction)
+{
+  switch (instruction) {
+  case ifeq:
+  case if_icmpeq:
+  case if_acmpeq:
+  case ifnull:
+    return lir::JumpIfEqual;
+  case ifne:
+  case if_icmpne:
+  case if_acmpne:
+  case ifnonnull:
+    return lir::JumpIfNotEqual;
+  case ifgt:
+  case if_icmpgt:
+    return lir::JumpIfGreater;
+  case ifge:
+  case if_icmpge:
+    return lir::JumpIfGreaterOrEqual;
+  case iflt:
+  case if_icmplt:
+    return lir::JumpIfLess;
+  case ifle:
+  case if_icmple:
+    return lir::JumpIfLessOrEqual;
+  default:
+    abort(t);
+  }
+}
+
+bool integerBranch(MyThread* t,
+                   Frame* frame,
+                   GcCode* code,
+                   unsigned& ip,
+                   ir::Value* a,
+                   ir::Value* b,
+                   unsigned* newIpp)
+{
+  if (ip + 3 > code->length()) {
+    return false;
+  }
+
+  avian::codegen::Compiler* c = frame->c;
+  unsigned instruction = code->body()[ip++];
+  uint32_t offset = codeReadInt16(t, code, ip);
+  uint32_t newIp = (ip - 3) + offset;
+  assertT(t, newIp < code->length());
+
+  ir::Value* target = frame->machineIpValue(newIp);
+
+  switch (instruction) {
+  case ifeq:
+  case ifne:
+  case ifgt:
+  case ifge:
+  case iflt:
+  case ifle:
+    c->condJump(toCompilerJumpOp(t, instruction), a, b, target);
+    break;
+
+  default:
+    ip -= 3;
+    return false;
+  }
+
+  *newIpp = newIp;
+  return true;
+}
+
+lir::TernaryOperation toCompilerFloatJumpOp(MyThread* t,
+                                            unsigned instruction,
+                                            bool lessIfUnordered)
+{
+  switch (instruction) {
+  case ifeq:
+    return lir::JumpIfFloatEqual;
+  case ifne:
+    return lir::JumpIfFloatNotEqual;
+  case ifgt:
+    if (lessIfUnordered) {
+      return lir::JumpIfFloatGreater;
+    } else {
+      return lir::JumpIfFloatGreaterOrUnordered;
+    }
+  case ifge:
+    if (lessIfUnordered) {
+      return lir::JumpIfFloatGreaterOrEqual;
+    } else {
+      return lir::JumpIfFloatGreaterOrEqualOrUnordered;
+    }
+  case iflt:
+    if (lessIfUnordered) {
+      return lir::JumpIfFloatLessOrUnordered;
+    } else {
+      return lir::JumpIfFloatLess;
+    }
+  case ifle:
+    if (lessIfUnordered) {
+      return lir::JumpIfFloatLessOrEqualOrUnordered;
+    } else {
+      return lir::JumpIfFloatLessOrEqual;
+    }
+  default:
+    abort(t);
+  }
+}
+
+bool floatBranch(MyThread* t,
+                 Frame* frame,
+                 GcCode* code,
+                 unsigned& ip,
+                 bool lessIfUnordered,
+                 ir::Value* a,
+                 ir::Value* b,
+                 unsigned* newIpp)
+{
+  if (ip + 3 > code->length()) {
+    return false;
+  }
+
+  avian::codegen::Compiler* c = frame->c;
+  unsigned instruction = code->body()[ip++];
+  uint32_t offset = codeReadInt16(t, code, ip);
+  uint32_t newIp = (ip - 3) + offset;
+  assertT(t, newIp < code->length());
+
+  ir::Value* target = frame->machineIpValue(newIp);
+
+  switch (instruction) {
+  case ifeq:
+  case ifne:
+  case ifgt:
+  case ifge:
+  case iflt:
+  case ifle:
+    c->condJump(
+        toCompilerFloatJumpOp(t, instruction, lessIfUnordered), a, b, target);
+    break;
+
+  default:
+    ip -= 3;
+    return false;
+  }
+
+  *newIpp = newIp;
+  return true;
+}
+
+ir::Value* popLongAddress(Frame* frame)
+{
+  return TargetBytesPerWord == 8
+             ? frame->popLarge(ir::Type::i8())
+             : frame->c->load(ir::ExtendMode::Signed,
+                              frame->popLarge(ir::Type::i8()),
+                              ir::Type::iptr());
+}
+
+bool intrinsic(MyThread* t, Frame* frame, GcMethod* target)
+{
+#define MATCH(name, constant)         \
+  (name->length() == sizeof(constant) \
+   and ::strcmp(reinterpret_cast<char*>(name->body().begin()), constant) == 0)
+
+  GcByteArray* className = target->class_()->name();
+  if (UNLIKELY(MATCH(className, "java/lang/Math"))) {
+    avian::codegen::Compiler* c = frame->c;
+    if (MATCH(target->name(), "sqrt") and MATCH(target->spec(), "(D)D")) {
+      frame->pushLarge(
+          ir::Type::f8(),
+          c->unaryOp(lir::FloatSquareRoot, frame->popLarge(ir::Type::f8())));
+      return true;
+    } else if (MATCH(target->name(), "abs")) {
+      if (MATCH(target->spec(), "(I)I")) {
+        frame->push(ir::Type::i4(),
+                    c->unaryOp(lir::Absolute, frame->pop(ir::Type::i4())));
+        return true;
+      } else if (MATCH(target->spec(), "(J)J")) {
         frame->pushLarge(
             ir::Type::i8(),
             c->unaryOp(lir::Absolute, frame->popLarge(ir::Type::i8())));
@@ -3741,117 +5666,1104 @@ bool intrinsic(MyThread* t UNUSED, Frame* frame, GcMethod* target)
         return true;
       }
     }
-  } else if (UNLIKELY(MATCH(className, "sun/misc/Unsafe"))) {
-    avian::codegen::Compiler* c = frame->c;
-    if (MATCH(target->name(), "getByte") and MATCH(target->spec(), "(J)B")) {
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      frame->push(ir::Type::i4(),
-                  c->load(ir::ExtendMode::Signed,
-                          c->memory(address, ir::Type::i1()),
-                          ir::Type::i4()));
-      return true;
-    } else if (MATCH(target->name(), "putByte")
-               and MATCH(target->spec(), "(JB)V")) {
-      ir::Value* value = frame->pop(ir::Type::i4());
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      c->store(value, c->memory(address, ir::Type::i1()));
-      return true;
-    } else if ((MATCH(target->name(), "getShort")
-                and MATCH(target->spec(), "(J)S"))
-               or (MATCH(target->name(), "getChar")
-                   and MATCH(target->spec(), "(J)C"))) {
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      frame->push(ir::Type::i4(),
-                  c->load(ir::ExtendMode::Signed,
-                          c->memory(address, ir::Type::i2()),
-                          ir::Type::i4()));
-      return true;
-    } else if ((MATCH(target->name(), "putShort")
-                and MATCH(target->spec(), "(JS)V"))
-               or (MATCH(target->name(), "putChar")
-                   and MATCH(target->spec(), "(JC)V"))) {
-      ir::Value* value = frame->pop(ir::Type::i4());
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      c->store(value, c->memory(address, ir::Type::i2()));
-      return true;
-    } else if ((MATCH(target->name(), "getInt")
-                and MATCH(target->spec(), "(J)I"))
-               or (MATCH(target->name(), "getFloat")
-                   and MATCH(target->spec(), "(J)F"))) {
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      ir::Type type = MATCH(target->name(), "getInt") ? ir::Type::i4()
-                                                      : ir::Type::f4();
-      frame->push(
-          type,
-          c->load(ir::ExtendMode::Signed, c->memory(address, type), type));
-      return true;
-    } else if ((MATCH(target->name(), "putInt")
-                and MATCH(target->spec(), "(JI)V"))
-               or (MATCH(target->name(), "putFloat")
-                   and MATCH(target->spec(), "(JF)V"))) {
-      ir::Type type = MATCH(target->name(), "putInt") ? ir::Type::i4()
-                                                      : ir::Type::f4();
-      ir::Value* value = frame->pop(type);
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      c->store(value, c->memory(address, type));
-      return true;
-    } else if ((MATCH(target->name(), "getLong")
-                and MATCH(target->spec(), "(J)J"))
-               or (MATCH(target->name(), "getDouble")
-                   and MATCH(target->spec(), "(J)D"))) {
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      ir::Type type = MATCH(target->name(), "getLong") ? ir::Type::i8()
-                                                       : ir::Type::f8();
-      frame->pushLarge(
-          type,
-          c->load(ir::ExtendMode::Signed, c->memory(address, type), type));
-      return true;
-    } else if ((MATCH(target->name(), "putLong")
-                and MATCH(target->spec(), "(JJ)V"))
-               or (MATCH(target->name(), "putDouble")
-                   and MATCH(target->spec(), "(JD)V"))) {
-      ir::Type type = MATCH(target->name(), "putLong") ? ir::Type::i8()
-                                                       : ir::Type::f8();
-      ir::Value* value = frame->popLarge(type);
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      c->store(value, c->memory(address, type));
-      return true;
-    } else if (MATCH(target->name(), "getAddress")
-               and MATCH(target->spec(), "(J)J")) {
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      frame->pushLarge(ir::Type::i8(),
-                       c->load(ir::ExtendMode::Signed,
-                               c->memory(address, ir::Type::iptr()),
-                               ir::Type::i8()));
-      return true;
-    } else if (MATCH(target->name(), "putAddress")
-               and MATCH(target->spec(), "(JJ)V")) {
-      ir::Value* value = frame->popLarge(ir::Type::i8());
-      ir::Value* address = popLongAddress(frame);
-      frame->pop(ir::Type::object());
-      c->store(value, c->memory(address, ir::Type::iptr()));
-      return true;
+  } else if (UNLIKELY(MATCH(className, "sun/misc/Unsafe"))) {
+    avian::codegen::Compiler* c = frame->c;
+    if (MATCH(target->name(), "getByte") and MATCH(target->spec(), "(J)B")) {
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      frame->push(ir::Type::i4(),
+                  c->load(ir::ExtendMode::Signed,
+                          c->memory(address, ir::Type::i1()),
+                          ir::Type::i4()));
+      return true;
+    } else if (MATCH(target->name(), "putByte")
+               and MATCH(target->spec(), "(JB)V")) {
+      ir::Value* value = frame->pop(ir::Type::i4());
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      c->store(value, c->memory(address, ir::Type::i1()));
+      return true;
+    } else if ((MATCH(target->name(), "getShort")
+                and MATCH(target->spec(), "(J)S"))
+               or (MATCH(target->name(), "getChar")
+                   and MATCH(target->spec(), "(J)C"))) {
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      frame->push(ir::Type::i4(),
+                  c->load(ir::ExtendMode::Signed,
+                          c->memory(address, ir::Type::i2()),
+                          ir::Type::i4()));
+      return true;
+    } else if ((MATCH(target->name(), "putShort")
+                and MATCH(target->spec(), "(JS)V"))
+               or (MATCH(target->name(), "putChar")
+                   and MATCH(target->spec(), "(JC)V"))) {
+      ir::Value* value = frame->pop(ir::Type::i4());
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      c->store(value, c->memory(address, ir::Type::i2()));
+      return true;
+    } else if ((MATCH(target->name(), "getInt")
+                and MATCH(target->spec(), "(J)I"))
+               or (MATCH(target->name(), "getFloat")
+                   and MATCH(target->spec(), "(J)F"))) {
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      ir::Type type = MATCH(target->name(), "getInt") ? ir::Type::i4()
+                                                      : ir::Type::f4();
+      frame->push(
+          type,
+          c->load(ir::ExtendMode::Signed, c->memory(address, type), type));
+      return true;
+    } else if ((MATCH(target->name(), "putInt")
+                and MATCH(target->spec(), "(JI)V"))
+               or (MATCH(target->name(), "putFloat")
+                   and MATCH(target->spec(), "(JF)V"))) {
+      ir::Type type = MATCH(target->name(), "putInt") ? ir::Type::i4()
+                                                      : ir::Type::f4();
+      ir::Value* value = frame->pop(type);
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      c->store(value, c->memory(address, type));
+      return true;
+    } else if ((MATCH(target->name(), "getLong")
+                and MATCH(target->spec(), "(J)J"))
+               or (MATCH(target->name(), "getDouble")
+                   and MATCH(target->spec(), "(J)D"))) {
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      ir::Type type = MATCH(target->name(), "getLong") ? ir::Type::i8()
+                                                       : ir::Type::f8();
+      frame->pushLarge(
+          type,
+          c->load(ir::ExtendMode::Signed, c->memory(address, type), type));
+      return true;
+    } else if ((MATCH(target->name(), "putLong")
+                and MATCH(target->spec(), "(JJ)V"))
+               or (MATCH(target->name(), "putDouble")
+                   and MATCH(target->spec(), "(JD)V"))) {
+      ir::Type type = MATCH(target->name(), "putLong") ? ir::Type::i8()
+                                                       : ir::Type::f8();
+      ir::Value* value = frame->popLarge(type);
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      c->store(value, c->memory(address, type));
+      return true;
+    } else if (MATCH(target->name(), "getAddress")
+               and MATCH(target->spec(), "(J)J")) {
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      frame->pushLarge(ir::Type::i8(),
+                       c->load(ir::ExtendMode::Signed,
+                               c->memory(address, ir::Type::iptr()),
+                               ir::Type::i8()));
+      return true;
+    } else if (MATCH(target->name(), "putAddress")
+               and MATCH(target->spec(), "(JJ)V")) {
+      ir::Value* value = frame->popLarge(ir::Type::i8());
+      ir::Value* address = popLongAddress(frame);
+      frame->pop(ir::Type::object());
+      c->store(value, c->memory(address, ir::Type::iptr()));
+      return true;
+    }
+  } else if (UNLIKELY(MATCH(className, "java/lang/String"))) {
+    // call the kernels directly rather than going through the native
+    // method machinery:
+    avian::codegen::Compiler* c = frame->c;
+    if (MATCH(target->name(), "charsEqual")
+        and MATCH(target->spec(),
+                  "(Ljava/lang/Object;ILjava/lang/Object;II)Z")) {
+      ir::Value* length = frame->pop(ir::Type::i4());
+      ir::Value* bOffset = frame->pop(ir::Type::i4());
+      ir::Value* b = frame->pop(ir::Type::object());
+      ir::Value* aOffset = frame->pop(ir::Type::i4());
+      ir::Value* a = frame->pop(ir::Type::object());
+      frame->push(
+          ir::Type::i4(),
+          c->nativeCall(
+              c->constant(getThunk(t, charsEqual64Thunk), ir::Type::iptr()),
+              0,
+              0,
+              ir::Type::i4(),
+              args(c->threadRegister(), a, aOffset, b, bOffset, length)));
+      return true;
+    } else if (MATCH(target->name(), "compareChars")
+               and MATCH(target->spec(),
+                         "(Ljava/lang/Object;IILjava/lang/Object;II)I")) {
+      ir::Value* bLength = frame->pop(ir::Type::i4());
+      ir::Value* bOffset = frame->pop(ir::Type::i4());
+      ir::Value* b = frame->pop(ir::Type::object());
+      ir::Value* aLength = frame->pop(ir::Type::i4());
+      ir::Value* aOffset = frame->pop(ir::Type::i4());
+      ir::Value* a = frame->pop(ir::Type::object());
+      frame->push(
+          ir::Type::i4(),
+          c->nativeCall(
+              c->constant(getThunk(t, compareChars64Thunk), ir::Type::iptr()),
+              0,
+              0,
+              ir::Type::i4(),
+              args(c->threadRegister(),
+                   a,
+                   aOffset,
+                   aLength,
+                   b,
+                   bOffset,
+                   bLength)));
+      return true;
+    } else if (MATCH(target->name(), "hashChars")
+               and MATCH(target->spec(), "(Ljava/lang/Object;II)I")) {
+      ir::Value* length = frame->pop(ir::Type::i4());
+      ir::Value* offset = frame->pop(ir::Type::i4());
+      ir::Value* data = frame->pop(ir::Type::object());
+      frame->push(
+          ir::Type::i4(),
+          c->nativeCall(
+              c->constant(getThunk(t, hashChars64Thunk), ir::Type::iptr()),
+              0,
+              0,
+              ir::Type::i4(),
+              args(c->threadRegister(), data, offset, length)));
+      return true;
+    } else if (MATCH(target->name(), "indexOfChar")
+               and MATCH(target->spec(), "(Ljava/lang/Object;III)I")) {
+      ir::Value* ch = frame->pop(ir::Type::i4());
+      ir::Value* length = frame->pop(ir::Type::i4());
+      ir::Value* offset = frame->pop(ir::Type::i4());
+      ir::Value* data = frame->pop(ir::Type::object());
+      frame->push(
+          ir::Type::i4(),
+          c->nativeCall(
+              c->constant(getThunk(t, indexOfChar64Thunk), ir::Type::iptr()),
+              0,
+              0,
+              ir::Type::i4(),
+              args(c->threadRegister(), data, offset, length, ch)));
+      return true;
+    } else if (MATCH(target->name(), "indexOfChars")
+               and MATCH(target->spec(),
+                         "(Ljava/lang/Object;IILjava/lang/Object;II)I")) {
+      ir::Value* patternLength = frame->pop(ir::Type::i4());
+      ir::Value* patternOffset = frame->pop(ir::Type::i4());
+      ir::Value* pattern = frame->pop(ir::Type::object());
+      ir::Value* length = frame->pop(ir::Type::i4());
+      ir::Value* offset = frame->pop(ir::Type::i4());
+      ir::Value* data = frame->pop(ir::Type::object());
+      frame->push(
+          ir::Type::i4(),
+          c->nativeCall(
+              c->constant(getThunk(t, indexOfChars64Thunk), ir::Type::iptr()),
+              0,
+              0,
+              ir::Type::i4(),
+              args(c->threadRegister(),
+                   data,
+                   offset,
+                   length,
+                   pattern,
+                   patternOffset,
+                   patternLength)));
+      return true;
+    }
+  } else if (UNLIKELY(MATCH(className, "java/util/Arrays"))) {
+    avian::codegen::Compiler* c = frame->c;
+    if (MATCH(target->name(), "elementsEqual")
+        and MATCH(target->spec(), "(Ljava/lang/Object;Ljava/lang/Object;I)Z")) {
+      ir::Value* length = frame->pop(ir::Type::i4());
+      ir::Value* b = frame->pop(ir::Type::object());
+      ir::Value* a = frame->pop(ir::Type::object());
+      frame->push(
+          ir::Type::i4(),
+          c->nativeCall(
+              c->constant(getThunk(t, elementsEqual64Thunk), ir::Type::iptr()),
+              0,
+              0,
+              ir::Type::i4(),
+              args(c->threadRegister(), a, b, length)));
+      return true;
+    } else if (MATCH(target->name(), "fillElements")
+               and MATCH(target->spec(), "(Ljava/lang/Object;IIJ)V")) {
+      ir::Value* value = frame->popLarge(ir::Type::i8());
+      ir::Value* stop = frame->pop(ir::Type::i4());
+      ir::Value* start = frame->pop(ir::Type::i4());
+      ir::Value* array = frame->pop(ir::Type::object());
+      c->nativeCall(
+          c->constant(getThunk(t, fillElements64Thunk), ir::Type::iptr()),
+          0,
+          0,
+          ir::Type::void_(),
+          args(c->threadRegister(), array, start, stop, nullptr, value));
+      return true;
+    }
+  }
+  return false;
+}
+
+unsigned targetFieldOffset(Context* context, GcField* field)
+{
+  if (context->bootContext) {
+    return context->bootContext->resolver->fieldOffset(context->thread, field);
+  } else {
+    return field->offset();
+  }
+}
+
+// Loads the specified field from table (an instance or a static
+// table), extended to the size it has on the operand stack.
+ir::Value* fieldValue(MyThread* t,
+                      Frame* frame,
+                      GcField* field,
+                      ir::Value* table)
+{
+  avian::codegen::Compiler* c = frame->c;
+  unsigned offset = targetFieldOffset(frame->context, field);
+
+  switch (field->code()) {
+  case ByteField:
+  case BooleanField:
+    return c->load(ir::ExtendMode::Signed,
+                   c->memory(table, ir::Type::i1(), offset),
+                   ir::Type::i4());
+
+  case CharField:
+    return c->load(ir::ExtendMode::Unsigned,
+                   c->memory(table, ir::Type::i2(), offset),
+                   ir::Type::i4());
+
+  case ShortField:
+    return c->load(ir::ExtendMode::Signed,
+                   c->memory(table, ir::Type::i2(), offset),
+                   ir::Type::i4());
+
+  case FloatField:
+    return c->load(ir::ExtendMode::Signed,
+                   c->memory(table, ir::Type::f4(), offset),
+                   ir::Type::f4());
+
+  case IntField:
+    return c->load(ir::ExtendMode::Signed,
+                   c->memory(table, ir::Type::i4(), offset),
+                   ir::Type::i4());
+
+  case DoubleField:
+    return c->load(ir::ExtendMode::Signed,
+                   c->memory(table, ir::Type::f8(), offset),
+                   ir::Type::f8());
+
+  case LongField:
+    return c->load(ir::ExtendMode::Signed,
+                   c->memory(table, ir::Type::i8(), offset),
+                   ir::Type::i8());
+
+  case ObjectField:
+    return c->load(ir::ExtendMode::Signed,
+                   c->memory(table, ir::Type::object(), offset),
+                   ir::Type::object());
+
+  default:
+    abort(t);
+  }
+}
+
+void loadField(MyThread* t, Frame* frame, GcField* field, ir::Value* table)
+{
+  frame->pushReturnValue(field->code(), fieldValue(t, frame, field, table));
+}
+
+void storeField(MyThread* t,
+                Frame* frame,
+                GcField* field,
+                ir::Value* table,
+                ir::Value* value,
+                bool isStatic)
+{
+  avian::codegen::Compiler* c = frame->c;
+  unsigned offset = targetFieldOffset(frame->context, field);
+
+  switch (field->code()) {
+  case ByteField:
+  case BooleanField:
+    c->store(value, c->memory(table, ir::Type::i1(), offset));
+    break;
+
+  case CharField:
+  case ShortField:
+    c->store(value, c->memory(table, ir::Type::i2(), offset));
+    break;
+
+  case FloatField:
+    c->store(value, c->memory(table, ir::Type::f4(), offset));
+    break;
+
+  case IntField:
+    c->store(value, c->memory(table, ir::Type::i4(), offset));
+    break;
+
+  case DoubleField:
+    c->store(value, c->memory(table, ir::Type::f8(), offset));
+    break;
+
+  case LongField:
+    c->store(value, c->memory(table, ir::Type::i8(), offset));
+    break;
+
+  case ObjectField:
+    if (not isStatic) {
+      c->nativeCall(
+          c->constant(getThunk(t, setMaybeNullThunk), ir::Type::iptr()),
+          0,
+          frame->trace(0, 0),
+          ir::Type::void_(),
+          args(c->threadRegister(),
+               table,
+               c->constant(offset, ir::Type::i4()),
+               value));
+    } else {
+      c->nativeCall(
+          c->constant(getThunk(t, setObjectThunk), ir::Type::iptr()),
+          0,
+          0,
+          ir::Type::void_(),
+          args(c->threadRegister(),
+               table,
+               c->constant(offset, ir::Type::i4()),
+               value));
+    }
+    break;
+
+  default:
+    abort(t);
+  }
+}
+
+// Returns the bytecode of the specified method if it is small enough
+// to be worth inlining at call sites (see Inliner).  Once a method has
+// been compiled, its bytecode is only available if we remembered it
+// in the inline table.
+GcCode* inlineCandidate(MyThread* t, GcMethod* method)
+{
+  if (method->flags() & (ACC_NATIVE | ACC_ABSTRACT | ACC_SYNCHRONIZED)) {
+    return 0;
+  }
+
+  GcCode* code = method->code();
+  if (code->pool()) {
+    return code;
+  }
+
+  GcArray* table = compileRoots(t)->inlineTable();
+  if (table) {
+    GcPair* entry = cast<GcPair>(
+        t, table->body()[objectHash(t, method) & (InlineTableSize - 1)]);
+    if (entry and entry->first() == method) {
+      return cast<GcCode>(t, entry->second());
+    }
+  }
+
+  return 0;
+}
+
+// Returns the field referred to by the two byte pool index at body in
+// the bytecode of the specified method, or null if it can't be
+// resolved without side effects or may not be accessed inline.
+GcField* inlineField(MyThread* t,
+                     GcMethod* method,
+                     GcCode* code,
+                     uint8_t* body,
+                     bool isStatic)
+{
+  GcField* field = cast<GcField>(t,
+                                 resolve(t,
+                                         method->class_()->loader(),
+                                         code->pool(),
+                                         ((body[0] << 8) | body[1]) - 1,
+                                         findFieldInClass,
+                                         GcNoSuchFieldError::Type,
+                                         false));
+
+  if (field == 0 or (field->flags() & ACC_VOLATILE)
+      or ((field->flags() & ACC_STATIC) != 0) != isStatic
+      or (isStatic and classNeedsInit(t, field->class_()))) {
+    return 0;
+  }
+
+  return field;
+}
+
+// Returns the code for a value of the specified type as the inliner
+// tracks it (IntField, LongField or ObjectField), or VoidField if it
+// doesn't handle such values.
+int inlineCode(int fieldCode)
+{
+  switch (fieldCode) {
+  case ByteField:
+  case BooleanField:
+  case CharField:
+  case ShortField:
+  case IntField:
+    return IntField;
+  case LongField:
+  case ObjectField:
+    return fieldCode;
+  default:
+    return VoidField;
+  }
+}
+
+// Returns true if a call to the specified method always reaches that
+// method and no override.  We don't track which classes extend which,
+// so a method not declared final is never assumed to be effectively
+// final.
+bool boundStatically(MyThread* t, GcMethod* method)
+{
+  return not methodVirtual(t, method) or (method->flags() & ACC_FINAL)
+         or (method->class_()->flags() & ACC_FINAL);
+}
+
+lir::TernaryOperation toCompilerBinaryOp(MyThread* t, unsigned instruction);
+
+// Compiles the body of a small, statically bound method in place of a
+// call to it.  We only handle straight-line code which loads and stores
+// locals and fields and does integer arithmetic which can't throw, so
+// the result needs no frame, exception handlers or stack map of its
+// own.
+//
+// The callee's operands and locals are tracked here rather than on the
+// caller's frame, which has no room for them.  The compiler only keeps
+// values on the frame alive across calls, though, so we refuse any
+// body which makes a call other than to store an object field just
+// before returning.
+//
+// A null reference dereferenced by the inlined code is caught by the
+// signal handler and reported as a NullPointerException thrown by the
+// caller, as for a getfield or putfield compiled there directly.  An
+// invokevirtual must also throw one if the receiver itself is null, so
+// in that case we require the body to dereference it before it stores
+// anything or returns.
+//
+// We run over the bytecode twice: once to check that we can inline all
+// of it, generating nothing, and then again to generate code.
+class Inliner {
+ public:
+  class Entry {
+   public:
+    Entry() : value(0), code(VoidField), receiver(false)
+    {
+    }
+
+    ir::Value* value;
+    int code;
+    bool receiver;
+  };
+
+  Inliner(MyThread* t,
+          Frame* frame,
+          GcMethod* target,
+          GcCode* code,
+          uint8_t* body,
+          unsigned length,
+          bool checkReceiver,
+          bool inTryBlock)
+      : t(t),
+        frame(frame),
+        c(frame->c),
+        target(target),
+        code(code),
+        body(body),
+        length(length),
+        checkReceiver(checkReceiver),
+        inTryBlock(inTryBlock),
+        emit(false),
+        sp(0),
+        targetProtector(t, &(this->target)),
+        codeProtector(t, &(this->code))
+  {
+  }
+
+  bool run(bool emit)
+  {
+    this->emit = emit;
+    sp = 0;
+
+    if (not initLocals()) {
+      return false;
+    }
+
+    if (emit and inTryBlock) {
+      c->saveLocals();
+      frame->trace(0, 0);
+    }
+
+    bool receiverChecked = not checkReceiver;
+    bool returned = false;
+    unsigned ip = 0;
+    while (ip < length) {
+      uint8_t instruction = body[ip++];
+
+      switch (instruction) {
+      case iconst_m1:
+      case iconst_0:
+      case iconst_1:
+      case iconst_2:
+      case iconst_3:
+      case iconst_4:
+      case iconst_5:
+        if (not push(IntField,
+                     constant(static_cast<int>(instruction) - iconst_0,
+                              ir::Type::i4()))) {
+          return false;
+        }
+        break;
+
+      case bipush:
+        if (ip + 1 > length
+            or not push(IntField,
+                        constant(static_cast<int8_t>(body[ip]),
+                                 ir::Type::i4()))) {
+          return false;
+        }
+        ip += 1;
+        break;
+
+      case sipush:
+        if (ip + 2 > length
+            or not push(IntField,
+                        constant(static_cast<int16_t>((body[ip] << 8)
+                                                      | body[ip + 1]),
+                                 ir::Type::i4()))) {
+          return false;
+        }
+        ip += 2;
+        break;
+
+      case lconst_0:
+      case lconst_1:
+        if (not push(LongField,
+                     constant(instruction - lconst_0, ir::Type::i8()))) {
+          return false;
+        }
+        break;
+
+      case aconst_null:
+        if (not push(ObjectField, constant(0, ir::Type::object()))) {
+          return false;
+        }
+        break;
+
+      case iload:
+      case lload:
+      case aload:
+        if (ip + 1 > length or not load(instruction, body[ip])) {
+          return false;
+        }
+        ip += 1;
+        break;
+
+      case iload_0:
+      case iload_1:
+      case iload_2:
+      case iload_3:
+        if (not load(iload, instruction - iload_0)) {
+          return false;
+        }
+        break;
+
+      case lload_0:
+      case lload_1:
+      case lload_2:
+      case lload_3:
+        if (not load(lload, instruction - lload_0)) {
+          return false;
+        }
+        break;
+
+      case aload_0:
+      case aload_1:
+      case aload_2:
+      case aload_3:
+        if (not load(aload, instruction - aload_0)) {
+          return false;
+        }
+        break;
+
+      case istore:
+      case lstore:
+      case astore:
+        if (ip + 1 > length or not store(instruction, body[ip])) {
+          return false;
+        }
+        ip += 1;
+        break;
+
+      case istore_0:
+      case istore_1:
+      case istore_2:
+      case istore_3:
+        if (not store(istore, instruction - istore_0)) {
+          return false;
+        }
+        break;
+
+      case lstore_0:
+      case lstore_1:
+      case lstore_2:
+      case lstore_3:
+        if (not store(lstore, instruction - lstore_0)) {
+          return false;
+        }
+        break;
+
+      case astore_0:
+      case astore_1:
+      case astore_2:
+      case astore_3:
+        if (not store(astore, instruction - astore_0)) {
+          return false;
+        }
+        break;
+
+      case iadd:
+      case iand:
+      case imul:
+      case ior:
+      case ishl:
+      case ishr:
+      case isub:
+      case iushr:
+      case ixor:
+        if (not binary(instruction, IntField)) {
+          return false;
+        }
+        break;
+
+      // long multiplication and shifts may be compiled as calls to
+      // helper functions on 32-bit targets, so we leave them alone:
+      case ladd:
+      case land:
+      case lor:
+      case lsub:
+      case lxor:
+        if (not binary(instruction, LongField)) {
+          return false;
+        }
+        break;
+
+      case ineg:
+      case lneg: {
+        Entry a;
+        if (not pop(instruction == ineg ? IntField : LongField, &a)
+            or not push(a.code,
+                        emit ? unaryOp(frame->context, lir::Negate, a.value)
+                             : 0)) {
+          return false;
+        }
+      } break;
+
+      case i2l: {
+        Entry a;
+        if (not pop(IntField, &a)
+            or not push(LongField,
+                        emit ? c->truncateThenExtend(ir::ExtendMode::Signed,
+                                                     ir::Type::i8(),
+                                                     ir::Type::i4(),
+                                                     a.value)
+                             : 0)) {
+          return false;
+        }
+      } break;
+
+      case l2i: {
+        Entry a;
+        if (not pop(LongField, &a)
+            or not push(IntField,
+                        emit ? c->truncate(ir::Type::i4(), a.value) : 0)) {
+          return false;
+        }
+      } break;
+
+      case i2b:
+      case i2c:
+      case i2s: {
+        Entry a;
+        if (not pop(IntField, &a)
+            or not push(
+                   IntField,
+                   emit ? c->truncateThenExtend(
+                              instruction == i2c ? ir::ExtendMode::Unsigned
+                                                 : ir::ExtendMode::Signed,
+                              ir::Type::i4(),
+                              instruction == i2b ? ir::Type::i1()
+                                                 : ir::Type::i2(),
+                              a.value)
+                        : 0)) {
+          return false;
+        }
+      } break;
+
+      case vm::dup: {
+        Entry a;
+        if (not popSingle(&a) or not push(a) or not push(a)) {
+          return false;
+        }
+      } break;
+
+      case vm::dup_x1: {
+        Entry a;
+        Entry b;
+        if (not popSingle(&a) or not popSingle(&b) or not push(a)
+            or not push(b) or not push(a)) {
+          return false;
+        }
+      } break;
+
+      case pop_: {
+        Entry a;
+        if (not popSingle(&a)) {
+          return false;
+        }
+      } break;
+
+      case getfield:
+      case getstatic: {
+        bool isStatic = instruction == getstatic;
+        GcField* field;
+        if (ip + 2 > length
+            or (field = inlineField(t, target, code, body + ip, isStatic))
+                   == 0
+            or inlineCode(field->code()) == VoidField) {
+          return false;
+        }
+        ip += 2;
+
+        PROTECT(t, field);
+
+        ir::Value* table;
+        if (isStatic) {
+          table = emit ? frame->append(field->class_()->staticTable()) : 0;
+        } else {
+          Entry instance;
+          if (not pop(ObjectField, &instance)) {
+            return false;
+          }
+
+          if (instance.receiver) {
+            receiverChecked = true;
+          }
+          table = instance.value;
+        }
+
+        if (not push(inlineCode(field->code()),
+                     emit ? fieldValue(t, frame, field, table) : 0)) {
+          return false;
+        }
+      } break;
+
+      case putfield:
+      case putstatic: {
+        bool isStatic = instruction == putstatic;
+        GcField* field;
+        if (ip + 2 > length
+            or (field = inlineField(t, target, code, body + ip, isStatic))
+                   == 0
+            or inlineCode(field->code()) == VoidField) {
+          return false;
+        }
+        ip += 2;
+
+        PROTECT(t, field);
+
+        // storing an object field may call into the VM, after which
+        // none of our values are safe to use:
+        if (field->code() == ObjectField
+            and (ip + 1 != length or body[ip] != return_)) {
+          return false;
+        }
+
+        Entry value;
+        if (not pop(inlineCode(field->code()), &value)) {
+          return false;
+        }
+
+        ir::Value* table;
+        if (isStatic) {
+          table = emit ? frame->append(field->class_()->staticTable()) : 0;
+        } else {
+          Entry instance;
+          if (not pop(ObjectField, &instance)) {
+            return false;
+          }
+
+          if (instance.receiver) {
+            receiverChecked = true;
+          }
+          table = instance.value;
+        }
+
+        if (not receiverChecked) {
+          return false;
+        }
+
+        if (emit) {
+          storeField(t, frame, field, table, value.value, isStatic);
+        }
+      } break;
+
+      case ireturn:
+      case lreturn:
+      case areturn: {
+        int returnCode = inlineCode(target->returnCode());
+        Entry value;
+        if (ip != length or not receiverChecked or returnCode == VoidField
+            or not pop(returnCode, &value)) {
+          return false;
+        }
+
+        if (emit) {
+          frame->pushReturnValue(returnCode, value.value);
+        }
+        returned = true;
+      } break;
+
+      case return_:
+        if (ip != length or not receiverChecked
+            or target->returnCode() != VoidField) {
+          return false;
+        }
+        returned = true;
+        break;
+
+      default:
+        return false;
+      }
+    }
+
+    return returned;
+  }
+
+ private:
+  // Sets up our locals to hold the arguments, popping them off the
+  // caller's frame if we're generating code.
+  bool initLocals()
+  {
+    if (code->maxLocals() > InlineLocalLimit
+        or target->parameterFootprint() > InlineLocalLimit) {
+      return false;
+    }
+
+    for (unsigned i = 0; i < InlineLocalLimit; ++i) {
+      locals[i] = Entry();
+    }
+
+    unsigned index = 0;
+    if ((target->flags() & ACC_STATIC) == 0) {
+      locals[index].code = ObjectField;
+      locals[index++].receiver = true;
+    }
+
+    for (MethodSpecIterator it(
+             t, reinterpret_cast<const char*>(target->spec()->body().begin()));
+         it.hasNext();) {
+      switch (*it.next()) {
+      case 'L':
+      case '[':
+        locals[index++].code = ObjectField;
+        break;
+
+      case 'J':
+        locals[index].code = LongField;
+        index += 2;
+        break;
+
+      case 'Z':
+      case 'B':
+      case 'C':
+      case 'S':
+      case 'I':
+        locals[index++].code = IntField;
+        break;
+
+      default:
+        return false;
+      }
+    }
+
+    if (emit) {
+      for (int i = index - 1; i >= 0; --i) {
+        if (locals[i].code != VoidField) {
+          locals[i].value = popField(t, frame, locals[i].code);
+        }
+      }
+    }
+
+    return true;
+  }
+
+  ir::Value* constant(int64_t value, ir::Type type)
+  {
+    return emit ? c->constant(value, type) : 0;
+  }
+
+  bool push(const Entry& e)
+  {
+    if (sp == InlineStackLimit) {
+      return false;
     }
+
+    stack[sp++] = e;
+    return true;
   }
-  return false;
+
+  bool push(int code, ir::Value* value)
+  {
+    Entry e;
+    e.value = value;
+    e.code = code;
+    return push(e);
+  }
+
+  bool pop(int code, Entry* e)
+  {
+    if (sp == 0 or stack[sp - 1].code != code) {
+      return false;
+    }
+
+    *e = stack[--sp];
+    return true;
+  }
+
+  // pops a value which takes up a single operand stack slot
+  bool popSingle(Entry* e)
+  {
+    return sp and stack[sp - 1].code != LongField
+           and pop(stack[sp - 1].code, e);
+  }
+
+  bool load(uint8_t instruction, unsigned index)
+  {
+    int code = instruction == iload
+                   ? IntField
+                   : (instruction == lload ? LongField : ObjectField);
+
+    return index < InlineLocalLimit and locals[index].code == code
+           and push(locals[index]);
+  }
+
+  bool store(uint8_t instruction, unsigned index)
+  {
+    int code = instruction == istore
+                   ? IntField
+                   : (instruction == lstore ? LongField : ObjectField);
+
+    Entry e;
+    if (index + (code == LongField ? 1 : 0) >= InlineLocalLimit
+        or not pop(code, &e)) {
+      return false;
+    }
+
+    e.receiver = false;
+    locals[index] = e;
+
+    if (code == LongField) {
+      locals[index + 1] = Entry();
+    }
+
+    if (index > 0 and locals[index - 1].code == LongField) {
+      locals[index - 1] = Entry();
+    }
+
+    return true;
+  }
+
+  bool binary(uint8_t instruction, int code)
+  {
+    Entry a;
+    Entry b;
+    if (not pop(code, &a) or not pop(code, &b)) {
+      return false;
+    }
+
+    return push(code,
+                emit ? binaryOp(frame->context,
+                                toCompilerBinaryOp(t, instruction),
+                                code == LongField ? ir::Type::i8()
+                                                  : ir::Type::i4(),
+                                a.value,
+                                b.value)
+                     : 0);
+  }
+
+  MyThread* t;
+  Frame* frame;
+  avian::codegen::Compiler* c;
+  GcMethod* target;
+  GcCode* code;
+  uint8_t* body;
+  unsigned length;
+  bool checkReceiver;
+  bool inTryBlock;
+  bool emit;
+  unsigned sp;
+  Entry stack[InlineStackLimit];
+  Entry locals[InlineLocalLimit];
+  Thread::SingleProtector targetProtector;
+  Thread::SingleProtector codeProtector;
+};
+
+// Compiles a call to the specified statically-bound target inline if
+// it is small and simple enough (see Inliner), where code and ip
+// identify the invoke instruction in the caller.
+bool inlineCall(MyThread* t,
+                Frame* frame,
+                GcMethod* target,
+                GcCode* code,
+                unsigned ip)
+{
+  bool isStatic = (target->flags() & ACC_STATIC) != 0;
+  if (isStatic and classNeedsInit(t, target->class_())) {
+    return false;
+  }
+
+  bool checkReceiver = code->body()[ip] == invokevirtual;
+  bool inTry = inTryBlock(t, code, ip);
+
+  GcCode* candidate = inlineCandidate(t, target);
+  if (candidate == 0 or candidate->length() > InlineSizeLimit
+      or candidate->exceptionHandlerTable()) {
+    return false;
+  }
+
+  // copy the bytecode, since resolving fields may move it:
+  uint8_t body[InlineSizeLimit];
+  unsigned length = candidate->length();
+  memcpy(body, candidate->body().begin(), length);
+
+  Inliner inliner(
+      t, frame, target, candidate, body, length, checkReceiver, inTry);
+
+  return inliner.run(false) and inliner.run(true);
 }
 
-unsigned targetFieldOffset(Context* context, GcField* field)
+// Remembers the bytecode of a method we've just compiled if it is
+// small enough to inline, so that callers compiled later may still
+// inline it.
+void rememberInlineCandidate(MyThread* t, GcMethod* method, GcCode* code)
 {
-  if (context->bootContext) {
-    return context->bootContext->resolver->fieldOffset(context->thread, field);
-  } else {
-    return field->offset();
+  if (code->length() > InlineSizeLimit or code->exceptionHandlerTable()
+      or code->maxLocals() > InlineLocalLimit) {
+    return;
+  }
+
+  PROTECT(t, method);
+  PROTECT(t, code);
+
+  if (compileRoots(t)->inlineTable() == 0) {
+    GcArray* table = makeArray(t, InlineTableSize);
+    compileRoots(t)->setInlineTable(t, table);
   }
+
+  GcPair* entry = makePair(t, method, code);
+  compileRoots(t)->inlineTable()->setBodyElement(
+      t, objectHash(t, method) & (InlineTableSize - 1), entry);
 }
 
 class Stack {
@@ -4097,6 +7009,10 @@ loop:
 
     frame->startLogicalIp(ip);
 
+    if (context->values) {
+      context->values->visit(t, code, ip);
+    }
+
     if (exceptionHandlerStart >= 0) {
       c->initLocalsFromLogicalIp(exceptionHandlerStart);
 
@@ -4151,12 +7067,16 @@ loop:
       ir::Value* index = frame->pop(ir::Type::i4());
       ir::Value* array = frame->pop(ir::Type::object());
 
-      if (inTryBlock(t, code, ip - 1)) {
+      // an access proven in range can't throw, so it needs neither a
+      // check nor the bookkeeping for one:
+      bool safe = EliminateBoundsChecks and context->safeArrayAccesses[ip - 1];
+
+      if ((not safe) and inTryBlock(t, code, ip - 1)) {
         c->saveLocals();
         frame->trace(0, 0);
       }
 
-      if (CheckArrayBounds) {
+      if (CheckArrayBounds and not safe) {
         c->checkBounds(array, TargetArrayLength, index, aioobThunk(t));
       }
 
@@ -4252,12 +7172,14 @@ loop:
       ir::Value* index = frame->pop(ir::Type::i4());
       ir::Value* array = frame->pop(ir::Type::object());
 
-      if (inTryBlock(t, code, ip - 1)) {
+      bool safe = EliminateBoundsChecks and context->safeArrayAccesses[ip - 1];
+
+      if ((not safe) and inTryBlock(t, code, ip - 1)) {
         c->saveLocals();
         frame->trace(0, 0);
       }
 
-      if (CheckArrayBounds) {
+      if (CheckArrayBounds and not safe) {
         c->checkBounds(array, TargetArrayLength, index, aioobThunk(t));
       }
 
@@ -4379,11 +7301,7 @@ loop:
 
     case arraylength: {
       frame->push(ir::Type::i4(),
-                  c->load(ir::ExtendMode::Signed,
-                          c->memory(frame->pop(ir::Type::object()),
-                                    ir::Type::iptr(),
-                                    TargetArrayLength),
-                          ir::Type::i4()));
+                  arrayLength(context, frame->pop(ir::Type::object())));
     } break;
 
     case astore:
@@ -4693,83 +7611,7 @@ loop:
           }
         }
 
-        switch (field->code()) {
-        case ByteField:
-        case BooleanField:
-          frame->push(ir::Type::i4(),
-                      c->load(ir::ExtendMode::Signed,
-                              c->memory(table,
-                                        ir::Type::i1(),
-                                        targetFieldOffset(context, field)),
-                              ir::Type::i4()));
-          break;
-
-        case CharField:
-          frame->push(ir::Type::i4(),
-                      c->load(ir::ExtendMode::Unsigned,
-                              c->memory(table,
-                                        ir::Type::i2(),
-                                        targetFieldOffset(context, field)),
-                              ir::Type::i4()));
-          break;
-
-        case ShortField:
-          frame->push(ir::Type::i4(),
-                      c->load(ir::ExtendMode::Signed,
-                              c->memory(table,
-                                        ir::Type::i2(),
-                                        targetFieldOffset(context, field)),
-                              ir::Type::i4()));
-          break;
-
-        case FloatField:
-          frame->push(ir::Type::f4(),
-                      c->load(ir::ExtendMode::Signed,
-                              c->memory(table,
-                                        ir::Type::f4(),
-                                        targetFieldOffset(context, field)),
-                              ir::Type::f4()));
-          break;
-
-        case IntField:
-          frame->push(ir::Type::i4(),
-                      c->load(ir::ExtendMode::Signed,
-                              c->memory(table,
-                                        ir::Type::i4(),
-                                        targetFieldOffset(context, field)),
-                              ir::Type::i4()));
-          break;
-
-        case DoubleField:
-          frame->pushLarge(ir::Type::f8(),
-                           c->load(ir::ExtendMode::Signed,
-                                   c->memory(table,
-                                             ir::Type::f8(),
-                                             targetFieldOffset(context, field)),
-                                   ir::Type::f8()));
-          break;
-
-        case LongField:
-          frame->pushLarge(ir::Type::i8(),
-                           c->load(ir::ExtendMode::Signed,
-                                   c->memory(table,
-                                             ir::Type::i8(),
-                                             targetFieldOffset(context, field)),
-                                   ir::Type::i8()));
-          break;
-
-        case ObjectField:
-          frame->push(ir::Type::object(),
-                      c->load(ir::ExtendMode::Signed,
-                              c->memory(table,
-                                        ir::Type::object(),
-                                        targetFieldOffset(context, field)),
-                              ir::Type::object()));
-          break;
-
-        default:
-          abort(t);
-        }
+        loadField(t, frame, field, table);
 
         if (field->flags() & ACC_VOLATILE) {
           if (TargetBytesPerWord == 4 and (field->code() == DoubleField
@@ -4899,8 +7741,11 @@ loop:
       ir::Value* b = frame->pop(ir::Type::i4());
       frame->push(
           ir::Type::i4(),
-          c->binaryOp(
-              toCompilerBinaryOp(t, instruction), ir::Type::i4(), a, b));
+          binaryOp(context,
+                   toCompilerBinaryOp(t, instruction),
+                   ir::Type::i4(),
+                   a,
+                   b));
     } break;
 
     case iconst_m1:
@@ -4935,13 +7780,13 @@ loop:
       ir::Value* a = frame->pop(ir::Type::i4());
       ir::Value* b = frame->pop(ir::Type::i4());
 
-      if (inTryBlock(t, code, ip - 1)) {
+      if (inTryBlock(t, code, ip - 1) and not nonZeroConstant(context, a)) {
         c->saveLocals();
         frame->trace(0, 0);
       }
 
       frame->push(ir::Type::i4(),
-                  c->binaryOp(lir::Divide, ir::Type::i4(), a, b));
+                  binaryOp(context, lir::Divide, ir::Type::i4(), a, b));
     } break;
 
     case if_acmpeq:
@@ -5076,7 +7921,7 @@ loop:
 
     case ineg: {
       frame->push(ir::Type::i4(),
-                  c->unaryOp(lir::Negate, frame->pop(ir::Type::i4())));
+                  unaryOp(context, lir::Negate, frame->pop(ir::Type::i4())));
     } break;
 
     case instanceof: {
@@ -5339,7 +8184,6 @@ loop:
       GcMethod* target = resolveMethod(t, context->method, index - 1, false);
 
       object argument;
-      Thunk thunk;
       unsigned parameterFootprint;
       int returnCode;
       bool tailCall;
@@ -5347,7 +8191,6 @@ loop:
         checkMethod(t, target, false);
 
         argument = target;
-        thunk = findInterfaceMethodFromInstanceThunk;
         parameterFootprint = target->parameterFootprint();
         returnCode = target->returnCode();
         tailCall = isTailCall(t, code, ip, context->method, target);
@@ -5355,22 +8198,28 @@ loop:
         GcReference* ref = cast<GcReference>(t, reference);
         PROTECT(t, ref);
         argument = makePair(t, context->method, reference);
-        thunk = findInterfaceMethodFromInstanceAndReferenceThunk;
         parameterFootprint = methodReferenceParameterFootprint(t, ref, false);
         returnCode = methodReferenceReturnCode(t, ref);
         tailCall = isReferenceTailCall(t, code, ip, context->method, ref);
       }
 
+      // each call site gets its own cache of receiver classes, which
+      // findInterfaceMethodFromCache consults before falling back to
+      // the machine-wide dispatch table:
+      argument = makeInterfaceCallCache(t, argument, InterfaceCallCacheSize);
+
       unsigned rSize = resultSize(t, returnCode);
 
       ir::Value* result = c->stackCall(
-          c->nativeCall(c->constant(getThunk(t, thunk), ir::Type::iptr()),
-                        0,
-                        frame->trace(0, 0),
-                        ir::Type::iptr(),
-                        args(c->threadRegister(),
-                             frame->append(argument),
-                             c->peek(1, parameterFootprint - 1))),
+          c->nativeCall(
+              c->constant(getThunk(t, findInterfaceMethodFromCacheThunk),
+                          ir::Type::iptr()),
+              0,
+              frame->trace(0, 0),
+              ir::Type::iptr(),
+              args(c->threadRegister(),
+                   frame->append(argument),
+                   c->peek(1, parameterFootprint - 1))),
           tailCall ? Compiler::TailJump : 0,
           frame->trace(0, 0),
           operandTypeForFieldCode(t, returnCode),
@@ -5395,6 +8244,8 @@ loop:
 
       GcMethod* target = resolveMethod(t, context->method, index - 1, false);
 
+      PROTECT(t, target);
+
       if (LIKELY(target)) {
         GcClass* class_ = context->method->class_();
         if (isSpecialMethod(t, target, class_)) {
@@ -5408,7 +8259,7 @@ loop:
         if (UNLIKELY(methodAbstract(t, target))) {
           compileDirectAbstractInvoke(
               t, frame, getMethodAddressThunk, target, tailCall);
-        } else {
+        } else if (not inlineCall(t, frame, target, code, ip - 3)) {
           compileDirectInvoke(t, frame, target, tailCall);
         }
       } else {
@@ -5436,10 +8287,13 @@ loop:
 
       GcMethod* target = resolveMethod(t, context->method, index - 1, false);
 
+      PROTECT(t, target);
+
       if (LIKELY(target)) {
         checkMethod(t, target, true);
 
-        if (not intrinsic(t, frame, target)) {
+        if (not(intrinsic(t, frame, target)
+                or inlineCall(t, frame, target, code, ip - 3))) {
           bool tailCall = isTailCall(t, code, ip, context->method, target);
           compileDirectInvoke(t, frame, target, tailCall);
         }
@@ -5468,10 +8322,14 @@ loop:
 
       GcMethod* target = resolveMethod(t, context->method, index - 1, false);
 
+      PROTECT(t, target);
+
       if (LIKELY(target)) {
         checkMethod(t, target, false);
 
-        if (not intrinsic(t, frame, target)) {
+        if (not(intrinsic(t, frame, target)
+                or (boundStatically(t, target)
+                    and inlineCall(t, frame, target, code, ip - 3)))) {
           bool tailCall = isTailCall(t, code, ip, context->method, target);
 
           if (LIKELY(methodVirtual(t, target))) {
@@ -5531,13 +8389,13 @@ loop:
       ir::Value* a = frame->pop(ir::Type::i4());
       ir::Value* b = frame->pop(ir::Type::i4());
 
-      if (inTryBlock(t, code, ip - 1)) {
+      if (inTryBlock(t, code, ip - 1) and not nonZeroConstant(context, a)) {
         c->saveLocals();
         frame->trace(0, 0);
       }
 
       frame->push(ir::Type::i4(),
-                  c->binaryOp(lir::Remainder, ir::Type::i4(), a, b));
+                  binaryOp(context, lir::Remainder, ir::Type::i4(), a, b));
     } break;
 
     case ireturn: {
@@ -5635,8 +8493,11 @@ loop:
       ir::Value* b = frame->popLarge(ir::Type::i8());
       frame->pushLarge(
           ir::Type::i8(),
-          c->binaryOp(
-              toCompilerBinaryOp(t, instruction), ir::Type::i8(), a, b));
+          binaryOp(context,
+                   toCompilerBinaryOp(t, instruction),
+                   ir::Type::i8(),
+                   a,
+                   b));
     } break;
 
     case lcmp: {
@@ -5742,13 +8603,13 @@ loop:
       ir::Value* a = frame->popLarge(ir::Type::i8());
       ir::Value* b = frame->popLarge(ir::Type::i8());
 
-      if (inTryBlock(t, code, ip - 1)) {
+      if (inTryBlock(t, code, ip - 1) and not nonZeroConstant(context, a)) {
         c->saveLocals();
         frame->trace(0, 0);
       }
 
       frame->pushLarge(ir::Type::i8(),
-                       c->binaryOp(lir::Divide, ir::Type::i8(), a, b));
+                       binaryOp(context, lir::Divide, ir::Type::i8(), a, b));
     } break;
 
     case lload:
@@ -5789,7 +8650,7 @@ loop:
     case lneg:
       frame->pushLarge(
           ir::Type::i8(),
-          c->unaryOp(lir::Negate, frame->popLarge(ir::Type::i8())));
+          unaryOp(context, lir::Negate, frame->popLarge(ir::Type::i8())));
       break;
 
     case lookupswitch: {
@@ -5861,13 +8722,13 @@ loop:
       ir::Value* a = frame->popLarge(ir::Type::i8());
       ir::Value* b = frame->popLarge(ir::Type::i8());
 
-      if (inTryBlock(t, code, ip - 1)) {
+      if (inTryBlock(t, code, ip - 1) and not nonZeroConstant(context, a)) {
         c->saveLocals();
         frame->trace(0, 0);
       }
 
       frame->pushLarge(ir::Type::i8(),
-                       c->binaryOp(lir::Remainder, ir::Type::i8(), a, b));
+                       binaryOp(context, lir::Remainder, ir::Type::i8(), a, b));
     } break;
 
     case lreturn: {
@@ -5889,8 +8750,11 @@ loop:
       ir::Value* b = frame->popLarge(ir::Type::i8());
       frame->pushLarge(
           ir::Type::i8(),
-          c->binaryOp(
-              toCompilerBinaryOp(t, instruction), ir::Type::i8(), a, b));
+          binaryOp(context,
+                   toCompilerBinaryOp(t, instruction),
+                   ir::Type::i8(),
+                   a,
+                   b));
     } break;
 
     case lstore:
@@ -6118,80 +8982,7 @@ loop:
           table = frame->pop(ir::Type::object());
         }
 
-        switch (fieldCode) {
-        case ByteField:
-        case BooleanField:
-          c->store(
-              value,
-              c->memory(
-                  table, ir::Type::i1(), targetFieldOffset(context, field)));
-          break;
-
-        case CharField:
-        case ShortField:
-          c->store(
-              value,
-              c->memory(
-                  table, ir::Type::i2(), targetFieldOffset(context, field)));
-          break;
-
-        case FloatField:
-          c->store(
-              value,
-              c->memory(
-                  table, ir::Type::f4(), targetFieldOffset(context, field)));
-          break;
-
-        case IntField:
-          c->store(
-              value,
-              c->memory(
-                  table, ir::Type::i4(), targetFieldOffset(context, field)));
-          break;
-
-        case DoubleField:
-          c->store(
-              value,
-              c->memory(
-                  table, ir::Type::f8(), targetFieldOffset(context, field)));
-          break;
-
-        case LongField:
-          c->store(
-              value,
-              c->memory(
-                  table, ir::Type::i8(), targetFieldOffset(context, field)));
-          break;
-
-        case ObjectField:
-          if (instruction == putfield) {
-            c->nativeCall(
-                c->constant(getThunk(t, setMaybeNullThunk), ir::Type::iptr()),
-                0,
-                frame->trace(0, 0),
-                ir::Type::void_(),
-                args(c->threadRegister(),
-                     table,
-                     c->constant(targetFieldOffset(context, field),
-                                 ir::Type::i4()),
-                     value));
-          } else {
-            c->nativeCall(
-                c->constant(getThunk(t, setObjectThunk), ir::Type::iptr()),
-                0,
-                0,
-                ir::Type::void_(),
-                args(c->threadRegister(),
-                     table,
-                     c->constant(targetFieldOffset(context, field),
-                                 ir::Type::i4()),
-                     value));
-          }
-          break;
-
-        default:
-          abort(t);
-        }
+        storeField(t, frame, field, table, value, instruction == putstatic);
 
         if (field->flags() & ACC_VOLATILE) {
           if (TargetBytesPerWord == 4
@@ -7294,6 +10085,8 @@ void finish(MyThread* t, FixedAllocator* allocator, Context* context)
       reinterpret_cast<const char*>(context->method->name()->body().begin()),
       reinterpret_cast<const char*>(context->method->spec()->body().begin()));
 
+  logSpills(t, context);
+
   // for debugging:
   if (false
       and ::strcmp(reinterpret_cast<const char*>(
@@ -7326,6 +10119,25 @@ void compile(MyThread* t, Context* context)
           locals,
           alignedFrameSize(t, context->method));
 
+  c->setEvictionPolicy(evictionPolicy(t));
+
+  if (evictionPolicy(t) == avian::codegen::Compiler::EvictFurthestUse) {
+    findLoops(t, context);
+  }
+
+  if (EliminateBoundsChecks) {
+    findSafeArrayAccesses(t, context);
+  }
+
+  if (context->optimize) {
+    Slice<bool> entries = Slice<bool>::allocAndSet(
+        &context->zone, context->method->code()->length() + 1, false);
+    if (findBlockEntries(t, context->method->code(), entries)) {
+      context->values = new (&context->zone)
+          ValueCache(entries, context->method->code()->length());
+    }
+  }
+
   ir::Type* stackMap = (ir::Type*)malloc(sizeof(ir::Type)
                                          * context->method->code()->maxStack());
   Frame frame(context, stackMap);
@@ -7373,6 +10185,15 @@ void compile(MyThread* t, Context* context)
 
   handleEntrance(t, &frame);
 
+  if (context->profile) {
+    c->nativeCall(
+        c->constant(getThunk(t, countInvocationThunk), ir::Type::iptr()),
+        0,
+        frame.trace(0, 0),
+        ir::Type::void_(),
+        args(c->threadRegister(), frame.append(context->profile)));
+  }
+
   Compiler::State* state = c->saveState();
 
   compile(t, &frame, 0);
@@ -7447,6 +10268,24 @@ void compile(MyThread* t, Context* context)
   }
   free(stackMap);
 }
+
+void resolveCatchTypes(MyThread* t, GcMethod* method)
+{
+  GcExceptionHandlerTable* ehTable = cast<GcExceptionHandlerTable>(
+      t, method->code()->exceptionHandlerTable());
+
+  if (ehTable) {
+    PROTECT(t, method);
+    PROTECT(t, ehTable);
+
+    for (unsigned i = 0; i < ehTable->length(); ++i) {
+      uint64_t handler = ehTable->body()[i];
+      if (exceptionHandlerCatchType(handler)) {
+        resolveClassInPool(t, method, exceptionHandlerCatchType(handler) - 1);
+      }
+    }
+  }
+}
 #endif // not AVIAN_AOT_ONLY
 
 void updateCall(MyThread* t,
@@ -7457,6 +10296,10 @@ void updateCall(MyThread* t,
   t->arch->updateCall(op, returnAddress, target);
 }
 
+void countInvocation(MyThread* t, GcMethodProfile* profile);
+
+void countBackEdge(MyThread* t, GcMethodProfile* profile);
+
 void* compileMethod2(MyThread* t, void* ip);
 
 uint64_t compileMethod(MyThread* t)
@@ -8783,7 +11626,8 @@ class MyProcessor : public Processor {
         useNativeFeatures(useNativeFeatures),
         compilationHandlers(0),
         dynamicTable(0),
-        dynamicTableSize(0)
+        dynamicTableSize(0),
+        evictionPolicy(avian::codegen::Compiler::EvictFirst)
   {
     thunkTable[compileMethodIndex] = voidPointer(local::compileMethod);
     thunkTable[compileVirtualMethodIndex] = voidPointer(compileVirtualMethod);
@@ -9445,7 +12289,7 @@ class MyProcessor : public Processor {
     if (image and code) {
       local::boot(static_cast<MyThread*>(t), image, code);
     } else {
-      roots = makeCompileRoots(t, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+      roots = makeCompileRoots(t, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
 
       {
         GcArray* ct = makeArray(t, 128);
@@ -9470,6 +12314,29 @@ class MyProcessor : public Processor {
     }
 #endif
 
+    const char* optimizeProperty = findProperty(t, "avian.optimize");
+    if (optimizeProperty and ::strcmp(optimizeProperty, "true") == 0) {
+      profiling.optimizeAll = true;
+    }
+
+    const char* evictProperty = findProperty(t, "avian.jit.evictFurthest");
+    if (evictProperty and ::strcmp(evictProperty, "true") == 0) {
+      evictionPolicy = avian::codegen::Compiler::EvictFurthestUse;
+    }
+
+    const char* hotMethodsPath = findProperty(t, "avian.jit.hotMethods");
+    if (hotMethodsPath) {
+      profiling.hotMethodLog = vm::fopen(hotMethodsPath, "wb");
+
+      const char* threshold = findProperty(t, "avian.jit.hotThreshold");
+      if (threshold) {
+        profiling.invocationThreshold = atoi(threshold);
+        profiling.backEdgeThreshold = profiling.invocationThreshold
+                                      * (HotBackEdgeThreshold
+                                         / HotInvocationThreshold);
+      }
+    }
+
     segFaultHandler.m = t->m;
     expect(
         t,
@@ -9554,6 +12421,8 @@ class MyProcessor : public Processor {
   CompilationHandlerList* compilationHandlers;
   void** dynamicTable;
   unsigned dynamicTableSize;
+  ProfilePolicy profiling;
+  avian::codegen::Compiler::EvictionPolicy evictionPolicy;
 };
 
 unsigned& dynamicIndex(MyThread* t)
@@ -9571,6 +12440,16 @@ unsigned& dynamicTableSize(MyThread* t)
   return static_cast<MyProcessor*>(t->m->processor)->dynamicTableSize;
 }
 
+ProfilePolicy* profilePolicy(MyThread* t)
+{
+  return &(static_cast<MyProcessor*>(t->m->processor)->profiling);
+}
+
+avian::codegen::Compiler::EvictionPolicy evictionPolicy(MyThread* t)
+{
+  return static_cast<MyProcessor*>(t->m->processor)->evictionPolicy;
+}
+
 const char* stringOrNull(const char* str)
 {
   if (str) {
@@ -9630,6 +12509,49 @@ void logCompile(MyThread* t,
   }
 }
 
+void logSpills(MyThread* t, Context* context)
+{
+  static bool open = false;
+  if (not open) {
+    open = true;
+    const char* path = findProperty(t, "avian.jit.spills");
+    if (path) {
+      spillLog = vm::fopen(path, "wb");
+    }
+  }
+
+  if (spillLog) {
+    avian::codegen::Compiler::Statistics statistics
+        = context->compiler->statistics();
+
+    fprintf(spillLog,
+            "%s.%s%s: %u spills, %u reloads\n",
+            reinterpret_cast<const char*>(
+                context->method->class_()->name()->body().begin()),
+            reinterpret_cast<const char*>(
+                context->method->name()->body().begin()),
+            reinterpret_cast<const char*>(
+                context->method->spec()->body().begin()),
+            statistics.spills,
+            statistics.reloads);
+  }
+}
+
+avian::codegen::lir::UnaryOperation callOperation(GcCallNode* node)
+{
+  if (node->flags() & TraceElement::LongCall) {
+    if (node->flags() & TraceElement::TailCall) {
+      return avian::codegen::lir::AlignedLongJump;
+    } else {
+      return avian::codegen::lir::AlignedLongCall;
+    }
+  } else if (node->flags() & TraceElement::TailCall) {
+    return avian::codegen::lir::AlignedJump;
+  } else {
+    return avian::codegen::lir::AlignedCall;
+  }
+}
+
 void* compileMethod2(MyThread* t, void* ip)
 {
   GcCallNode* node = findCallNode(t, ip);
@@ -9662,25 +12584,51 @@ void* compileMethod2(MyThread* t, void* ip)
   }
 
   if (updateCaller) {
-    avian::codegen::lir::UnaryOperation op;
-    if (node->flags() & TraceElement::LongCall) {
-      if (node->flags() & TraceElement::TailCall) {
-        op = avian::codegen::lir::AlignedLongJump;
-      } else {
-        op = avian::codegen::lir::AlignedLongCall;
-      }
-    } else if (node->flags() & TraceElement::TailCall) {
-      op = avian::codegen::lir::AlignedJump;
-    } else {
-      op = avian::codegen::lir::AlignedCall;
-    }
-
-    updateCall(t, op, updateIp, reinterpret_cast<void*>(address));
+    updateCall(
+        t, callOperation(node), updateIp, reinterpret_cast<void*>(address));
   }
 
   return reinterpret_cast<void*>(address);
 }
 
+void logHotMethod(MyThread* t, GcMethodProfile* profile)
+{
+  ACQUIRE(t, t->m->classLock);
+
+  if (profile->reported()) {
+    return;
+  }
+
+  profile->reported() = true;
+
+  GcMethod* method = profile->method();
+  fprintf(profilePolicy(t)->hotMethodLog,
+          "%s.%s%s: %u invocations, %u back edges\n",
+          reinterpret_cast<const char*>(
+              method->class_()->name()->body().begin()),
+          reinterpret_cast<const char*>(method->name()->body().begin()),
+          reinterpret_cast<const char*>(method->spec()->body().begin()),
+          profile->invocations(),
+          profile->backEdges());
+}
+
+void countInvocation(MyThread* t, GcMethodProfile* profile)
+{
+  if (UNLIKELY(++profile->invocations()
+               == profilePolicy(t)->invocationThreshold)) {
+    logHotMethod(t, profile);
+  }
+}
+
+void countBackEdge(MyThread* t, GcMethodProfile* profile)
+{
+  idleIfNecessary(t);
+
+  if (UNLIKELY(++profile->backEdges() == profilePolicy(t)->backEdgeThreshold)) {
+    logHotMethod(t, profile);
+  }
+}
+
 bool isThunk(MyProcessor::ThunkCollection* thunks, void* ip)
 {
   uint8_t* thunkStart = thunks->default_.start;
@@ -10661,26 +13609,23 @@ void compile(MyThread* t,
   PROTECT(t, clone);
 
   Context context(t, bootContext, clone);
-  compile(t, &context);
+  context.optimize = profilePolicy(t)->optimizeAll;
 
-  {
-    GcExceptionHandlerTable* ehTable = cast<GcExceptionHandlerTable>(
-        t, clone->code()->exceptionHandlerTable());
+  if (bootContext == 0 and profilePolicy(t)->hotMethodLog
+      and (method->vmFlags() & ClassInitFlag) == 0) {
+    context.profile = makeMethodProfile(t, method, 0, 0, 0);
+  }
 
-    if (ehTable) {
-      PROTECT(t, ehTable);
+  compile(t, &context);
 
-      // resolve all exception handler catch types before we acquire
-      // the class lock:
-      for (unsigned i = 0; i < ehTable->length(); ++i) {
-        uint64_t handler = ehTable->body()[i];
-        if (exceptionHandlerCatchType(handler)) {
-          resolveClassInPool(t, clone, exceptionHandlerCatchType(handler) - 1);
-        }
-      }
-    }
+  if (bootContext == 0) {
+    rememberInlineCandidate(t, method, clone->code());
   }
 
+  // resolve all exception handler catch types before we acquire the
+  // class lock:
+  resolveCatchTypes(t, clone);
+
   ACQUIRE(t, t->m->classLock);
 
   if (methodAddress(t, method) != defaultThunk(t)) {
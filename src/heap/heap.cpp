@@ -10,6 +10,7 @@
 
 #include <avian/heap/heap.h>
 #include <avian/system/system.h>
+#include <avian/system/memory.h>
 #include "avian/common.h"
 #include "avian/arch.h"
 
@@ -17,16 +18,66 @@
 
 using namespace vm;
 using namespace avian::util;
+using avian::system::Memory;
 
 namespace {
 
 namespace local {
 
-const unsigned Top = ~static_cast<unsigned>(0);
+const uintptr_t Top = ~static_cast<uintptr_t>(0);
 
 const unsigned InitialGen2CapacityInBytes = 4 * 1024 * 1024;
 const unsigned InitialTenuredFixieCeilingInBytes = 4 * 1024 * 1024;
 
+// upper bound on the number of threads (including the one which
+// requested the collection) used for parallel minor collections:
+const unsigned MaxCollectorCount = 64;
+
+// parallel collection relies on atomic compare-and-swap, and on the
+// client being able to walk objects from any thread, which isn't the
+// case where THREAD_RUNTIME_ARRAY allocates from the VM thread:
+#if defined(USE_ATOMIC_OPERATIONS) && !defined(_MSC_VER)
+const bool ParallelCollectionSupported = true;
+#else
+const bool ParallelCollectionSupported = false;
+#endif
+
+// size of the chunks of nextGen1 and gen2 claimed by each collector
+// thread when copying in parallel.  Objects larger than
+// CollectorLargeObjectSizeInWords get a claim of their own instead:
+const unsigned CollectorBufferSizeInWords = 8 * 1024;
+const unsigned CollectorLargeObjectSizeInWords = CollectorBufferSizeInWords
+                                                 / 16;
+
+// claims are rounded up to a multiple of this many words so that no
+// two collector threads ever write to the same word of nextAgeMap:
+const unsigned CollectorClaimAlignmentInWords = BitsPerWord;
+
+// stored in the first word of an object while a collector thread
+// copies it in parallel with the others.  No live object has a zero
+// there, and the client will take it for neither a forwarding pointer
+// nor the header of a fixed object:
+const uintptr_t BusyMark = 0;
+
+// number of grey objects in each block of a collector's work queue:
+const unsigned WorkBlockCapacity = 256;
+
+// a collector thread will share a partially full block of work once
+// it holds at least this many objects and another thread is idle:
+const unsigned WorkBlockShareThreshold = 16;
+
+// concurrent marking relies on the same things parallel collection
+// does, since the marker thread walks objects while the client runs:
+const bool ConcurrentMarkingSupported = ParallelCollectionSupported;
+
+// a minor collection starts marking gen2 in the background if gen2 is
+// at least this many sixteenths full, or if it only has room for this
+// many more minor collections' worth of tenured objects, either of
+// which should leave the marker time to finish before gen2 fills up
+// and forces a major collection:
+const unsigned ConcurrentMarkingThreshold = 12;
+const unsigned ConcurrentMarkingLeadTime = 4;
+
 const bool Verbose = false;
 const bool Verbose2 = false;
 const bool Debug = false;
@@ -64,9 +115,25 @@ void* tryAllocate(Context* c, size_t size);
 void* allocate(Context* c, size_t size);
 void* allocate(Context* c, size_t size, bool limit);
 void free(Context* c, const void* p, size_t size);
+void* tryAllocatePages(Context* c, size_t size);
+void freePages(Context* c, const void* p, size_t size);
+
+// segment capacities, positions, and map indexes are word counts,
+// which need not fit in 32 bits on a 64-bit system, so we use these
+// rather than the unsigned versions from avian/util/math.h:
+
+inline uintptr_t divideRoundingUp(uintptr_t n, uintptr_t d)
+{
+  return (n + d - 1) / d;
+}
+
+inline uintptr_t average(uintptr_t a, uintptr_t b)
+{
+  return (a / 2) + (b / 2) + (a & b & 1);
+}
 
 #ifdef USE_ATOMIC_OPERATIONS
-inline void markBitAtomic(uintptr_t* map, unsigned i)
+inline void markBitAtomic(uintptr_t* map, uintptr_t i)
 {
   uintptr_t* p = map + wordOf(i);
   uintptr_t v = static_cast<uintptr_t>(1) << bitOf(i);
@@ -106,10 +173,10 @@ class Segment {
     class Iterator {
      public:
       Map* map;
-      unsigned index;
-      unsigned limit;
+      uintptr_t index;
+      uintptr_t limit;
 
-      Iterator(Map* map, unsigned start, unsigned end) : map(map)
+      Iterator(Map* map, uintptr_t start, uintptr_t end) : map(map)
       {
         assertT(map->segment->context, map->bitsPerRecord == 1);
         assertT(map->segment->context, map->segment);
@@ -127,9 +194,9 @@ class Segment {
 
       bool hasMore()
       {
-        unsigned word = wordOf(index);
+        uintptr_t word = wordOf(index);
         unsigned bit = bitOf(index);
-        unsigned wordLimit = wordOf(limit);
+        uintptr_t wordLimit = wordOf(limit);
         unsigned bitLimit = bitOf(limit);
 
         for (; word <= wordLimit and (word < wordLimit or bit < bitLimit);
@@ -156,7 +223,7 @@ class Segment {
         return false;
       }
 
-      unsigned next()
+      uintptr_t next()
       {
         assertT(map->segment->context, hasMore());
         assertT(map->segment->context, map->segment);
@@ -221,38 +288,38 @@ class Segment {
       }
     }
 
-    unsigned calculateOffset(unsigned capacity)
+    uintptr_t calculateOffset(uintptr_t capacity)
     {
-      unsigned n = 0;
+      uintptr_t n = 0;
       if (child)
         n += child->calculateFootprint(capacity);
       return n;
     }
 
-    static unsigned calculateSize(Context* c UNUSED,
-                                  unsigned capacity,
-                                  unsigned scale,
-                                  unsigned bitsPerRecord)
+    static uintptr_t calculateSize(Context* c UNUSED,
+                                   uintptr_t capacity,
+                                   unsigned scale,
+                                   unsigned bitsPerRecord)
     {
-      unsigned result = ceilingDivide(
-          ceilingDivide(capacity, scale) * bitsPerRecord, BitsPerWord);
+      uintptr_t result = divideRoundingUp(
+          divideRoundingUp(capacity, scale) * bitsPerRecord, BitsPerWord);
       assertT(c, result);
       return result;
     }
 
-    unsigned calculateSize(unsigned capacity)
+    uintptr_t calculateSize(uintptr_t capacity)
     {
       return calculateSize(segment->context, capacity, scale, bitsPerRecord);
     }
 
-    unsigned size()
+    uintptr_t size()
     {
       return calculateSize(segment->capacity());
     }
 
-    unsigned calculateFootprint(unsigned capacity)
+    uintptr_t calculateFootprint(uintptr_t capacity)
     {
-      unsigned n = calculateSize(capacity);
+      uintptr_t n = calculateSize(capacity);
       if (child)
         n += child->calculateFootprint(capacity);
       return n;
@@ -272,38 +339,38 @@ class Segment {
         child->replaceWith(m->child);
     }
 
-    unsigned indexOf(unsigned segmentIndex)
+    uintptr_t indexOf(uintptr_t segmentIndex)
     {
       return (segmentIndex / scale) * bitsPerRecord;
     }
 
-    unsigned indexOf(void* p)
+    uintptr_t indexOf(void* p)
     {
       assertT(segment->context, segment->almostContains(p));
       assertT(segment->context, segment->capacity());
       return indexOf(segment->indexOf(p));
     }
 
-    void clearBit(unsigned i)
+    void clearBit(uintptr_t i)
     {
       assertT(segment->context, wordOf(i) < size());
 
       vm::clearBit(data, i);
     }
 
-    void setBit(unsigned i)
+    void setBit(uintptr_t i)
     {
       assertT(segment->context, wordOf(i) < size());
 
       vm::markBit(data, i);
     }
 
-    void clearOnlyIndex(unsigned index)
+    void clearOnlyIndex(uintptr_t index)
     {
       clearBits(data, bitsPerRecord, index);
     }
 
-    void clearOnly(unsigned segmentIndex)
+    void clearOnly(uintptr_t segmentIndex)
     {
       clearOnlyIndex(indexOf(segmentIndex));
     }
@@ -320,12 +387,12 @@ class Segment {
         child->clear(p);
     }
 
-    void setOnlyIndex(unsigned index, unsigned v = 1)
+    void setOnlyIndex(uintptr_t index, unsigned v = 1)
     {
       setBits(data, bitsPerRecord, index, v);
     }
 
-    void setOnly(unsigned segmentIndex, unsigned v = 1)
+    void setOnly(uintptr_t segmentIndex, unsigned v = 1)
     {
       setOnlyIndex(indexOf(segmentIndex), v);
     }
@@ -362,14 +429,14 @@ class Segment {
 
   Context* context;
   uintptr_t* data;
-  unsigned position_;
-  unsigned capacity_;
+  uintptr_t position_;
+  uintptr_t capacity_;
   Map* map;
 
   Segment(Context* context,
           Map* map,
-          unsigned desired,
-          unsigned minimum,
+          uintptr_t desired,
+          uintptr_t minimum,
           int64_t available = INT64_MAX)
       : context(context), data(0), position_(0), capacity_(0), map(map)
   {
@@ -383,9 +450,9 @@ class Segment {
       capacity_ = desired;
 
       if (static_cast<int64_t>(footprint(capacity_)) > available) {
-        unsigned top = capacity_;
-        unsigned bottom = minimum;
-        unsigned target = available;
+        uintptr_t top = capacity_;
+        uintptr_t bottom = minimum;
+        int64_t target = available;
         while (true) {
           if (static_cast<int64_t>(footprint(capacity_)) > target) {
             if (bottom == capacity_) {
@@ -396,14 +463,14 @@ class Segment {
               break;
             }
             top = capacity_;
-            capacity_ = avg(bottom, capacity_);
+            capacity_ = average(bottom, capacity_);
           } else if (static_cast<int64_t>(footprint(capacity_)) < target) {
             if (top == capacity_
                 or static_cast<int64_t>(footprint(capacity_ + 1)) >= target) {
               break;
             }
             bottom = capacity_;
-            capacity_ = avg(top, capacity_);
+            capacity_ = average(top, capacity_);
           } else {
             break;
           }
@@ -416,7 +483,7 @@ class Segment {
 
         if (data == 0) {
           if (capacity_ > minimum) {
-            capacity_ = avg(minimum, capacity_);
+            capacity_ = average(minimum, capacity_);
             if (capacity_ == 0) {
               break;
             }
@@ -436,8 +503,8 @@ class Segment {
   Segment(Context* context,
           Map* map,
           uintptr_t* data,
-          unsigned position,
-          unsigned capacity)
+          uintptr_t position,
+          uintptr_t capacity)
       : context(context),
         data(data),
         position_(position),
@@ -449,23 +516,23 @@ class Segment {
     }
   }
 
-  unsigned footprint(unsigned capacity)
+  uintptr_t footprint(uintptr_t capacity)
   {
     return capacity
            + (map and capacity ? map->calculateFootprint(capacity) : 0);
   }
 
-  unsigned capacity()
+  uintptr_t capacity()
   {
     return capacity_;
   }
 
-  unsigned position()
+  uintptr_t position()
   {
     return position_;
   }
 
-  unsigned remaining()
+  uintptr_t remaining()
   {
     return capacity() - position();
   }
@@ -501,18 +568,26 @@ class Segment {
     return position() and p >= data and p < data + position();
   }
 
+  // like contains, but without consulting the position, which other
+  // collector threads may be advancing concurrently.  This is
+  // equivalent for any pointer to a live object:
+  bool spans(void* p)
+  {
+    return capacity() and p >= data and p < data + capacity();
+  }
+
   bool almostContains(void* p)
   {
     return contains(p) or p == data + position();
   }
 
-  void* get(unsigned offset)
+  void* get(uintptr_t offset)
   {
     assertT(context, offset <= position());
     return data + offset;
   }
 
-  unsigned indexOf(void* p)
+  uintptr_t indexOf(void* p)
   {
     assertT(context, almostContains(p));
     return static_cast<uintptr_t*>(p) - data;
@@ -544,6 +619,7 @@ class Fixie {
   static const unsigned Marked = 1 << 1;
   static const unsigned Dirty = 1 << 2;
   static const unsigned Dead = 1 << 3;
+  static const unsigned Large = 1 << 4;
 
   Fixie(Context* c, unsigned size, bool hasMask, Fixie** handle, bool immortal)
       : age(immortal ? FixieTenureThreshold + 1 : 0),
@@ -555,7 +631,7 @@ class Fixie {
     memset(mask(), 0, maskSize(size, hasMask));
     add(c, handle);
     if (DebugFixies) {
-      fprintf(stderr, "make fixie %p of size %d\n", this, totalSize());
+      fprintf(stderr, "make fixie %p of size %" LD "\n", this, totalSize());
     }
   }
 
@@ -613,17 +689,18 @@ class Fixie {
     return body_ + size;
   }
 
-  static unsigned maskSize(unsigned size, bool hasMask)
+  static uintptr_t maskSize(unsigned size, bool hasMask)
   {
-    return hasMask * ceilingDivide(size, BitsPerWord) * BytesPerWord;
+    return hasMask * divideRoundingUp(size, BitsPerWord) * BytesPerWord;
   }
 
-  static unsigned totalSize(unsigned size, bool hasMask)
+  static uintptr_t totalSize(unsigned size, bool hasMask)
   {
-    return sizeof(Fixie) + (size * BytesPerWord) + maskSize(size, hasMask);
+    return sizeof(Fixie) + (static_cast<uintptr_t>(size) * BytesPerWord)
+           + maskSize(size, hasMask);
   }
 
-  unsigned totalSize()
+  uintptr_t totalSize()
   {
     return totalSize(size, hasMask());
   }
@@ -675,6 +752,22 @@ class Fixie {
     }
   }
 
+  // true if this fixie lives in pages of its own, allocated by
+  // tryAllocatePages rather than the client's allocator:
+  bool large()
+  {
+    return (flags & Large) != 0;
+  }
+
+  void large(bool v)
+  {
+    if (v) {
+      flags |= Large;
+    } else {
+      flags &= ~Large;
+    }
+  }
+
   // be sure to update e.g. TargetFixieSizeInBytes in bootimage.cpp if
   // you add/remove/change fields in this class:
 
@@ -693,9 +786,21 @@ Fixie* fixie(void* body)
 
 void free(Context* c, Fixie** fixies, bool resetImmortal = false);
 
+class Collector;
+class WorkBlock;
+class Marker;
+
+void disposeCollectors(Context* c);
+void disposeMarkers(Context* c);
+
 class Context {
  public:
-  Context(System* system, unsigned limit)
+  Context(System* system,
+          uint64_t limit,
+          unsigned collectorCount,
+          bool compactGen2,
+          bool concurrentGen2,
+          unsigned largeObjectThreshold)
       : system(system),
         client(0),
         count(0),
@@ -727,6 +832,7 @@ class Context {
         incomingFootprint(0),
         pendingAllocation(0),
         tenureFootprint(0),
+        promotedFootprint(0),
         gen1Padding(0),
         tenurePadding(0),
         gen2Padding(0),
@@ -734,6 +840,7 @@ class Context {
         untenuredFixieFootprint(0),
         tenuredFixieFootprint(0),
         tenuredFixieCeiling(InitialTenuredFixieCeilingInBytes),
+        largeObjectThreshold(largeObjectThreshold),
         mode(Heap::MinorCollection),
         fixies(0),
         tenuredFixies(0),
@@ -743,15 +850,78 @@ class Context {
         lastCollectionTime(system->now()),
         totalCollectionTime(0),
         totalTime(0),
-        limitWasExceeded(false)
+        limitWasExceeded(false),
+        collectorCount(collectorCount),
+        collectors(0),
+        collectorLock(0),
+        collectorMonitor(0),
+        freeWorkBlocks(0),
+        collectorGeneration(0),
+        runningCollectors(0),
+        activeCollectors(collectorCount),
+        stopCollectors(false),
+        parallel(false),
+        busy(false),
+        postVisiting(false),
+        compactGen2(compactGen2),
+        compacting(false),
+        startMap(0),
+        liveMap(0),
+        growMap(0),
+        compactionMapSize(0),
+        forwardTable(0),
+        compactionBase(0),
+        youngSlotMap(&nextGen1, 1, 1, 0, false),
+        markStack(0),
+        slotLog(0),
+        concurrentGen2(concurrentGen2),
+        marking(false),
+        markers(0),
+        markerMonitor(0),
+        markerPaused(false),
+        markerBusy(false),
+        stopMarker(false),
+        slotMap(0),
+        padLog(0),
+        peakCount(0),
+        promoted(0)
   {
+    memset(collections, 0, sizeof(collections));
+    memset(collectionTime, 0, sizeof(collectionTime));
+    memset(maxCollectionTime, 0, sizeof(maxCollectionTime));
+    memset(causes, 0, sizeof(causes));
+    memset(records, 0, sizeof(records));
+
     if (not system->success(system->make(&lock))) {
       system->abort();
     }
+
+    if (collectorCount > 1
+        and not(system->success(system->make(&collectorLock))
+                and system->success(system->make(&collectorMonitor)))) {
+      system->abort();
+    }
+
+    if (concurrentGen2
+        and not system->success(system->make(&markerMonitor))) {
+      system->abort();
+    }
   }
 
   void dispose()
   {
+    disposeCollectors(this);
+    disposeMarkers(this);
+
+    if (collectorLock) {
+      collectorLock->dispose();
+      collectorMonitor->dispose();
+    }
+
+    if (markerMonitor) {
+      markerMonitor->dispose();
+    }
+
     gen1.dispose();
     nextGen1.dispose();
     gen2.dispose();
@@ -769,8 +939,8 @@ class Context {
   System* system;
   Heap::Client* client;
 
-  unsigned count;
-  unsigned limit;
+  uint64_t count;
+  uint64_t limit;
 
   System::Mutex* lock;
 
@@ -793,19 +963,24 @@ class Context {
   Segment::Map nextHeapMap;
   Segment nextGen2;
 
-  unsigned gen2Base;
+  uintptr_t gen2Base;
+
+  uintptr_t incomingFootprint;
+  int64_t pendingAllocation;
+  uintptr_t tenureFootprint;
+  uintptr_t promotedFootprint;
+  uintptr_t gen1Padding;
+  uintptr_t tenurePadding;
+  uintptr_t gen2Padding;
 
-  unsigned incomingFootprint;
-  int pendingAllocation;
-  unsigned tenureFootprint;
-  unsigned gen1Padding;
-  unsigned tenurePadding;
-  unsigned gen2Padding;
+  uint64_t fixieTenureFootprint;
+  uint64_t untenuredFixieFootprint;
+  uint64_t tenuredFixieFootprint;
+  uint64_t tenuredFixieCeiling;
 
-  unsigned fixieTenureFootprint;
-  unsigned untenuredFixieFootprint;
-  unsigned tenuredFixieFootprint;
-  unsigned tenuredFixieCeiling;
+  // fixed objects of at least this many bytes are large (see
+  // Fixie::large):
+  unsigned largeObjectThreshold;
 
   Heap::CollectionType mode;
 
@@ -820,6 +995,79 @@ class Context {
   int64_t totalTime;
 
   bool limitWasExceeded;
+
+  // state for parallel minor collections.  collectors[0] represents
+  // the thread which requested the collection, and the rest are
+  // helper threads started the first time we collect in parallel:
+  unsigned collectorCount;
+  Collector* collectors;
+  System::Mutex* collectorLock;
+  System::Monitor* collectorMonitor;
+  WorkBlock* freeWorkBlocks;
+  unsigned collectorGeneration;
+  unsigned runningCollectors;
+  volatile unsigned activeCollectors;
+  bool stopCollectors;
+
+  // true while a parallel minor collection is in progress:
+  bool parallel;
+
+  // true while the collecting thread is running heap code (as
+  // opposed to client code) during a parallel collection:
+  bool busy;
+
+  // true once the client has started processing weak references and
+  // finalizers, after which every visit must be traced to completion
+  // before control returns to the client:
+  bool postVisiting;
+
+  // state for mark-compact major collections.  Each of startMap,
+  // liveMap, and growMap has one bit per word of gen2, marking
+  // respectively the first word of each reachable object, every word
+  // of each reachable object, and the last word of each object which
+  // needs an extra word for its hash code if it moves:
+  bool compactGen2;
+  bool compacting;
+  uintptr_t* startMap;
+  uintptr_t* liveMap;
+  uintptr_t* growMap;
+  uintptr_t compactionMapSize;
+  uintptr_t* forwardTable;
+  uintptr_t* compactionBase;
+  Segment::Map youngSlotMap;
+  WorkBlock* markStack;
+  WorkBlock* slotLog;
+
+  // state for concurrent marking.  While marking is true, the marker
+  // thread (markers[1]) scans gen2 objects from markStack whenever no
+  // collection is in progress, recording each slot it scans in
+  // slotMap, as does mark() for each slot the client writes.
+  // markers[0] represents whichever thread is collecting, which sets
+  // markerPaused and waits for markerBusy to be cleared before
+  // touching the heap:
+  bool concurrentGen2;
+  bool marking;
+  Marker* markers;
+  System::Monitor* markerMonitor;
+  volatile bool markerPaused;
+  bool markerBusy;
+  bool stopMarker;
+  uintptr_t* slotMap;
+  WorkBlock* padLog;
+
+  // statistics, indexed by Heap::CollectionType or
+  // Heap::CollectionCause where applicable, and guarded by lock so
+  // that the client may read them at any time:
+  unsigned collections[2];
+  int64_t collectionTime[2];
+  int64_t maxCollectionTime[2];
+  uint64_t peakCount;
+  unsigned causes[Heap::CauseCount];
+  uint64_t promoted;
+
+  // the most recent collections, indexed by sequence number (less
+  // one) modulo Heap::RecordCount:
+  Heap::Record records[Heap::RecordCount];
 };
 
 const char* segment(Context* c, void* p)
@@ -842,18 +1090,35 @@ inline Aborter* getAborter(Context* c)
   return c->system;
 }
 
-inline unsigned minimumNextGen1Capacity(Context* c)
+inline uintptr_t minimumNextGen1Capacity(Context* c)
 {
+  if (c->compacting) {
+    // nothing is tenured during a compacting collection, so objects
+    // old enough to be tenured stay in nextGen1 until the next minor
+    // collection:
+    return c->gen1.position() + c->incomingFootprint + c->gen1Padding
+           + c->tenurePadding;
+  }
+
   return c->gen1.position() - c->tenureFootprint + c->incomingFootprint
          + c->gen1Padding;
 }
 
-inline unsigned minimumNextGen2Capacity(Context* c)
+inline uintptr_t minimumNextGen2Capacity(Context* c)
 {
   return c->gen2.position() + c->tenureFootprint + c->tenurePadding
          + c->gen2Padding;
 }
 
+inline uintptr_t parallelSlack(Context* c, uintptr_t footprint)
+{
+  // room for padding left behind by rounding and abandoned claims,
+  // plus each thread's last, partially used claim:
+  return (footprint / 8)
+         + (c->collectorCount
+            * (CollectorBufferSizeInWords + CollectorClaimAlignmentInWords));
+}
+
 inline bool oversizedGen2(Context* c)
 {
   return c->gen2.capacity() > (InitialGen2CapacityInBytes / BytesPerWord)
@@ -865,19 +1130,23 @@ inline void initNextGen1(Context* c)
   new (&(c->nextAgeMap))
       Segment::Map(&(c->nextGen1), max(1, log(TenureThreshold)), 1, 0, false);
 
-  unsigned minimum = minimumNextGen1Capacity(c);
-  unsigned desired = minimum;
+  uintptr_t minimum = minimumNextGen1Capacity(c);
+  uintptr_t desired = minimum;
+
+  if (c->collectorCount > 1 and c->mode == Heap::MinorCollection) {
+    desired += parallelSlack(c, minimum);
+  }
 
   new (&(c->nextGen1)) Segment(c, &(c->nextAgeMap), desired, minimum);
 
   if (Verbose2) {
     fprintf(stderr,
-            "init nextGen1 to %d bytes\n",
+            "init nextGen1 to %" LD " bytes\n",
             c->nextGen1.capacity() * BytesPerWord);
   }
 }
 
-inline void initNextGen2(Context* c)
+inline void initNextGen2(Context* c, uintptr_t minimum)
 {
   new (&(c->nextPointerMap)) Segment::Map(&(c->nextGen2), 1, 1, 0, true);
 
@@ -890,8 +1159,7 @@ inline void initNextGen2(Context* c)
   new (&(c->nextHeapMap)) Segment::Map(
       &(c->nextGen2), 1, c->pageMap.scale * 1024, &(c->nextPageMap), true);
 
-  unsigned minimum = minimumNextGen2Capacity(c);
-  unsigned desired = minimum;
+  uintptr_t desired = minimum;
 
   if (not oversizedGen2(c)) {
     desired *= 2;
@@ -908,20 +1176,23 @@ inline void initNextGen2(Context* c)
       minimum,
       static_cast<int64_t>(c->limit / BytesPerWord)
       - (static_cast<int64_t>(c->count / BytesPerWord)
-         - c->gen2.footprint(c->gen2.capacity())
-         - c->gen1.footprint(c->gen1.capacity()) + c->pendingAllocation));
+         - static_cast<int64_t>(c->gen2.footprint(c->gen2.capacity()))
+         - static_cast<int64_t>(c->gen1.footprint(c->gen1.capacity()))
+         + c->pendingAllocation));
 
   if (Verbose2) {
     fprintf(stderr,
-            "init nextGen2 to %d bytes\n",
+            "init nextGen2 to %" LD " bytes\n",
             c->nextGen2.capacity() * BytesPerWord);
   }
 }
 
 inline bool fresh(Context* c, void* o)
 {
-  return c->nextGen1.contains(o) or c->nextGen2.contains(o)
-         or (c->gen2.contains(o) and c->gen2.indexOf(o) >= c->gen2Base);
+  return c->nextGen1.spans(o) or c->nextGen2.spans(o)
+         or (c->gen2.spans(o)
+             and static_cast<uintptr_t>(static_cast<uintptr_t*>(o)
+                                        - c->gen2.data) >= c->gen2Base);
 }
 
 inline bool wasCollected(Context* c, void* o)
@@ -971,7 +1242,11 @@ void free(Context* c, Fixie** fixies, bool resetImmortal)
       if (DebugFixies) {
         fprintf(stderr, "free fixie %p\n", f);
       }
-      free(c, f, f->totalSize());
+      if (f->large()) {
+        freePages(c, f, f->totalSize());
+      } else {
+        free(c, f, f->totalSize());
+      }
     }
   }
 }
@@ -1046,8 +1321,10 @@ void sweepFixies(Context* c)
     f->marked(false);
   }
 
-  c->tenuredFixieCeiling
-      = max(c->tenuredFixieFootprint * 2, InitialTenuredFixieCeilingInBytes);
+  c->tenuredFixieCeiling = c->tenuredFixieFootprint * 2;
+  if (c->tenuredFixieCeiling < InitialTenuredFixieCeilingInBytes) {
+    c->tenuredFixieCeiling = InitialTenuredFixieCeilingInBytes;
+  }
 }
 
 inline void* copyTo(Context* c, Segment* s, void* o, unsigned size)
@@ -1063,6 +1340,8 @@ bool immortalHeapContains(Context* c, void* p)
   return p < c->immortalHeapEnd and p >= c->immortalHeapStart;
 }
 
+void markObject(Context* c, void* o);
+
 void* copy2(Context* c, void* o)
 {
   unsigned size = c->client->copiedSizeInWords(o);
@@ -1073,7 +1352,7 @@ void* copy2(Context* c, void* o)
     return copyTo(c, &(c->nextGen2), o, size);
   } else if (c->gen1.contains(o)) {
     unsigned age = c->ageMap.get(o);
-    if (age == TenureThreshold) {
+    if (age == TenureThreshold and not c->compacting) {
       if (c->mode == Heap::MinorCollection) {
         assertT(c, c->gen2.remaining() >= size);
 
@@ -1081,15 +1360,26 @@ void* copy2(Context* c, void* o)
           c->gen2Base = c->gen2.position();
         }
 
-        return copyTo(c, &(c->gen2), o, size);
+        o = copyTo(c, &(c->gen2), o, size);
+        c->promotedFootprint += size;
+
+        // objects tenured while gen2 is being marked are live as far
+        // as the marker is concerned, but it must still scan them:
+        if (c->marking) {
+          markObject(c, o);
+        }
+
+        return o;
       } else {
+        c->promotedFootprint += size;
         return copyTo(c, &(c->nextGen2), o, size);
       }
     } else {
       o = copyTo(c, &(c->nextGen1), o, size);
 
-      c->nextAgeMap.setOnly(o, age + 1);
-      if (age + 1 == TenureThreshold) {
+      unsigned nextAge = min(age + 1, TenureThreshold);
+      c->nextAgeMap.setOnly(o, nextAge);
+      if (nextAge == TenureThreshold) {
         c->tenureFootprint += size;
       }
 
@@ -1142,10 +1432,12 @@ void* update3(Context* c, void* o, bool* needsVisit)
     }
     *needsVisit = false;
     return o;
-  } else if (immortalHeapContains(c, o)) {
+  } else if (immortalHeapContains(c, o) or fresh(c, o)) {
+    // the latter may happen if the client visits a slot which
+    // already refers to a copy
     *needsVisit = false;
     return o;
-  } else if (wasCollected(c, o)) {
+  } else if (fresh(c, get(o, 0))) {
     *needsVisit = false;
     return follow(c, o);
   } else {
@@ -1156,7 +1448,13 @@ void* update3(Context* c, void* o, bool* needsVisit)
 
 void* update2(Context* c, void* o, bool* needsVisit)
 {
-  if (c->mode == Heap::MinorCollection and c->gen2.contains(o)) {
+  if (c->mode == Heap::MinorCollection and c->gen2.spans(o)) {
+    // hand the marker whatever we find in gen2 along the way, so
+    // that there's less left to mark when gen2 is collected:
+    if (c->marking and c->gen2.contains(o)) {
+      markObject(c, o);
+    }
+
     *needsVisit = false;
     return o;
   }
@@ -1210,7 +1508,7 @@ void updateHeapMap(Context* c,
   if (not(immortalHeapContains(c, result)
           or (c->client->isFixed(result)
               and fixie(result)->age >= FixieTenureThreshold)
-          or seg->contains(result))) {
+          or seg->spans(result))) {
     if (target and c->client->isFixed(target)) {
       Fixie* f = fixie(target);
       assertT(c, offset == 0 or f->hasMask());
@@ -1228,7 +1526,7 @@ void updateHeapMap(Context* c,
         f->dirty(true);
         markBit(f->mask(), offset);
       }
-    } else if (seg->contains(p)) {
+    } else if (seg->spans(p)) {
       if (Debug) {
         fprintf(stderr,
                 "mark %p (%s) at %p (%s)\n",
@@ -1238,7 +1536,15 @@ void updateHeapMap(Context* c,
                 segment(c, p));
       }
 
+#ifdef USE_ATOMIC_OPERATIONS
+      if (c->parallel) {
+        map->markAtomic(p);
+      } else {
+        map->set(p);
+      }
+#else
       map->set(p);
+#endif
     }
   }
 }
@@ -1263,171 +1569,1561 @@ void* update(Context* c,
   return result;
 }
 
-const uintptr_t BitsetExtensionBit
-    = (static_cast<uintptr_t>(1) << (BitsPerWord - 1));
+// Parallel minor collections
+//
+// Rather than tracing depth-first from each root as collect() does
+// below, each collector thread copies objects into chunks of nextGen1
+// and gen2 it has claimed for itself and pushes the copies onto its
+// own queue of grey objects to be scanned later.  Threads which run
+// out of work steal blocks of grey objects from the others.  Races to
+// copy the same object are settled by a compare-and-swap on its first
+// word, which is where the forwarding pointer goes.
+
+class WorkBlock {
+ public:
+  WorkBlock* next;
+  unsigned count;
+  void* items[WorkBlockCapacity];
+};
 
-void bitsetInit(uintptr_t* p)
-{
-  memset(p, 0, BytesPerWord);
-}
+class Buffer {
+ public:
+  Buffer() : position(0), limit(0)
+  {
+  }
 
-void bitsetClear(uintptr_t* p, unsigned start, unsigned end)
-{
-  if (end < BitsPerWord - 1) {
-    // do nothing
-  } else if (start < BitsPerWord - 1) {
-    memset(p + 1, 0, (wordOf(end + (BitsPerWord * 2) + 1)) * BytesPerWord);
-  } else {
-    unsigned startWord = wordOf(start + (BitsPerWord * 2) + 1);
-    unsigned endWord = wordOf(end + (BitsPerWord * 2) + 1);
-    if (endWord > startWord) {
-      memset(p + startWord + 1, 0, (endWord - startWord) * BytesPerWord);
-    }
+  uintptr_t* position;
+  uintptr_t* limit;
+};
+
+class Collector : public System::Runnable {
+ public:
+  Collector(Context* c, unsigned index)
+      : c(c),
+        index(index),
+        generation(c->collectorGeneration),
+        systemThread(0),
+        lock(0),
+        current(0),
+        queue(0),
+        queued(0),
+        tenureFootprint(0),
+        promotedFootprint(0)
+  {
   }
-}
 
-void bitsetSet(uintptr_t* p, unsigned i, bool v)
+  virtual void attach(System::Thread* t)
+  {
+    systemThread = t;
+  }
+
+  virtual void run();
+
+  virtual bool interrupted()
+  {
+    return false;
+  }
+
+  virtual void setInterrupted(bool)
+  {
+  }
+
+  Context* c;
+  unsigned index;
+  unsigned generation;
+  System::Thread* systemThread;
+  System::Mutex* lock;
+  WorkBlock* current;
+  WorkBlock* queue;
+  volatile unsigned queued;
+  Buffer gen1Buffer;
+  Buffer gen2Buffer;
+  uintptr_t tenureFootprint;
+  uintptr_t promotedFootprint;
+};
+
+WorkBlock* makeWorkBlock(Context* c)
 {
-  if (i >= BitsPerWord - 1) {
-    i += (BitsPerWord * 2) + 1;
-    if (v) {
-      p[0] |= BitsetExtensionBit;
-      if (p[2] <= wordOf(i) - 3)
-        p[2] = wordOf(i) - 2;
+  WorkBlock* b;
+  {
+    ACQUIRE(c->collectorLock);
+
+    b = c->freeWorkBlocks;
+    if (b) {
+      c->freeWorkBlocks = b->next;
     }
   }
 
-  if (v) {
-    markBit(p, i);
-  } else {
-    clearBit(p, i);
+  if (b == 0) {
+    b = static_cast<WorkBlock*>(allocate(c, sizeof(WorkBlock)));
   }
+
+  b->next = 0;
+  b->count = 0;
+  return b;
 }
 
-bool bitsetHasMore(uintptr_t* p)
+void releaseWorkBlock(Context* c, WorkBlock* b)
 {
-  switch (*p) {
-  case 0:
-    return false;
+  ACQUIRE(c->collectorLock);
 
-  case BitsetExtensionBit: {
-    uintptr_t length = p[2];
-    uintptr_t word = wordOf(p[1]);
-    for (; word < length; ++word) {
-      if (p[word + 3]) {
-        p[1] = indexOf(word, 0);
-        return true;
-      }
-    }
-    p[1] = indexOf(word, 0);
-    return false;
+  b->next = c->freeWorkBlocks;
+  c->freeWorkBlocks = b;
+}
+
+void publish(Collector* w)
+{
+  WorkBlock* b = w->current;
+  w->current = makeWorkBlock(w->c);
+
+  ACQUIRE(w->lock);
+
+  b->next = w->queue;
+  w->queue = b;
+  ++w->queued;
+}
+
+WorkBlock* take(Collector* w)
+{
+  if (w->queued == 0) {
+    return 0;
   }
 
-  default:
-    return true;
+  ACQUIRE(w->lock);
+
+  WorkBlock* b = w->queue;
+  if (b) {
+    w->queue = b->next;
+    --w->queued;
+    b->next = 0;
   }
+  return b;
 }
 
-unsigned bitsetNext(Context* c, uintptr_t* p)
+void push(Collector* w, void* o)
 {
-  bool more UNUSED = bitsetHasMore(p);
-  assertT(c, more);
+  WorkBlock* b = w->current;
+  if (b->count == WorkBlockCapacity
+      or (b->count >= WorkBlockShareThreshold and w->queued == 0
+          and w->c->activeCollectors < w->c->collectorCount)) {
+    publish(w);
+    b = w->current;
+  }
 
-  switch (*p) {
-  case 0:
-    abort(c);
+  b->items[b->count++] = o;
+}
 
-  case BitsetExtensionBit: {
-    uintptr_t i = p[1];
-    uintptr_t word = wordOf(i);
-    assertT(c, word < p[2]);
-    for (uintptr_t bit = bitOf(i); bit < BitsPerWord; ++bit) {
-      if (p[word + 3] & (static_cast<uintptr_t>(1) << bit)) {
-        p[1] = indexOf(word, bit) + 1;
-        bitsetSet(p, p[1] + BitsPerWord - 2, false);
-        return p[1] + BitsPerWord - 2;
-      }
-    }
-    abort(c);
+bool refill(Collector* w)
+{
+  Context* c = w->c;
+
+  WorkBlock* b = take(w);
+  for (unsigned i = 1; b == 0 and i < c->collectorCount; ++i) {
+    b = take(c->collectors + ((w->index + i) % c->collectorCount));
   }
 
-  default: {
-    for (unsigned i = 0; i < BitsPerWord - 1; ++i) {
-      if (*p & (static_cast<uintptr_t>(1) << i)) {
-        bitsetSet(p, i, false);
-        return i;
-      }
+  if (b) {
+    releaseWorkBlock(c, w->current);
+    w->current = b;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+bool workAvailable(Context* c)
+{
+  for (unsigned i = 0; i < c->collectorCount; ++i) {
+    if (c->collectors[i].queued) {
+      return true;
     }
-    abort(c);
   }
+  return false;
+}
+
+uintptr_t* claim(Context* c, Segment* s, uintptr_t* size, unsigned minimum)
+{
+  ACQUIRE(c->collectorLock);
+
+  if (*size > s->remaining()) {
+    *size = s->remaining();
   }
+
+  // collect() checked that there would be enough room before
+  // choosing to collect in parallel:
+  expect(c->system, *size >= minimum);
+
+  return static_cast<uintptr_t*>(s->allocate(*size));
 }
 
-void collect(Context* c, void** p, void* target, unsigned offset)
+void* allocateCopy(Collector* w, Segment* s, Buffer* b, unsigned size)
 {
-  void* original = maskAlignedPointer(*p);
-  void* parent_ = 0;
+  if (size > CollectorLargeObjectSizeInWords) {
+    uintptr_t n = ceilingDivide(size, CollectorClaimAlignmentInWords)
+                  * CollectorClaimAlignmentInWords;
+    return claim(w->c, s, &n, size);
+  }
 
-  if (Debug) {
-    fprintf(stderr,
-            "update %p (%s) at %p (%s)\n",
-            maskAlignedPointer(*p),
-            segment(c, *p),
-            p,
-            segment(c, p));
+  if (static_cast<unsigned>(b->limit - b->position) < size) {
+    uintptr_t n = CollectorBufferSizeInWords;
+    b->position = claim(w->c, s, &n, size);
+    b->limit = b->position + n;
   }
 
-  bool needsVisit;
-  local::set(p, update(c, maskAlignedPointer(p), target, offset, &needsVisit));
+  void* p = b->position;
+  b->position += size;
+  return p;
+}
 
-  if (Debug) {
-    fprintf(stderr,
-            "  result: %p (%s) (visit? %d)\n",
-            maskAlignedPointer(*p),
-            segment(c, *p),
-            needsVisit);
+void retire(Segment* s, Buffer* b)
+{
+  // give back whatever we didn't use if nothing was claimed after
+  // it; otherwise it just becomes padding:
+  if (b->limit and b->limit == s->data + s->position()) {
+    s->position_ -= b->limit - b->position;
   }
 
-  if (not needsVisit)
-    return;
+  b->position = b->limit = 0;
+}
 
-visit : {
-  void* copy = follow(c, original);
+void markFixie(Collector* w, void* o)
+{
+  Context* c = w->c;
+  Fixie* f = fixie(o);
 
-  class Walker : public Heap::Walker {
-   public:
-    Walker(Context* c, void* copy, uintptr_t* bitset)
-        : c(c),
-          copy(copy),
-          bitset(bitset),
-          first(0),
-          second(0),
-          last(0),
-          visits(0),
-          total(0)
+  if ((not f->marked()) and (c->mode == Heap::MajorCollection
+                             or f->age < FixieTenureThreshold)) {
+    bool marked;
     {
-    }
+      ACQUIRE(c->collectorLock);
 
-    virtual bool visit(unsigned offset)
-    {
-      if (Debug) {
-        fprintf(stderr,
-                "  update %p (%s) at %p - offset %d from %p (%s)\n",
-                get(copy, offset),
-                segment(c, get(copy, offset)),
-                getp(copy, offset),
-                offset,
-                copy,
-                segment(c, copy));
+      marked = not f->marked();
+      if (marked) {
+        if (DebugFixies) {
+          fprintf(stderr, "mark fixie %p\n", f);
+        }
+
+        f->marked(true);
+        f->dead(false);
+        f->move(c, &(c->visitedFixies));
       }
+    }
 
-      bool needsVisit;
-      void* childCopy
-          = update(c, getp(copy, offset), copy, offset, &needsVisit);
+    if (marked) {
+      push(w, o);
+    }
+  }
+}
 
-      if (Debug) {
-        fprintf(stderr,
-                "    result: %p (%s) (visit? %d)\n",
+void* evacuate(Collector* w, void* o, bool* needsVisit)
+{
+  Context* c = w->c;
+
+  *needsVisit = false;
+
+  if (c->gen2.spans(o)) {
+    return o;
+  } else if (c->client->isFixed(o)) {
+    markFixie(w, o);
+    return o;
+  } else if (immortalHeapContains(c, o) or fresh(c, o)) {
+    // the latter may happen if the client stores a reference to a
+    // copy into an object we haven't scanned yet
+    return o;
+  }
+
+#ifdef USE_ATOMIC_OPERATIONS
+  // claim the object before looking at it, so that nobody else can
+  // forward it while we're working out its size or copying it.  If
+  // someone else got there first, wait for them to finish instead:
+  uintptr_t* p = &fieldAtOffset<uintptr_t>(o, 0);
+  uintptr_t header = *p;
+  while (true) {
+    if (header == BusyMark) {
+      loadMemoryBarrier();
+    } else if (fresh(c, reinterpret_cast<void*>(header))) {
+      return reinterpret_cast<void*>(header);
+    } else if (atomicCompareAndSwap(p, header, BusyMark)) {
+      break;
+    }
+    header = *p;
+  }
+#else
+  uintptr_t header = 0;
+  abort(c);
+#endif
+
+  unsigned size = c->client->copiedSizeInWords(o, header);
+
+  unsigned age = c->gen1.contains(o) ? c->ageMap.get(o) : 0;
+  bool tenure = c->gen1.contains(o) and age == TenureThreshold;
+
+  void* r = allocateCopy(w,
+                         tenure ? &(c->gen2) : &(c->nextGen1),
+                         tenure ? &(w->gen2Buffer) : &(w->gen1Buffer),
+                         size);
+
+  c->client->copy(o, r, header);
+
+  if (tenure) {
+    w->promotedFootprint += size;
+  } else {
+    if (c->gen1.contains(o)) {
+      c->nextAgeMap.setOnly(r, age + 1);
+      if (age + 1 == TenureThreshold) {
+        w->tenureFootprint += size;
+      }
+    } else {
+      c->nextAgeMap.clear(r);
+    }
+  }
+
+#ifdef USE_ATOMIC_OPERATIONS
+  // the barrier implied by the swap makes sure anyone who sees the
+  // forwarding pointer also sees the copy:
+  expect(c->system,
+         atomicCompareAndSwap(p, BusyMark, reinterpret_cast<uintptr_t>(r)));
+#endif
+
+  *needsVisit = true;
+  return r;
+}
+
+void updateSlot(Collector* w, void** p, void* target, unsigned offset)
+{
+  void* o = maskAlignedPointer(*p);
+  if (o == 0) {
+    return;
+  }
+
+  bool needsVisit;
+  void* result = evacuate(w, o, &needsVisit);
+
+  local::set(p, result);
+
+  updateHeapMap(w->c, p, target, offset, result);
+
+  if (needsVisit) {
+    push(w, result);
+  }
+}
+
+void scan(Collector* w, void* o)
+{
+  class Walker : public Heap::Walker {
+   public:
+    Walker(Collector* w, void* o) : w(w), o(o)
+    {
+    }
+
+    virtual bool visit(unsigned offset)
+    {
+      updateSlot(w, getp(o, offset), o, offset);
+      return true;
+    }
+
+    Collector* w;
+    void* o;
+  } walker(w, o);
+
+  w->c->client->walk(o, &walker);
+}
+
+void drainShared(Collector* w)
+{
+  Context* c = w->c;
+
+  while (true) {
+    while (w->current->count or refill(w)) {
+      scan(w, w->current->items[--w->current->count]);
+    }
+
+    {
+      ACQUIRE(c->collectorLock);
+      --c->activeCollectors;
+    }
+
+    // we're out of work, so wait until someone shares theirs or
+    // everyone else runs out too:
+    while (true) {
+      if (workAvailable(c)) {
+        {
+          ACQUIRE(c->collectorLock);
+          ++c->activeCollectors;
+        }
+
+        if (refill(w)) {
+          break;
+        }
+
+        {
+          ACQUIRE(c->collectorLock);
+          --c->activeCollectors;
+        }
+      } else if (c->activeCollectors == 0) {
+        return;
+      }
+
+      c->system->yield();
+    }
+  }
+}
+
+void Collector::run()
+{
+  while (true) {
+    c->collectorMonitor->acquire(systemThread);
+
+    while (generation == c->collectorGeneration and not c->stopCollectors) {
+      c->collectorMonitor->wait(systemThread, 0);
+    }
+
+    generation = c->collectorGeneration;
+    bool stop = c->stopCollectors;
+
+    c->collectorMonitor->release(systemThread);
+
+    if (stop) {
+      return;
+    }
+
+    drainShared(this);
+
+    c->collectorMonitor->acquire(systemThread);
+
+    if (--c->runningCollectors == 0) {
+      c->collectorMonitor->notifyAll(systemThread);
+    }
+
+    c->collectorMonitor->release(systemThread);
+  }
+}
+
+void drainInParallel(Context* c)
+{
+  Collector* w = c->collectors;
+  System::Thread* t = w->systemThread;
+
+  c->activeCollectors = c->collectorCount;
+
+  c->collectorMonitor->acquire(t);
+  ++c->collectorGeneration;
+  c->runningCollectors = c->collectorCount - 1;
+  c->collectorMonitor->notifyAll(t);
+  c->collectorMonitor->release(t);
+
+  drainShared(w);
+
+  c->collectorMonitor->acquire(t);
+  while (c->runningCollectors) {
+    c->collectorMonitor->wait(t, 0);
+  }
+  c->collectorMonitor->release(t);
+
+  c->activeCollectors = c->collectorCount;
+}
+
+void drain(Context* c)
+{
+  Collector* w = c->collectors;
+
+  bool busy = c->busy;
+  c->busy = true;
+
+  // don't bother waking the helper threads unless there's at least a
+  // full block of work to share:
+  while (true) {
+    if (w->queued) {
+      drainInParallel(c);
+      break;
+    } else if (w->current->count) {
+      scan(w, w->current->items[--w->current->count]);
+    } else {
+      break;
+    }
+  }
+
+  c->busy = busy;
+}
+
+void startCollectors(Context* c)
+{
+  c->collectors = static_cast<Collector*>(
+      allocate(c, sizeof(Collector) * c->collectorCount));
+
+  for (unsigned i = 0; i < c->collectorCount; ++i) {
+    Collector* w = new (c->collectors + i) Collector(c, i);
+
+    if (not c->system->success(c->system->make(&(w->lock)))) {
+      c->system->abort();
+    }
+
+    w->current = makeWorkBlock(c);
+  }
+
+  for (unsigned i = 1; i < c->collectorCount; ++i) {
+    expect(c->system, c->system->success(c->system->start(c->collectors + i)));
+  }
+}
+
+void disposeCollectors(Context* c)
+{
+  if (c->collectors == 0) {
+    return;
+  }
+
+  Collector* w = c->collectors;
+  expect(c->system, c->system->success(c->system->attach(w)));
+
+  c->collectorMonitor->acquire(w->systemThread);
+  c->stopCollectors = true;
+  c->collectorMonitor->notifyAll(w->systemThread);
+  c->collectorMonitor->release(w->systemThread);
+
+  for (unsigned i = 0; i < c->collectorCount; ++i) {
+    w = c->collectors + i;
+
+    if (i) {
+      w->systemThread->join();
+    }
+    w->systemThread->dispose();
+
+    releaseWorkBlock(c, w->current);
+    w->lock->dispose();
+  }
+
+  while (c->freeWorkBlocks) {
+    WorkBlock* b = c->freeWorkBlocks;
+    c->freeWorkBlocks = b->next;
+    free(c, b, sizeof(WorkBlock));
+  }
+
+  free(c, c->collectors, sizeof(Collector) * c->collectorCount);
+  c->collectors = 0;
+}
+
+bool shouldCollectInParallel(Context* c)
+{
+  // while marking, each object tenured must be handed to the marker,
+  // which only the sequential collector does:
+  if (c->collectorCount < 2 or c->mode != Heap::MinorCollection
+      or c->marking) {
+    return false;
+  }
+
+  uintptr_t gen1Footprint = minimumNextGen1Capacity(c);
+  if (c->nextGen1.capacity() < gen1Footprint
+                               + parallelSlack(c, gen1Footprint)) {
+    return false;
+  }
+
+  uintptr_t gen2Footprint = c->tenureFootprint + c->tenurePadding;
+  return gen2Footprint == 0
+         or c->gen2.remaining() >= gen2Footprint
+                                   + parallelSlack(c, gen2Footprint);
+}
+
+void startParallelCollection(Context* c)
+{
+  if (c->collectors == 0) {
+    startCollectors(c);
+  }
+
+  // the collecting thread needs a System::Thread of its own to
+  // coordinate with the helpers:
+  expect(c->system, c->system->success(c->system->attach(c->collectors)));
+
+  for (unsigned i = 0; i < c->collectorCount; ++i) {
+    c->collectors[i].tenureFootprint = 0;
+    c->collectors[i].promotedFootprint = 0;
+  }
+
+  c->gen2Base = c->gen2.position();
+  c->busy = true;
+  c->postVisiting = false;
+}
+
+void finishParallelCollection(Context* c)
+{
+  drain(c);
+
+  for (unsigned i = 0; i < c->collectorCount; ++i) {
+    Collector* w = c->collectors + i;
+
+    retire(&(c->nextGen1), &(w->gen1Buffer));
+    retire(&(c->gen2), &(w->gen2Buffer));
+
+    c->tenureFootprint += w->tenureFootprint;
+    c->promotedFootprint += w->promotedFootprint;
+  }
+
+  c->collectors->systemThread->dispose();
+  c->collectors->systemThread = 0;
+
+  c->parallel = false;
+  c->busy = false;
+  c->postVisiting = false;
+}
+
+// Mark-compact major collections
+//
+// When compactGen2 is set, a major collection leaves gen2 objects
+// where they are while tracing rather than copying them to a new
+// segment, so it needs little more memory than gen2 already uses.
+// Young objects are copied to nextGen1 as usual (including any old
+// enough to be tenured, which wait there for the next minor
+// collection), while each reachable gen2 object is recorded in
+// startMap, liveMap, and growMap and pushed onto markStack to be
+// scanned later.  We also remember every slot visited or written
+// during the collection: in gen2's pointerMap if the slot is in gen2,
+// in youngSlotMap if it is in nextGen1, and in slotLog otherwise.
+//
+// Once the client is done, we assign each live object a new address
+// by sliding everything down, as the Compressor does: forwardTable
+// holds, for every BitsPerWord words of gen2, the new index of the
+// first live word among them, and counting bits in liveMap and
+// growMap gives the rest.  We then rewrite every remembered slot
+// which refers to gen2, rebuild the heapMap cards for slots which
+// refer to young objects, and finally move the objects.  If gen2 is
+// too small for what we expect to tenure next, or much too large, we
+// slide into a fresh segment instead.
+
+void visitMarkedFixies(Context* c);
+bool limitExceeded(Context* c, int64_t pendingAllocation);
+
+inline unsigned bitCount(uintptr_t v)
+{
+#ifdef _MSC_VER
+  unsigned n = 0;
+  for (; v; v &= v - 1) {
+    ++n;
+  }
+  return n;
+#else
+  return __builtin_popcountll(v);
+#endif
+}
+
+inline unsigned lowestBit(uintptr_t v)
+{
+#ifdef _MSC_VER
+  unsigned n = 0;
+  for (; (v & 1) == 0; v >>= 1) {
+    ++n;
+  }
+  return n;
+#else
+  return __builtin_ctzll(v);
+#endif
+}
+
+void markBits(uintptr_t* map, uintptr_t start, uintptr_t end)
+{
+  for (; start < end and bitOf(start); ++start) {
+    markBit(map, start);
+  }
+
+  for (; start + BitsPerWord <= end; start += BitsPerWord) {
+    map[wordOf(start)] = ~static_cast<uintptr_t>(0);
+  }
+
+  for (; start < end; ++start) {
+    markBit(map, start);
+  }
+}
+
+// returns the index of the first bit in [start, end) which is set
+// (or, if inverted, clear) in map, or end if there is none:
+uintptr_t findBit(uintptr_t* map,
+                  uintptr_t start,
+                  uintptr_t end,
+                  bool inverted)
+{
+  while (start < end) {
+    uintptr_t w = map[wordOf(start)];
+    if (inverted) {
+      w = ~w;
+    }
+
+    w &= (~static_cast<uintptr_t>(0)) << bitOf(start);
+    if (w) {
+      uintptr_t i = indexOf(wordOf(start), lowestBit(w));
+      return i < end ? i : end;
+    }
+
+    start = indexOf(wordOf(start) + 1, 0);
+  }
+
+  return end;
+}
+
+void append(Context* c, WorkBlock** list, void* item)
+{
+  WorkBlock* b = *list;
+  if (b == 0 or b->count == WorkBlockCapacity) {
+    b = static_cast<WorkBlock*>(allocate(c, sizeof(WorkBlock)));
+    b->next = *list;
+    b->count = 0;
+    *list = b;
+  }
+
+  b->items[b->count++] = item;
+}
+
+void freeBlocks(Context* c, WorkBlock** list)
+{
+  while (*list) {
+    WorkBlock* b = *list;
+    *list = b->next;
+    free(c, b, sizeof(WorkBlock));
+  }
+}
+
+bool popMarked(Context* c, void** o)
+{
+  WorkBlock* b = c->markStack;
+  if (b and b->count == 0 and b->next) {
+    c->markStack = b->next;
+    free(c, b, sizeof(WorkBlock));
+    b = c->markStack;
+  }
+
+  if (b and b->count) {
+    *o = b->items[--b->count];
+    return true;
+  } else {
+    return false;
+  }
+}
+
+void recordSlot(Context* c, void** p)
+{
+  if (c->gen2.contains(p)) {
+    c->pointerMap.setOnly(p);
+  } else if (c->nextGen1.contains(p)) {
+    c->youngSlotMap.setOnly(p);
+  } else if (c->gen2.contains(maskAlignedPointer(*p))) {
+    append(c, &(c->slotLog), p);
+  }
+}
+
+void markObject(Context* c, void* o)
+{
+  uintptr_t i = c->gen2.indexOf(o);
+  if (not getBit(c->startMap, i)) {
+    markBit(c->startMap, i);
+
+    unsigned size = c->client->sizeInWords(o);
+    markBits(c->liveMap, i, i + size);
+
+    if (c->client->copiedSizeInWords(o) > size) {
+      markBit(c->growMap, i + size - 1);
+    }
+
+    append(c, &(c->markStack), o);
+  }
+}
+
+void markSlot(Context* c, void** p, void* target, unsigned offset)
+{
+  void* o = maskAlignedPointer(*p);
+  if (o) {
+    if (c->gen2.contains(o)) {
+      markObject(c, o);
+    } else {
+      bool needsVisit;
+      void* result = update3(c, o, &needsVisit);
+      local::set(p, result);
+
+      updateHeapMap(c, p, target, offset, result);
+
+      if (needsVisit) {
+        append(c, &(c->markStack), result);
+      }
+    }
+  }
+
+  recordSlot(c, p);
+}
+
+void scanMarked(Context* c, void* o)
+{
+  class Walker : public Heap::Walker {
+   public:
+    Walker(Context* c, void* o) : c(c), o(o)
+    {
+    }
+
+    virtual bool visit(unsigned offset)
+    {
+      markSlot(c, getp(o, offset), o, offset);
+      return true;
+    }
+
+    Context* c;
+    void* o;
+  } walker(c, o);
+
+  c->client->walk(o, &walker);
+}
+
+void drainMarkStack(Context* c)
+{
+  while (true) {
+    void* o;
+    while (popMarked(c, &o)) {
+      scanMarked(c, o);
+    }
+
+    if (c->markedFixies) {
+      visitMarkedFixies(c);
+    } else {
+      break;
+    }
+  }
+}
+
+uintptr_t* makeMarkMap(Context* c, uintptr_t size)
+{
+  uintptr_t* map = static_cast<uintptr_t*>(allocate(c, size * BytesPerWord));
+  memset(map, 0, size * BytesPerWord);
+  return map;
+}
+
+void finishMarking(Context* c);
+
+void startCompaction(Context* c)
+{
+  // if gen2 has been marked concurrently, the maps already exist:
+  if (not c->marking) {
+    uintptr_t size = divideRoundingUp(c->gen2.position(), BitsPerWord) + 1;
+    c->compactionMapSize = size;
+
+    c->startMap = makeMarkMap(c, size);
+    c->liveMap = makeMarkMap(c, size);
+    c->growMap = makeMarkMap(c, size);
+  }
+
+  if (c->nextGen1.capacity()) {
+    uintptr_t n = Segment::Map::calculateSize(c, c->nextGen1.capacity(), 1, 1);
+    new (&(c->youngSlotMap))
+        Segment::Map(&(c->nextGen1),
+                     static_cast<uintptr_t*>(allocate(c, n * BytesPerWord)),
+                     1,
+                     1,
+                     0,
+                     true);
+    c->youngSlotMap.init();
+  } else {
+    new (&(c->youngSlotMap)) Segment::Map(&(c->nextGen1), 1, 1, 0, false);
+  }
+
+  // the cards left over from minor collections are of no use to us,
+  // and pointerMap will now record slots of every kind:
+  if (c->gen2.capacity()) {
+    for (Segment::Map* m = &(c->heapMap); m; m = m->child) {
+      memset(m->data, 0, m->size() * BytesPerWord);
+    }
+  }
+
+  if (c->marking) {
+    finishMarking(c);
+  }
+}
+
+inline uintptr_t objectEnd(Context* c, uintptr_t start, uintptr_t end)
+{
+  uintptr_t next = findBit(c->startMap, start + 1, end, false);
+  uintptr_t dead = findBit(c->liveMap, start + 1, end, true);
+  return next < dead ? next : dead;
+}
+
+inline uintptr_t forwardIndex(Context* c, uintptr_t i)
+{
+  uintptr_t word = wordOf(i);
+  uintptr_t below = (static_cast<uintptr_t>(1) << bitOf(i)) - 1;
+  return c->forwardTable[word] + bitCount(c->liveMap[word] & below)
+         + bitCount(c->growMap[word] & below);
+}
+
+inline void* forward(Context* c, void* o)
+{
+  uintptr_t i = c->gen2.indexOf(o);
+  assertT(c, getBit(c->startMap, i));
+  return c->compactionBase + forwardIndex(c, i);
+}
+
+// rewrites the slot at p if it refers to gen2, returning true if it
+// refers to something a minor collection may move instead:
+bool forwardSlot(Context* c, void** p)
+{
+  void* o = maskAlignedPointer(*p);
+  if (o == 0 or immortalHeapContains(c, o)) {
+    return false;
+  } else if (c->gen2.contains(o)) {
+    local::set(p, forward(c, o));
+    return false;
+  } else if (c->client->isFixed(o)) {
+    return fixie(o)->age < FixieTenureThreshold;
+  } else {
+    return true;
+  }
+}
+
+int compareSlots(const void* a, const void* b)
+{
+  uintptr_t x = reinterpret_cast<uintptr_t>(*static_cast<void* const*>(a));
+  uintptr_t y = reinterpret_cast<uintptr_t>(*static_cast<void* const*>(b));
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+void forwardLoggedSlots(Context* c)
+{
+  unsigned count = 0;
+  for (WorkBlock* b = c->slotLog; b; b = b->next) {
+    count += b->count;
+  }
+
+  if (count) {
+    // a slot may have been logged more than once, but must only be
+    // forwarded once:
+    void** slots = static_cast<void**>(allocate(c, count * BytesPerWord));
+    unsigned index = 0;
+    for (WorkBlock* b = c->slotLog; b; b = b->next) {
+      memcpy(slots + index, b->items, b->count * BytesPerWord);
+      index += b->count;
+    }
+
+    qsort(slots, count, BytesPerWord, compareSlots);
+
+    for (unsigned i = 0; i < count; ++i) {
+      if (i == 0 or slots[i] != slots[i - 1]) {
+        forwardSlot(c, static_cast<void**>(slots[i]));
+      }
+    }
+
+    free(c, slots, count * BytesPerWord);
+  }
+
+  freeBlocks(c, &(c->slotLog));
+}
+
+void finishCompaction(Context* c)
+{
+  uintptr_t end = c->gen2.position();
+  uintptr_t size = c->compactionMapSize;
+
+  uintptr_t live = 0;
+  uintptr_t growth = 0;
+  for (uintptr_t i = 0; i < size; ++i) {
+    live += bitCount(c->liveMap[i]);
+    growth += bitCount(c->growMap[i]);
+  }
+
+  uintptr_t minimum = live + growth + c->tenureFootprint + c->tenurePadding
+                      + c->gen2Padding;
+
+  // slide into a new segment only if gen2 would otherwise be too
+  // small to hold what we expect to tenure before the next major
+  // collection, or so large as to trigger another one right away:
+  bool relocate
+      = c->gen2.capacity() < minimum
+        or (c->gen2.capacity() < minimum + (minimum / 2)
+            and not limitExceeded(c, c->pendingAllocation))
+        or (c->gen2.capacity() > InitialGen2CapacityInBytes / BytesPerWord
+            and live < c->gen2.capacity() / 4);
+
+  if (relocate) {
+    initNextGen2(c, minimum);
+    c->compactionBase = c->nextGen2.data;
+  } else {
+    c->compactionBase = c->gen2.data;
+  }
+
+  // an object which stays where it is keeps its address as its hash
+  // code, so it needn't grow:
+  uintptr_t position = 0;
+  for (uintptr_t s = findBit(c->startMap, 0, end, false); s < end;) {
+    uintptr_t e = objectEnd(c, s, end);
+    uintptr_t objectSize = e - s;
+    if (getBit(c->growMap, e - 1)) {
+      if (position == s and not relocate) {
+        clearBit(c->growMap, e - 1);
+        ++c->gen2Padding;
+      } else {
+        ++objectSize;
+      }
+    }
+    position += objectSize;
+
+    s = findBit(c->startMap, e, end, false);
+  }
+
+  c->forwardTable
+      = static_cast<uintptr_t*>(allocate(c, size * sizeof(uintptr_t)));
+
+  uintptr_t index = 0;
+  for (uintptr_t i = 0; i < size; ++i) {
+    c->forwardTable[i] = index;
+    index += bitCount(c->liveMap[i]) + bitCount(c->growMap[i]);
+  }
+
+  assertT(c, index == position);
+
+  if (relocate and position) {
+    c->nextGen2.allocate(position);
+  }
+
+  Segment::Map* cards = relocate ? &(c->nextHeapMap) : &(c->heapMap);
+
+  // forward slots in gen2 and rebuild the cards.  Since nothing moves
+  // up, each card lands at or before the slot we're looking at:
+  if (end) {
+    uintptr_t* slots = c->pointerMap.data;
+    uintptr_t limit = divideRoundingUp(end, BitsPerWord);
+    for (uintptr_t word = 0; word < limit; ++word) {
+      uintptr_t bits = slots[word];
+      slots[word] = 0;
+
+      for (; bits; bits &= bits - 1) {
+        uintptr_t i = indexOf(word, lowestBit(bits));
+        if (getBit(c->liveMap, i)
+            and forwardSlot(c, reinterpret_cast<void**>(c->gen2.data + i))) {
+          cards->set(c->compactionBase + forwardIndex(c, i));
+        }
+      }
+    }
+  }
+
+  if (c->youngSlotMap.data) {
+    uintptr_t* slots = c->youngSlotMap.data;
+    uintptr_t limit = divideRoundingUp(c->nextGen1.position(), BitsPerWord);
+    for (uintptr_t word = 0; word < limit; ++word) {
+      for (uintptr_t bits = slots[word]; bits; bits &= bits - 1) {
+        forwardSlot(c,
+                    reinterpret_cast<void**>(
+                        c->nextGen1.data
+                        + indexOf(word, lowestBit(bits))));
+      }
+    }
+
+    free(c,
+         c->youngSlotMap.data,
+         Segment::Map::calculateSize(c, c->nextGen1.capacity(), 1, 1)
+         * BytesPerWord);
+    c->youngSlotMap.data = 0;
+  }
+
+  forwardLoggedSlots(c);
+
+  for (uintptr_t s = findBit(c->startMap, 0, end, false); s < end;) {
+    uintptr_t e = objectEnd(c, s, end);
+    uintptr_t* src = c->gen2.data + s;
+    uintptr_t* dst = c->compactionBase + forwardIndex(c, s);
+
+    if (dst != src) {
+      memmove(dst, src, (e - s) * BytesPerWord);
+
+      if (getBit(c->growMap, e - 1)) {
+        c->client->extend(src, dst, e - s);
+      }
+    }
+
+    s = findBit(c->startMap, e, end, false);
+  }
+
+  if (Verbose2) {
+    fprintf(stderr,
+            "compacted gen2 from %" LD " to %" LD " bytes%s\n",
+            end * BytesPerWord,
+            position * BytesPerWord,
+            relocate ? " in a new segment" : "");
+  }
+
+  if (relocate) {
+    c->gen2.replaceWith(&(c->nextGen2));
+  } else {
+    c->gen2.position_ = position;
+  }
+
+  free(c, c->forwardTable, size * sizeof(uintptr_t));
+  free(c, c->startMap, size * BytesPerWord);
+  free(c, c->liveMap, size * BytesPerWord);
+  free(c, c->growMap, size * BytesPerWord);
+  c->forwardTable = 0;
+  c->startMap = c->liveMap = c->growMap = 0;
+  c->compactionBase = 0;
+
+  freeBlocks(c, &(c->markStack));
+}
+
+// Concurrent marking
+//
+// When concurrentGen2 is set, a minor collection which finds gen2
+// more than ConcurrentMarkingThreshold sixteenths full allocates the
+// mark-compact maps for the whole of gen2's capacity and hands each
+// gen2 object it comes across to the marker thread, which marks what
+// they refer to while the client runs, as it would during a
+// mark-compact collection.  Rather than following young objects and
+// fixies, the marker records every slot it scans in slotMap, and the
+// client does the same for every gen2 slot it writes by way of
+// mark().  Minor collections pause the marker, hand it whatever they
+// tenure as well as whatever gen2 objects they find, and let it go
+// again.
+//
+// The next major collection (whenever its usual triggers call for
+// one) then need only revisit the recorded slots of live objects,
+// the roots, and the young generation before compacting as usual.
+// That covers anything the client moved out of an unscanned object
+// into a scanned one while the marker ran, since the latter's slot
+// will have been recorded.
+
+class Marker : public System::Runnable {
+ public:
+  Marker(Context* c) : c(c), systemThread(0)
+  {
+  }
+
+  virtual void attach(System::Thread* t)
+  {
+    systemThread = t;
+  }
+
+  virtual void run();
+
+  virtual bool interrupted()
+  {
+    return false;
+  }
+
+  virtual void setInterrupted(bool)
+  {
+  }
+
+  Context* c;
+  System::Thread* systemThread;
+};
+
+bool hasMarked(Context* c)
+{
+  for (WorkBlock* b = c->markStack; b; b = b->next) {
+    if (b->count) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the marker thread and the client may both be setting bits in
+// slotMap at the same time:
+void recordSlotConcurrently(Context* c, void** p)
+{
+  uintptr_t i = c->gen2.indexOf(p);
+  if (not getBit(c->slotMap, i)) {
+#ifdef USE_ATOMIC_OPERATIONS
+    markBitAtomic(c->slotMap, i);
+#else
+    abort(c);
+#endif
+  }
+}
+
+void scanConcurrently(Context* c, void* o)
+{
+  class Walker : public Heap::Walker {
+   public:
+    Walker(Context* c, void* o) : c(c), o(o)
+    {
+    }
+
+    virtual bool visit(unsigned offset)
+    {
+      void** p = getp(o, offset);
+      recordSlotConcurrently(c, p);
+
+      void* target = maskAlignedPointer(*p);
+      if (target and c->gen2.contains(target)) {
+        markObject(c, target);
+      }
+      return true;
+    }
+
+    Context* c;
+    void* o;
+  } walker(c, o);
+
+  c->client->walk(o, &walker);
+}
+
+void Marker::run()
+{
+  c->markerMonitor->acquire(systemThread);
+
+  while (true) {
+    while (not(c->stopMarker
+               or (c->marking and hasMarked(c) and not c->markerPaused))) {
+      c->markerMonitor->wait(systemThread, 0);
+    }
+
+    if (c->stopMarker) {
+      break;
+    }
+
+    c->markerBusy = true;
+    c->markerMonitor->release(systemThread);
+
+    void* o;
+    while ((not c->markerPaused) and popMarked(c, &o)) {
+      scanConcurrently(c, o);
+    }
+
+    c->markerMonitor->acquire(systemThread);
+    c->markerBusy = false;
+    c->markerMonitor->notifyAll(systemThread);
+  }
+
+  c->markerMonitor->release(systemThread);
+}
+
+void startMarkers(Context* c)
+{
+  c->markers = static_cast<Marker*>(allocate(c, sizeof(Marker) * 2));
+  new (c->markers) Marker(c);
+  new (c->markers + 1) Marker(c);
+
+  // the marker will wait for resumeMarker before doing anything:
+  c->markerPaused = true;
+
+  expect(c->system, c->system->success(c->system->start(c->markers + 1)));
+}
+
+void pauseMarker(Context* c)
+{
+  if (c->markers == 0) {
+    return;
+  }
+
+  Marker* m = c->markers;
+  expect(c->system, c->system->success(c->system->attach(m)));
+
+  c->markerMonitor->acquire(m->systemThread);
+  c->markerPaused = true;
+  while (c->markerBusy) {
+    c->markerMonitor->wait(m->systemThread, 0);
+  }
+  c->markerMonitor->release(m->systemThread);
+
+  m->systemThread->dispose();
+  m->systemThread = 0;
+}
+
+void resumeMarker(Context* c)
+{
+  if (c->markers == 0) {
+    return;
+  }
+
+  Marker* m = c->markers;
+  expect(c->system, c->system->success(c->system->attach(m)));
+
+  c->markerMonitor->acquire(m->systemThread);
+  c->markerPaused = false;
+  c->markerMonitor->notifyAll(m->systemThread);
+  c->markerMonitor->release(m->systemThread);
+
+  m->systemThread->dispose();
+  m->systemThread = 0;
+}
+
+void freeMarkMaps(Context* c)
+{
+  uintptr_t size = c->compactionMapSize * BytesPerWord;
+  free(c, c->startMap, size);
+  free(c, c->liveMap, size);
+  free(c, c->growMap, size);
+  free(c, c->slotMap, size);
+  c->startMap = c->liveMap = c->growMap = c->slotMap = 0;
+
+  freeBlocks(c, &(c->markStack));
+  freeBlocks(c, &(c->padLog));
+}
+
+void disposeMarkers(Context* c)
+{
+  if (c->markers) {
+    Marker* m = c->markers;
+    expect(c->system, c->system->success(c->system->attach(m)));
+
+    c->markerMonitor->acquire(m->systemThread);
+    c->stopMarker = true;
+    c->markerPaused = true;
+    c->markerMonitor->notifyAll(m->systemThread);
+    c->markerMonitor->release(m->systemThread);
+
+    c->markers[1].systemThread->join();
+    c->markers[1].systemThread->dispose();
+    m->systemThread->dispose();
+
+    free(c, c->markers, sizeof(Marker) * 2);
+    c->markers = 0;
+  }
+
+  if (c->marking) {
+    freeMarkMaps(c);
+    c->marking = false;
+  }
+}
+
+bool shouldStartMarking(Context* c)
+{
+  if (c->concurrentGen2 and c->mode == Heap::MinorCollection
+      and not c->marking and c->gen2.position()) {
+    uintptr_t tenure = c->tenureFootprint + c->tenurePadding;
+    return c->gen2.position() >= (c->gen2.capacity() / 16)
+                                 * ConcurrentMarkingThreshold
+           or c->gen2.remaining() < tenure * ConcurrentMarkingLeadTime;
+  } else {
+    return false;
+  }
+}
+
+void startMarking(Context* c)
+{
+  // gen2 won't be replaced until the next major collection, so maps
+  // covering its capacity will cover everything tenured until then:
+  uintptr_t size = divideRoundingUp(c->gen2.capacity(), BitsPerWord) + 1;
+  c->compactionMapSize = size;
+
+  c->startMap = makeMarkMap(c, size);
+  c->liveMap = makeMarkMap(c, size);
+  c->growMap = makeMarkMap(c, size);
+  c->slotMap = makeMarkMap(c, size);
+
+  c->marking = true;
+
+  if (c->markers == 0) {
+    startMarkers(c);
+  }
+
+  if (Verbose) {
+    fprintf(stderr,
+            "start marking %" LD " bytes of gen2\n",
+            c->gen2.position() * BytesPerWord);
+  }
+}
+
+void finishMarking(Context* c)
+{
+  // objects whose hash codes have been taken since they were marked
+  // will need an extra word if they move:
+  for (WorkBlock* b = c->padLog; b; b = b->next) {
+    for (unsigned i = 0; i < b->count; ++i) {
+      void* o = b->items[i];
+      uintptr_t index = c->gen2.indexOf(o);
+      if (getBit(c->startMap, index)) {
+        unsigned size = c->client->sizeInWords(o);
+        if (c->client->copiedSizeInWords(o) > size) {
+          markBit(c->growMap, index + size - 1);
+        }
+      }
+    }
+  }
+
+  freeBlocks(c, &(c->padLog));
+
+  // revisit every recorded slot of every object marked so far, which
+  // marks anything the client stored there and moves anything young,
+  // while recording the slot in pointerMap so it can be forwarded:
+  uintptr_t* slots = c->slotMap;
+  uintptr_t limit = divideRoundingUp(c->gen2.position(), BitsPerWord);
+  for (uintptr_t word = 0; word < limit; ++word) {
+    for (uintptr_t bits = slots[word]; bits; bits &= bits - 1) {
+      uintptr_t i = indexOf(word, lowestBit(bits));
+      if (getBit(c->liveMap, i)) {
+        markSlot(c, reinterpret_cast<void**>(c->gen2.data + i), 0, 0);
+      }
+    }
+  }
+
+  free(c, c->slotMap, c->compactionMapSize * BytesPerWord);
+  c->slotMap = 0;
+
+  c->marking = false;
+
+  if (Verbose2) {
+    fprintf(stderr, "finish marking gen2\n");
+  }
+
+  // finish whatever the marker didn't get to before the roots are
+  // visited:
+  drainMarkStack(c);
+}
+
+const uintptr_t BitsetExtensionBit
+    = (static_cast<uintptr_t>(1) << (BitsPerWord - 1));
+
+void bitsetInit(uintptr_t* p)
+{
+  memset(p, 0, BytesPerWord);
+}
+
+void bitsetClear(uintptr_t* p, unsigned start, unsigned end)
+{
+  if (end < BitsPerWord - 1) {
+    // do nothing
+  } else if (start < BitsPerWord - 1) {
+    memset(p + 1, 0, (wordOf(end + (BitsPerWord * 2) + 1)) * BytesPerWord);
+  } else {
+    unsigned startWord = wordOf(start + (BitsPerWord * 2) + 1);
+    unsigned endWord = wordOf(end + (BitsPerWord * 2) + 1);
+    if (endWord > startWord) {
+      memset(p + startWord + 1, 0, (endWord - startWord) * BytesPerWord);
+    }
+  }
+}
+
+void bitsetSet(uintptr_t* p, unsigned i, bool v)
+{
+  if (i >= BitsPerWord - 1) {
+    i += (BitsPerWord * 2) + 1;
+    if (v) {
+      p[0] |= BitsetExtensionBit;
+      if (p[2] <= wordOf(i) - 3)
+        p[2] = wordOf(i) - 2;
+    }
+  }
+
+  if (v) {
+    markBit(p, i);
+  } else {
+    clearBit(p, i);
+  }
+}
+
+bool bitsetHasMore(uintptr_t* p)
+{
+  switch (*p) {
+  case 0:
+    return false;
+
+  case BitsetExtensionBit: {
+    uintptr_t length = p[2];
+    uintptr_t word = wordOf(p[1]);
+    for (; word < length; ++word) {
+      if (p[word + 3]) {
+        p[1] = indexOf(word, 0);
+        return true;
+      }
+    }
+    p[1] = indexOf(word, 0);
+    return false;
+  }
+
+  default:
+    return true;
+  }
+}
+
+unsigned bitsetNext(Context* c, uintptr_t* p)
+{
+  bool more UNUSED = bitsetHasMore(p);
+  assertT(c, more);
+
+  switch (*p) {
+  case 0:
+    abort(c);
+
+  case BitsetExtensionBit: {
+    uintptr_t i = p[1];
+    uintptr_t word = wordOf(i);
+    assertT(c, word < p[2]);
+    for (uintptr_t bit = bitOf(i); bit < BitsPerWord; ++bit) {
+      if (p[word + 3] & (static_cast<uintptr_t>(1) << bit)) {
+        p[1] = indexOf(word, bit) + 1;
+        bitsetSet(p, p[1] + BitsPerWord - 2, false);
+        return p[1] + BitsPerWord - 2;
+      }
+    }
+    abort(c);
+  }
+
+  default: {
+    for (unsigned i = 0; i < BitsPerWord - 1; ++i) {
+      if (*p & (static_cast<uintptr_t>(1) << i)) {
+        bitsetSet(p, i, false);
+        return i;
+      }
+    }
+    abort(c);
+  }
+  }
+}
+
+void collect(Context* c, void** p, void* target, unsigned offset)
+{
+  void* original = maskAlignedPointer(*p);
+  void* parent_ = 0;
+
+  if (Debug) {
+    fprintf(stderr,
+            "update %p (%s) at %p (%s)\n",
+            maskAlignedPointer(*p),
+            segment(c, *p),
+            p,
+            segment(c, p));
+  }
+
+  bool needsVisit;
+  local::set(p, update(c, maskAlignedPointer(p), target, offset, &needsVisit));
+
+  if (Debug) {
+    fprintf(stderr,
+            "  result: %p (%s) (visit? %d)\n",
+            maskAlignedPointer(*p),
+            segment(c, *p),
+            needsVisit);
+  }
+
+  if (not needsVisit)
+    return;
+
+visit : {
+  void* copy = follow(c, original);
+
+  class Walker : public Heap::Walker {
+   public:
+    Walker(Context* c, void* copy, uintptr_t* bitset)
+        : c(c),
+          copy(copy),
+          bitset(bitset),
+          first(0),
+          second(0),
+          last(0),
+          visits(0),
+          total(0)
+    {
+    }
+
+    virtual bool visit(unsigned offset)
+    {
+      if (Debug) {
+        fprintf(stderr,
+                "  update %p (%s) at %p - offset %d from %p (%s)\n",
+                get(copy, offset),
+                segment(c, get(copy, offset)),
+                getp(copy, offset),
+                offset,
+                copy,
+                segment(c, copy));
+      }
+
+      bool needsVisit;
+      void* childCopy
+          = update(c, getp(copy, offset), copy, offset, &needsVisit);
+
+      if (Debug) {
+        fprintf(stderr,
+                "    result: %p (%s) (visit? %d)\n",
                 childCopy,
                 segment(c, childCopy),
                 needsVisit);
@@ -1570,12 +3266,24 @@ visit : {
 
 void collect(Context* c, void** p)
 {
-  collect(c, p, 0, 0);
+  if (c->parallel) {
+    updateSlot(c->collectors, p, 0, 0);
+  } else if (c->compacting) {
+    markSlot(c, p, 0, 0);
+  } else {
+    collect(c, p, 0, 0);
+  }
 }
 
 void collect(Context* c, void* target, unsigned offset)
 {
-  collect(c, getp(target, offset), target, offset);
+  if (c->parallel) {
+    updateSlot(c->collectors, getp(target, offset), target, offset);
+  } else if (c->compacting) {
+    markSlot(c, getp(target, offset), target, offset);
+  } else {
+    collect(c, getp(target, offset), target, offset);
+  }
 }
 
 void visitDirtyFixies(Context* c, Fixie** p)
@@ -1674,8 +3382,8 @@ void visitMarkedFixies(Context* c)
 
 void collect(Context* c,
              Segment::Map* map,
-             unsigned start,
-             unsigned end,
+             uintptr_t start,
+             uintptr_t end,
              bool* dirty,
              bool expectDirty UNUSED)
 {
@@ -1684,8 +3392,8 @@ void collect(Context* c,
     wasDirty = true;
     if (map->child) {
       assertT(c, map->scale > 1);
-      unsigned s = it.next();
-      unsigned e = s + map->scale;
+      uintptr_t s = it.next();
+      uintptr_t e = s + map->scale;
 
       map->clearOnly(s);
       bool childDirty = false;
@@ -1720,6 +3428,7 @@ void collect2(Context* c)
 {
   c->gen2Base = Top;
   c->tenureFootprint = 0;
+  c->promotedFootprint = 0;
   c->fixieTenureFootprint = 0;
   c->gen1Padding = 0;
   c->tenurePadding = 0;
@@ -1728,9 +3437,13 @@ void collect2(Context* c)
     c->gen2Padding = 0;
   }
 
+  if (c->parallel) {
+    startParallelCollection(c);
+  }
+
   if (c->mode == Heap::MinorCollection and c->gen2.position()) {
-    unsigned start = 0;
-    unsigned end = start + c->gen2.position();
+    uintptr_t start = 0;
+    uintptr_t end = start + c->gen2.position();
     bool dirty;
     collect(c, &(c->heapMap), start, end, &dirty, false);
   }
@@ -1747,87 +3460,206 @@ void collect2(Context* c)
 
     virtual void visit(void* p)
     {
-      local::collect(c, static_cast<void**>(p));
-      visitMarkedFixies(c);
+      if (c->parallel) {
+        c->busy = true;
+
+        local::collect(c, static_cast<void**>(p));
+
+        if (c->postVisiting) {
+          drain(c);
+        }
+
+        c->busy = false;
+      } else if (c->compacting) {
+        local::collect(c, static_cast<void**>(p));
+        drainMarkStack(c);
+      } else {
+        local::collect(c, static_cast<void**>(p));
+        visitMarkedFixies(c);
+      }
     }
 
     Context* c;
   } v(c);
 
+  if (c->parallel) {
+    c->busy = false;
+  }
+
   c->client->visitRoots(&v);
+
+  if (c->parallel) {
+    finishParallelCollection(c);
+  }
 }
 
-bool limitExceeded(Context* c, int pendingAllocation)
+bool limitExceeded(Context* c, int64_t pendingAllocation)
 {
-  unsigned count = c->count + pendingAllocation
-                   - (c->gen2.remaining() * BytesPerWord);
+  int64_t count = static_cast<int64_t>(c->count) + pendingAllocation
+                  - static_cast<int64_t>(c->gen2.remaining() * BytesPerWord);
+  bool exceeded = count > static_cast<int64_t>(c->limit);
 
   if (Verbose) {
-    if (count > c->limit) {
+    if (exceeded) {
       if (not c->limitWasExceeded) {
         c->limitWasExceeded = true;
-        fprintf(stderr, "heap limit %d exceeded: %d\n", c->limit, count);
+        fprintf(stderr,
+                "heap limit %" ULD " exceeded: %" LLD "\n",
+                c->limit,
+                count);
       }
     } else if (c->limitWasExceeded) {
       c->limitWasExceeded = false;
-      fprintf(
-          stderr, "heap limit %d no longer exceeded: %d\n", c->limit, count);
+      fprintf(stderr,
+              "heap limit %" ULD " no longer exceeded: %" LLD "\n",
+              c->limit,
+              count);
     }
   }
 
-  return count > c->limit;
+  return exceeded;
+}
+
+// returns the reason we must do a major collection regardless of
+// what the client asked for, if any:
+Heap::CollectionCause majorCollectionCause(Context* c)
+{
+  if (limitExceeded(c, c->pendingAllocation)) {
+    return Heap::LowMemoryCause;
+  } else if (oversizedGen2(c)) {
+    return Heap::OversizedGen2Cause;
+  } else if (c->tenureFootprint + c->tenurePadding > c->gen2.remaining()) {
+    return Heap::UndersizedGen2Cause;
+  } else if (c->fixieTenureFootprint + c->tenuredFixieFootprint
+             > c->tenuredFixieCeiling) {
+    return Heap::FixieCeilingCause;
+  } else {
+    return Heap::RequestedCause;
+  }
+}
+
+const char* causeName(Heap::CollectionCause cause)
+{
+  switch (cause) {
+  case Heap::LowMemoryCause:
+    return "low memory";
+  case Heap::OversizedGen2Cause:
+    return "oversized gen2";
+  case Heap::UndersizedGen2Cause:
+    return "undersized gen2";
+  case Heap::FixieCeilingCause:
+    return "fixie ceiling";
+  default:
+    return "request";
+  }
+}
+
+void addRecord(Context* c, Heap::Record* r)
+{
+  ACQUIRE(c->lock);
+
+  ++c->collections[r->type];
+  c->collectionTime[r->type] += r->milliseconds;
+  if (r->milliseconds > c->maxCollectionTime[r->type]) {
+    c->maxCollectionTime[r->type] = r->milliseconds;
+  }
+
+  ++c->causes[r->cause];
+  c->promoted += r->promoted;
+
+  r->sequence = c->collections[Heap::MinorCollection]
+                + c->collections[Heap::MajorCollection];
+  r->footprintAfter = c->count;
+
+  c->records[(r->sequence - 1) % Heap::RecordCount] = *r;
 }
 
 void collect(Context* c)
 {
-  if (limitExceeded(c, c->pendingAllocation) or oversizedGen2(c)
-      or c->tenureFootprint + c->tenurePadding > c->gen2.remaining()
-      or c->fixieTenureFootprint + c->tenuredFixieFootprint
-         > c->tenuredFixieCeiling) {
+  pauseMarker(c);
+
+  Heap::CollectionCause cause = majorCollectionCause(c);
+  if (cause != Heap::RequestedCause) {
     if (Verbose) {
-      if (limitExceeded(c, c->pendingAllocation)) {
-        fprintf(stderr, "low memory causes ");
-      } else if (oversizedGen2(c)) {
-        fprintf(stderr, "oversized gen2 causes ");
-      } else if (c->tenureFootprint + c->tenurePadding > c->gen2.remaining()) {
-        fprintf(stderr, "undersized gen2 causes ");
-      } else {
-        fprintf(stderr, "fixie ceiling causes ");
-      }
+      fprintf(stderr, "%s causes ", causeName(cause));
     }
 
     c->mode = Heap::MajorCollection;
   }
 
-  int64_t then;
+  c->compacting = c->mode == Heap::MajorCollection and c->compactGen2;
+
+  int64_t then = c->system->now();
+
+  Heap::Record record;
+  record.type = c->mode;
+  record.cause = cause;
+  record.start = then;
+  record.incoming = c->incomingFootprint * BytesPerWord;
+  record.gen1Before = c->gen1.position() * BytesPerWord;
+  record.gen2Before = c->gen2.position() * BytesPerWord;
+  record.footprintBefore = c->count;
+
+  if (shouldStartMarking(c)) {
+    startMarking(c);
+  }
+
+  initNextGen1(c);
+
+  if (c->compacting) {
+    startCompaction(c);
+  } else if (c->mode == Heap::MajorCollection) {
+    initNextGen2(c, minimumNextGen2Capacity(c));
+  }
+
+  c->parallel = shouldCollectInParallel(c);
+
   if (Verbose) {
-    if (c->mode == Heap::MajorCollection) {
+    if (c->compacting) {
+      fprintf(stderr, "compacting major collection\n");
+    } else if (c->mode == Heap::MajorCollection) {
       fprintf(stderr, "major collection\n");
+    } else if (c->parallel) {
+      fprintf(stderr, "parallel minor collection\n");
     } else {
       fprintf(stderr, "minor collection\n");
     }
-
-    then = c->system->now();
   }
 
-  initNextGen1(c);
+  collect2(c);
 
-  if (c->mode == Heap::MajorCollection) {
-    initNextGen2(c);
+  if (c->compacting) {
+    finishCompaction(c);
   }
 
-  collect2(c);
-
   c->gen1.replaceWith(&(c->nextGen1));
-  if (c->mode == Heap::MajorCollection) {
+  if (c->mode == Heap::MajorCollection and not c->compacting) {
     c->gen2.replaceWith(&(c->nextGen2));
   }
 
+  c->compacting = false;
+
+  // the marker may follow objects between collections, when nothing
+  // in gen2 should look like a copy:
+  c->gen2Base = Top;
+
   sweepFixies(c);
 
+  resumeMarker(c);
+
+  int64_t now = c->system->now();
+  int64_t collection = now - then;
+
+  record.milliseconds = collection;
+  record.gen1After = c->gen1.position() * BytesPerWord;
+  record.gen2After = c->gen2.position() * BytesPerWord;
+  record.untenuredFixies = c->untenuredFixieFootprint;
+  record.tenuredFixies = c->tenuredFixieFootprint;
+  record.promoted = c->promotedFootprint * BytesPerWord;
+
+  addRecord(c, &record);
+
   if (Verbose) {
-    int64_t now = c->system->now();
-    int64_t collection = now - then;
     int64_t run = then - c->lastCollectionTime;
     c->totalCollectionTime += collection;
     c->totalTime += collection + run;
@@ -1844,21 +3676,21 @@ void collect(Context* c)
             static_cast<int>(c->totalTime - c->totalCollectionTime));
 
     fprintf(stderr,
-            " -             gen1: %8d/%8d bytes\n",
+            " -             gen1: %8" LD "/%8" LD " bytes\n",
             c->gen1.position() * BytesPerWord,
             c->gen1.capacity() * BytesPerWord);
 
     fprintf(stderr,
-            " -             gen2: %8d/%8d bytes\n",
+            " -             gen2: %8" LD "/%8" LD " bytes\n",
             c->gen2.position() * BytesPerWord,
             c->gen2.capacity() * BytesPerWord);
 
     fprintf(stderr,
-            " - untenured fixies:          %8d bytes\n",
+            " - untenured fixies:          %8" ULD " bytes\n",
             c->untenuredFixieFootprint);
 
     fprintf(stderr,
-            " -   tenured fixies:          %8d bytes\n",
+            " -   tenured fixies:          %8" ULD " bytes\n",
             c->tenuredFixieFootprint);
   }
 }
@@ -1868,13 +3700,16 @@ void* allocate(Context* c, size_t size, bool limit)
   ACQUIRE(c->lock);
 
   if (DebugAllocation) {
-    size = pad(size) + 2 * BytesPerWord;
+    size = padWord(size) + 2 * BytesPerWord;
   }
 
   if ((not limit) or size + c->count < c->limit) {
     void* p = c->system->tryAllocate(size);
     if (p) {
       c->count += size;
+      if (c->count > c->peakCount) {
+        c->peakCount = c->count;
+      }
 
       if (DebugAllocation) {
         static_cast<uintptr_t*>(p)[0] = 0x22377322;
@@ -1906,7 +3741,7 @@ void free(Context* c, const void* p, size_t size)
   ACQUIRE(c->lock);
 
   if (DebugAllocation) {
-    size = pad(size) + 2 * BytesPerWord;
+    size = padWord(size) + 2 * BytesPerWord;
 
     memset(const_cast<void*>(p), 0xFE, size - (2 * BytesPerWord));
 
@@ -1925,6 +3760,47 @@ void free(Context* c, const void* p, size_t size)
   c->count -= size;
 }
 
+// large objects get pages straight from the system so that, unlike
+// memory from the client's allocator, they are always returned to it
+// when freed.  The pages count against the heap limit like anything
+// else we allocate:
+uintptr_t pageRound(size_t size)
+{
+  return ceilingDivide(size, Memory::PageSize) * Memory::PageSize;
+}
+
+void* tryAllocatePages(Context* c, size_t size)
+{
+  size = pageRound(size);
+
+  ACQUIRE(c->lock);
+
+  if (size + c->count < c->limit) {
+    void* p = Memory::allocate(size).begin();
+    if (p) {
+      c->count += size;
+      if (c->count > c->peakCount) {
+        c->peakCount = c->count;
+      }
+      return p;
+    }
+  }
+  return 0;
+}
+
+void freePages(Context* c, const void* p, size_t size)
+{
+  size = pageRound(size);
+
+  ACQUIRE(c->lock);
+
+  expect(c->system, c->count >= size);
+
+  Memory::free(Slice<uint8_t>(
+      static_cast<uint8_t*>(const_cast<void*>(p)), size));
+  c->count -= size;
+}
+
 void free_(Context* c, const void* p, size_t size)
 {
   free(c, p, size);
@@ -1932,7 +3808,18 @@ void free_(Context* c, const void* p, size_t size)
 
 class MyHeap : public Heap {
  public:
-  MyHeap(System* system, unsigned limit) : c(system, limit)
+  MyHeap(System* system,
+         uint64_t limit,
+         unsigned collectorCount,
+         bool compactGen2,
+         bool concurrentGen2,
+         unsigned largeObjectThreshold)
+      : c(system,
+          limit,
+          collectorCount,
+          compactGen2,
+          concurrentGen2,
+          largeObjectThreshold)
   {
   }
 
@@ -1948,17 +3835,17 @@ class MyHeap : public Heap {
     c.immortalHeapEnd = start + sizeInWords;
   }
 
-  virtual unsigned remaining()
+  virtual uint64_t remaining()
   {
-    return c.limit - c.count;
+    return c.count < c.limit ? c.limit - c.count : 0;
   }
 
-  virtual unsigned limit()
+  virtual uint64_t limit()
   {
     return c.limit;
   }
 
-  virtual bool limitExceeded(int pendingAllocation = 0)
+  virtual bool limitExceeded(int64_t pendingAllocation = 0)
   {
     return local::limitExceeded(&c, pendingAllocation);
   }
@@ -1980,7 +3867,7 @@ class MyHeap : public Heap {
 
   virtual void collect(CollectionType type,
                        unsigned incomingFootprint,
-                       int pendingAllocation)
+                       int64_t pendingAllocation)
   {
     c.mode = type;
     c.incomingFootprint = incomingFootprint;
@@ -1989,7 +3876,7 @@ class MyHeap : public Heap {
     local::collect(&c);
   }
 
-  virtual unsigned fixedFootprint(unsigned sizeInWords, bool objectMask)
+  virtual uint64_t fixedFootprint(unsigned sizeInWords, bool objectMask)
   {
     return Fixie::totalSize(sizeInWords, objectMask);
   }
@@ -2002,7 +3889,7 @@ class MyHeap : public Heap {
   {
     expect(&c, not limitExceeded());
 
-    unsigned total = Fixie::totalSize(sizeInWords, objectMask);
+    uintptr_t total = Fixie::totalSize(sizeInWords, objectMask);
     void* p = allocator->allocate(total);
 
     expect(&c, not limitExceeded());
@@ -2026,6 +3913,24 @@ class MyHeap : public Heap {
     return allocateFixed(allocator, sizeInWords, objectMask, 0, true);
   }
 
+  virtual unsigned largeObjectThreshold()
+  {
+    return c.largeObjectThreshold;
+  }
+
+  virtual void* tryAllocateLarge(unsigned sizeInWords, bool objectMask)
+  {
+    uintptr_t total = Fixie::totalSize(sizeInWords, objectMask);
+    void* p = local::tryAllocatePages(&c, total);
+    if (p == 0) {
+      return 0;
+    }
+
+    Fixie* f = new (p) Fixie(&c, sizeInWords, objectMask, &(c.fixies), false);
+    f->large(true);
+    return f->body();
+  }
+
   bool needsMark(void* p)
   {
     assertT(&c, c.client->isFixed(p) or (not immortalHeapContains(&c, p)));
@@ -2048,6 +3953,23 @@ class MyHeap : public Heap {
 
   virtual void mark(void* p, unsigned offset, unsigned count)
   {
+    if (c.compacting) {
+      // the client is writing to objects during a compacting
+      // collection, so remember the slots in case they need to be
+      // forwarded.  Gen2 cards will be rebuilt from scratch
+      // afterward:
+      for (unsigned i = 0; i < count; ++i) {
+        recordSlot(&c, static_cast<void**>(p) + offset + i);
+      }
+    } else if (c.marking and c.gen2.contains(p)) {
+      // likewise while the marker runs, in case the client is moving
+      // a reference out of an object the marker hasn't scanned yet
+      // into one it has:
+      for (unsigned i = 0; i < count; ++i) {
+        recordSlotConcurrently(&c, static_cast<void**>(p) + offset + i);
+      }
+    }
+
     if (needsMark(p)) {
 #ifndef USE_ATOMIC_OPERATIONS
       ACQUIRE(c.lock);
@@ -2082,7 +4004,7 @@ class MyHeap : public Heap {
 
         if (dirty)
           markDirty(&c, f);
-      } else {
+      } else if (not c.compacting) {
         Segment::Map* map;
         if (c.gen2.contains(p)) {
           map = &(c.heapMap);
@@ -2115,14 +4037,33 @@ class MyHeap : public Heap {
       }
     } else if (c.gen2.contains(p)) {
       ++c.gen2Padding;
+
+      if (c.marking) {
+        // the marker may already have decided this object won't need
+        // to grow if it moves:
+        append(&c, &(c.padLog), p);
+      }
     } else {
       ++c.gen1Padding;
     }
   }
 
+  // during a parallel collection, the client expects to see the
+  // results of tracing everything it has visited so far whenever it
+  // asks about an object, as it would if we traced depth-first:
+  void drainIfParallel()
+  {
+    if (c.parallel and not c.busy) {
+      drain(&c);
+    }
+  }
+
   virtual void* follow(void* p)
   {
-    if (p == 0 or c.client->isFixed(p)) {
+    drainIfParallel();
+
+    if (p == 0 or c.client->isFixed(p)
+        or (c.compacting and c.gen2.contains(p))) {
       return p;
     } else if (wasCollected(&c, p)) {
       if (Debug) {
@@ -2142,11 +4083,16 @@ class MyHeap : public Heap {
 
   virtual void postVisit()
   {
+    drainIfParallel();
+    c.postVisiting = true;
+
     killFixies(&c);
   }
 
   virtual Status status(void* p)
   {
+    drainIfParallel();
+
     p = maskAlignedPointer(p);
 
     if (p == 0) {
@@ -2159,6 +4105,8 @@ class MyHeap : public Heap {
                                             : Tenured);
     } else if (c.nextGen1.contains(p)) {
       return Reachable;
+    } else if (c.compacting and c.gen2.contains(p)) {
+      return getBit(c.startMap, c.gen2.indexOf(p)) ? Tenured : Unreachable;
     } else if (c.nextGen2.contains(p) or immortalHeapContains(&c, p)
                or (c.gen2.contains(p)
                    and (c.mode == Heap::MinorCollection
@@ -2176,6 +4124,45 @@ class MyHeap : public Heap {
     return c.mode;
   }
 
+  virtual void statistics(Statistics* statistics)
+  {
+    ACQUIRE(c.lock);
+
+    for (unsigned i = 0; i < 2; ++i) {
+      statistics->collections[i] = c.collections[i];
+      statistics->totalMilliseconds[i] = c.collectionTime[i];
+      statistics->maxMilliseconds[i] = c.maxCollectionTime[i];
+    }
+
+    statistics->footprint = c.count;
+    statistics->peakFootprint = c.peakCount;
+
+    for (unsigned i = 0; i < CauseCount; ++i) {
+      statistics->causes[i] = c.causes[i];
+    }
+    statistics->promoted = c.promoted;
+  }
+
+  virtual unsigned records(uint64_t since, Record* records, unsigned count)
+  {
+    ACQUIRE(c.lock);
+
+    uint64_t last = c.collections[MinorCollection]
+                    + c.collections[MajorCollection];
+
+    // older records have been overwritten by now:
+    uint64_t first = since + 1;
+    if (last > RecordCount and first <= last - RecordCount) {
+      first = last - RecordCount + 1;
+    }
+
+    unsigned n = 0;
+    for (uint64_t i = first; i <= last and n < count; ++i) {
+      records[n++] = c.records[(i - 1) % RecordCount];
+    }
+    return n;
+  }
+
   virtual void disposeFixies()
   {
     c.disposeFixies();
@@ -2197,10 +4184,32 @@ class MyHeap : public Heap {
 
 namespace vm {
 
-Heap* makeHeap(System* system, unsigned limit)
+Heap* makeHeap(System* system,
+               uint64_t limit,
+               unsigned collectorCount,
+               bool compactGen2,
+               bool concurrentGen2,
+               unsigned largeObjectThreshold)
 {
+  if (not local::ConcurrentMarkingSupported) {
+    concurrentGen2 = false;
+  } else if (concurrentGen2) {
+    compactGen2 = true;
+  }
+
+  if ((not local::ParallelCollectionSupported) or collectorCount == 0) {
+    collectorCount = 1;
+  } else if (collectorCount > local::MaxCollectorCount) {
+    collectorCount = local::MaxCollectorCount;
+  }
+
   return new (system->tryAllocate(sizeof(local::MyHeap)))
-      local::MyHeap(system, limit);
+      local::MyHeap(system,
+                    limit,
+                    collectorCount,
+                    compactGen2,
+                    concurrentGen2,
+                    largeObjectThreshold);
 }
 
 }  // namespace vm
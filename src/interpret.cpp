@@ -763,6 +763,215 @@ void safePoint(Thread* t)
   }
 }
 
+void popStaticField(Thread* t, GcField* field)
+{
+  GcSingleton* table = field->class_()->staticTable();
+
+  switch (field->code()) {
+  case ByteField:
+  case BooleanField:
+  case CharField:
+  case ShortField:
+  case FloatField:
+  case IntField: {
+    int32_t value = popInt(t);
+    switch (field->code()) {
+    case ByteField:
+    case BooleanField:
+      fieldAtOffset<int8_t>(table, field->offset()) = value;
+      break;
+
+    case CharField:
+    case ShortField:
+      fieldAtOffset<int16_t>(table, field->offset()) = value;
+      break;
+
+    case FloatField:
+    case IntField:
+      fieldAtOffset<int32_t>(table, field->offset()) = value;
+      break;
+    }
+  } break;
+
+  case DoubleField:
+  case LongField: {
+    fieldAtOffset<int64_t>(table, field->offset()) = popLong(t);
+  } break;
+
+  case ObjectField: {
+    setField(t, table, field->offset(), popObject(t));
+  } break;
+
+  default:
+    abort(t);
+  }
+}
+
+// Internal instructions which replace the standard ones once their
+// constant pool entries have been resolved.  Each keeps the operands of
+// the instruction it replaces, so quickening is a single byte store and
+// a thread racing with it will execute one form or the other, both of
+// which are correct.  The quick forms read the resolved pool entry
+// directly, skipping resolution, class initialization checks, and (for
+// instance fields) the dispatch on field type.
+enum QuickInstruction {
+  getfield_int8_quick = 0xcb,
+  getfield_int16_quick = 0xcc,
+  getfield_int32_quick = 0xcd,
+  getfield_int64_quick = 0xce,
+  getfield_object_quick = 0xcf,
+  putfield_int8_quick = 0xd0,
+  putfield_int16_quick = 0xd1,
+  putfield_int32_quick = 0xd2,
+  putfield_int64_quick = 0xd3,
+  putfield_object_quick = 0xd4,
+  getstatic_quick = 0xd5,
+  putstatic_quick = 0xd6,
+  invokevirtual_quick = 0xd7,
+  ldc_quick = 0xd8,
+  ldc_w_quick = 0xd9,
+
+  // superinstructions, which replace the first instruction of a
+  // frequently executed sequence and execute the whole sequence.  The
+  // rest of the sequence is left intact, so branches into the middle of
+  // it still work:
+  aload_0_getfield_int32_quick = 0xda,
+  aload_0_getfield_object_quick = 0xdb,
+  iload_iload_iadd = 0xdc,
+  iinc_goto = 0xdd
+};
+
+void quicken(GcCode* code, unsigned ip, unsigned instruction)
+{
+  // make sure any thread which sees the quick form also sees the
+  // resolved pool entry it depends on:
+  storeStoreMemoryBarrier();
+
+  code->body()[ip] = instruction;
+}
+
+inline object quickEntry(Thread* t, GcCode* code, unsigned index)
+{
+  loadMemoryBarrier();
+
+  return singletonObject(t, code->pool(), index - 1);
+}
+
+inline GcField* quickField(Thread* t, GcCode* code, unsigned index)
+{
+  return cast<GcField>(t, quickEntry(t, code, index));
+}
+
+unsigned getFieldQuick(Thread* t, GcField* field)
+{
+  switch (field->code()) {
+  case ByteField:
+  case BooleanField:
+    return getfield_int8_quick;
+
+  case CharField:
+  case ShortField:
+    return getfield_int16_quick;
+
+  case FloatField:
+  case IntField:
+    return getfield_int32_quick;
+
+  case DoubleField:
+  case LongField:
+    return getfield_int64_quick;
+
+  case ObjectField:
+    return getfield_object_quick;
+
+  default:
+    abort(t);
+  }
+}
+
+unsigned putFieldQuick(Thread* t, GcField* field)
+{
+  switch (field->code()) {
+  case ByteField:
+  case BooleanField:
+    return putfield_int8_quick;
+
+  case CharField:
+  case ShortField:
+    return putfield_int16_quick;
+
+  case FloatField:
+  case IntField:
+    return putfield_int32_quick;
+
+  case DoubleField:
+  case LongField:
+    return putfield_int64_quick;
+
+  case ObjectField:
+    return putfield_object_quick;
+
+  default:
+    abort(t);
+  }
+}
+
+void traceInstruction(Thread* t, unsigned instruction)
+{
+  fprintf(stderr,
+          "ip: %d; instruction: 0x%x in %s.%s ",
+          t->ip - 1,
+          instruction,
+          frameMethod(t, t->frame)->class_()->name()->body().begin(),
+          frameMethod(t, t->frame)->name()->body().begin());
+
+  int line = findLineNumber(t, frameMethod(t, t->frame), t->ip);
+  switch (line) {
+  case NativeLine:
+    fprintf(stderr, "(native)\n");
+    break;
+  case UnknownLine:
+    fprintf(stderr, "(unknown line)\n");
+    break;
+  default:
+    fprintf(stderr, "(line %d)\n", line);
+  }
+}
+
+// With GCC and Clang we dispatch directly from the end of each
+// instruction's handler to the next one through a table of label
+// addresses, giving the branch predictor one indirect branch per
+// handler instead of a single shared one.  Other compilers (or builds
+// defining AVIAN_SWITCH_DISPATCH) use the plain switch.
+#if (defined __GNUC__) && !(defined AVIAN_SWITCH_DISPATCH)
+#define AVIAN_THREADED_DISPATCH
+#endif
+
+#ifdef AVIAN_THREADED_DISPATCH
+#define INSTRUCTION(x) \
+  case x:              \
+  op_##x
+
+#define VM_INSTRUCTION(x) \
+  case vm::x:             \
+  op_##x
+
+#define NEXT_INSTRUCTION                  \
+  do {                                    \
+    instruction = code->body()[ip++];     \
+    if (DebugRun) {                       \
+      traceInstruction(t, instruction);   \
+    }                                     \
+    goto* dispatchTable[instruction];     \
+  } while (0)
+#else
+#define INSTRUCTION(x) case x
+
+#define VM_INSTRUCTION(x) case vm::x
+
+#define NEXT_INSTRUCTION goto loop
+#endif
+
 object interpret3(Thread* t, const int base)
 {
   unsigned instruction = nop;
@@ -781,32 +990,266 @@ object interpret3(Thread* t, const int base)
     goto throw_;
   }
 
+#ifdef AVIAN_THREADED_DISPATCH
+  // The table is filled in on first use.  Threads racing to do so
+  // all store the same values, so no locking is needed, but no thread
+  // may use the table until it is complete: the barriers ensure that
+  // any thread which sees dispatchTableReady also sees every entry.
+  static void* dispatchTable[256];
+  static bool dispatchTableReady = false;
+
+  if (LIKELY(dispatchTableReady)) {
+    loadMemoryBarrier();
+  } else {
+    for (unsigned i = 0; i < 256; ++i) {
+      dispatchTable[i] = &&dispatch;
+    }
+
+    dispatchTable[aaload] = &&op_aaload;
+    dispatchTable[aastore] = &&op_aastore;
+    dispatchTable[aconst_null] = &&op_aconst_null;
+    dispatchTable[aload] = &&op_aload;
+    dispatchTable[aload_0] = &&op_aload_0;
+    dispatchTable[aload_1] = &&op_aload_1;
+    dispatchTable[aload_2] = &&op_aload_2;
+    dispatchTable[aload_3] = &&op_aload_3;
+    dispatchTable[anewarray] = &&op_anewarray;
+    dispatchTable[areturn] = &&op_areturn;
+    dispatchTable[arraylength] = &&op_arraylength;
+    dispatchTable[astore] = &&op_astore;
+    dispatchTable[astore_0] = &&op_astore_0;
+    dispatchTable[astore_1] = &&op_astore_1;
+    dispatchTable[astore_2] = &&op_astore_2;
+    dispatchTable[astore_3] = &&op_astore_3;
+    dispatchTable[athrow] = &&op_athrow;
+    dispatchTable[baload] = &&op_baload;
+    dispatchTable[bastore] = &&op_bastore;
+    dispatchTable[bipush] = &&op_bipush;
+    dispatchTable[caload] = &&op_caload;
+    dispatchTable[castore] = &&op_castore;
+    dispatchTable[checkcast] = &&op_checkcast;
+    dispatchTable[d2f] = &&op_d2f;
+    dispatchTable[d2i] = &&op_d2i;
+    dispatchTable[d2l] = &&op_d2l;
+    dispatchTable[dadd] = &&op_dadd;
+    dispatchTable[daload] = &&op_daload;
+    dispatchTable[dastore] = &&op_dastore;
+    dispatchTable[dcmpg] = &&op_dcmpg;
+    dispatchTable[dcmpl] = &&op_dcmpl;
+    dispatchTable[dconst_0] = &&op_dconst_0;
+    dispatchTable[dconst_1] = &&op_dconst_1;
+    dispatchTable[ddiv] = &&op_ddiv;
+    dispatchTable[dmul] = &&op_dmul;
+    dispatchTable[dneg] = &&op_dneg;
+    dispatchTable[vm::drem] = &&op_drem;
+    dispatchTable[dsub] = &&op_dsub;
+    dispatchTable[vm::dup] = &&op_dup;
+    dispatchTable[dup_x1] = &&op_dup_x1;
+    dispatchTable[dup_x2] = &&op_dup_x2;
+    dispatchTable[vm::dup2] = &&op_dup2;
+    dispatchTable[dup2_x1] = &&op_dup2_x1;
+    dispatchTable[dup2_x2] = &&op_dup2_x2;
+    dispatchTable[f2d] = &&op_f2d;
+    dispatchTable[f2i] = &&op_f2i;
+    dispatchTable[f2l] = &&op_f2l;
+    dispatchTable[fadd] = &&op_fadd;
+    dispatchTable[faload] = &&op_faload;
+    dispatchTable[fastore] = &&op_fastore;
+    dispatchTable[fcmpg] = &&op_fcmpg;
+    dispatchTable[fcmpl] = &&op_fcmpl;
+    dispatchTable[fconst_0] = &&op_fconst_0;
+    dispatchTable[fconst_1] = &&op_fconst_1;
+    dispatchTable[fconst_2] = &&op_fconst_2;
+    dispatchTable[fdiv] = &&op_fdiv;
+    dispatchTable[fmul] = &&op_fmul;
+    dispatchTable[fneg] = &&op_fneg;
+    dispatchTable[frem] = &&op_frem;
+    dispatchTable[fsub] = &&op_fsub;
+    dispatchTable[getfield] = &&op_getfield;
+    dispatchTable[getstatic] = &&op_getstatic;
+    dispatchTable[goto_] = &&op_goto_;
+    dispatchTable[goto_w] = &&op_goto_w;
+    dispatchTable[i2b] = &&op_i2b;
+    dispatchTable[i2c] = &&op_i2c;
+    dispatchTable[i2d] = &&op_i2d;
+    dispatchTable[i2f] = &&op_i2f;
+    dispatchTable[i2l] = &&op_i2l;
+    dispatchTable[i2s] = &&op_i2s;
+    dispatchTable[iadd] = &&op_iadd;
+    dispatchTable[iaload] = &&op_iaload;
+    dispatchTable[iand] = &&op_iand;
+    dispatchTable[iastore] = &&op_iastore;
+    dispatchTable[iconst_m1] = &&op_iconst_m1;
+    dispatchTable[iconst_0] = &&op_iconst_0;
+    dispatchTable[iconst_1] = &&op_iconst_1;
+    dispatchTable[iconst_2] = &&op_iconst_2;
+    dispatchTable[iconst_3] = &&op_iconst_3;
+    dispatchTable[iconst_4] = &&op_iconst_4;
+    dispatchTable[iconst_5] = &&op_iconst_5;
+    dispatchTable[idiv] = &&op_idiv;
+    dispatchTable[if_acmpeq] = &&op_if_acmpeq;
+    dispatchTable[if_acmpne] = &&op_if_acmpne;
+    dispatchTable[if_icmpeq] = &&op_if_icmpeq;
+    dispatchTable[if_icmpne] = &&op_if_icmpne;
+    dispatchTable[if_icmpgt] = &&op_if_icmpgt;
+    dispatchTable[if_icmpge] = &&op_if_icmpge;
+    dispatchTable[if_icmplt] = &&op_if_icmplt;
+    dispatchTable[if_icmple] = &&op_if_icmple;
+    dispatchTable[ifeq] = &&op_ifeq;
+    dispatchTable[ifne] = &&op_ifne;
+    dispatchTable[ifgt] = &&op_ifgt;
+    dispatchTable[ifge] = &&op_ifge;
+    dispatchTable[iflt] = &&op_iflt;
+    dispatchTable[ifle] = &&op_ifle;
+    dispatchTable[ifnonnull] = &&op_ifnonnull;
+    dispatchTable[ifnull] = &&op_ifnull;
+    dispatchTable[iinc] = &&op_iinc;
+    dispatchTable[iload] = &&op_iload;
+    dispatchTable[fload] = &&op_fload;
+    dispatchTable[iload_0] = &&op_iload_0;
+    dispatchTable[fload_0] = &&op_fload_0;
+    dispatchTable[iload_1] = &&op_iload_1;
+    dispatchTable[fload_1] = &&op_fload_1;
+    dispatchTable[iload_2] = &&op_iload_2;
+    dispatchTable[fload_2] = &&op_fload_2;
+    dispatchTable[iload_3] = &&op_iload_3;
+    dispatchTable[fload_3] = &&op_fload_3;
+    dispatchTable[imul] = &&op_imul;
+    dispatchTable[ineg] = &&op_ineg;
+    dispatchTable[instanceof] = &&op_instanceof;
+    dispatchTable[invokedynamic] = &&op_invokedynamic;
+    dispatchTable[invokeinterface] = &&op_invokeinterface;
+    dispatchTable[invokespecial] = &&op_invokespecial;
+    dispatchTable[invokestatic] = &&op_invokestatic;
+    dispatchTable[invokevirtual] = &&op_invokevirtual;
+    dispatchTable[ior] = &&op_ior;
+    dispatchTable[irem] = &&op_irem;
+    dispatchTable[ireturn] = &&op_ireturn;
+    dispatchTable[freturn] = &&op_freturn;
+    dispatchTable[ishl] = &&op_ishl;
+    dispatchTable[ishr] = &&op_ishr;
+    dispatchTable[istore] = &&op_istore;
+    dispatchTable[fstore] = &&op_fstore;
+    dispatchTable[istore_0] = &&op_istore_0;
+    dispatchTable[fstore_0] = &&op_fstore_0;
+    dispatchTable[istore_1] = &&op_istore_1;
+    dispatchTable[fstore_1] = &&op_fstore_1;
+    dispatchTable[istore_2] = &&op_istore_2;
+    dispatchTable[fstore_2] = &&op_fstore_2;
+    dispatchTable[istore_3] = &&op_istore_3;
+    dispatchTable[fstore_3] = &&op_fstore_3;
+    dispatchTable[isub] = &&op_isub;
+    dispatchTable[iushr] = &&op_iushr;
+    dispatchTable[ixor] = &&op_ixor;
+    dispatchTable[jsr] = &&op_jsr;
+    dispatchTable[jsr_w] = &&op_jsr_w;
+    dispatchTable[l2d] = &&op_l2d;
+    dispatchTable[l2f] = &&op_l2f;
+    dispatchTable[l2i] = &&op_l2i;
+    dispatchTable[ladd] = &&op_ladd;
+    dispatchTable[laload] = &&op_laload;
+    dispatchTable[land] = &&op_land;
+    dispatchTable[lastore] = &&op_lastore;
+    dispatchTable[lcmp] = &&op_lcmp;
+    dispatchTable[lconst_0] = &&op_lconst_0;
+    dispatchTable[lconst_1] = &&op_lconst_1;
+    dispatchTable[ldc] = &&op_ldc;
+    dispatchTable[ldc_w] = &&op_ldc_w;
+    dispatchTable[ldc2_w] = &&op_ldc2_w;
+    dispatchTable[ldiv_] = &&op_ldiv_;
+    dispatchTable[lload] = &&op_lload;
+    dispatchTable[dload] = &&op_dload;
+    dispatchTable[lload_0] = &&op_lload_0;
+    dispatchTable[dload_0] = &&op_dload_0;
+    dispatchTable[lload_1] = &&op_lload_1;
+    dispatchTable[dload_1] = &&op_dload_1;
+    dispatchTable[lload_2] = &&op_lload_2;
+    dispatchTable[dload_2] = &&op_dload_2;
+    dispatchTable[lload_3] = &&op_lload_3;
+    dispatchTable[dload_3] = &&op_dload_3;
+    dispatchTable[lmul] = &&op_lmul;
+    dispatchTable[lneg] = &&op_lneg;
+    dispatchTable[lookupswitch] = &&op_lookupswitch;
+    dispatchTable[lor] = &&op_lor;
+    dispatchTable[lrem] = &&op_lrem;
+    dispatchTable[lreturn] = &&op_lreturn;
+    dispatchTable[dreturn] = &&op_dreturn;
+    dispatchTable[lshl] = &&op_lshl;
+    dispatchTable[lshr] = &&op_lshr;
+    dispatchTable[lstore] = &&op_lstore;
+    dispatchTable[dstore] = &&op_dstore;
+    dispatchTable[lstore_0] = &&op_lstore_0;
+    dispatchTable[dstore_0] = &&op_dstore_0;
+    dispatchTable[lstore_1] = &&op_lstore_1;
+    dispatchTable[dstore_1] = &&op_dstore_1;
+    dispatchTable[lstore_2] = &&op_lstore_2;
+    dispatchTable[dstore_2] = &&op_dstore_2;
+    dispatchTable[lstore_3] = &&op_lstore_3;
+    dispatchTable[dstore_3] = &&op_dstore_3;
+    dispatchTable[lsub] = &&op_lsub;
+    dispatchTable[lushr] = &&op_lushr;
+    dispatchTable[lxor] = &&op_lxor;
+    dispatchTable[monitorenter] = &&op_monitorenter;
+    dispatchTable[monitorexit] = &&op_monitorexit;
+    dispatchTable[multianewarray] = &&op_multianewarray;
+    dispatchTable[new_] = &&op_new_;
+    dispatchTable[newarray] = &&op_newarray;
+    dispatchTable[pop_] = &&op_pop_;
+    dispatchTable[pop2] = &&op_pop2;
+    dispatchTable[putfield] = &&op_putfield;
+    dispatchTable[putstatic] = &&op_putstatic;
+    dispatchTable[ret] = &&op_ret;
+    dispatchTable[return_] = &&op_return_;
+    dispatchTable[saload] = &&op_saload;
+    dispatchTable[sastore] = &&op_sastore;
+    dispatchTable[sipush] = &&op_sipush;
+    dispatchTable[swap] = &&op_swap;
+    dispatchTable[tableswitch] = &&op_tableswitch;
+    dispatchTable[wide] = &&op_wide;
+    dispatchTable[impdep1] = &&op_impdep1;
+    dispatchTable[getfield_int8_quick] = &&op_getfield_int8_quick;
+    dispatchTable[getfield_int16_quick] = &&op_getfield_int16_quick;
+    dispatchTable[getfield_int32_quick] = &&op_getfield_int32_quick;
+    dispatchTable[getfield_int64_quick] = &&op_getfield_int64_quick;
+    dispatchTable[getfield_object_quick] = &&op_getfield_object_quick;
+    dispatchTable[putfield_int8_quick] = &&op_putfield_int8_quick;
+    dispatchTable[putfield_int16_quick] = &&op_putfield_int16_quick;
+    dispatchTable[putfield_int32_quick] = &&op_putfield_int32_quick;
+    dispatchTable[putfield_int64_quick] = &&op_putfield_int64_quick;
+    dispatchTable[putfield_object_quick] = &&op_putfield_object_quick;
+    dispatchTable[getstatic_quick] = &&op_getstatic_quick;
+    dispatchTable[putstatic_quick] = &&op_putstatic_quick;
+    dispatchTable[invokevirtual_quick] = &&op_invokevirtual_quick;
+    dispatchTable[ldc_quick] = &&op_ldc_quick;
+    dispatchTable[ldc_w_quick] = &&op_ldc_w_quick;
+    dispatchTable[aload_0_getfield_int32_quick]
+        = &&op_aload_0_getfield_int32_quick;
+    dispatchTable[aload_0_getfield_object_quick]
+        = &&op_aload_0_getfield_object_quick;
+    dispatchTable[iload_iload_iadd] = &&op_iload_iload_iadd;
+    dispatchTable[iinc_goto] = &&op_iinc_goto;
+
+    dispatchTable[nop] = &&op_nop;
+
+    storeStoreMemoryBarrier();
+    dispatchTableReady = true;
+  }
+#endif
+
 loop:
   instruction = code->body()[ip++];
 
   if (DebugRun) {
-    fprintf(stderr,
-            "ip: %d; instruction: 0x%x in %s.%s ",
-            ip - 1,
-            instruction,
-            frameMethod(t, frame)->class_()->name()->body().begin(),
-            frameMethod(t, frame)->name()->body().begin());
-
-    int line = findLineNumber(t, frameMethod(t, frame), ip);
-    switch (line) {
-    case NativeLine:
-      fprintf(stderr, "(native)\n");
-      break;
-    case UnknownLine:
-      fprintf(stderr, "(unknown line)\n");
-      break;
-    default:
-      fprintf(stderr, "(line %d)\n", line);
-    }
+    traceInstruction(t, instruction);
   }
 
+#ifdef AVIAN_THREADED_DISPATCH
+  goto* dispatchTable[instruction];
+
+dispatch:
+#endif
   switch (instruction) {
-  case aaload: {
+  INSTRUCTION(aaload): {
     int32_t index = popInt(t);
     object array = popObject(t);
 
@@ -828,9 +1271,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case aastore: {
+  INSTRUCTION(aastore): {
     object value = popObject(t);
     int32_t index = popInt(t);
     object array = popObject(t);
@@ -853,39 +1296,52 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case aconst_null: {
+  INSTRUCTION(aconst_null): {
     pushObject(t, 0);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case aload: {
+  INSTRUCTION(aload): {
     pushObject(t, localObject(t, code->body()[ip++]));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case aload_0: {
+  INSTRUCTION(aload_0): {
     pushObject(t, localObject(t, 0));
+
+    switch (code->body()[ip]) {
+    case getfield_int32_quick:
+      quicken(code, ip - 1, aload_0_getfield_int32_quick);
+      break;
+
+    case getfield_object_quick:
+      quicken(code, ip - 1, aload_0_getfield_object_quick);
+      break;
+
+    default:
+      break;
+    }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case aload_1: {
+  INSTRUCTION(aload_1): {
     pushObject(t, localObject(t, 1));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case aload_2: {
+  INSTRUCTION(aload_2): {
     pushObject(t, localObject(t, 2));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case aload_3: {
+  INSTRUCTION(aload_3): {
     pushObject(t, localObject(t, 3));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case anewarray: {
+  INSTRUCTION(anewarray): {
     int32_t count = popInt(t);
 
     if (LIKELY(count >= 0)) {
@@ -900,21 +1356,21 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case areturn: {
+  INSTRUCTION(areturn): {
     object result = popObject(t);
     if (frame > base) {
       popFrame(t);
       pushObject(t, result);
-      goto loop;
+      NEXT_INSTRUCTION;
     } else {
       return result;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case arraylength: {
+  INSTRUCTION(arraylength): {
     object array = popObject(t);
     if (LIKELY(array)) {
       pushInt(t, fieldAtOffset<uintptr_t>(array, BytesPerWord));
@@ -923,34 +1379,34 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case astore: {
+  INSTRUCTION(astore): {
     store(t, code->body()[ip++]);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case astore_0: {
+  INSTRUCTION(astore_0): {
     store(t, 0);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case astore_1: {
+  INSTRUCTION(astore_1): {
     store(t, 1);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case astore_2: {
+  INSTRUCTION(astore_2): {
     store(t, 2);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case astore_3: {
+  INSTRUCTION(astore_3): {
     store(t, 3);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case athrow: {
+  INSTRUCTION(athrow): {
     exception = cast<GcThrowable>(t, popObject(t));
     if (UNLIKELY(exception == 0)) {
       exception = makeThrowable(t, GcNullPointerException::Type);
@@ -958,7 +1414,7 @@ loop:
   }
     goto throw_;
 
-  case baload: {
+  INSTRUCTION(baload): {
     int32_t index = popInt(t);
     object array = popObject(t);
 
@@ -995,9 +1451,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case bastore: {
+  INSTRUCTION(bastore): {
     int8_t value = popInt(t);
     int32_t index = popInt(t);
     object array = popObject(t);
@@ -1035,14 +1491,14 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case bipush: {
+  INSTRUCTION(bipush): {
     pushInt(t, static_cast<int8_t>(code->body()[ip++]));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case caload: {
+  INSTRUCTION(caload): {
     int32_t index = popInt(t);
     object array = popObject(t);
 
@@ -1063,9 +1519,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case castore: {
+  INSTRUCTION(castore): {
     uint16_t value = popInt(t);
     int32_t index = popInt(t);
     object array = popObject(t);
@@ -1087,9 +1543,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case checkcast: {
+  INSTRUCTION(checkcast): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     if (peekObject(t, sp - 1)) {
@@ -1108,14 +1564,14 @@ loop:
       }
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case d2f: {
+  INSTRUCTION(d2f): {
     pushFloat(t, static_cast<float>(popDouble(t)));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case d2i: {
+  INSTRUCTION(d2i): {
     double f = popDouble(t);
     switch (fpclassify(f)) {
     case FP_NAN:
@@ -1132,9 +1588,9 @@ loop:
       break;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case d2l: {
+  INSTRUCTION(d2l): {
     double f = popDouble(t);
     switch (fpclassify(f)) {
     case FP_NAN:
@@ -1151,17 +1607,17 @@ loop:
       break;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dadd: {
+  INSTRUCTION(dadd): {
     double b = popDouble(t);
     double a = popDouble(t);
 
     pushDouble(t, a + b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case daload: {
+  INSTRUCTION(daload): {
     int32_t index = popInt(t);
     object array = popObject(t);
 
@@ -1182,9 +1638,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dastore: {
+  INSTRUCTION(dastore): {
     double value = popDouble(t);
     int32_t index = popInt(t);
     object array = popObject(t);
@@ -1206,9 +1662,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dcmpg: {
+  INSTRUCTION(dcmpg): {
     double b = popDouble(t);
     double a = popDouble(t);
 
@@ -1225,9 +1681,9 @@ loop:
       pushInt(t, 1);
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dcmpl: {
+  INSTRUCTION(dcmpl): {
     double b = popDouble(t);
     double a = popDouble(t);
 
@@ -1244,58 +1700,58 @@ loop:
       pushInt(t, static_cast<unsigned>(-1));
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dconst_0: {
+  INSTRUCTION(dconst_0): {
     pushDouble(t, 0);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dconst_1: {
+  INSTRUCTION(dconst_1): {
     pushDouble(t, 1);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ddiv: {
+  INSTRUCTION(ddiv): {
     double b = popDouble(t);
     double a = popDouble(t);
 
     pushDouble(t, a / b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dmul: {
+  INSTRUCTION(dmul): {
     double b = popDouble(t);
     double a = popDouble(t);
 
     pushDouble(t, a * b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dneg: {
+  INSTRUCTION(dneg): {
     double a = popDouble(t);
 
     pushDouble(t, -a);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case vm::drem: {
+  VM_INSTRUCTION(drem): {
     double b = popDouble(t);
     double a = popDouble(t);
 
     pushDouble(t, fmod(a, b));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dsub: {
+  INSTRUCTION(dsub): {
     double b = popDouble(t);
     double a = popDouble(t);
 
     pushDouble(t, a - b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case vm::dup: {
+  VM_INSTRUCTION(dup): {
     if (DebugStack) {
       fprintf(stderr, "dup\n");
     }
@@ -1303,9 +1759,9 @@ loop:
     memcpy(stack + ((sp)*2), stack + ((sp - 1) * 2), BytesPerWord * 2);
     ++sp;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dup_x1: {
+  INSTRUCTION(dup_x1): {
     if (DebugStack) {
       fprintf(stderr, "dup_x1\n");
     }
@@ -1315,9 +1771,9 @@ loop:
     memcpy(stack + ((sp - 2) * 2), stack + ((sp)*2), BytesPerWord * 2);
     ++sp;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dup_x2: {
+  INSTRUCTION(dup_x2): {
     if (DebugStack) {
       fprintf(stderr, "dup_x2\n");
     }
@@ -1328,9 +1784,9 @@ loop:
     memcpy(stack + ((sp - 3) * 2), stack + ((sp)*2), BytesPerWord * 2);
     ++sp;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case vm::dup2: {
+  VM_INSTRUCTION(dup2): {
     if (DebugStack) {
       fprintf(stderr, "dup2\n");
     }
@@ -1338,9 +1794,9 @@ loop:
     memcpy(stack + ((sp)*2), stack + ((sp - 2) * 2), BytesPerWord * 4);
     sp += 2;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dup2_x1: {
+  INSTRUCTION(dup2_x1): {
     if (DebugStack) {
       fprintf(stderr, "dup2_x1\n");
     }
@@ -1351,9 +1807,9 @@ loop:
     memcpy(stack + ((sp - 3) * 2), stack + ((sp)*2), BytesPerWord * 4);
     sp += 2;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case dup2_x2: {
+  INSTRUCTION(dup2_x2): {
     if (DebugStack) {
       fprintf(stderr, "dup2_x2\n");
     }
@@ -1365,14 +1821,14 @@ loop:
     memcpy(stack + ((sp - 4) * 2), stack + ((sp)*2), BytesPerWord * 4);
     sp += 2;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case f2d: {
+  INSTRUCTION(f2d): {
     pushDouble(t, popFloat(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case f2i: {
+  INSTRUCTION(f2i): {
     float f = popFloat(t);
     switch (fpclassify(f)) {
     case FP_NAN:
@@ -1389,9 +1845,9 @@ loop:
       break;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case f2l: {
+  INSTRUCTION(f2l): {
     float f = popFloat(t);
     switch (fpclassify(f)) {
     case FP_NAN:
@@ -1405,17 +1861,17 @@ loop:
       break;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fadd: {
+  INSTRUCTION(fadd): {
     float b = popFloat(t);
     float a = popFloat(t);
 
     pushFloat(t, a + b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case faload: {
+  INSTRUCTION(faload): {
     int32_t index = popInt(t);
     object array = popObject(t);
 
@@ -1436,9 +1892,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fastore: {
+  INSTRUCTION(fastore): {
     float value = popFloat(t);
     int32_t index = popInt(t);
     object array = popObject(t);
@@ -1460,9 +1916,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fcmpg: {
+  INSTRUCTION(fcmpg): {
     float b = popFloat(t);
     float a = popFloat(t);
 
@@ -1479,9 +1935,9 @@ loop:
       pushInt(t, 1);
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fcmpl: {
+  INSTRUCTION(fcmpl): {
     float b = popFloat(t);
     float a = popFloat(t);
 
@@ -1498,63 +1954,63 @@ loop:
       pushInt(t, static_cast<unsigned>(-1));
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fconst_0: {
+  INSTRUCTION(fconst_0): {
     pushFloat(t, 0);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fconst_1: {
+  INSTRUCTION(fconst_1): {
     pushFloat(t, 1);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fconst_2: {
+  INSTRUCTION(fconst_2): {
     pushFloat(t, 2);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fdiv: {
+  INSTRUCTION(fdiv): {
     float b = popFloat(t);
     float a = popFloat(t);
 
     pushFloat(t, a / b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fmul: {
+  INSTRUCTION(fmul): {
     float b = popFloat(t);
     float a = popFloat(t);
 
     pushFloat(t, a * b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fneg: {
+  INSTRUCTION(fneg): {
     float a = popFloat(t);
 
     pushFloat(t, -a);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case frem: {
+  INSTRUCTION(frem): {
     float b = popFloat(t);
     float a = popFloat(t);
 
     pushFloat(t, fmodf(a, b));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case fsub: {
+  INSTRUCTION(fsub): {
     float b = popFloat(t);
     float a = popFloat(t);
 
     pushFloat(t, a - b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case getfield: {
+  INSTRUCTION(getfield): {
     if (LIKELY(peekObject(t, sp - 1))) {
       uint16_t index = codeReadInt16(t, code, ip);
 
@@ -1567,14 +2023,18 @@ loop:
       ACQUIRE_FIELD_FOR_READ(t, field);
 
       pushField(t, popObject(t), field);
+
+      if ((field->flags() & ACC_VOLATILE) == 0) {
+        quicken(code, ip - 3, getFieldQuick(t, field));
+      }
     } else {
       exception = makeThrowable(t, GcNullPointerException::Type);
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case getstatic: {
+  INSTRUCTION(getstatic): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     GcField* field = resolveField(t, frameMethod(t, frame), index - 1);
@@ -1588,60 +2048,65 @@ loop:
     ACQUIRE_FIELD_FOR_READ(t, field);
 
     pushField(t, field->class_()->staticTable(), field);
+
+    if ((field->flags() & ACC_VOLATILE) == 0
+        and (field->class_()->vmFlags() & NeedInitFlag) == 0) {
+      quicken(code, ip - 3, getstatic_quick);
+    }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case goto_: {
+  INSTRUCTION(goto_): {
     int16_t offset = codeReadInt16(t, code, ip);
     ip = (ip - 3) + offset;
   }
     goto back_branch;
 
-  case goto_w: {
+  INSTRUCTION(goto_w): {
     int32_t offset = codeReadInt32(t, code, ip);
     ip = (ip - 5) + offset;
   }
     goto back_branch;
 
-  case i2b: {
+  INSTRUCTION(i2b): {
     pushInt(t, static_cast<int8_t>(popInt(t)));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case i2c: {
+  INSTRUCTION(i2c): {
     pushInt(t, static_cast<uint16_t>(popInt(t)));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case i2d: {
+  INSTRUCTION(i2d): {
     pushDouble(t, static_cast<double>(static_cast<int32_t>(popInt(t))));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case i2f: {
+  INSTRUCTION(i2f): {
     pushFloat(t, static_cast<float>(static_cast<int32_t>(popInt(t))));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case i2l: {
+  INSTRUCTION(i2l): {
     pushLong(t, static_cast<int32_t>(popInt(t)));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case i2s: {
+  INSTRUCTION(i2s): {
     pushInt(t, static_cast<int16_t>(popInt(t)));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iadd: {
+  INSTRUCTION(iadd): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
     pushInt(t, a + b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iaload: {
+  INSTRUCTION(iaload): {
     int32_t index = popInt(t);
     object array = popObject(t);
 
@@ -1662,17 +2127,17 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iand: {
+  INSTRUCTION(iand): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
     pushInt(t, a & b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iastore: {
+  INSTRUCTION(iastore): {
     int32_t value = popInt(t);
     int32_t index = popInt(t);
     object array = popObject(t);
@@ -1694,44 +2159,44 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iconst_m1: {
+  INSTRUCTION(iconst_m1): {
     pushInt(t, static_cast<unsigned>(-1));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iconst_0: {
+  INSTRUCTION(iconst_0): {
     pushInt(t, 0);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iconst_1: {
+  INSTRUCTION(iconst_1): {
     pushInt(t, 1);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iconst_2: {
+  INSTRUCTION(iconst_2): {
     pushInt(t, 2);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iconst_3: {
+  INSTRUCTION(iconst_3): {
     pushInt(t, 3);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iconst_4: {
+  INSTRUCTION(iconst_4): {
     pushInt(t, 4);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iconst_5: {
+  INSTRUCTION(iconst_5): {
     pushInt(t, 5);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case idiv: {
+  INSTRUCTION(idiv): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
@@ -1742,9 +2207,9 @@ loop:
 
     pushInt(t, a / b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case if_acmpeq: {
+  INSTRUCTION(if_acmpeq): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     object b = popObject(t);
@@ -1756,7 +2221,7 @@ loop:
   }
     goto back_branch;
 
-  case if_acmpne: {
+  INSTRUCTION(if_acmpne): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     object b = popObject(t);
@@ -1768,7 +2233,7 @@ loop:
   }
     goto back_branch;
 
-  case if_icmpeq: {
+  INSTRUCTION(if_icmpeq): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     int32_t b = popInt(t);
@@ -1780,7 +2245,7 @@ loop:
   }
     goto back_branch;
 
-  case if_icmpne: {
+  INSTRUCTION(if_icmpne): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     int32_t b = popInt(t);
@@ -1792,7 +2257,7 @@ loop:
   }
     goto back_branch;
 
-  case if_icmpgt: {
+  INSTRUCTION(if_icmpgt): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     int32_t b = popInt(t);
@@ -1804,7 +2269,7 @@ loop:
   }
     goto back_branch;
 
-  case if_icmpge: {
+  INSTRUCTION(if_icmpge): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     int32_t b = popInt(t);
@@ -1816,7 +2281,7 @@ loop:
   }
     goto back_branch;
 
-  case if_icmplt: {
+  INSTRUCTION(if_icmplt): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     int32_t b = popInt(t);
@@ -1828,7 +2293,7 @@ loop:
   }
     goto back_branch;
 
-  case if_icmple: {
+  INSTRUCTION(if_icmple): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     int32_t b = popInt(t);
@@ -1840,7 +2305,7 @@ loop:
   }
     goto back_branch;
 
-  case ifeq: {
+  INSTRUCTION(ifeq): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     if (popInt(t) == 0) {
@@ -1849,7 +2314,7 @@ loop:
   }
     goto back_branch;
 
-  case ifne: {
+  INSTRUCTION(ifne): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     if (popInt(t)) {
@@ -1858,7 +2323,7 @@ loop:
   }
     goto back_branch;
 
-  case ifgt: {
+  INSTRUCTION(ifgt): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     if (static_cast<int32_t>(popInt(t)) > 0) {
@@ -1867,7 +2332,7 @@ loop:
   }
     goto back_branch;
 
-  case ifge: {
+  INSTRUCTION(ifge): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     if (static_cast<int32_t>(popInt(t)) >= 0) {
@@ -1876,7 +2341,7 @@ loop:
   }
     goto back_branch;
 
-  case iflt: {
+  INSTRUCTION(iflt): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     if (static_cast<int32_t>(popInt(t)) < 0) {
@@ -1885,7 +2350,7 @@ loop:
   }
     goto back_branch;
 
-  case ifle: {
+  INSTRUCTION(ifle): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     if (static_cast<int32_t>(popInt(t)) <= 0) {
@@ -1894,7 +2359,7 @@ loop:
   }
     goto back_branch;
 
-  case ifnonnull: {
+  INSTRUCTION(ifnonnull): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     if (popObject(t)) {
@@ -1903,7 +2368,7 @@ loop:
   }
     goto back_branch;
 
-  case ifnull: {
+  INSTRUCTION(ifnull): {
     int16_t offset = codeReadInt16(t, code, ip);
 
     if (popObject(t) == 0) {
@@ -1912,58 +2377,70 @@ loop:
   }
     goto back_branch;
 
-  case iinc: {
+  INSTRUCTION(iinc): {
     uint8_t index = code->body()[ip++];
     int8_t c = code->body()[ip++];
 
     setLocalInt(t, index, localInt(t, index) + c);
+
+    if (code->body()[ip] == goto_) {
+      quicken(code, ip - 3, iinc_goto);
+    }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iload:
-  case fload: {
+  INSTRUCTION(iload): {
     pushInt(t, localInt(t, code->body()[ip++]));
+
+    if (code->body()[ip] == iload and code->body()[ip + 2] == iadd) {
+      quicken(code, ip - 2, iload_iload_iadd);
+    }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(fload): {
+    pushInt(t, localInt(t, code->body()[ip++]));
+  }
+    NEXT_INSTRUCTION;
 
-  case iload_0:
-  case fload_0: {
+  INSTRUCTION(iload_0):
+  INSTRUCTION(fload_0): {
     pushInt(t, localInt(t, 0));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iload_1:
-  case fload_1: {
+  INSTRUCTION(iload_1):
+  INSTRUCTION(fload_1): {
     pushInt(t, localInt(t, 1));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iload_2:
-  case fload_2: {
+  INSTRUCTION(iload_2):
+  INSTRUCTION(fload_2): {
     pushInt(t, localInt(t, 2));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iload_3:
-  case fload_3: {
+  INSTRUCTION(iload_3):
+  INSTRUCTION(fload_3): {
     pushInt(t, localInt(t, 3));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case imul: {
+  INSTRUCTION(imul): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
     pushInt(t, a * b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ineg: {
+  INSTRUCTION(ineg): {
     pushInt(t, -popInt(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case instanceof: {
+  INSTRUCTION(instanceof): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     if (peekObject(t, sp - 1)) {
@@ -1979,9 +2456,9 @@ loop:
       pushInt(t, 0);
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case invokedynamic: {
+  INSTRUCTION(invokedynamic): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     ip += 2;
@@ -2009,7 +2486,7 @@ loop:
     method = site->target()->method();
   } goto invoke;
 
-  case invokeinterface: {
+  INSTRUCTION(invokeinterface): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     ip += 2;
@@ -2026,9 +2503,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case invokespecial: {
+  INSTRUCTION(invokespecial): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     GcMethod* m = resolveMethod(t, frameMethod(t, frame), index - 1);
@@ -2054,9 +2531,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case invokestatic: {
+  INSTRUCTION(invokestatic): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     GcMethod* m = resolveMethod(t, frameMethod(t, frame), index - 1);
@@ -2068,7 +2545,7 @@ loop:
   }
     goto invoke;
 
-  case invokevirtual: {
+  INSTRUCTION(invokevirtual): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     GcMethod* m = resolveMethod(t, frameMethod(t, frame), index - 1);
@@ -2079,6 +2556,8 @@ loop:
       PROTECT(t, m);
       PROTECT(t, class_);
 
+      quicken(code, ip - 3, invokevirtual_quick);
+
       method = findVirtualMethod(t, m, class_);
       goto invoke;
     } else {
@@ -2086,17 +2565,17 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ior: {
+  INSTRUCTION(ior): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
     pushInt(t, a | b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case irem: {
+  INSTRUCTION(irem): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
@@ -2107,131 +2586,131 @@ loop:
 
     pushInt(t, a % b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ireturn:
-  case freturn: {
+  INSTRUCTION(ireturn):
+  INSTRUCTION(freturn): {
     int32_t result = popInt(t);
     if (frame > base) {
       popFrame(t);
       pushInt(t, result);
-      goto loop;
+      NEXT_INSTRUCTION;
     } else {
       return makeInt(t, result);
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ishl: {
+  INSTRUCTION(ishl): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
     pushInt(t, a << (b & 0x1F));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ishr: {
+  INSTRUCTION(ishr): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
     pushInt(t, a >> (b & 0x1F));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case istore:
-  case fstore: {
+  INSTRUCTION(istore):
+  INSTRUCTION(fstore): {
     setLocalInt(t, code->body()[ip++], popInt(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case istore_0:
-  case fstore_0: {
+  INSTRUCTION(istore_0):
+  INSTRUCTION(fstore_0): {
     setLocalInt(t, 0, popInt(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case istore_1:
-  case fstore_1: {
+  INSTRUCTION(istore_1):
+  INSTRUCTION(fstore_1): {
     setLocalInt(t, 1, popInt(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case istore_2:
-  case fstore_2: {
+  INSTRUCTION(istore_2):
+  INSTRUCTION(fstore_2): {
     setLocalInt(t, 2, popInt(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case istore_3:
-  case fstore_3: {
+  INSTRUCTION(istore_3):
+  INSTRUCTION(fstore_3): {
     setLocalInt(t, 3, popInt(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case isub: {
+  INSTRUCTION(isub): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
     pushInt(t, a - b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case iushr: {
+  INSTRUCTION(iushr): {
     int32_t b = popInt(t);
     uint32_t a = popInt(t);
 
     pushInt(t, a >> (b & 0x1F));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ixor: {
+  INSTRUCTION(ixor): {
     int32_t b = popInt(t);
     int32_t a = popInt(t);
 
     pushInt(t, a ^ b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case jsr: {
+  INSTRUCTION(jsr): {
     uint16_t offset = codeReadInt16(t, code, ip);
 
     pushInt(t, ip);
     ip = (ip - 3) + static_cast<int16_t>(offset);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case jsr_w: {
+  INSTRUCTION(jsr_w): {
     uint32_t offset = codeReadInt32(t, code, ip);
 
     pushInt(t, ip);
     ip = (ip - 5) + static_cast<int32_t>(offset);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case l2d: {
+  INSTRUCTION(l2d): {
     pushDouble(t, static_cast<double>(static_cast<int64_t>(popLong(t))));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case l2f: {
+  INSTRUCTION(l2f): {
     pushFloat(t, static_cast<float>(static_cast<int64_t>(popLong(t))));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case l2i: {
+  INSTRUCTION(l2i): {
     pushInt(t, static_cast<int32_t>(popLong(t)));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ladd: {
+  INSTRUCTION(ladd): {
     int64_t b = popLong(t);
     int64_t a = popLong(t);
 
     pushLong(t, a + b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case laload: {
+  INSTRUCTION(laload): {
     int32_t index = popInt(t);
     object array = popObject(t);
 
@@ -2252,17 +2731,17 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case land: {
+  INSTRUCTION(land): {
     int64_t b = popLong(t);
     int64_t a = popLong(t);
 
     pushLong(t, a & b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lastore: {
+  INSTRUCTION(lastore): {
     int64_t value = popLong(t);
     int32_t index = popInt(t);
     object array = popObject(t);
@@ -2284,28 +2763,28 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lcmp: {
+  INSTRUCTION(lcmp): {
     int64_t b = popLong(t);
     int64_t a = popLong(t);
 
     pushInt(t, a > b ? 1 : a == b ? 0 : -1);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lconst_0: {
+  INSTRUCTION(lconst_0): {
     pushLong(t, 0);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lconst_1: {
+  INSTRUCTION(lconst_1): {
     pushLong(t, 1);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ldc:
-  case ldc_w: {
+  INSTRUCTION(ldc):
+  INSTRUCTION(ldc_w): {
     uint16_t index;
 
     if (instruction == ldc) {
@@ -2328,14 +2807,22 @@ loop:
                    reinterpret_cast<object>(getJClass(t, cast<GcClass>(t, v))));
       } else {
         pushObject(t, v);
+
+        quicken(code,
+                ip - (instruction == ldc ? 2 : 3),
+                instruction == ldc ? ldc_quick : ldc_w_quick);
       }
     } else {
       pushInt(t, singletonValue(t, pool, index - 1));
+
+      quicken(code,
+              ip - (instruction == ldc ? 2 : 3),
+              instruction == ldc ? ldc_quick : ldc_w_quick);
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ldc2_w: {
+  INSTRUCTION(ldc2_w): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     GcSingleton* pool = code->pool();
@@ -2344,9 +2831,9 @@ loop:
     memcpy(&v, &singletonValue(t, pool, index - 1), 8);
     pushLong(t, v);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ldiv_: {
+  INSTRUCTION(ldiv_): {
     int64_t b = popLong(t);
     int64_t a = popLong(t);
 
@@ -2357,52 +2844,52 @@ loop:
 
     pushLong(t, a / b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lload:
-  case dload: {
+  INSTRUCTION(lload):
+  INSTRUCTION(dload): {
     pushLong(t, localLong(t, code->body()[ip++]));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lload_0:
-  case dload_0: {
+  INSTRUCTION(lload_0):
+  INSTRUCTION(dload_0): {
     pushLong(t, localLong(t, 0));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lload_1:
-  case dload_1: {
+  INSTRUCTION(lload_1):
+  INSTRUCTION(dload_1): {
     pushLong(t, localLong(t, 1));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lload_2:
-  case dload_2: {
+  INSTRUCTION(lload_2):
+  INSTRUCTION(dload_2): {
     pushLong(t, localLong(t, 2));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lload_3:
-  case dload_3: {
+  INSTRUCTION(lload_3):
+  INSTRUCTION(dload_3): {
     pushLong(t, localLong(t, 3));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lmul: {
+  INSTRUCTION(lmul): {
     int64_t b = popLong(t);
     int64_t a = popLong(t);
 
     pushLong(t, a * b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lneg: {
+  INSTRUCTION(lneg): {
     pushLong(t, -popLong(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lookupswitch: {
+  INSTRUCTION(lookupswitch): {
     int32_t base = ip - 1;
 
     ip += 3;
@@ -2427,23 +2914,23 @@ loop:
         bottom = middle + 1;
       } else {
         ip = base + codeReadInt32(t, code, index);
-        goto loop;
+        NEXT_INSTRUCTION;
       }
     }
 
     ip = base + default_;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lor: {
+  INSTRUCTION(lor): {
     int64_t b = popLong(t);
     int64_t a = popLong(t);
 
     pushLong(t, a | b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lrem: {
+  INSTRUCTION(lrem): {
     int64_t b = popLong(t);
     int64_t a = popLong(t);
 
@@ -2454,92 +2941,92 @@ loop:
 
     pushLong(t, a % b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lreturn:
-  case dreturn: {
+  INSTRUCTION(lreturn):
+  INSTRUCTION(dreturn): {
     int64_t result = popLong(t);
     if (frame > base) {
       popFrame(t);
       pushLong(t, result);
-      goto loop;
+      NEXT_INSTRUCTION;
     } else {
       return makeLong(t, result);
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lshl: {
+  INSTRUCTION(lshl): {
     int32_t b = popInt(t);
     int64_t a = popLong(t);
 
     pushLong(t, a << (b & 0x3F));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lshr: {
+  INSTRUCTION(lshr): {
     int32_t b = popInt(t);
     int64_t a = popLong(t);
 
     pushLong(t, a >> (b & 0x3F));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lstore:
-  case dstore: {
+  INSTRUCTION(lstore):
+  INSTRUCTION(dstore): {
     setLocalLong(t, code->body()[ip++], popLong(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lstore_0:
-  case dstore_0: {
+  INSTRUCTION(lstore_0):
+  INSTRUCTION(dstore_0): {
     setLocalLong(t, 0, popLong(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lstore_1:
-  case dstore_1: {
+  INSTRUCTION(lstore_1):
+  INSTRUCTION(dstore_1): {
     setLocalLong(t, 1, popLong(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lstore_2:
-  case dstore_2: {
+  INSTRUCTION(lstore_2):
+  INSTRUCTION(dstore_2): {
     setLocalLong(t, 2, popLong(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lstore_3:
-  case dstore_3: {
+  INSTRUCTION(lstore_3):
+  INSTRUCTION(dstore_3): {
     setLocalLong(t, 3, popLong(t));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lsub: {
+  INSTRUCTION(lsub): {
     int64_t b = popLong(t);
     int64_t a = popLong(t);
 
     pushLong(t, a - b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lushr: {
+  INSTRUCTION(lushr): {
     int64_t b = popInt(t);
     uint64_t a = popLong(t);
 
     pushLong(t, a >> (b & 0x3F));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case lxor: {
+  INSTRUCTION(lxor): {
     int64_t b = popLong(t);
     int64_t a = popLong(t);
 
     pushLong(t, a ^ b);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case monitorenter: {
+  INSTRUCTION(monitorenter): {
     object o = popObject(t);
     if (LIKELY(o)) {
       acquire(t, o);
@@ -2548,9 +3035,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case monitorexit: {
+  INSTRUCTION(monitorexit): {
     object o = popObject(t);
     if (LIKELY(o)) {
       release(t, o);
@@ -2559,9 +3046,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case multianewarray: {
+  INSTRUCTION(multianewarray): {
     uint16_t index = codeReadInt16(t, code, ip);
     uint8_t dimensions = code->body()[ip++];
 
@@ -2588,9 +3075,9 @@ loop:
 
     pushObject(t, array);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case new_: {
+  INSTRUCTION(new_): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     GcClass* class_ = resolveClassInPool(t, frameMethod(t, frame), index - 1);
@@ -2600,9 +3087,9 @@ loop:
 
     pushObject(t, make(t, class_));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case newarray: {
+  INSTRUCTION(newarray): {
     int32_t count = popInt(t);
 
     if (LIKELY(count >= 0)) {
@@ -2654,22 +3141,22 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case nop:
-    goto loop;
+  INSTRUCTION(nop):
+    NEXT_INSTRUCTION;
 
-  case pop_: {
+  INSTRUCTION(pop_): {
     --sp;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case pop2: {
+  INSTRUCTION(pop2): {
     sp -= 2;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case putfield: {
+  INSTRUCTION(putfield): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     GcField* field = resolveField(t, frameMethod(t, frame), index - 1);
@@ -2740,10 +3227,14 @@ loop:
     if (UNLIKELY(exception)) {
       goto throw_;
     }
+
+    if ((field->flags() & ACC_VOLATILE) == 0) {
+      quicken(code, ip - 3, putFieldQuick(t, field));
+    }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case putstatic: {
+  INSTRUCTION(putstatic): {
     uint16_t index = codeReadInt16(t, code, ip);
 
     GcField* field = resolveField(t, frameMethod(t, frame), index - 1);
@@ -2756,55 +3247,21 @@ loop:
 
     initClass(t, field->class_());
 
-    GcSingleton* table = field->class_()->staticTable();
+    popStaticField(t, field);
 
-    switch (field->code()) {
-    case ByteField:
-    case BooleanField:
-    case CharField:
-    case ShortField:
-    case FloatField:
-    case IntField: {
-      int32_t value = popInt(t);
-      switch (field->code()) {
-      case ByteField:
-      case BooleanField:
-        fieldAtOffset<int8_t>(table, field->offset()) = value;
-        break;
-
-      case CharField:
-      case ShortField:
-        fieldAtOffset<int16_t>(table, field->offset()) = value;
-        break;
-
-      case FloatField:
-      case IntField:
-        fieldAtOffset<int32_t>(table, field->offset()) = value;
-        break;
-      }
-    } break;
-
-    case DoubleField:
-    case LongField: {
-      fieldAtOffset<int64_t>(table, field->offset()) = popLong(t);
-    } break;
-
-    case ObjectField: {
-      setField(t, table, field->offset(), popObject(t));
-    } break;
-
-    default:
-      abort(t);
+    if ((field->flags() & ACC_VOLATILE) == 0
+        and (field->class_()->vmFlags() & NeedInitFlag) == 0) {
+      quicken(code, ip - 3, putstatic_quick);
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case ret: {
+  INSTRUCTION(ret): {
     ip = localInt(t, code->body()[ip]);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case return_: {
+  INSTRUCTION(return_): {
     GcMethod* method = frameMethod(t, frame);
     if ((method->flags() & ConstructorFlag)
         and (method->class_()->vmFlags() & HasFinalMemberFlag)) {
@@ -2813,14 +3270,14 @@ loop:
 
     if (frame > base) {
       popFrame(t);
-      goto loop;
+      NEXT_INSTRUCTION;
     } else {
       return 0;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case saload: {
+  INSTRUCTION(saload): {
     int32_t index = popInt(t);
     object array = popObject(t);
 
@@ -2841,9 +3298,9 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case sastore: {
+  INSTRUCTION(sastore): {
     int16_t value = popInt(t);
     int32_t index = popInt(t);
     object array = popObject(t);
@@ -2865,22 +3322,22 @@ loop:
       goto throw_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case sipush: {
+  INSTRUCTION(sipush): {
     pushInt(t, static_cast<int16_t>(codeReadInt16(t, code, ip)));
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case swap: {
+  INSTRUCTION(swap): {
     uintptr_t tmp[2];
     memcpy(tmp, stack + ((sp - 1) * 2), BytesPerWord * 2);
     memcpy(stack + ((sp - 1) * 2), stack + ((sp - 2) * 2), BytesPerWord * 2);
     memcpy(stack + ((sp - 2) * 2), tmp, BytesPerWord * 2);
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case tableswitch: {
+  INSTRUCTION(tableswitch): {
     int32_t base = ip - 1;
 
     ip += 3;
@@ -2899,12 +3356,12 @@ loop:
       ip = base + default_;
     }
   }
-    goto loop;
+    NEXT_INSTRUCTION;
 
-  case wide:
+  INSTRUCTION(wide):
     goto wide;
 
-  case impdep1: {
+  INSTRUCTION(impdep1): {
     // this means we're invoking a virtual method on an instance of a
     // bootstrap class, so we need to load the real class to get the
     // real method and call it.
@@ -2912,7 +3369,9 @@ loop:
     assertT(t, frameNext(t, frame) >= base);
     popFrame(t);
 
-    assertT(t, code->body()[ip - 3] == invokevirtual);
+    assertT(t,
+            code->body()[ip - 3] == invokevirtual
+            or code->body()[ip - 3] == invokevirtual_quick);
     ip -= 2;
 
     uint16_t index = codeReadInt16(t, code, ip);
@@ -2926,7 +3385,248 @@ loop:
 
     ip -= 3;
   }
-    goto loop;
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(getfield_int8_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      pushInt(t,
+              fieldAtOffset<int8_t>(target,
+                                    quickField(t, code, index)->offset()));
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(getfield_int16_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      pushInt(t,
+              fieldAtOffset<int16_t>(target,
+                                     quickField(t, code, index)->offset()));
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(getfield_int32_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      pushInt(t,
+              fieldAtOffset<int32_t>(target,
+                                     quickField(t, code, index)->offset()));
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(getfield_int64_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      pushLong(t,
+               fieldAtOffset<int64_t>(target,
+                                      quickField(t, code, index)->offset()));
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(getfield_object_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      pushObject(t,
+                 fieldAtOffset<object>(target,
+                                       quickField(t, code, index)->offset()));
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(putfield_int8_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    int32_t value = popInt(t);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      fieldAtOffset<int8_t>(target, quickField(t, code, index)->offset())
+          = value;
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(putfield_int16_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    int32_t value = popInt(t);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      fieldAtOffset<int16_t>(target, quickField(t, code, index)->offset())
+          = value;
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(putfield_int32_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    int32_t value = popInt(t);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      fieldAtOffset<int32_t>(target, quickField(t, code, index)->offset())
+          = value;
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(putfield_int64_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    int64_t value = popLong(t);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      fieldAtOffset<int64_t>(target, quickField(t, code, index)->offset())
+          = value;
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(putfield_object_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    object value = popObject(t);
+    object target = popObject(t);
+    if (LIKELY(target)) {
+      setField(t, target, quickField(t, code, index)->offset(), value);
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(getstatic_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    GcField* field = quickField(t, code, index);
+    pushField(t, field->class_()->staticTable(), field);
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(putstatic_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+    popStaticField(t, quickField(t, code, index));
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(invokevirtual_quick): {
+    uint16_t index = codeReadInt16(t, code, ip);
+
+    GcMethod* m
+        = cast<GcMethodHandle>(t, quickEntry(t, code, index))->method();
+
+    unsigned parameterFootprint = m->parameterFootprint();
+    if (LIKELY(peekObject(t, sp - parameterFootprint))) {
+      method = findVirtualMethod(
+          t, m, objectClass(t, peekObject(t, sp - parameterFootprint)));
+      goto invoke;
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(ldc_quick):
+  INSTRUCTION(ldc_w_quick): {
+    uint16_t index;
+
+    if (instruction == ldc_quick) {
+      index = code->body()[ip++];
+    } else {
+      index = codeReadInt16(t, code, ip);
+    }
+
+    GcSingleton* pool = code->pool();
+
+    if (singletonIsObject(t, pool, index - 1)) {
+      pushObject(t, singletonObject(t, pool, index - 1));
+    } else {
+      pushInt(t, singletonValue(t, pool, index - 1));
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(aload_0_getfield_int32_quick): {
+    object target = localObject(t, 0);
+    ++ip;
+    uint16_t index = codeReadInt16(t, code, ip);
+    if (LIKELY(target)) {
+      pushInt(t,
+              fieldAtOffset<int32_t>(target,
+                                     quickField(t, code, index)->offset()));
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(aload_0_getfield_object_quick): {
+    object target = localObject(t, 0);
+    ++ip;
+    uint16_t index = codeReadInt16(t, code, ip);
+    if (LIKELY(target)) {
+      pushObject(t,
+                 fieldAtOffset<object>(target,
+                                       quickField(t, code, index)->offset()));
+    } else {
+      exception = makeThrowable(t, GcNullPointerException::Type);
+      goto throw_;
+    }
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(iload_iload_iadd): {
+    int32_t a = localInt(t, code->body()[ip]);
+    int32_t b = localInt(t, code->body()[ip + 2]);
+    ip += 4;
+
+    pushInt(t, a + b);
+  }
+    NEXT_INSTRUCTION;
+
+  INSTRUCTION(iinc_goto): {
+    uint8_t index = code->body()[ip++];
+    int8_t c = code->body()[ip++];
+
+    setLocalInt(t, index, localInt(t, index) + c);
+
+    ++ip;
+    int16_t offset = codeReadInt16(t, code, ip);
+    ip = (ip - 3) + offset;
+  }
+    goto back_branch;
 
   default:
     abort(t);
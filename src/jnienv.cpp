@@ -15,6 +15,7 @@
 #include "avian/constants.h"
 
 #include <avian/util/runtime-array.h>
+#include <avian/gc.h>
 
 using namespace vm;
 
@@ -169,34 +170,44 @@ void JNICALL
   stringChars(t, *s, start, length, dst);
 }
 
+// Critical regions leave the calling thread idle, so that other
+// threads may collect garbage in the meantime.  That's safe for fixed
+// objects, which never move and which the caller's reference keeps
+// alive, so we hand out their bodies directly.  Anything else may
+// move, so we hand out a copy instead, as JNI allows.
+//
+// Note that this makes critical access anything but free for movable
+// objects, which include every array of up to ThreadHeapSizeInBytes:
+// we copy the whole thing out, and unless released with JNI_ABORT,
+// the whole thing back again.  Natives which only need part of an
+// array which may be that small should copy just that part with
+// Get/Set<Type>ArrayRegion instead (see ByteArrayRange in
+// classpath/jni-util.h).
 const jchar* JNICALL GetStringCritical(Thread* t, jstring s, jboolean* isCopy)
 {
-  if (t->criticalLevel == 0) {
-    enter(t, Thread::ActiveState);
-  }
-
-  ++t->criticalLevel;
-
-  if (isCopy) {
-    *isCopy = true;
-  }
+  ENTER(t, Thread::ActiveState);
 
   object data = (*s)->data();
-  if (objectClass(t, data) == type(t, GcByteArray::Type)) {
-    return GetStringChars(t, s, isCopy);
-  } else {
+  if (objectClass(t, data) == type(t, GcCharArray::Type)
+      and objectFixed(t, data)) {
+    if (isCopy) {
+      *isCopy = false;
+    }
+
     return &cast<GcCharArray>(t, data)->body()[(*s)->offset(t)];
+  } else {
+    return GetStringChars(t, s, isCopy);
   }
 }
 
 void JNICALL ReleaseStringCritical(Thread* t, jstring s, const jchar* chars)
 {
-  if (objectClass(t, (*s)->data()) == type(t, GcByteArray::Type)) {
-    ReleaseStringChars(t, s, chars);
-  }
+  ENTER(t, Thread::ActiveState);
 
-  if ((--t->criticalLevel) == 0) {
-    enter(t, Thread::IdleState);
+  object data = (*s)->data();
+  if (objectClass(t, data) == type(t, GcByteArray::Type)
+      or chars != &cast<GcCharArray>(t, data)->body()[(*s)->offset(t)]) {
+    ReleaseStringChars(t, s, chars);
   }
 }
 
@@ -2970,28 +2981,64 @@ void JNICALL SetDoubleArrayRegion(Thread* t,
   }
 }
 
+unsigned primitiveArraySize(Thread* t, object array)
+{
+  return objectClass(t, array)->arrayElementSize()
+         * fieldAtOffset<uintptr_t>(array, BytesPerWord);
+}
+
+void* primitiveArrayBody(object array)
+{
+  return &fieldAtOffset<uintptr_t>(array, BytesPerWord * 2);
+}
+
+// see GetStringCritical for why we only copy objects which may move,
+// and what that costs:
 void* JNICALL
     GetPrimitiveArrayCritical(Thread* t, jarray array, jboolean* isCopy)
 {
-  if (t->criticalLevel == 0) {
-    enter(t, Thread::ActiveState);
-  }
+  ENTER(t, Thread::ActiveState);
 
-  ++t->criticalLevel;
+  expect(t, *array);
 
-  if (isCopy) {
-    *isCopy = true;
-  }
+  if (objectFixed(t, *array)) {
+    if (isCopy) {
+      *isCopy = false;
+    }
 
-  expect(t, *array);
+    return primitiveArrayBody(*array);
+  } else {
+    unsigned size = primitiveArraySize(t, *array);
+    void* p = t->m->heap->allocate(size);
+    if (size) {
+      memcpy(p, primitiveArrayBody(*array), size);
+    }
 
-  return reinterpret_cast<uintptr_t*>(*array) + 2;
+    if (isCopy) {
+      *isCopy = true;
+    }
+
+    return p;
+  }
 }
 
-void JNICALL ReleasePrimitiveArrayCritical(Thread* t, jarray, void*, jint)
+void JNICALL
+    ReleasePrimitiveArrayCritical(Thread* t, jarray array, void* p, jint mode)
 {
-  if ((--t->criticalLevel) == 0) {
-    enter(t, Thread::IdleState);
+  ENTER(t, Thread::ActiveState);
+
+  if (p != primitiveArrayBody(*array)) {
+    unsigned size = primitiveArraySize(t, *array);
+
+    if (mode == 0 or mode == AVIAN_JNI_COMMIT) {
+      if (size) {
+        memcpy(primitiveArrayBody(*array), p, size);
+      }
+    }
+
+    if (mode == 0 or mode == AVIAN_JNI_ABORT) {
+      t->m->heap->free(p, size);
+    }
   }
 }
 
@@ -3282,34 +3329,31 @@ struct JavaVMInitArgs {
   jboolean ignoreUnrecognized;
 };
 
-int parseSize(const char* s)
+uint64_t parseSize(const char* s)
 {
-  unsigned length = strlen(s);
-  RUNTIME_ARRAY(char, buffer, length + 1);
+  // sizes are parsed by hand rather than with atoi so that e.g. -Xmx8g
+  // doesn't overflow 32 bits:
+  uint64_t size = 0;
+  for (; *s >= '0' and *s <= '9'; ++s) {
+    size = (size * 10) + (*s - '0');
+  }
 
-  if (length == 0)
-    return 0;
+  switch (*s) {
+  case 'k':
+  case 'K':
+    return size * 1024;
 
-  char suffix = s[length - 1];
-  if (suffix== 'k' or suffix == 'K') {
-    memcpy(RUNTIME_ARRAY_BODY(buffer), s, length - 1);
-    RUNTIME_ARRAY_BODY(buffer)[length - 1] = 0;
-    return atoi(RUNTIME_ARRAY_BODY(buffer)) * 1024;
-  }
+  case 'm':
+  case 'M':
+    return size * 1024 * 1024;
 
-  if (suffix == 'm' or suffix == 'M') {
-    memcpy(RUNTIME_ARRAY_BODY(buffer), s, length - 1);
-    RUNTIME_ARRAY_BODY(buffer)[length - 1] = 0;
-    return atoi(RUNTIME_ARRAY_BODY(buffer)) * 1024 * 1024;
-  }
+  case 'g':
+  case 'G':
+    return size * 1024 * 1024 * 1024;
 
-  if (suffix == 'g' or suffix == 'G') {
-    memcpy(RUNTIME_ARRAY_BODY(buffer), s, length - 1);
-    RUNTIME_ARRAY_BODY(buffer)[length - 1] = 0;
-    return atoi(RUNTIME_ARRAY_BODY(buffer)) * 1024 * 1024 * 1024;
+  default:
+    return size;
   }
-
-  return atoi(s);
 }
 
 void append(char** p, const char* value, unsigned length, char tail)
@@ -3612,12 +3656,16 @@ extern "C" AVIAN_EXPORT jint JNICALL
 {
   local::JavaVMInitArgs* a = static_cast<local::JavaVMInitArgs*>(args);
 
-  unsigned heapLimit = 0;
+  uint64_t heapLimit = 0;
   unsigned stackLimit = 0;
   const char* bootLibraries = 0;
   const char* classpath = 0;
   const char* javaHome = AVIAN_JAVA_HOME;
   bool reentrant = false;
+  unsigned gcThreads = 1;
+  bool gcCompact = false;
+  bool gcConcurrent = false;
+  unsigned gcLargeObjectThreshold = DefaultLargeObjectThresholdInBytes;
   const char* embedPrefix = AVIAN_EMBED_PREFIX;
   const char* bootClasspathPrepend = "";
   const char* bootClasspath = 0;
@@ -3671,6 +3719,25 @@ extern "C" AVIAN_EXPORT jint JNICALL
       } else if (strncmp(p, REENTRANT_PROPERTY "=", sizeof(REENTRANT_PROPERTY))
                  == 0) {
         reentrant = strcmp(p + sizeof(REENTRANT_PROPERTY), "true") == 0;
+      } else if (strncmp(p, GC_THREADS_PROPERTY "=", sizeof(GC_THREADS_PROPERTY))
+                 == 0) {
+        int count = atoi(p + sizeof(GC_THREADS_PROPERTY));
+        gcThreads = count > 0 ? count : 1;
+      } else if (strncmp(p, GC_COMPACT_PROPERTY "=", sizeof(GC_COMPACT_PROPERTY))
+                 == 0) {
+        gcCompact = strcmp(p + sizeof(GC_COMPACT_PROPERTY), "true") == 0;
+      } else if (strncmp(p,
+                         GC_CONCURRENT_PROPERTY "=",
+                         sizeof(GC_CONCURRENT_PROPERTY)) == 0) {
+        gcConcurrent = strcmp(p + sizeof(GC_CONCURRENT_PROPERTY), "true")
+                       == 0;
+      } else if (strncmp(p,
+                         GC_LARGE_OBJECT_THRESHOLD_PROPERTY "=",
+                         sizeof(GC_LARGE_OBJECT_THRESHOLD_PROPERTY)) == 0) {
+        uint64_t threshold
+            = local::parseSize(p + sizeof(GC_LARGE_OBJECT_THRESHOLD_PROPERTY));
+        gcLargeObjectThreshold = threshold < 0xFFFFFFFF ? threshold
+                                                        : 0xFFFFFFFF;
       } else if (strncmp(p,
                          EMBED_PREFIX_PROPERTY "=",
                          sizeof(EMBED_PREFIX_PROPERTY)) == 0) {
@@ -3694,7 +3761,12 @@ extern "C" AVIAN_EXPORT jint JNICALL
   }
 
   System* s = makeSystem(reentrant);
-  Heap* h = makeHeap(s, heapLimit);
+  Heap* h = makeHeap(s,
+                     heapLimit,
+                     gcThreads,
+                     gcCompact,
+                     gcConcurrent,
+                     gcLargeObjectThreshold);
   Classpath* c = makeClasspath(s, h, javaHome, embedPrefix);
 
   if (bootClasspath == 0) {
@@ -3789,6 +3861,64 @@ extern "C" AVIAN_EXPORT jint JNICALL
   return run(*t, local::boot, 0) ? 0 : -1;
 }
 
+extern "C" AVIAN_EXPORT void avianCollectionStatistics(
+    void* vm,
+    AvianCollectionStatistics* statistics)
+{
+  Heap::Statistics s;
+  static_cast<Machine*>(vm)->heap->statistics(&s);
+
+  for (unsigned i = 0; i < 2; ++i) {
+    statistics->collections[i] = s.collections[i];
+    statistics->totalMilliseconds[i] = s.totalMilliseconds[i];
+    statistics->maxMilliseconds[i] = s.maxMilliseconds[i];
+  }
+
+  for (unsigned i = 0; i < Heap::CauseCount; ++i) {
+    statistics->causes[i] = s.causes[i];
+  }
+
+  statistics->footprint = s.footprint;
+  statistics->peakFootprint = s.peakFootprint;
+  statistics->promoted = s.promoted;
+}
+
+extern "C" AVIAN_EXPORT unsigned avianCollectionRecords(
+    void* vm,
+    uint64_t since,
+    AvianCollectionRecord* records,
+    unsigned count)
+{
+  if (count > Heap::RecordCount) {
+    count = Heap::RecordCount;
+  }
+
+  Heap::Record rs[Heap::RecordCount];
+  count = static_cast<Machine*>(vm)->heap->records(since, rs, count);
+
+  for (unsigned i = 0; i < count; ++i) {
+    Heap::Record* r = rs + i;
+    AvianCollectionRecord* record = records + i;
+    record->sequence = r->sequence;
+    record->type = r->type;
+    record->cause = r->cause;
+    record->start = r->start;
+    record->milliseconds = r->milliseconds;
+    record->incoming = r->incoming;
+    record->gen1Before = r->gen1Before;
+    record->gen1After = r->gen1After;
+    record->gen2Before = r->gen2Before;
+    record->gen2After = r->gen2After;
+    record->untenuredFixies = r->untenuredFixies;
+    record->tenuredFixies = r->tenuredFixies;
+    record->promoted = r->promoted;
+    record->footprintBefore = r->footprintBefore;
+    record->footprintAfter = r->footprintAfter;
+  }
+
+  return count;
+}
+
 extern "C" AVIAN_EXPORT jstring JNICALL JVM_GetTemporaryDirectory(JNIEnv* e UNUSED)
 {
   // Unimplemented
@@ -0,0 +1,466 @@
+/* Copyright (c) 2008-2015, Avian Contributors
+
+   Permission to use, copy, modify, and/or distribute this software
+   for any purpose with or without fee is hereby granted, provided
+   that the above copyright notice and this permission notice appear
+   in all copies.
+
+   There is NO WARRANTY for this software.  See license.txt for
+   details. */
+
+#include "avian/kernels.h"
+
+// We use SSE2 on x86_64, where it's always available, and NEON on
+// arm64; anything else gets the scalar loops.  Where the C library
+// already provides an equivalent (memcmp, memchr, and memset), we use
+// that instead, since it typically picks the widest instructions the
+// CPU supports at runtime.
+#if (defined __x86_64__) || (defined _M_X64)
+#define AVIAN_KERNELS_SSE2
+#include <emmintrin.h>
+#elif (defined __aarch64__) && (defined __ARM_NEON)
+#define AVIAN_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace vm;
+
+namespace {
+
+namespace local {
+
+inline uint16_t charOf(int8_t c)
+{
+  return static_cast<uint16_t>(c);
+}
+
+inline uint16_t charOf(uint16_t c)
+{
+  return c;
+}
+
+inline uint8_t* body(object array)
+{
+  return &fieldAtOffset<uint8_t>(array, ArrayBody);
+}
+
+inline bool wide(Thread* t, object array)
+{
+  return objectClass(t, array)->arrayElementSize() == 2;
+}
+
+inline const int8_t* bytes(object array, int32_t offset)
+{
+  return reinterpret_cast<int8_t*>(body(array)) + offset;
+}
+
+inline const uint16_t* chars(object array, int32_t offset)
+{
+  return reinterpret_cast<uint16_t*>(body(array)) + offset;
+}
+
+inline uint16_t charAt(Thread* t, object array, int32_t offset)
+{
+  return wide(t, array) ? *chars(array, offset) : charOf(*bytes(array, offset));
+}
+
+#ifdef AVIAN_KERNELS_SSE2
+// eight characters, each widened to 16 bits:
+typedef __m128i Chars;
+
+inline Chars load(const uint16_t* p)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline Chars load(const int8_t* p)
+{
+  __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+  return _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+}
+
+inline Chars broadcast(uint16_t c)
+{
+  return _mm_set1_epi16(c);
+}
+
+inline bool allEqual(Chars a, Chars b)
+{
+  return _mm_movemask_epi8(_mm_cmpeq_epi16(a, b)) == 0xFFFF;
+}
+
+inline bool anyEqual(Chars a, Chars b)
+{
+  return _mm_movemask_epi8(_mm_cmpeq_epi16(a, b)) != 0;
+}
+
+inline bool allEqual16(const int8_t* a, const int8_t* b)
+{
+  __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+  __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) == 0xFFFF;
+}
+
+// SSE2 has no 32-bit multiply which keeps the low halves of the
+// products, so we do the even and odd lanes separately:
+inline __m128i multiply(__m128i a, __m128i b)
+{
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+template <class C>
+uint32_t hashVector(const C* data, unsigned length, unsigned* index)
+{
+  uint32_t p[9];
+  p[0] = 1;
+  for (unsigned i = 1; i < 9; ++i) {
+    p[i] = p[i - 1] * 31;
+  }
+
+  // lane k of low holds the hash of characters k, k + 8, k + 16,
+  // etc., and likewise lane k of high for characters k + 4, k + 12,
+  // and so on, so each iteration multiplies by 31^8:
+  __m128i zero = _mm_setzero_si128();
+  __m128i low = zero;
+  __m128i high = zero;
+  __m128i m = _mm_set1_epi32(p[8]);
+
+  unsigned i = 0;
+  for (; i + 8 <= length; i += 8) {
+    Chars c = load(data + i);
+    low = _mm_add_epi32(multiply(low, m), _mm_unpacklo_epi16(c, zero));
+    high = _mm_add_epi32(multiply(high, m), _mm_unpackhi_epi16(c, zero));
+  }
+  *index = i;
+
+  low = multiply(low, _mm_set_epi32(p[4], p[5], p[6], p[7]));
+  high = multiply(high, _mm_set_epi32(p[0], p[1], p[2], p[3]));
+
+  __m128i sum = _mm_add_epi32(low, high);
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+#elif (defined AVIAN_KERNELS_NEON)
+typedef uint16x8_t Chars;
+
+inline Chars load(const uint16_t* p)
+{
+  return vld1q_u16(p);
+}
+
+inline Chars load(const int8_t* p)
+{
+  return vreinterpretq_u16_s16(vmovl_s8(vld1_s8(p)));
+}
+
+inline Chars broadcast(uint16_t c)
+{
+  return vdupq_n_u16(c);
+}
+
+inline bool allEqual(Chars a, Chars b)
+{
+  return vminvq_u16(vceqq_u16(a, b)) == 0xFFFF;
+}
+
+inline bool anyEqual(Chars a, Chars b)
+{
+  return vmaxvq_u16(vceqq_u16(a, b)) != 0;
+}
+
+inline bool allEqual16(const int8_t* a, const int8_t* b)
+{
+  return vminvq_u8(vceqq_s8(vld1q_s8(a), vld1q_s8(b))) == 0xFF;
+}
+
+template <class C>
+uint32_t hashVector(const C* data, unsigned length, unsigned* index)
+{
+  uint32_t p[9];
+  p[0] = 1;
+  for (unsigned i = 1; i < 9; ++i) {
+    p[i] = p[i - 1] * 31;
+  }
+
+  // see the SSE2 version above:
+  uint32x4_t low = vdupq_n_u32(0);
+  uint32x4_t high = low;
+  uint32x4_t m = vdupq_n_u32(p[8]);
+
+  unsigned i = 0;
+  for (; i + 8 <= length; i += 8) {
+    Chars c = load(data + i);
+    low = vmlaq_u32(vmovl_u16(vget_low_u16(c)), low, m);
+    high = vmlaq_u32(vmovl_u16(vget_high_u16(c)), high, m);
+  }
+  *index = i;
+
+  const uint32_t lowWeights[] = {p[7], p[6], p[5], p[4]};
+  const uint32_t highWeights[] = {p[3], p[2], p[1], p[0]};
+
+  return vaddvq_u32(vaddq_u32(vmulq_u32(low, vld1q_u32(lowWeights)),
+                              vmulq_u32(high, vld1q_u32(highWeights))));
+}
+#endif
+
+// returns the index of the first character which differs between a
+// and b, or length if there is none:
+template <class A, class B>
+unsigned difference(const A* a, const B* b, unsigned length)
+{
+  unsigned i = 0;
+#if (defined AVIAN_KERNELS_SSE2) || (defined AVIAN_KERNELS_NEON)
+  for (; i + 8 <= length; i += 8) {
+    if (not allEqual(load(a + i), load(b + i))) {
+      break;
+    }
+  }
+#endif
+  while (i < length and charOf(a[i]) == charOf(b[i])) {
+    ++i;
+  }
+  return i;
+}
+
+template <>
+unsigned difference(const int8_t* a, const int8_t* b, unsigned length)
+{
+  unsigned i = 0;
+#if (defined AVIAN_KERNELS_SSE2) || (defined AVIAN_KERNELS_NEON)
+  for (; i + 16 <= length; i += 16) {
+    if (not allEqual16(a + i, b + i)) {
+      break;
+    }
+  }
+#endif
+  while (i < length and a[i] == b[i]) {
+    ++i;
+  }
+  return i;
+}
+
+unsigned difference(Thread* t,
+                    object a,
+                    int32_t aOffset,
+                    object b,
+                    int32_t bOffset,
+                    unsigned length)
+{
+  if (wide(t, a)) {
+    if (wide(t, b)) {
+      return difference(chars(a, aOffset), chars(b, bOffset), length);
+    } else {
+      return difference(bytes(b, bOffset), chars(a, aOffset), length);
+    }
+  } else if (wide(t, b)) {
+    return difference(bytes(a, aOffset), chars(b, bOffset), length);
+  } else {
+    return difference(bytes(a, aOffset), bytes(b, bOffset), length);
+  }
+}
+
+template <class C>
+int32_t hash(const C* data, unsigned length)
+{
+  uint32_t h = 0;
+  unsigned i = 0;
+#if (defined AVIAN_KERNELS_SSE2) || (defined AVIAN_KERNELS_NEON)
+  if (length >= 16) {
+    h = hashVector(data, length, &i);
+  }
+#endif
+  for (; i < length; ++i) {
+    h = (h * 31) + charOf(data[i]);
+  }
+  return h;
+}
+
+int32_t indexOf(const uint16_t* data, unsigned length, uint16_t c)
+{
+  unsigned i = 0;
+#if (defined AVIAN_KERNELS_SSE2) || (defined AVIAN_KERNELS_NEON)
+  Chars needle = broadcast(c);
+  for (; i + 8 <= length; i += 8) {
+    if (anyEqual(load(data + i), needle)) {
+      break;
+    }
+  }
+#endif
+  for (; i < length; ++i) {
+    if (data[i] == c) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int32_t indexOf(const int8_t* data, unsigned length, int32_t c)
+{
+  // find the byte, if any, which String.charAt would widen to c:
+  int8_t b = static_cast<int8_t>(c);
+  if (charOf(b) != c) {
+    return -1;
+  }
+
+  const void* p = memchr(data, b, length);
+  return p ? static_cast<const int8_t*>(p) - data : -1;
+}
+
+template <class T>
+void fill(T* data, int32_t start, int32_t stop, T value)
+{
+  // simple enough for the compiler to vectorize on its own:
+  for (int32_t i = start; i < stop; ++i) {
+    data[i] = value;
+  }
+}
+
+}  // namespace local
+
+}  // namespace
+
+namespace vm {
+
+bool charsEqual(Thread* t,
+                object a,
+                int32_t aOffset,
+                object b,
+                int32_t bOffset,
+                int32_t length)
+{
+  if (local::wide(t, a) == local::wide(t, b)) {
+    unsigned size = local::wide(t, a) ? 2 : 1;
+    return memcmp(local::body(a) + (aOffset * size),
+                  local::body(b) + (bOffset * size),
+                  length * size) == 0;
+  } else {
+    return local::difference(t, a, aOffset, b, bOffset, length)
+           == static_cast<unsigned>(length);
+  }
+}
+
+int32_t compareChars(Thread* t,
+                     object a,
+                     int32_t aOffset,
+                     int32_t aLength,
+                     object b,
+                     int32_t bOffset,
+                     int32_t bLength)
+{
+  unsigned length = aLength < bLength ? aLength : bLength;
+  unsigned i = local::difference(t, a, aOffset, b, bOffset, length);
+  if (i < length) {
+    return static_cast<int32_t>(local::charAt(t, a, aOffset + i))
+           - local::charAt(t, b, bOffset + i);
+  } else {
+    return aLength - bLength;
+  }
+}
+
+int32_t hashChars(Thread* t, object data, int32_t offset, int32_t length)
+{
+  if (local::wide(t, data)) {
+    return local::hash(local::chars(data, offset), length);
+  } else {
+    return local::hash(local::bytes(data, offset), length);
+  }
+}
+
+int32_t indexOfChar(Thread* t,
+                    object data,
+                    int32_t offset,
+                    int32_t length,
+                    int32_t c)
+{
+  if (c < 0 or c > 0xFFFF) {
+    return -1;
+  } else if (local::wide(t, data)) {
+    return local::indexOf(local::chars(data, offset), length, c);
+  } else {
+    return local::indexOf(local::bytes(data, offset), length, c);
+  }
+}
+
+int32_t indexOfChars(Thread* t,
+                     object data,
+                     int32_t offset,
+                     int32_t length,
+                     object pattern,
+                     int32_t patternOffset,
+                     int32_t patternLength)
+{
+  if (patternLength == 0) {
+    return 0;
+  }
+
+  // look for the first character of the pattern, then see whether
+  // the rest follows it:
+  uint16_t first = local::charAt(t, pattern, patternOffset);
+  int32_t limit = length - patternLength + 1;
+  for (int32_t i = 0; i < limit; ++i) {
+    int32_t j = indexOfChar(t, data, offset + i, limit - i, first);
+    if (j < 0) {
+      return -1;
+    }
+    i += j;
+
+    unsigned rest = patternLength - 1;
+    if (local::difference(
+            t, data, offset + i + 1, pattern, patternOffset + 1, rest)
+        == rest) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool elementsEqual(Thread* t, object a, object b, int32_t length)
+{
+  return memcmp(local::body(a),
+                local::body(b),
+                length * objectClass(t, a)->arrayElementSize()) == 0;
+}
+
+void fillElements(Thread* t,
+                  object array,
+                  int32_t start,
+                  int32_t stop,
+                  int64_t value)
+{
+  uint8_t* p = local::body(array);
+  switch (objectClass(t, array)->arrayElementSize()) {
+  case 1:
+    memset(p + start, static_cast<uint8_t>(value), stop - start);
+    break;
+
+  case 2:
+    local::fill(reinterpret_cast<uint16_t*>(p),
+                start,
+                stop,
+                static_cast<uint16_t>(value));
+    break;
+
+  case 4:
+    local::fill(reinterpret_cast<uint32_t*>(p),
+                start,
+                stop,
+                static_cast<uint32_t>(value));
+    break;
+
+  case 8:
+    local::fill(reinterpret_cast<uint64_t*>(p),
+                start,
+                stop,
+                static_cast<uint64_t>(value));
+    break;
+
+  default:
+    abort(t);
+  }
+}
+
+}  // namespace vm
@@ -274,8 +274,6 @@ void killZombies(Thread* t, Thread* o)
 
 unsigned footprint(Thread* t)
 {
-  expect(t, t->criticalLevel == 0);
-
   unsigned n = t->heapOffset + t->heapIndex + t->backupHeapIndex;
 
   for (Thread* c = t->child; c; c = c->peer) {
@@ -291,6 +289,12 @@ void visitRoots(Thread* t, Heap::Visitor* v)
     v->visit(&(t->javaThread));
     v->visit(&(t->exception));
 
+    for (unsigned i = 0; i < ThinLockRecordCount; ++i) {
+      if (t->lockRecords[i].target) {
+        v->visit(&(t->lockRecords[i].target));
+      }
+    }
+
     t->m->processor->visitObjects(t, v);
 
     for (Thread::Protector* p = t->protector; p; p = p->next) {
@@ -391,6 +395,11 @@ void finalizerTargetUnreachable(Thread* t, Heap::Visitor* v, GcFinalizer** p)
     // TODO: use set() here?
     finalizer->next() = t->m->finalizeQueue;
     t->m->finalizeQueue = finalizer;
+
+    // these slots aren't visited otherwise, but the heap may need to
+    // update them if it moves objects after we return:
+    v->visit(&(finalizer->next()));
+    v->visit(&(t->m->finalizeQueue));
   } else {
     finalizer->setQueueTarget(t, finalizer->target());
     finalizer->setQueueNext(t, roots(t)->objectsToFinalize());
@@ -552,6 +561,7 @@ void postVisit(Thread* t, Heap::Visitor* v)
         *p = cast<GcFinalizer>(t, finalizer->next());
         finalizer->next() = firstNewTenuredFinalizer;
         firstNewTenuredFinalizer = finalizer;
+        v->visit(&(finalizer->next()));
       } else {
         p = reinterpret_cast<GcFinalizer**>(&(*p)->next());
       }
@@ -591,6 +601,7 @@ void postVisit(Thread* t, Heap::Visitor* v)
         *p = cast<GcJreference>(t, reference->vmNext());
         reference->vmNext() = firstNewTenuredWeakReference;
         firstNewTenuredWeakReference = reference;
+        v->visit(&(reference->vmNext()));
       } else {
         p = reinterpret_cast<GcJreference**>(&(*p)->vmNext());
       }
@@ -645,11 +656,15 @@ void postVisit(Thread* t, Heap::Visitor* v)
   if (lastNewTenuredFinalizer) {
     lastNewTenuredFinalizer->next() = m->tenuredFinalizers;
     m->tenuredFinalizers = firstNewTenuredFinalizer;
+    v->visit(&(lastNewTenuredFinalizer->next()));
+    v->visit(&(m->tenuredFinalizers));
   }
 
   if (lastNewTenuredWeakReference) {
     lastNewTenuredWeakReference->vmNext() = m->tenuredWeakReferences;
     m->tenuredWeakReferences = firstNewTenuredWeakReference;
+    v->visit(&(lastNewTenuredWeakReference->vmNext()));
+    v->visit(&(m->tenuredWeakReferences));
   }
 
   for (Reference* r = m->jniReferences; r; r = r->next) {
@@ -663,28 +678,56 @@ void postVisit(Thread* t, Heap::Visitor* v)
   }
 }
 
+unsigned adaptHeapSize(Thread* t)
+{
+  unsigned size = t->defaultHeapSizeInWords;
+
+  if (t->heapRefillCount >= ThreadHeapGrowThreshold) {
+    // this thread keeps running out of space between collections, so
+    // give it more to work with and take the refill path less often:
+    size = min(size * 2, ThreadHeapMaximumSizeInWords);
+  } else if (t->heapRefillCount == 0 and t->heapIndex < size / 4) {
+    // this thread barely touched its heap, so don't hold onto memory
+    // it isn't using:
+    size = max(size / 2, ThreadHeapMinimumSizeInWords);
+  }
+
+  return size;
+}
+
 void postCollect(Thread* t)
 {
+  unsigned size = adaptHeapSize(t);
+
+  t->heapAllocatedWords += t->heapOffset + t->heapIndex;
+  t->heapRefillCount = 0;
+
 #ifdef VM_STRESS
-  t->m->heap->free(t->defaultHeap, ThreadHeapSizeInBytes);
-  t->defaultHeap
-      = static_cast<uintptr_t*>(t->m->heap->allocate(ThreadHeapSizeInBytes));
-  memset(t->defaultHeap, 0, ThreadHeapSizeInBytes);
+  bool reallocate = true;
+#else
+  bool reallocate = size != t->defaultHeapSizeInWords;
 #endif
 
-  if (t->heap == t->defaultHeap) {
+  if (reallocate) {
+    t->m->heap->free(t->defaultHeap, t->defaultHeapSizeInWords * BytesPerWord);
+    t->defaultHeap
+        = static_cast<uintptr_t*>(t->m->heap->allocate(size * BytesPerWord));
+    memset(t->defaultHeap, 0, size * BytesPerWord);
+    t->defaultHeapSizeInWords = size;
+  } else if (t->heap == t->defaultHeap) {
     memset(t->defaultHeap, 0, t->heapIndex * BytesPerWord);
   } else {
-    memset(t->defaultHeap, 0, ThreadHeapSizeInBytes);
-    t->heap = t->defaultHeap;
+    memset(t->defaultHeap, 0, size * BytesPerWord);
   }
 
+  t->heap = t->defaultHeap;
+  t->heapSizeInWords = size;
   t->heapOffset = 0;
 
   if (t->m->heap->limitExceeded()) {
     // if we're out of memory, pretend the thread-local heap is
     // already full so we don't make things worse:
-    t->heapIndex = ThreadHeapSizeInWords;
+    t->heapIndex = size;
   } else {
     t->heapIndex = 0;
   }
@@ -3446,15 +3489,21 @@ class HeapClient : public Heap::Client {
   }
 
   virtual unsigned copiedSizeInWords(void* p)
+  {
+    object o = static_cast<object>(m->heap->follow(maskAlignedPointer(p)));
+    return copiedSizeInWords(o, alias(o, 0));
+  }
+
+  virtual unsigned copiedSizeInWords(void* p, uintptr_t header)
   {
     Thread* t = m->rootThread;
 
-    object o = static_cast<object>(m->heap->follow(maskAlignedPointer(p)));
-    assertT(t, not objectFixed(t, o));
+    object o = static_cast<object>(p);
+    assertT(t, (header & (~PointerMask)) != FixedMark);
 
-    unsigned n = baseSize(t, o, m->heap->follow(objectClass(t, o)));
+    unsigned n = baseSize(t, o, m->heap->follow(headerClass(header)));
 
-    if (objectExtended(t, o) or hashTaken(t, o)) {
+    if ((header & (~PointerMask)) != 0) {
       ++n;
     }
 
@@ -3462,28 +3511,48 @@ class HeapClient : public Heap::Client {
   }
 
   virtual void copy(void* srcp, void* dstp)
+  {
+    object src = static_cast<object>(m->heap->follow(maskAlignedPointer(srcp)));
+    copy(src, dstp, alias(src, 0));
+  }
+
+  virtual void copy(void* srcp, void* dstp, uintptr_t header)
   {
     Thread* t = m->rootThread;
 
-    object src = static_cast<object>(m->heap->follow(maskAlignedPointer(srcp)));
-    assertT(t, not objectFixed(t, src));
+    object src = static_cast<object>(srcp);
+    assertT(t, (header & (~PointerMask)) != FixedMark);
 
-    GcClass* class_ = m->heap->follow(objectClass(t, src));
+    GcClass* class_ = m->heap->follow(headerClass(header));
 
     unsigned base = baseSize(t, src, class_);
-    unsigned n = extendedSize(t, src, base);
+    unsigned n = base + ((header & (~PointerMask)) == ExtendedMark);
 
     object dst = static_cast<object>(dstp);
 
     memcpy(dst, src, n * BytesPerWord);
+    alias(dst, 0) = header;
 
-    if (hashTaken(t, src)) {
+    if ((header & (~PointerMask)) == HashTakenMark) {
       alias(dst, 0) &= PointerMask;
       alias(dst, 0) |= ExtendedMark;
       extendedWord(t, dst, base) = takeHash(t, src);
     }
   }
 
+  virtual void extend(void* originalp, void* movedp, unsigned sizeInWords)
+  {
+    Thread* t = m->rootThread;
+
+    object moved = static_cast<object>(movedp);
+    assertT(t, hashTaken(t, moved));
+
+    alias(moved, 0) &= PointerMask;
+    alias(moved, 0) |= ExtendedMark;
+    extendedWord(t, moved, sizeInWords)
+        = takeHash(t, static_cast<object>(originalp));
+  }
+
   virtual void walk(void* p, Heap::Walker* w)
   {
     object o = static_cast<object>(m->heap->follow(maskAlignedPointer(p)));
@@ -3496,10 +3565,15 @@ class HeapClient : public Heap::Client {
   }
 
  private:
+  static GcClass* headerClass(uintptr_t header)
+  {
+    return reinterpret_cast<GcClass*>(header & PointerMask);
+  }
+
   Machine* m;
 };
 
-void doCollect(Thread* t, Heap::CollectionType type, int pendingAllocation)
+void doCollect(Thread* t, Heap::CollectionType type, int64_t pendingAllocation)
 {
   expect(t, not t->m->collecting);
 
@@ -3518,7 +3592,7 @@ void doCollect(Thread* t, Heap::CollectionType type, int pendingAllocation)
   m->heap->collect(
       type,
       footprint(m->rootThread),
-      pendingAllocation - (t->m->heapPoolIndex * ThreadHeapSizeInWords));
+      pendingAllocation - static_cast<int64_t>(t->m->heapPoolFootprint));
   m->unsafe = false;
 
   postCollect(m->rootThread);
@@ -3526,16 +3600,19 @@ void doCollect(Thread* t, Heap::CollectionType type, int pendingAllocation)
   killZombies(t, m->rootThread);
 
   for (unsigned i = 0; i < m->heapPoolIndex; ++i) {
-    m->heap->free(m->heapPool[i], ThreadHeapSizeInBytes);
+    m->heap->free(m->heapPool[i], m->heapPoolSizes[i] * BytesPerWord);
   }
   m->heapPoolIndex = 0;
+  m->heapPoolFootprint = 0;
 
   if (m->heap->limitExceeded()) {
     // if we're out of memory, disallow further allocations of fixed
     // objects:
     m->fixedFootprint = FixedFootprintThresholdInBytes;
+    m->largeFootprint = LargeFootprintThresholdInBytes;
   } else {
     m->fixedFootprint = 0;
+    m->largeFootprint = 0;
   }
 
 #ifdef VM_STRESS
@@ -3706,6 +3783,7 @@ Machine::Machine(System* system,
       liveCount(0),
       daemonCount(0),
       fixedFootprint(0),
+      largeFootprint(0),
       stackSizeInBytes(stackSizeInBytes),
       localThread(0),
       stateLock(0),
@@ -3713,6 +3791,7 @@ Machine::Machine(System* system,
       classLock(0),
       referenceLock(0),
       shutdownLock(0),
+      thinLockMonitor(0),
       libraries(0),
       errorLog(0),
       bootimage(0),
@@ -3728,10 +3807,13 @@ Machine::Machine(System* system,
       triedBuiltinOnLoad(false),
       dumpedHeapOnOOM(false),
       alive(true),
-      heapPoolIndex(0)
+      heapPoolIndex(0),
+      heapPoolFootprint(0)
 {
   heap->setClient(heapClient);
 
+  memset(lockTable, 0, ThinLockTableSize * BytesPerWord);
+
   populateJNITables(&javaVMVTable, &jniEnvVTable);
 
   // Copying the properties memory (to avoid memory crashes)
@@ -3760,6 +3842,7 @@ Machine::Machine(System* system,
       or not system->success(system->make(&classLock))
       or not system->success(system->make(&referenceLock))
       or not system->success(system->make(&shutdownLock))
+      or not system->success(system->make(&thinLockMonitor))
       or not system->success(system->load(&libraries, bootstrapPropertyDup))) {
     system->abort();
   }
@@ -3788,6 +3871,7 @@ void Machine::dispose()
   classLock->dispose();
   referenceLock->dispose();
   shutdownLock->dispose();
+  thinLockMonitor->dispose();
 
   if (libraries) {
     libraries->disposeAll();
@@ -3800,7 +3884,7 @@ void Machine::dispose()
   }
 
   for (unsigned i = 0; i < heapPoolIndex; ++i) {
-    heap->free(heapPool[i], ThreadHeapSizeInBytes);
+    heap->free(heapPool[i], heapPoolSizes[i] * BytesPerWord);
   }
 
   if (bootimage) {
@@ -3827,13 +3911,17 @@ Thread::Thread(Machine* m, GcThread* javaThread, Thread* parent)
       child(0),
       waitNext(0),
       state(NoState),
-      criticalLevel(0),
       systemThread(0),
       lock(0),
       javaThread(javaThread),
       exception(0),
       heapIndex(0),
       heapOffset(0),
+      heapSizeInWords(ThreadHeapSizeInWords),
+      defaultHeapSizeInWords(ThreadHeapSizeInWords),
+      heapRefillCount(0),
+      heapRefills(0),
+      heapAllocatedWords(0),
       protector(0),
       classInitStack(0),
       libraryLoadStack(0),
@@ -3844,6 +3932,14 @@ Thread::Thread(Machine* m, GcThread* javaThread, Thread* parent)
       backupHeapIndex(0),
       flags(ActiveFlag)
 {
+  for (unsigned i = 0; i < ThinLockRecordCount; ++i) {
+    lockRecords[i].owner = this;
+    lockRecords[i].target = 0;
+    lockRecords[i].slot = 0;
+    lockRecords[i].next = 0;
+    lockRecords[i].depth = 0;
+    lockRecords[i].contended = false;
+  }
 }
 
 void Thread::init()
@@ -3958,6 +4054,15 @@ void Thread::exit()
 
 void Thread::dispose()
 {
+  // a thread may exit while still holding thin locks (e.g. via
+  // JNI MonitorEnter), so make sure we don't leave dangling records
+  // in the lock table:
+  for (unsigned i = 0; i < ThinLockRecordCount; ++i) {
+    if (lockRecords[i].target) {
+      thinLockRelease(this, lockRecords + i);
+    }
+  }
+
   if (lock) {
     lock->dispose();
   }
@@ -3968,7 +4073,7 @@ void Thread::dispose()
 
   --m->threadCount;
 
-  m->heap->free(defaultHeap, ThreadHeapSizeInBytes);
+  m->heap->free(defaultHeap, defaultHeapSizeInWords * BytesPerWord);
 
   m->processor->dispose(this);
 }
@@ -4235,14 +4340,16 @@ void enter(Thread* t, Thread::State s)
 
 object allocate2(Thread* t, unsigned sizeInBytes, bool objectMask)
 {
-  return allocate3(
-      t,
-      t->m->heap,
-      ceilingDivide(sizeInBytes, BytesPerWord) > ThreadHeapSizeInWords
-          ? Machine::FixedAllocation
-          : Machine::MovableAllocation,
-      sizeInBytes,
-      objectMask);
+  Machine::AllocationType type;
+  if (ceilingDivide(sizeInBytes, BytesPerWord) <= ThreadHeapSizeInWords) {
+    type = Machine::MovableAllocation;
+  } else if (sizeInBytes >= t->m->heap->largeObjectThreshold()) {
+    type = Machine::LargeAllocation;
+  } else {
+    type = Machine::FixedAllocation;
+  }
+
+  return allocate3(t, t->m->heap, type, sizeInBytes, objectMask);
 }
 
 object allocate3(Thread* t,
@@ -4251,8 +4358,6 @@ object allocate3(Thread* t,
                  unsigned sizeInBytes,
                  bool objectMask)
 {
-  expect(t, t->criticalLevel == 0);
-
   if (UNLIKELY(t->getFlags() & Thread::UseBackupHeapFlag)) {
     expect(t,
            t->backupHeapIndex + ceilingDivide(sizeInBytes, BytesPerWord)
@@ -4265,7 +4370,7 @@ object allocate3(Thread* t,
   } else if (UNLIKELY(t->getFlags() & Thread::TracingFlag)) {
     expect(t,
            t->heapIndex + ceilingDivide(sizeInBytes, BytesPerWord)
-           <= ThreadHeapSizeInWords);
+           <= t->heapSizeInWords);
     return allocateSmall(t, sizeInBytes);
   }
 
@@ -4285,19 +4390,32 @@ object allocate3(Thread* t,
     switch (type) {
     case Machine::MovableAllocation:
       if (t->heapIndex + ceilingDivide(sizeInBytes, BytesPerWord)
-          > ThreadHeapSizeInWords) {
+          > t->heapSizeInWords) {
+        // the default heap may have shrunk below the size of this
+        // object, in which case the refill must be big enough to hold
+        // it:
+        unsigned size = max(t->defaultHeapSizeInWords,
+                            ceilingDivide(sizeInBytes, BytesPerWord));
+
         t->heap = 0;
         if ((not t->m->heap->limitExceeded())
-            and t->m->heapPoolIndex < ThreadHeapPoolSize) {
+            and t->m->heapPoolIndex < ThreadHeapPoolSize
+            and t->m->heapPoolFootprint + size
+                <= ThreadHeapPoolFootprintInWords) {
           t->heap = static_cast<uintptr_t*>(
-              t->m->heap->tryAllocate(ThreadHeapSizeInBytes));
+              t->m->heap->tryAllocate(size * BytesPerWord));
 
           if (t->heap) {
-            memset(t->heap, 0, ThreadHeapSizeInBytes);
+            memset(t->heap, 0, size * BytesPerWord);
 
-            t->m->heapPool[t->m->heapPoolIndex++] = t->heap;
+            t->m->heapPool[t->m->heapPoolIndex] = t->heap;
+            t->m->heapPoolSizes[t->m->heapPoolIndex++] = size;
+            t->m->heapPoolFootprint += size;
             t->heapOffset += t->heapIndex;
             t->heapIndex = 0;
+            t->heapSizeInWords = size;
+            ++t->heapRefillCount;
+            ++t->heapRefills;
           }
         }
       }
@@ -4311,9 +4429,15 @@ object allocate3(Thread* t,
 
     case Machine::ImmortalAllocation:
       break;
+
+    case Machine::LargeAllocation:
+      if (t->m->largeFootprint + sizeInBytes > LargeFootprintThresholdInBytes) {
+        t->heap = 0;
+      }
+      break;
     }
 
-    int pendingAllocation = t->m->heap->fixedFootprint(
+    int64_t pendingAllocation = t->m->heap->fixedFootprint(
         ceilingDivide(sizeInBytes, BytesPerWord), objectMask);
 
     if (t->heap == 0 or t->m->heap->limitExceeded(pendingAllocation)) {
@@ -4327,7 +4451,7 @@ object allocate3(Thread* t,
     }
   } while (type == Machine::MovableAllocation
            and t->heapIndex + ceilingDivide(sizeInBytes, BytesPerWord)
-               > ThreadHeapSizeInWords);
+               > t->heapSizeInWords);
 
   switch (type) {
   case Machine::MovableAllocation: {
@@ -4359,17 +4483,36 @@ object allocate3(Thread* t,
     return o;
   }
 
+  case Machine::LargeAllocation: {
+    object o = static_cast<object>(t->m->heap->tryAllocateLarge(
+        ceilingDivide(sizeInBytes, BytesPerWord), objectMask));
+
+    if (o == 0) {
+      throw_(t, roots(t)->outOfMemoryError());
+    }
+
+    // no need to clear it, since the heap gives each large object
+    // freshly mapped pages:
+
+    alias(o, 0) = FixedMark;
+
+    t->m->largeFootprint += t->m->heap->fixedFootprint(
+        ceilingDivide(sizeInBytes, BytesPerWord), objectMask);
+
+    return o;
+  }
+
   default:
     abort(t);
   }
 }
 
-void collect(Thread* t, Heap::CollectionType type, int pendingAllocation)
+void collect(Thread* t, Heap::CollectionType type, int64_t pendingAllocation)
 {
   ENTER(t, Thread::ExclusiveState);
 
-  unsigned pending = pendingAllocation
-                     - (t->m->heapPoolIndex * ThreadHeapSizeInWords);
+  int64_t pending = pendingAllocation
+                    - static_cast<int64_t>(t->m->heapPoolFootprint);
 
   if (t->m->heap->limitExceeded(pending)) {
     type = Heap::MajorCollection;
@@ -5487,6 +5630,105 @@ GcMonitor* objectMonitor(Thread* t, object o, bool createNew)
   }
 }
 
+void thinLockNotify(Thread* t)
+{
+  ACQUIRE_RAW(t, t->m->thinLockMonitor);
+
+  t->m->thinLockMonitor->notifyAll(t->systemThread);
+}
+
+// Waits until the specified object's thin lock, if still held by
+// another thread, is released.  We mark the holder's record as
+// contended while holding thinLockMonitor, so its release can't slip
+// in between that check and our wait without notifying us.
+void thinLockWait(Thread* t, uintptr_t* slot, object o)
+{
+  System::Monitor* lock = t->m->thinLockMonitor;
+
+  lock->acquire(t->systemThread);
+
+  Thread::LockRecord* head = thinLockLockSlot(t, slot);
+  Thread::LockRecord* r = thinLockFind(head, o);
+  bool held = r and r->owner != t;
+  if (held) {
+    r->contended = true;
+  }
+  thinLockUnlockSlot(slot, head);
+
+  if (held) {
+    // we must not block trying to become active again (e.g. while
+    // another thread collects garbage) until we've let go of the
+    // lock, since the thread releasing the thin lock needs it:
+    ENTER(t, Thread::IdleState);
+
+    lock->wait(t->systemThread, 0);
+    lock->release(t->systemThread);
+  } else {
+    lock->release(t->systemThread);
+  }
+}
+
+void acquireInflated(Thread* t, object o, GcMonitor* m)
+{
+  PROTECT(t, o);
+
+  if (m == 0) {
+    m = objectMonitor(t, o, true);
+  }
+
+  PROTECT(t, m);
+
+  uintptr_t* slot = thinLockSlot(t, o);
+
+  while (true) {
+    monitorAcquire(t, m);
+
+    storeLoadMemoryBarrier();
+
+    if (not thinLockHeldByOther(t, slot, o)) {
+      break;
+    }
+
+    // another thread thin-locked the object before it was inflated;
+    // get out of its way until it releases the lock (it will inflate
+    // it itself if it needs to wait):
+    monitorRelease(t, m);
+
+    thinLockWait(t, slot, o);
+  }
+
+  if (DebugMonitors) {
+    fprintf(stderr,
+            "thread %p acquires %p for %x\n",
+            t,
+            m,
+            objectHash(t, o));
+  }
+}
+
+GcMonitor* inflate(Thread* t, object o, Thread::LockRecord* r)
+{
+  assertT(t, r->target == o);
+
+  PROTECT(t, o);
+
+  GcMonitor* m = objectMonitor(t, o, true);
+
+  // any other thread which gets to the monitor first will notice our
+  // thin lock and release it promptly:
+  monitorAcquire(t, m);
+
+  m->depth() = r->depth;
+
+  thinLockRelease(t, r);
+
+  if (DebugMonitors) {
+    fprintf(stderr, "thread %p inflates %p for %x\n", t, m, objectHash(t, o));
+  }
+
+  return m;
+}
+
 object intern(Thread* t, object s)
 {
   PROTECT(t, s);
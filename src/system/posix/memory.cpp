@@ -33,9 +33,10 @@ util::Slice<uint8_t> Memory::allocate(size_t sizeInBytes,
     prot |= PROT_EXEC;
   }
 #ifdef MAP_32BIT
-  // map to the lower 32 bits of memory when possible so as to avoid
-  // expensive relative jumps
-  const unsigned Extra = MAP_32BIT;
+  // map code to the lower 32 bits of memory when possible so as to
+  // avoid expensive relative jumps, but leave data (e.g. the heap's
+  // large objects) free to go anywhere rather than crowd it out:
+  const unsigned Extra = (perms & Execute) ? MAP_32BIT : 0;
 #else
   const unsigned Extra = 0;
 #endif
@@ -1,6 +1,5 @@
 THUNK(tryInitClass)
-THUNK(findInterfaceMethodFromInstance)
-THUNK(findInterfaceMethodFromInstanceAndReference)
+THUNK(findInterfaceMethodFromCache)
 THUNK(findSpecialMethodFromReference)
 THUNK(findStaticMethodFromReference)
 THUNK(findVirtualMethodFromReference)
@@ -64,6 +63,13 @@ THUNK(setLongFieldValueFromReference)
 THUNK(setStaticObjectFieldValueFromReference)
 THUNK(setObjectFieldValueFromReference)
 THUNK(instanceOf64)
+THUNK(charsEqual64)
+THUNK(compareChars64)
+THUNK(hashChars64)
+THUNK(indexOfChar64)
+THUNK(indexOfChars64)
+THUNK(elementsEqual64)
+THUNK(fillElements64)
 THUNK(instanceOfFromReference)
 THUNK(makeNewGeneral64)
 THUNK(makeNew64)
@@ -72,4 +78,6 @@ THUNK(setObject)
 THUNK(getJClass64)
 THUNK(getJClassFromReference)
 THUNK(gcIfNecessary)
+THUNK(countInvocation)
+THUNK(countBackEdge)
 THUNK(idleIfNecessary)
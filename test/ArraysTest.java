@@ -71,6 +71,175 @@ public class ArraysTest {
     expect(exception != null);
   }
 
+  private static int sum(int[] array) {
+    int sum = 0;
+    for (int i = 0; i < array.length; ++i) {
+      sum += array[i];
+    }
+    return sum;
+  }
+
+  private static int sumEach(int[] array) {
+    int sum = 0;
+    for (int v: array) {
+      sum += v;
+    }
+    return sum;
+  }
+
+  private static int sumPastEnd(int[] array) {
+    int sum = 0;
+    for (int i = 0; i <= array.length; ++i) {
+      sum += array[i];
+    }
+    return sum;
+  }
+
+  private static int sumNext(int[] array) {
+    int sum = 0;
+    for (int i = 0; i < array.length; ++i) {
+      sum += array[i + 1];
+    }
+    return sum;
+  }
+
+  private static int sumSwitching(int[] array, int[] other) {
+    int sum = 0;
+    int[] a = array;
+    for (int i = 0; i < a.length; ++i) {
+      if (i == 2) {
+        a = other;
+      }
+      sum += a[i];
+    }
+    return sum;
+  }
+
+  private static void increment(int[] array, int index) {
+    array[index] += 1;
+    array[index] = array[index] + 1;
+  }
+
+  public static void testLoops() {
+    int[] array = new int[] { 1, 2, 3, 4 };
+    expect(sum(array) == 10);
+    expect(sumEach(array) == 10);
+    expect(sum(new int[0]) == 0);
+
+    Exception exception = null;
+    try {
+      sumPastEnd(array);
+    } catch (ArrayIndexOutOfBoundsException e) {
+      exception = e;
+    }
+    expect(exception != null);
+
+    exception = null;
+    try {
+      sumNext(array);
+    } catch (ArrayIndexOutOfBoundsException e) {
+      exception = e;
+    }
+    expect(exception != null);
+
+    exception = null;
+    try {
+      sumSwitching(array, new int[2]);
+    } catch (ArrayIndexOutOfBoundsException e) {
+      exception = e;
+    }
+    expect(exception != null);
+
+    exception = null;
+    try {
+      sum(null);
+    } catch (NullPointerException e) {
+      exception = e;
+    }
+    expect(exception != null);
+
+    increment(array, 3);
+    expect(array[3] == 6);
+
+    exception = null;
+    try {
+      increment(array, 4);
+    } catch (ArrayIndexOutOfBoundsException e) {
+      exception = e;
+    }
+    expect(exception != null);
+    expect(array[3] == 6);
+  }
+
+  public static void testFillAndEquals() {
+    for (int length = 0; length < 40; ++length) {
+      byte[] b1 = new byte[length];
+      byte[] b2 = new byte[length];
+      Arrays.fill(b1, (byte) -3);
+      Arrays.fill(b2, 1, length, (byte) -3);
+      expect(length == 0 || b2[0] == 0);
+      if (length > 0) b2[0] = -3;
+      expect(Arrays.equals(b1, b2));
+
+      char[] c1 = new char[length];
+      char[] c2 = new char[length];
+      Arrays.fill(c1, '\uffee');
+      Arrays.fill(c2, '\uffee');
+      expect(Arrays.equals(c1, c2));
+
+      short[] s1 = new short[length];
+      Arrays.fill(s1, (short) -2);
+      int[] i1 = new int[length];
+      int[] i2 = new int[length];
+      Arrays.fill(i1, -7);
+      Arrays.fill(i2, 0, length, -7);
+      expect(Arrays.equals(i1, i2));
+
+      long[] l1 = new long[length];
+      long[] l2 = new long[length];
+      Arrays.fill(l1, 0x123456789abcdefL);
+      Arrays.fill(l2, 0x123456789abcdefL);
+      expect(Arrays.equals(l1, l2));
+
+      boolean[] z = new boolean[length];
+      Arrays.fill(z, true);
+      float[] f = new float[length];
+      Arrays.fill(f, 1.5f);
+      double[] d = new double[length];
+      Arrays.fill(d, -2.25);
+
+      for (int i = 0; i < length; ++i) {
+        expect(b1[i] == -3);
+        expect(c1[i] == '\uffee');
+        expect(s1[i] == -2);
+        expect(i1[i] == -7);
+        expect(l1[i] == 0x123456789abcdefL);
+        expect(z[i]);
+        expect(f[i] == 1.5f);
+        expect(d[i] == -2.25);
+      }
+
+      if (length > 0) {
+        b2[length - 1] = 0;
+        c2[length - 1] = 0;
+        i2[length - 1] = 0;
+        l2[length - 1] = 0;
+        expect(! Arrays.equals(b1, b2));
+        expect(! Arrays.equals(c1, c2));
+        expect(! Arrays.equals(i1, i2));
+        expect(! Arrays.equals(l1, l2));
+      }
+    }
+
+    Exception exception = null;
+    try {
+      Arrays.fill(new int[4], 2, 5, 0);
+    } catch (ArrayIndexOutOfBoundsException e) {
+      exception = e;
+    }
+    expect(exception != null);
+  }
+
   public static void main(String[] args) {
     { int[] array = new int[0];
       Exception exception = null;
@@ -202,5 +371,7 @@ public class ArraysTest {
 
     testSort();
     testBinarySearch();
+    testLoops();
+    testFillAndEquals();
   }
 }
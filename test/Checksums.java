@@ -0,0 +1,93 @@
+import java.nio.ByteBuffer;
+import java.util.zip.Adler32;
+import java.util.zip.CRC32;
+import java.util.zip.Checksum;
+
+public class Checksums {
+  private static void expect(boolean v) {
+    if (! v) throw new RuntimeException();
+  }
+
+  private static byte[] ascii(String s) throws Exception {
+    return s.getBytes("UTF-8");
+  }
+
+  // feeds data to c a byte at a time, as a whole array, in pieces, and
+  // via heap and direct buffers, expecting the same result each time:
+  private static void expectChecksum(Checksum c, byte[] data, long expected) {
+    c.reset();
+    for (int i = 0; i < data.length; ++i) {
+      c.update(data[i]);
+    }
+    expect(c.getValue() == expected);
+
+    c.reset();
+    c.update(data, 0, data.length);
+    expect(c.getValue() == expected);
+
+    c.reset();
+    int half = data.length / 2;
+    c.update(data, 0, half);
+    if (half < data.length) {
+      c.update(data[half]);
+      c.update(data, half + 1, data.length - half - 1);
+    }
+    expect(c.getValue() == expected);
+
+    byte[] padded = new byte[data.length + 8];
+    System.arraycopy(data, 0, padded, 3, data.length);
+    ByteBuffer heap = ByteBuffer.wrap(padded, 3, data.length);
+    ByteBuffer direct = ByteBuffer.allocateDirect(data.length + 5);
+    direct.position(5);
+    direct.put(data);
+    direct.position(5);
+
+    for (ByteBuffer b: new ByteBuffer[] { heap, direct }) {
+      int limit = b.limit();
+      c.reset();
+      if (c instanceof CRC32) {
+        ((CRC32) c).update(b);
+      } else {
+        ((Adler32) c).update(b);
+      }
+      expect(c.getValue() == expected);
+      expect(b.position() == limit);
+    }
+  }
+
+  public static void main(String[] args) throws Exception {
+    CRC32 crc = new CRC32();
+    expect(crc.getValue() == 0);
+    expectChecksum(crc, new byte[0], 0);
+    expectChecksum(crc, ascii("123456789"), 0xCBF43926L);
+    expectChecksum
+      (crc, ascii("The quick brown fox jumps over the lazy dog"),
+       0x414FA339L);
+
+    Adler32 adler = new Adler32();
+    expect(adler.getValue() == 1);
+    expectChecksum(adler, new byte[0], 1);
+    expectChecksum(adler, ascii("Wikipedia"), 0x11E60398L);
+
+    // long enough for zlib to take its unrolled and deferred-modulo
+    // paths, with every byte value represented:
+    byte[] big = new byte[100000];
+    for (int i = 0; i < big.length; ++i) {
+      big[i] = (byte) (i * 31 + (i >> 8));
+    }
+    crc.reset();
+    crc.update(big);
+    long bigCrc = crc.getValue();
+    expectChecksum(crc, big, bigCrc);
+
+    adler.reset();
+    adler.update(big);
+    long bigAdler = adler.getValue();
+    expectChecksum(adler, big, bigAdler);
+
+    try {
+      crc.update(big, big.length - 1, 2);
+      expect(false);
+    } catch (ArrayIndexOutOfBoundsException e) { }
+  }
+}
@@ -0,0 +1,70 @@
+import avian.Machine;
+
+public class CollectionRecords {
+  private static void expect(boolean v) {
+    if (! v) throw new RuntimeException();
+  }
+
+  private static Object garbage() {
+    Object[] array = null;
+    for (int i = 0; i < 100000; ++i) {
+      Object[] a = new Object[4];
+      a[0] = array;
+      array = (i % 1000) == 0 ? null : a;
+    }
+    return array;
+  }
+
+  public static void main(String[] args) {
+    garbage();
+    System.gc();
+    garbage();
+    System.gc();
+
+    // allocate these first, lest doing so cause another collection
+    // after we've read the statistics:
+    long[] statistics = new long[Machine.StatisticsSize];
+    long[] records = new long[64 * Machine.RecordSize];
+    long[] one = new long[Machine.RecordSize + 1];
+
+    Machine.collectionStatistics(statistics);
+
+    long collections = statistics[0] + statistics[1];
+    expect(statistics[1] >= 2);
+
+    long causes = 0;
+    for (int i = 9; i < Machine.StatisticsSize; ++i) {
+      causes += statistics[i];
+    }
+    expect(causes == collections);
+
+    int count = Machine.collectionRecords(0, records);
+    expect(count == Math.min(collections, 64));
+
+    long last = collections - count;
+    int majors = 0;
+    for (int i = 0; i < count; ++i) {
+      int r = i * Machine.RecordSize;
+      expect(records[r + Machine.RecordSequence] == last + 1);
+      expect(records[r + Machine.RecordType] == Machine.MinorCollection
+             || records[r + Machine.RecordType] == Machine.MajorCollection);
+      expect(records[r + Machine.RecordPause] >= 0);
+      expect(records[r + Machine.RecordFootprintAfter] > 0);
+      if (records[r + Machine.RecordType] == Machine.MajorCollection) {
+        ++majors;
+      }
+      last = records[r + Machine.RecordSequence];
+    }
+
+    // including the ones we asked for:
+    expect(majors >= 2);
+
+    // only what's new since the given sequence number:
+    expect(Machine.collectionRecords(last, records) == 0);
+    expect(Machine.collectionRecords(last - 1, records) == 1);
+    expect(records[Machine.RecordSequence] == last);
+
+    // and no more than fits:
+    expect(Machine.collectionRecords(0, one) == 1);
+  }
+}
@@ -0,0 +1,137 @@
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.InputStream;
+import java.nio.ByteBuffer;
+import java.util.zip.Deflater;
+import java.util.zip.DeflaterOutputStream;
+import java.util.zip.Inflater;
+import java.util.zip.InflaterInputStream;
+
+public class Compression {
+  private static void expect(boolean v) {
+    if (! v) throw new RuntimeException();
+  }
+
+  private static byte[] data() {
+    byte[] data = new byte[64 * 1024];
+    for (int i = 0; i < data.length; ++i) {
+      data[i] = (byte) ("abcabcxyz".charAt(i % 9) + (i / 4096));
+    }
+    return data;
+  }
+
+  private static void expectEqual(byte[] a, int aOffset, byte[] b,
+                                  int bOffset, int length)
+  {
+    for (int i = 0; i < length; ++i) {
+      expect(a[aOffset + i] == b[bOffset + i]);
+    }
+  }
+
+  private static void testStreams(byte[] data) throws Exception {
+    ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+    DeflaterOutputStream out = new DeflaterOutputStream(bytes);
+    out.write(data, 0, 1000);
+    out.write(data, 1000, data.length - 1000);
+    out.close();
+
+    byte[] compressed = bytes.toByteArray();
+    expect(compressed.length < data.length);
+
+    InputStream in = new InflaterInputStream
+      (new ByteArrayInputStream(compressed));
+    byte[] result = new byte[data.length];
+    int count = 0;
+    int c;
+    while ((c = in.read(result, count, Math.min(777, result.length - count)))
+           > 0)
+    {
+      count += c;
+    }
+    in.close();
+
+    expect(count == data.length);
+    expectEqual(data, 0, result, 0, data.length);
+  }
+
+  // round-trips data through a Deflater and an Inflater using small
+  // buffers of the specified kind, so that each call has to pick up
+  // where the last left off:
+  private static void testBuffers(byte[] data, boolean direct)
+    throws Exception
+  {
+    ByteBuffer input = direct
+      ? ByteBuffer.allocateDirect(data.length)
+      : ByteBuffer.allocate(data.length);
+    input.put(data);
+    input.flip();
+
+    ByteBuffer compressed = ByteBuffer.allocate(data.length);
+    ByteBuffer chunk = direct
+      ? ByteBuffer.allocateDirect(100) : ByteBuffer.allocate(100);
+
+    Deflater deflater = new Deflater();
+    deflater.setInput(input);
+    deflater.finish();
+    while (! deflater.finished()) {
+      chunk.clear();
+      deflater.deflate(chunk);
+      chunk.flip();
+      compressed.put(chunk);
+    }
+    deflater.dispose();
+    expect(! input.hasRemaining());
+    compressed.flip();
+
+    ByteBuffer output = direct
+      ? ByteBuffer.allocateDirect(data.length + 10)
+      : ByteBuffer.allocate(data.length + 10);
+
+    Inflater inflater = new Inflater();
+    inflater.setInput(compressed);
+    while (! inflater.finished()) {
+      ByteBuffer window = output.duplicate();
+      window.limit(Math.min(output.position() + 1000, output.capacity()));
+      output.position(output.position() + inflater.inflate(window));
+    }
+    inflater.dispose();
+    expect(! compressed.hasRemaining());
+    expect(output.position() == data.length);
+
+    output.flip();
+    byte[] result = new byte[data.length];
+    output.get(result);
+    expectEqual(data, 0, result, 0, data.length);
+  }
+
+  private static void testBounds() throws Exception {
+    Inflater inflater = new Inflater();
+    try {
+      inflater.setInput(new byte[10], 5, 6);
+      expect(false);
+    } catch (ArrayIndexOutOfBoundsException e) { }
+
+    inflater.setInput(new byte[10]);
+    try {
+      inflater.inflate(new byte[10], -1, 5);
+      expect(false);
+    } catch (ArrayIndexOutOfBoundsException e) { }
+    inflater.dispose();
+
+    Deflater deflater = new Deflater();
+    deflater.setInput(new byte[10]);
+    try {
+      deflater.deflate(new byte[10], 8, 3);
+      expect(false);
+    } catch (ArrayIndexOutOfBoundsException e) { }
+    deflater.dispose();
+  }
+
+  public static void main(String[] args) throws Exception {
+    byte[] data = data();
+    testStreams(data);
+    testBuffers(data, false);
+    testBuffers(data, true);
+    testBounds();
+  }
+}
@@ -13,7 +13,36 @@ public class ConcurrentHashMapTest {
     if (! v) throw new RuntimeException();
   }
 
+  private static void testResize() {
+    final int count = 10000;
+    ConcurrentMap<Integer, Object> map = new ConcurrentHashMap();
+    for (int i = 0; i < count; ++i) {
+      expect(map.put(i, i) == null);
+    }
+    expect(map.size() == count);
+
+    int seen = 0;
+    for (Map.Entry<Integer, Object> e: map.entrySet()) {
+      expect(e.getKey().equals(e.getValue()));
+      ++ seen;
+    }
+    expect(seen == count);
+
+    for (int i = 0; i < count; i += 2) {
+      expect(map.remove(i).equals(i));
+    }
+    expect(map.size() == count / 2);
+    for (int i = 0; i < count; ++i) {
+      expect(map.containsKey(i) == ((i & 1) != 0));
+    }
+
+    map.clear();
+    expect(map.isEmpty());
+  }
+
   public static void main(String[] args) throws Throwable {
+    testResize();
+
     final ConcurrentMap<Integer, Object> map = new ConcurrentHashMap();
     final int[] counter = new int[1];
     final int[] step = new int[1];
@@ -0,0 +1,77 @@
+import avian.Machine;
+
+public class CriticalRegions {
+  static {
+    System.loadLibrary("test");
+  }
+
+  private static void expect(boolean v) {
+    if (! v) throw new RuntimeException();
+  }
+
+  private static native boolean fill(byte[] array, int rounds);
+
+  private static volatile boolean done;
+
+  private static long collections() {
+    long[] statistics = new long[8];
+    Machine.collectionStatistics(statistics);
+    return statistics[0] + statistics[1];
+  }
+
+  // holds a critical region on an array of the specified length for a
+  // while, with another thread collecting garbage as fast as it can
+  // all the while, and returns whether the native code got a copy:
+  private static boolean storm(int length) throws Exception {
+    byte[] array = new byte[length];
+    for (int i = 0; i < length; ++i) {
+      array[i] = (byte) (i * 7);
+    }
+
+    done = false;
+    Thread collector = new Thread() {
+        public void run() {
+          while (! done) {
+            for (int i = 0; i < 1000; ++i) {
+              new Object[8].hashCode();
+            }
+            System.gc();
+          }
+        }
+      };
+    collector.start();
+
+    // give the collector a head start:
+    long start = collections();
+    while (collections() < start + 2) {
+      Thread.sleep(1);
+    }
+
+    int rounds = (64 * 1024 * 1024) / length;
+    long before = collections();
+    boolean isCopy = fill(array, rounds);
+    long during = collections() - before;
+
+    done = true;
+    collector.join();
+
+    // the collector should not have had to wait for us to finish:
+    expect(during >= 4);
+
+    // whatever the native code wrote should have made it back,
+    // whether or not the array moved in the meantime:
+    for (int i = 0; i < length; ++i) {
+      expect(array[i] == (byte) ((i * 7) + (i * rounds)));
+    }
+
+    return isCopy;
+  }
+
+  public static void main(String[] args) throws Exception {
+    // small arrays may move, so they're copied...
+    expect(storm(4 * 1024));
+
+    // ...but big ones are fixed in place, so they need not be:
+    expect(! storm(1024 * 1024));
+  }
+}
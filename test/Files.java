@@ -1,6 +1,11 @@
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
 import java.io.File;
 import java.io.FileInputStream;
 import java.io.FileOutputStream;
+import java.io.RandomAccessFile;
+import java.nio.channels.Channels;
+import java.nio.channels.FileChannel;
 
 public class Files {
   private static final boolean IsWindows
@@ -53,7 +58,158 @@ public class Files {
     }
   }
   
+  private static byte[] data(int length) {
+    byte[] data = new byte[length];
+    for (int i = 0; i < length; ++i) {
+      data[i] = (byte) ((i * 7) + (i >> 9));
+    }
+    return data;
+  }
+
+  private static void writeFile(File f, byte[] data) throws Exception {
+    FileOutputStream out = new FileOutputStream(f);
+    try {
+      out.write(data, 0, 1000);
+      out.write(data, 1000, data.length - 1000);
+    } finally {
+      out.close();
+    }
+  }
+
+  private static void expectFile(File f, byte[] data) throws Exception {
+    FileInputStream in = new FileInputStream(f);
+    try {
+      byte[] result = new byte[data.length + 10];
+      int offset = 5;
+      int c;
+      while (offset < result.length
+             && (c = in.read
+                 (result, offset, Math.min(4096, result.length - offset)))
+             > 0)
+      {
+        offset += c;
+      }
+      expect(offset - 5 == data.length);
+
+      for (int i = 0; i < data.length; ++i) {
+        expect(result[i + 5] == data[i]);
+      }
+    } finally {
+      in.close();
+    }
+  }
+
+  private static void readWriteArraysTest(int length) throws Exception {
+    byte[] data = data(length);
+    File f = new File("test.bin");
+    try {
+      writeFile(f, data);
+      expect(f.length() == data.length);
+      expectFile(f, data);
+    } finally {
+      f.delete();
+    }
+  }
+
+  private static void boundsTest() throws Exception {
+    byte[] data = data(16);
+    File f = new File("test.bin");
+    try {
+      FileOutputStream out = new FileOutputStream(f);
+      try {
+        int[][] ranges = { { -1, 4 }, { 4, -1 }, { 8, 9 },
+                           { 1, Integer.MAX_VALUE } };
+        for (int[] range: ranges) {
+          try {
+            out.write(data, range[0], range[1]);
+            expect(false);
+          } catch (IndexOutOfBoundsException e) { }
+        }
+        out.write(data, 0, data.length);
+      } finally {
+        out.close();
+      }
+
+      FileInputStream in = new FileInputStream(f);
+      try {
+        int[][] ranges = { { 4, -1 }, { 1, Integer.MAX_VALUE } };
+        for (int[] range: ranges) {
+          try {
+            in.read(data, range[0], range[1]);
+            expect(false);
+          } catch (IndexOutOfBoundsException e) { }
+        }
+        expect(in.read(data, 0, data.length) == data.length);
+      } finally {
+        in.close();
+      }
+    } finally {
+      f.delete();
+    }
+  }
+
+  private static void transferTest() throws Exception {
+    byte[] data = data(100000);
+    File a = new File("test-a.bin");
+    File b = new File("test-b.bin");
+    try {
+      writeFile(a, data);
+
+      RandomAccessFile in = new RandomAccessFile(a, "r");
+      RandomAccessFile out = new RandomAccessFile(b, "rw");
+      try {
+        FileChannel inChannel = in.getChannel();
+        FileChannel outChannel = out.getChannel();
+
+        // file to file, in two pieces:
+        long n = inChannel.transferTo(0, 1000, outChannel);
+        expect(n == 1000);
+        while (n < data.length) {
+          n += inChannel.transferTo(n, data.length - n, outChannel);
+        }
+        expect(outChannel.position() == data.length);
+        expect(inChannel.position() == 0);
+
+        // file to anything else:
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        expect(inChannel.transferTo
+               (10, 500, Channels.newChannel(bytes)) == 500);
+        byte[] copy = bytes.toByteArray();
+        for (int i = 0; i < 500; ++i) {
+          expect(copy[i] == data[10 + i]);
+        }
+
+        // anything else to file, past the end:
+        expect(outChannel.transferFrom
+               (Channels.newChannel(new ByteArrayInputStream(data)),
+                data.length, data.length) == data.length);
+
+        // file to file, from the source's current position:
+        inChannel.position(data.length - 3);
+        expect(outChannel.transferFrom(inChannel, data.length * 2, 10) == 3);
+        expect(inChannel.position() == data.length);
+      } finally {
+        in.close();
+        out.close();
+      }
+
+      byte[] expected = new byte[(data.length * 2) + 3];
+      System.arraycopy(data, 0, expected, 0, data.length);
+      System.arraycopy(data, 0, expected, data.length, data.length);
+      System.arraycopy(data, data.length - 3, expected, data.length * 2, 3);
+      expectFile(b, expected);
+    } finally {
+      a.delete();
+      b.delete();
+    }
+  }
+
   public static void main(String[] args) throws Exception {
+    // big enough to be allocated as a fixed object, and not:
+    readWriteArraysTest(100000);
+    readWriteArraysTest(20000);
+    boundsTest();
+    transferTest();
     isAbsoluteTest(true);
     isAbsoluteTest(false);
     setExecutableTestWithPermissions(true);
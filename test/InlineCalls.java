@@ -0,0 +1,93 @@
+public class InlineCalls {
+  private int count;
+  private long total;
+  private byte small;
+  private Object last;
+
+  private static int hits;
+
+  private static void expect(boolean v) {
+    if (! v) throw new RuntimeException();
+  }
+
+  private static int square(int v) {
+    return v * v;
+  }
+
+  private static int mix(int a, int b) {
+    int t = a ^ b;
+    return (t << 3) - (b >>> 1) + 7;
+  }
+
+  private static long widen(int v, long w) {
+    return (v + w) & 0xFFFFFFFFFFL;
+  }
+
+  private static int narrow(long v) {
+    return (short) (int) v;
+  }
+
+  private static void hit() {
+    ++ hits;
+  }
+
+  private int next() {
+    return count++;
+  }
+
+  private void add(long v) {
+    total += v + count;
+  }
+
+  private void setSmall(int v) {
+    small = (byte) v;
+  }
+
+  private void remember(Object o) {
+    last = o;
+  }
+
+  public final long offset(int v) {
+    return total + v;
+  }
+
+  public static void main(String[] args) {
+    expect(square(7) == 49);
+    expect(square(-3) == 9);
+    expect(mix(5, 12) == 73);
+    expect(widen(-1, 2L) == 1L);
+    expect(widen(Integer.MAX_VALUE, 1L) == 0x80000000L);
+    expect(narrow(0x12345678L) == 0x5678);
+    expect(narrow(0xFFFFL) == -1);
+
+    for (int i = 0; i < 5; ++i) {
+      hit();
+    }
+    expect(hits == 5);
+
+    InlineCalls c = new InlineCalls();
+    for (int i = 0; i < 10; ++i) {
+      expect(c.next() == i);
+      c.add(i);
+    }
+    expect(c.count == 10);
+    expect(c.total == 100);
+    expect(c.offset(3) == 103);
+
+    c.setSmall(0x1ff);
+    expect(c.small == -1);
+
+    Object o = new Object();
+    c.remember(o);
+    expect(c.last == o);
+    c.remember(null);
+    expect(c.last == null);
+
+    try {
+      ((InlineCalls) null).next();
+      throw new RuntimeException();
+    } catch (NullPointerException e) {
+      // cool
+    }
+  }
+}
@@ -64,6 +64,31 @@ public class Integers {
     }
   }
 
+  private static void testPowersOfTwo(int eight, int one) {
+    // eight and one are passed in so they aren't known to be constant;
+    // compare with the same operations on constants, which the
+    // optimizing tier reduces to shifts and masks or folds away:
+    int[] values = { 0, 1, -1, 7, -7, 8, -8, 9, -9, 123456789, -123456789,
+                     Integer.MAX_VALUE, Integer.MIN_VALUE };
+    for (int i = 0; i < values.length; ++i) {
+      int v = values[i];
+      expect(v / 8 == v / eight);
+      expect(v % 8 == v % eight);
+      expect(v * 8 == v * eight);
+      expect(v / -8 == v / -eight);
+      expect(v % -8 == v % -eight);
+      expect(v / 1 == v / one);
+      expect(v / -1 == v / -one);
+      expect(v % -1 == v % -one);
+      expect(v * -1 == v * -one);
+      expect((v + 0) == (v + one - one));
+      expect((v & -1) == (v & -one));
+      expect((v >> 32) == (v >> (eight * 4)));
+      expect((v + 3) * (v + 3) == (v + 3 * one) * (v + 3 * one));
+      expect(values.length + values.length == values.length * 2);
+    }
+  }
+
   public static void main(String[] args) throws Exception {
     { int foo = 1028;
       foo -= 1023;
@@ -366,5 +391,7 @@ public class Integers {
     expect(291 == Integer.decode("#123").intValue());
 
     testNumberOfLeadingZeros();
+
+    testPowersOfTwo(8, 1);
   }
 }
@@ -76,6 +76,24 @@ public class Longs {
     }
   }
 
+  private static void testPowersOfTwo(long sixteen, long one) {
+    // see Integers.testPowersOfTwo
+    long[] values = { 0, 1, -1, 15, -15, 16, -16, 17, -17, 0x123456789ABCL,
+                      -0x123456789ABCL, Long.MAX_VALUE, Long.MIN_VALUE };
+    for (int i = 0; i < values.length; ++i) {
+      long v = values[i];
+      expect(v / 16 == v / sixteen);
+      expect(v % 16 == v % sixteen);
+      expect(v * 16 == v * sixteen);
+      expect(v / 0x100000000L == v / (sixteen << 28));
+      expect(v % 0x100000000L == v % (sixteen << 28));
+      expect(v / -1 == v / -one);
+      expect(v % -1 == v % -one);
+      expect((v ^ 0) == (v ^ (one - one)));
+      expect((v << 64) == (v << (int) (sixteen * 4)));
+    }
+  }
+
   public static void main(String[] args) throws Exception {
     expect(volatileLong == getConstant());
 
@@ -389,6 +407,8 @@ public class Longs {
     { long b = 0xFFFFFFFFFFFFFFFFL; int s = 20;
       expect((b >>> -s) == 0xFFFFF);
     }
+
+    testPowersOfTwo(16, 1);
   }
 
 }
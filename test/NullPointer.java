@@ -2,6 +2,18 @@ public class NullPointer {
   private int x;
   private Object y;
 
+  private int getX() {
+    return x;
+  }
+
+  private void setY(Object y) {
+    this.y = y;
+  }
+
+  public final int twice(int v) {
+    return v + v;
+  }
+
   private static void throw_(Object o) {
     o.toString();
   }
@@ -119,6 +131,30 @@ public class NullPointer {
       e.printStackTrace();
     }
 
+    // inlined getter
+    try {
+      int a = ((NullPointer) null).getX();
+      throw new RuntimeException();
+    } catch (NullPointerException e) {
+      e.printStackTrace();
+    }
+
+    // inlined setter
+    try {
+      ((NullPointer) null).setY(null);
+      throw new RuntimeException();
+    } catch (NullPointerException e) {
+      e.printStackTrace();
+    }
+
+    // final method which never dereferences its receiver
+    try {
+      ((NullPointer) null).twice(1);
+      throw new RuntimeException();
+    } catch (NullPointerException e) {
+      e.printStackTrace();
+    }
+
     // monitorenter
     try {
       synchronized ((Object) null) {
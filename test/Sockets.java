@@ -1,5 +1,9 @@
 import java.net.SocketAddress;
 import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.channels.SelectionKey;
+import java.nio.channels.Selector;
+import java.nio.channels.ServerSocketChannel;
 import java.nio.channels.SocketChannel;
 import java.io.IOException;
 
@@ -27,7 +31,145 @@ public class Sockets {
     }
   }
 
+  private static void fill(ByteBuffer[] buffers, byte start) {
+    for (ByteBuffer b: buffers) {
+      while (b.hasRemaining()) {
+        b.put(start++);
+      }
+      b.flip();
+    }
+  }
+
+  private static void check(ByteBuffer[] buffers, byte start) {
+    for (ByteBuffer b: buffers) {
+      b.flip();
+      while (b.hasRemaining()) {
+        expect(b.get() == start++);
+      }
+    }
+  }
+
+  private static long remaining(ByteBuffer[] buffers) {
+    long total = 0;
+    for (ByteBuffer b: buffers) {
+      total += b.remaining();
+    }
+    return total;
+  }
+
+  public static void testDirectBuffers() throws Exception {
+    final int Port = 22047;
+    final SocketAddress Address = new InetSocketAddress("127.0.0.1", Port);
+
+    ServerSocketChannel server = ServerSocketChannel.open();
+    try {
+      server.socket().bind(Address);
+
+      SocketChannel out = SocketChannel.open();
+      try {
+        out.connect(Address);
+        SocketChannel in = server.accept();
+        try {
+          // one direct buffer at a time:
+          ByteBuffer[] src = new ByteBuffer[] {
+            ByteBuffer.allocateDirect(1000) };
+          ByteBuffer[] dst = new ByteBuffer[] {
+            ByteBuffer.allocateDirect(1000) };
+          fill(src, (byte) 0);
+          while (src[0].hasRemaining()) {
+            out.write(src[0]);
+          }
+          while (dst[0].hasRemaining()) {
+            expect(in.read(dst[0]) > 0);
+          }
+          check(dst, (byte) 0);
+
+          // gathered from and scattered to several, including an
+          // empty one:
+          src = new ByteBuffer[] { ByteBuffer.allocateDirect(100),
+                                   ByteBuffer.allocateDirect(0),
+                                   ByteBuffer.allocateDirect(3000) };
+          dst = new ByteBuffer[] { ByteBuffer.allocateDirect(1500),
+                                   ByteBuffer.allocateDirect(1600) };
+          fill(src, (byte) 42);
+          while (remaining(src) != 0) {
+            expect(out.write(src) > 0);
+          }
+          while (remaining(dst) != 0) {
+            expect(in.read(dst) > 0);
+          }
+          check(dst, (byte) 42);
+
+          // and heap buffers mixed in with direct ones:
+          src = new ByteBuffer[] { ByteBuffer.allocate(700),
+                                   ByteBuffer.allocateDirect(300) };
+          dst = new ByteBuffer[] { ByteBuffer.allocateDirect(500),
+                                   ByteBuffer.allocate(500) };
+          fill(src, (byte) 7);
+          while (remaining(src) != 0) {
+            expect(out.write(src) > 0);
+          }
+          while (remaining(dst) != 0) {
+            expect(in.read(dst) > 0);
+          }
+          check(dst, (byte) 7);
+
+          out.close();
+          dst[0].clear();
+          expect(in.read(dst) == -1);
+        } finally {
+          in.close();
+        }
+      } finally {
+        out.close();
+      }
+    } finally {
+      server.close();
+    }
+  }
+
+  // A key whose interest set is empty must not be reported, nor wake
+  // the selector, even after its peer has hung up:
+  public static void testPausedKeyAfterHangup() throws Exception {
+    final int Port = 22048;
+    final SocketAddress Address = new InetSocketAddress("127.0.0.1", Port);
+
+    ServerSocketChannel server = ServerSocketChannel.open();
+    Selector selector = Selector.open();
+    try {
+      server.socket().bind(Address);
+
+      SocketChannel out = SocketChannel.open();
+      out.connect(Address);
+      SocketChannel in = server.accept();
+      try {
+        in.configureBlocking(false);
+        SelectionKey key = in.register(selector, SelectionKey.OP_READ, null);
+
+        out.close();
+        expect(selector.select(5000) == 1);
+        expect(key.isReadable());
+
+        key.interestOps(0);
+        long start = System.currentTimeMillis();
+        expect(selector.select(500) == 0);
+        expect(System.currentTimeMillis() - start >= 400);
+
+        key.interestOps(SelectionKey.OP_READ);
+        expect(selector.select(5000) == 1);
+        expect(key.isReadable());
+      } finally {
+        in.close();
+      }
+    } finally {
+      selector.close();
+      server.close();
+    }
+  }
+
   public static void main(String[] args) throws Exception {
     testFailedBind();
+    testDirectBuffers();
+    testPausedKeyAfterHangup();
   }
 }
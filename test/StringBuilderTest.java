@@ -6,6 +6,10 @@ public class StringBuilderTest {
     verifyAppendStrLength();
     verifyAppendCharLength();
     verifySubstring();
+    verifyEditing();
+    verifyNonAscii();
+    verifyNumbers();
+    verifyToStringThenModify();
   }
   
   private static void verify(String srcStr, int iterations, String result) {
@@ -62,4 +66,103 @@ public class StringBuilderTest {
     String endSubString = sb.substring(fooStr.length());
     verify(fooStr, endSubString);
   }
+
+  private static void verifyEditing() {
+    StringBuilder sb = new StringBuilder("hello world");
+    sb.insert(5, ",");
+    verify("hello, world", sb.toString());
+    sb.insert(0, ">> ").insert(sb.length(), '!');
+    verify(">> hello, world!", sb.toString());
+    sb.delete(0, 3);
+    verify("hello, world!", sb.toString());
+    sb.deleteCharAt(5);
+    verify("hello world!", sb.toString());
+    sb.replace(6, 11, "there");
+    verify("hello there!", sb.toString());
+    sb.setCharAt(0, 'H');
+    verify("Hello there!", sb.toString());
+    verify("there", sb.substring(6, 11));
+
+    sb.setLength(5);
+    verify("Hello", sb.toString());
+    sb.setLength(7);
+    verify("Hello\0\0", sb.toString());
+
+    if (sb.indexOf("llo") != 2 || sb.lastIndexOf("l") != 3) {
+      throw new IllegalStateException();
+    }
+
+    sb.ensureCapacity(1000);
+    if (sb.capacity() < 1000) {
+      throw new IllegalStateException();
+    }
+    verify("Hello\0\0", sb.toString());
+  }
+
+  private static void verifyNonAscii() {
+    StringBuilder sb = new StringBuilder();
+    sb.append("abc");
+    sb.append('\u00e9');
+    sb.append("def");
+    verify("abc\u00e9def", sb.toString());
+    if (sb.charAt(3) != '\u00e9' || sb.length() != 7) {
+      throw new IllegalStateException();
+    }
+
+    sb = new StringBuilder("abcdef");
+    sb.insert(3, "\u03bb\u03bc");
+    verify("abc\u03bb\u03bcdef", sb.toString());
+
+    sb = new StringBuilder("abc");
+    sb.append(new char[] { 'd', '\u2603', 'e' });
+    verify("abcd\u2603e", sb.toString());
+
+    sb = new StringBuilder("abc");
+    sb.setCharAt(1, '\u00fc');
+    verify("a\u00fcc", sb.toString());
+
+    char[] dst = new char[3];
+    sb.getChars(0, 3, dst, 0);
+    verify("a\u00fcc", new String(dst));
+  }
+
+  private static void verifyNumbers() {
+    StringBuilder sb = new StringBuilder();
+    sb.append(0).append(' ').append(-1).append(' ').append(42)
+      .append(' ').append(Integer.MIN_VALUE).append(' ')
+      .append(Integer.MAX_VALUE).append(' ').append(Long.MIN_VALUE)
+      .append(' ').append(Long.MAX_VALUE);
+    verify("0 -1 42 -2147483648 2147483647 -9223372036854775808 "
+           + "9223372036854775807", sb.toString());
+  }
+
+  private static void verifyToStringThenModify() {
+    // fill the builder exactly, so that toString shares its buffer:
+    StringBuilder sb = new StringBuilder(6);
+    sb.append("foobar");
+    String s = sb.toString();
+
+    sb.setCharAt(0, 'g');
+    sb.append("baz");
+    verify("foobar", s);
+    verify("goobarbaz", sb.toString());
+
+    sb = new StringBuilder(3);
+    sb.append("abc");
+    s = sb.toString();
+    sb.delete(0, 1);
+    verify("abc", s);
+    verify("bc", sb.toString());
+
+    sb = new StringBuilder(3);
+    sb.append("abc");
+    s = sb.toString();
+    sb.insert(0, '\u00e9');
+    verify("abc", s);
+    verify("\u00e9abc", sb.toString());
+
+    if (! s.equals("abc") || s.hashCode() != "abc".hashCode()) {
+      throw new IllegalStateException();
+    }
+  }
 }
@@ -114,6 +114,89 @@ public class Strings {
     expect("\0078".matches("\\078"));
   }
 
+  private static int referenceHash(String s) {
+    int h = 0;
+    for (int i = 0; i < s.length(); ++i) {
+      h = (h * 31) + s.charAt(i);
+    }
+    return h;
+  }
+
+  private static int referenceIndexOf(String s, String pattern, int start) {
+    for (int i = Math.max(start, 0); i + pattern.length() <= s.length(); ++i) {
+      int j = 0;
+      while (j < pattern.length() && s.charAt(i + j) == pattern.charAt(j)) {
+        ++j;
+      }
+      if (j == pattern.length()) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  // Strings may be backed by either byte or char arrays, and their
+  // equals, hashCode, compareTo, and indexOf methods are vectorized,
+  // so we try each combination at lengths on either side of the
+  // vector widths:
+  public static void testKernels() throws Exception {
+    java.util.Random random = new java.util.Random(42);
+
+    for (int length = 0; length < 80; ++length) {
+      byte[] bytes = new byte[length];
+      for (int i = 0; i < length; ++i) {
+        bytes[i] = (byte) ('a' + random.nextInt(3));
+      }
+
+      String narrow = new String(bytes, "UTF-8");
+      String wide = new String(narrow.toCharArray());
+      String offset = ("xyz" + narrow + "xyz").substring(3, 3 + length);
+      String unicode = narrow + "\u00ae\u2665";
+
+      String[] strings = new String[] { narrow, wide, offset };
+      for (String a: strings) {
+        expect(a.hashCode() == referenceHash(a));
+
+        for (String b: strings) {
+          expect(a.equals(b));
+          expect(a.compareTo(b) == 0);
+        }
+
+        expect(! a.equals(unicode));
+        expect(a.compareTo(unicode) < 0);
+        expect(unicode.compareTo(a) > 0);
+        expect(unicode.hashCode() == referenceHash(unicode));
+        expect(unicode.indexOf(a) == 0);
+        expect(unicode.indexOf('\u2665') == length + 1);
+        expect(a.indexOf('\u2665') == -1);
+
+        if (length > 0) {
+          char[] chars = a.toCharArray();
+          chars[length - 1] = 'd';
+          String changed = new String(chars);
+          expect(! a.equals(changed));
+          expect(a.compareTo(changed) < 0);
+          expect(changed.compareTo(a) > 0);
+          expect(a.indexOf('d') == -1);
+          expect(changed.indexOf('d') == length - 1);
+          expect(changed.indexOf("d") == length - 1);
+        }
+
+        for (int start = -1; start <= length; ++start) {
+          for (int n = 0; n < 4 && start + n <= length; ++n) {
+            String pattern = a.substring(Math.max(start, 0),
+                                         Math.max(start, 0) + n);
+            expect(a.indexOf(pattern, start) == referenceIndexOf
+                   (a, pattern, start));
+            expect(a.indexOf(new String(pattern.toCharArray()), 0)
+                   == referenceIndexOf(a, pattern, 0));
+          }
+          expect(a.indexOf('b', start) == referenceIndexOf(a, "b", start));
+        }
+      }
+    }
+  }
+
   public static void main(String[] args) throws Exception {
     expect(new String(new byte[] { 99, 111, 109, 46, 101, 99, 111, 118, 97,
                                    116, 101, 46, 110, 97, 116, 46, 98, 117,
@@ -221,6 +304,8 @@ public class Strings {
 
     testTrivialPattern();
 
+    testKernels();
+
     { String s = "hello, world!";
       java.nio.CharBuffer buffer = java.nio.CharBuffer.allocate(s.length());
       new java.io.InputStreamReader
@@ -49,6 +49,83 @@ public class Threads implements Runnable {
       thread.join();
     }
 
+    { final Object lock = new Object();
+      final int[] counter = new int[1];
+      final int threadCount = 4;
+      final int iterations = 10000;
+      Thread[] threads = new Thread[threadCount];
+      for (int i = 0; i < threadCount; ++i) {
+        threads[i] = new Thread() {
+            public void run() {
+              for (int j = 0; j < iterations; ++j) {
+                synchronized (lock) {
+                  synchronized (lock) {
+                    ++ counter[0];
+                  }
+                }
+              }
+            }
+          };
+        threads[i].start();
+      }
+
+      for (int i = 0; i < threadCount; ++i) {
+        threads[i].join();
+      }
+
+      expect(counter[0] == threadCount * iterations);
+      expect(! Thread.holdsLock(lock));
+    }
+
+    { final Object lock = new Object();
+      synchronized (lock) {
+        synchronized (lock) {
+          expect(Thread.holdsLock(lock));
+          lock.notify();
+          lock.wait(1);
+          expect(Thread.holdsLock(lock));
+        }
+        expect(Thread.holdsLock(lock));
+      }
+      expect(! Thread.holdsLock(lock));
+    }
+
+    { // more objects than there are thin lock table slots, so that
+      // distinct objects share slots:
+      final Object[] locks = new Object[4096];
+      for (int i = 0; i < locks.length; ++i) {
+        locks[i] = new Object();
+      }
+      final int[] counters = new int[locks.length];
+      final int threadCount = 4;
+      Thread[] threads = new Thread[threadCount];
+      for (int i = 0; i < threadCount; ++i) {
+        threads[i] = new Thread() {
+            public void run() {
+              for (int j = 0; j < 10; ++j) {
+                for (int k = 0; k < locks.length; ++k) {
+                  synchronized (locks[k]) {
+                    synchronized (locks[(k * 1025) % locks.length]) {
+                      ++ counters[k];
+                    }
+                  }
+                }
+              }
+            }
+          };
+        threads[i].start();
+      }
+
+      for (int i = 0; i < threadCount; ++i) {
+        threads[i].join();
+      }
+
+      for (int i = 0; i < locks.length; ++i) {
+        expect(counters[i] == threadCount * 10);
+        expect(! Thread.holdsLock(locks[i]));
+      }
+    }
+
     System.out.println("finished; success? " + success);
 
     if (! success) {
@@ -0,0 +1,97 @@
+package extra;
+
+import avian.Machine;
+
+public class Allocation {
+  private static final int Iterations = 2000000;
+
+  private static final class Node {
+    public final int value;
+    public final Node next;
+
+    public Node(int value, Node next) {
+      this.value = value;
+      this.next = next;
+    }
+  }
+
+  private static class Worker implements Runnable {
+    private final int iterations;
+    public final long[] statistics = new long[3];
+    public long elapsed;
+    public int result;
+
+    public Worker(int iterations) {
+      this.iterations = iterations;
+    }
+
+    public void run() {
+      long[] before = new long[3];
+      Machine.allocationStatistics(before);
+
+      long start = System.currentTimeMillis();
+      Node list = null;
+      int sum = 0;
+      for (int i = 0; i < iterations; ++i) {
+        // keep a short tail alive so not everything dies immediately:
+        list = new Node(i, (i & 63) == 0 ? null : list);
+        sum += list.value + new int[i & 15].length;
+      }
+      elapsed = System.currentTimeMillis() - start;
+      result = sum;
+
+      Machine.allocationStatistics(statistics);
+      statistics[0] -= before[0];
+      statistics[1] -= before[1];
+    }
+  }
+
+  private static void run(int threadCount) throws Exception {
+    Worker[] workers = new Worker[threadCount];
+    Thread[] threads = new Thread[threadCount];
+    for (int i = 0; i < threadCount; ++i) {
+      workers[i] = new Worker(Iterations);
+      threads[i] = new Thread(workers[i]);
+    }
+
+    long start = System.currentTimeMillis();
+    for (int i = 0; i < threadCount; ++i) {
+      threads[i].start();
+    }
+    for (int i = 0; i < threadCount; ++i) {
+      threads[i].join();
+    }
+    long elapsed = System.currentTimeMillis() - start;
+
+    long bytes = 0;
+    long refills = 0;
+    for (int i = 0; i < threadCount; ++i) {
+      bytes += workers[i].statistics[0];
+      refills += workers[i].statistics[1];
+    }
+
+    System.out.println
+      (threadCount + " thread(s): " + elapsed + " ms, "
+       + (elapsed == 0 ? 0 : (bytes / 1024) / elapsed) + " KB/ms, "
+       + refills + " refills ("
+       + (bytes == 0 ? 0 : (refills * 1024 * 1024) / bytes)
+       + " per MB allocated)");
+
+    for (int i = 0; i < threadCount; ++i) {
+      System.out.println
+        ("  thread " + i + ": " + workers[i].elapsed + " ms, "
+         + (workers[i].statistics[0] / 1024) + " KB allocated, "
+         + workers[i].statistics[1] + " refills, final heap size "
+         + (workers[i].statistics[2] / 1024) + " KB");
+    }
+  }
+
+  public static void main(String[] args) throws Exception {
+    // warm up:
+    new Worker(Iterations / 10).run();
+
+    for (int threadCount = 1; threadCount <= 8; threadCount *= 2) {
+      run(threadCount);
+    }
+  }
+}
@@ -0,0 +1,87 @@
+package extra;
+
+public class Arithmetic {
+  private static final int Size = 4096;
+  private static final int Iterations = 20000;
+
+  // division and remainder by powers of two, which the optimizing tier
+  // turns into shifts and masks:
+  private static int buckets(int[] array) {
+    int sum = 0;
+    for (int i = 0; i < array.length; ++i) {
+      int v = array[i];
+      sum += (v / 16) + (v % 64) + (v * 8);
+    }
+    return sum;
+  }
+
+  private static long longBuckets(long[] array) {
+    long sum = 0;
+    for (int i = 0; i < array.length; ++i) {
+      long v = array[i];
+      sum += (v / 16) + (v % 64);
+    }
+    return sum;
+  }
+
+  // repeated subexpressions within a block:
+  private static int distances(int[] xs, int[] ys) {
+    int sum = 0;
+    for (int i = 0; i < xs.length; ++i) {
+      int x = xs[i];
+      int y = ys[i];
+      sum += (x - y) * (x - y) + (x + y) * (x + y) + xs.length - ys.length;
+    }
+    return sum;
+  }
+
+  private static void report(String name, long start, long elements) {
+    long elapsed = System.currentTimeMillis() - start;
+    System.out.println
+      (name + ": " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : elements / elapsed) + " elements/ms)");
+  }
+
+  public static void main(String[] args) {
+    int[] ints = new int[Size];
+    int[] others = new int[Size];
+    long[] longs = new long[Size];
+    for (int i = 0; i < Size; ++i) {
+      ints[i] = (i & 1) == 0 ? i * 31 : -i * 17;
+      others[i] = i ^ 0x5555;
+      longs[i] = ((long) ints[i]) << 20;
+    }
+
+    long elements = (long) Size * Iterations;
+    long result = 0;
+
+    System.out.println
+      ("optimize: " + System.getProperty("avian.optimize")
+       + ", tiered: " + System.getProperty("avian.tiered"));
+
+    // warm up (and, with avian.tiered, reach tier two):
+    for (int i = 0; i < Iterations / 10; ++i) {
+      result += buckets(ints) + longBuckets(longs) + distances(ints, others);
+    }
+
+    long start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      result += buckets(ints);
+    }
+    report("int division", start, elements);
+
+    start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      result += longBuckets(longs);
+    }
+    report("long division", start, elements);
+
+    start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      result += distances(ints, others);
+    }
+    report("subexpressions", start, elements);
+
+    System.out.println("(" + result + ")");
+  }
+}
@@ -0,0 +1,123 @@
+package extra;
+
+public class ArrayLoops {
+  private static final int Size = 4096;
+  private static final int Iterations = 20000;
+
+  private static int sum(int[] array) {
+    int sum = 0;
+    for (int i = 0; i < array.length; ++i) {
+      sum += array[i];
+    }
+    return sum;
+  }
+
+  private static int sumEach(int[] array) {
+    int sum = 0;
+    for (int v: array) {
+      sum += v;
+    }
+    return sum;
+  }
+
+  private static void fill(byte[] array, byte value) {
+    for (int i = 0; i < array.length; ++i) {
+      array[i] = value;
+    }
+  }
+
+  private static void scale(long[] array, long factor) {
+    for (int i = 0; i < array.length; ++i) {
+      array[i] *= factor;
+    }
+  }
+
+  private static double dot(double[] a, double[] b) {
+    double sum = 0;
+    for (int i = 0; i < a.length; ++i) {
+      sum += a[i] * b[i];
+    }
+    return sum;
+  }
+
+  private static int count(Object[] array) {
+    int count = 0;
+    for (int i = 0; i < array.length; ++i) {
+      if (array[i] != null) {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  private static void report(String name, long start, long elements) {
+    long elapsed = System.currentTimeMillis() - start;
+    System.out.println
+      (name + ": " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : elements / elapsed) + " elements/ms)");
+  }
+
+  public static void main(String[] args) {
+    int[] ints = new int[Size];
+    byte[] bytes = new byte[Size];
+    long[] longs = new long[Size];
+    double[] doubles = new double[Size];
+    Object[] objects = new Object[Size];
+    for (int i = 0; i < Size; ++i) {
+      ints[i] = i;
+      longs[i] = i;
+      doubles[i] = i;
+      objects[i] = (i & 1) == 0 ? null : ints;
+    }
+
+    long elements = (long) Size * Iterations;
+    int result = 0;
+
+    // warm up:
+    for (int i = 0; i < Iterations / 10; ++i) {
+      result += sum(ints) + sumEach(ints) + count(objects)
+        + (int) dot(doubles, doubles);
+      fill(bytes, (byte) i);
+      scale(longs, 1);
+    }
+
+    long start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      result += sum(ints);
+    }
+    report("sum", start, elements);
+
+    start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      result += sumEach(ints);
+    }
+    report("for each", start, elements);
+
+    start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      fill(bytes, (byte) i);
+    }
+    report("fill", start, elements);
+
+    start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      scale(longs, 1);
+    }
+    report("scale", start, elements);
+
+    start = System.currentTimeMillis();
+    double d = 0;
+    for (int i = 0; i < Iterations; ++i) {
+      d += dot(doubles, doubles);
+    }
+    report("dot", start, elements);
+
+    start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      result += count(objects);
+    }
+    report("count", start, elements);
+
+    System.out.println("(" + result + ", " + d + ")");
+  }
+}
@@ -0,0 +1,75 @@
+package extra;
+
+import java.nio.ByteBuffer;
+import java.util.zip.Adler32;
+import java.util.zip.CRC32;
+import java.util.zip.Checksum;
+
+public class ChecksumThroughput {
+  private static final long BytesPerRun = 1024L * 1024 * 1024;
+  private static final int[] Sizes = { 64, 4096, 1024 * 1024 };
+
+  private static void update(Checksum c, ByteBuffer b) {
+    if (c instanceof CRC32) {
+      ((CRC32) c).update(b);
+    } else {
+      ((Adler32) c).update(b);
+    }
+  }
+
+  private static void report(String name, int size, long bytes,
+                             long elapsed, long value)
+  {
+    System.out.println
+      ("  " + name + ", " + size + " byte chunks: " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : (bytes / (1024 * 1024)) * 1000 / elapsed)
+       + " MB/s) (" + Long.toHexString(value) + ")");
+  }
+
+  private static void run(Checksum c, String name) {
+    System.out.println(name + ":");
+
+    for (int size: Sizes) {
+      byte[] array = new byte[size];
+      for (int i = 0; i < size; ++i) {
+        array[i] = (byte) i;
+      }
+      long rounds = BytesPerRun / size;
+
+      c.reset();
+      long start = System.currentTimeMillis();
+      for (long i = 0; i < rounds; ++i) {
+        c.update(array, 0, size);
+      }
+      report("byte[]", size, rounds * size,
+             System.currentTimeMillis() - start, c.getValue());
+
+      ByteBuffer direct = ByteBuffer.allocateDirect(size);
+      direct.put(array);
+
+      c.reset();
+      start = System.currentTimeMillis();
+      for (long i = 0; i < rounds; ++i) {
+        direct.clear();
+        update(c, direct);
+      }
+      report("direct buffer", size, rounds * size,
+             System.currentTimeMillis() - start, c.getValue());
+    }
+
+    // single bytes are still handled in Java, so measure less of them:
+    long count = BytesPerRun / 16;
+    c.reset();
+    long start = System.currentTimeMillis();
+    for (long i = 0; i < count; ++i) {
+      c.update((int) i);
+    }
+    report("update(int)", 1, count, System.currentTimeMillis() - start,
+           c.getValue());
+  }
+
+  public static void main(String[] args) {
+    run(new CRC32(), "CRC32");
+    run(new Adler32(), "Adler32");
+  }
+}
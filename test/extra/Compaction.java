@@ -0,0 +1,94 @@
+package extra;
+
+import avian.Machine;
+
+import java.io.BufferedReader;
+import java.io.FileReader;
+import java.io.IOException;
+
+public class Compaction {
+  private static final int LiveArrays = 2048;
+  private static final int ArrayLength = 1024;
+  private static final int Rounds = 16;
+
+  private static final class Node {
+    public Node next;
+    public final Object payload;
+
+    public Node(Node next, Object payload) {
+      this.next = next;
+      this.payload = payload;
+    }
+  }
+
+  private static String memoryStatus() {
+    StringBuilder sb = new StringBuilder();
+    try {
+      BufferedReader in = new BufferedReader
+        (new FileReader("/proc/self/status"));
+      try {
+        String line;
+        while ((line = in.readLine()) != null) {
+          if (line.startsWith("VmHWM:") || line.startsWith("VmRSS:")) {
+            if (sb.length() != 0) {
+              sb.append(", ");
+            }
+            sb.append(line.replaceAll("\\s+", " "));
+          }
+        }
+      } finally {
+        in.close();
+      }
+    } catch (IOException e) {
+      // not Linux, presumably
+    }
+    return sb.length() == 0 ? "unavailable" : sb.toString();
+  }
+
+  public static void main(String[] args) {
+    String compact = System.getProperty("avian.gc.compact");
+
+    // a large, long-lived old generation, part of which is replaced
+    // each round so that major collections have garbage to reclaim
+    // and survivors to move:
+    Node[] live = new Node[LiveArrays];
+    for (int i = 0; i < live.length; ++i) {
+      live[i] = new Node(null, new int[ArrayLength]);
+      live[i].payload.hashCode();
+    }
+
+    long start = System.currentTimeMillis();
+    int sum = 0;
+    for (int round = 0; round < Rounds; ++round) {
+      for (int i = round & 1; i < live.length; i += 2) {
+        live[i] = new Node(live[(i + 1) % live.length],
+                           new long[ArrayLength / 2]);
+      }
+
+      // plenty of short-lived garbage in between:
+      for (int i = 0; i < 100000; ++i) {
+        sum += new Node(null, null).hashCode() & 1;
+      }
+
+      System.gc();
+    }
+    long elapsed = System.currentTimeMillis() - start;
+
+    long[] statistics = new long[8];
+    Machine.collectionStatistics(statistics);
+
+    System.out.println
+      ("compact: " + (compact == null ? "false" : compact)
+       + ", elapsed: " + elapsed + " ms (" + sum + ")");
+    System.out.println
+      ("  minor: " + statistics[0] + " collections, "
+       + statistics[2] + " ms total, " + statistics[4] + " ms max");
+    System.out.println
+      ("  major: " + statistics[1] + " collections, "
+       + statistics[3] + " ms total, " + statistics[5] + " ms max");
+    System.out.println
+      ("  heap: " + (statistics[6] / 1024) + " KB now, "
+       + (statistics[7] / 1024) + " KB peak");
+    System.out.println("  process: " + memoryStatus());
+  }
+}
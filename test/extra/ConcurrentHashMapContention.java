@@ -0,0 +1,66 @@
+package extra;
+
+import java.util.concurrent.ConcurrentHashMap;
+
+public class ConcurrentHashMapContention {
+  private static final int Operations = 1000000;
+  private static final int KeyRange = 1 << 16;
+
+  private static long run(final ConcurrentHashMap<Integer, Integer> map,
+                          int threadCount, final int readPercent)
+    throws InterruptedException
+  {
+    Thread[] threads = new Thread[threadCount];
+    final int operations = Operations / threadCount;
+
+    for (int i = 0; i < threadCount; ++i) {
+      final int seed = i + 1;
+      threads[i] = new Thread() {
+          public void run() {
+            int random = seed;
+            for (int j = 0; j < operations; ++j) {
+              random = (random * 1103515245) + 12345;
+              Integer key = (random >>> 8) & (KeyRange - 1);
+              if (((random >>> 1) & 0x7FFFFFFF) % 100 < readPercent) {
+                map.get(key);
+              } else if ((random & 1) == 0) {
+                map.put(key, key);
+              } else {
+                map.remove(key);
+              }
+            }
+          }
+        };
+    }
+
+    long start = System.currentTimeMillis();
+    for (Thread t: threads) {
+      t.start();
+    }
+    for (Thread t: threads) {
+      t.join();
+    }
+    return System.currentTimeMillis() - start;
+  }
+
+  public static void main(String[] args) throws Exception {
+    int[] threadCounts = new int[] { 1, 2, 4, 8, 16 };
+    int[] readPercents = new int[] { 0, 50, 90 };
+
+    // warm up:
+    run(new ConcurrentHashMap<Integer, Integer>(), 2, 50);
+
+    for (int readPercent: readPercents) {
+      for (int threadCount: threadCounts) {
+        ConcurrentHashMap<Integer, Integer> map
+          = new ConcurrentHashMap<Integer, Integer>();
+        long elapsed = run(map, threadCount, readPercent);
+        System.out.println
+          (threadCount + " threads, " + readPercent + "% reads: "
+           + elapsed + " ms for " + Operations + " operations ("
+           + (elapsed == 0 ? 0 : (Operations / elapsed))
+           + " operations/ms, final size " + map.size() + ")");
+      }
+    }
+  }
+}
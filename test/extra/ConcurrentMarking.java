@@ -0,0 +1,98 @@
+package extra;
+
+import avian.Machine;
+
+public class ConcurrentMarking {
+  private static final int LiveNodes = 256 * 1024;
+  private static final int PayloadLength = 8;
+  private static final int Iterations = 20000000;
+
+  // upper bounds, in milliseconds, of each bucket of the pause
+  // histogram, the last of which catches everything longer:
+  private static final long[] Buckets = { 1, 2, 5, 10, 20, 50, 100, 200,
+                                          500, Long.MAX_VALUE };
+
+  private static final class Node {
+    public Node next;
+    public final int[] payload;
+
+    public Node(Node next) {
+      this.next = next;
+      this.payload = new int[PayloadLength];
+    }
+  }
+
+  private static void record(long[] histogram, long pause) {
+    for (int i = 0; i < Buckets.length; ++i) {
+      if (pause <= Buckets[i]) {
+        ++histogram[i];
+        return;
+      }
+    }
+  }
+
+  private static String label(int bucket) {
+    if (Buckets[bucket] == Long.MAX_VALUE) {
+      return "> " + Buckets[bucket - 1] + " ms";
+    } else {
+      return "<= " + Buckets[bucket] + " ms";
+    }
+  }
+
+  public static void main(String[] args) {
+    String concurrent = System.getProperty("avian.gc.concurrent");
+
+    // a large old generation of short chains, which we keep splicing
+    // new nodes into and cutting old ones out of, so that it fills up
+    // with garbage and has to be collected again and again:
+    Node[] live = new Node[LiveNodes / 4];
+    for (int i = 0; i < live.length; ++i) {
+      live[i] = new Node(new Node(new Node(new Node(null))));
+    }
+
+    long[] histogram = new long[Buckets.length];
+    long start = System.currentTimeMillis();
+    long last = start;
+    long maxPause = 0;
+    int sum = 0;
+
+    for (int i = 0; i < Iterations; ++i) {
+      Node head = live[(i * 7919) % live.length];
+      Node n = new Node(head.next.next);
+      head.next = n;
+      sum += n.payload.length;
+
+      if ((i & 255) == 0) {
+        long now = System.currentTimeMillis();
+        long pause = now - last;
+        record(histogram, pause);
+        if (pause > maxPause) {
+          maxPause = pause;
+        }
+        last = now;
+      }
+    }
+
+    long elapsed = System.currentTimeMillis() - start;
+
+    long[] statistics = new long[8];
+    Machine.collectionStatistics(statistics);
+
+    System.out.println
+      ("concurrent: " + (concurrent == null ? "false" : concurrent)
+       + ", elapsed: " + elapsed + " ms, max pause: " + maxPause + " ms"
+       + " (" + sum + ")");
+    System.out.println
+      ("  minor: " + statistics[0] + " collections, "
+       + statistics[2] + " ms total, " + statistics[4] + " ms max");
+    System.out.println
+      ("  major: " + statistics[1] + " collections, "
+       + statistics[3] + " ms total, " + statistics[5] + " ms max");
+    System.out.println("  gaps between samples of 256 iterations:");
+    for (int i = 0; i < Buckets.length; ++i) {
+      if (histogram[i] != 0) {
+        System.out.println("    " + label(i) + ": " + histogram[i]);
+      }
+    }
+  }
+}
@@ -0,0 +1,118 @@
+package extra;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.InputStream;
+import java.util.Enumeration;
+import java.util.zip.DeflaterOutputStream;
+import java.util.zip.InflaterInputStream;
+import java.util.zip.ZipEntry;
+import java.util.zip.ZipFile;
+import java.util.zip.ZipOutputStream;
+
+public class Decompression {
+  private static final int DataSize = 4 * 1024 * 1024;
+  private static final int Rounds = 64;
+  private static final int EntryCount = 16;
+
+  // something between text and noise, which compresses about 2:1:
+  private static byte[] data(int size) {
+    byte[] data = new byte[size];
+    int seed = 1;
+    for (int i = 0; i < size; ++i) {
+      seed = 3170425 * seed + 132102;
+      data[i] = (byte) ('a' + ((seed >>> 24) & 15));
+    }
+    return data;
+  }
+
+  private static long drain(InputStream in, byte[] buffer) throws Exception {
+    long total = 0;
+    int c;
+    while ((c = in.read(buffer)) > 0) {
+      total += c;
+    }
+    in.close();
+    return total;
+  }
+
+  private static void report(String name, long bytes, long elapsed) {
+    System.out.println
+      ("  " + name + ": " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : (bytes / (1024 * 1024)) * 1000 / elapsed)
+       + " MB/s)");
+  }
+
+  private static void inflaterInputStream(byte[] data, int bufferSize)
+    throws Exception
+  {
+    ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+    DeflaterOutputStream out = new DeflaterOutputStream(bytes);
+    out.write(data);
+    out.close();
+    byte[] compressed = bytes.toByteArray();
+
+    byte[] buffer = new byte[bufferSize];
+    long total = 0;
+    long start = System.currentTimeMillis();
+    for (int i = 0; i < Rounds; ++i) {
+      total += drain
+        (new InflaterInputStream(new ByteArrayInputStream(compressed)),
+         buffer);
+    }
+    report("InflaterInputStream, " + bufferSize + " byte reads", total,
+           System.currentTimeMillis() - start);
+  }
+
+  private static void zipFile(byte[] data, int bufferSize) throws Exception {
+    File file = File.createTempFile("decompression", ".zip");
+    try {
+      ZipOutputStream out = new ZipOutputStream(new FileOutputStream(file));
+      int entrySize = data.length / EntryCount;
+      for (int i = 0; i < EntryCount; ++i) {
+        out.putNextEntry(new ZipEntry("entry" + i));
+        out.write(data, i * entrySize, entrySize);
+        out.closeEntry();
+      }
+      out.close();
+
+      byte[] buffer = new byte[bufferSize];
+      long total = 0;
+      long start = System.currentTimeMillis();
+      for (int i = 0; i < Rounds; ++i) {
+        ZipFile zip = new ZipFile(file);
+        try {
+          for (Enumeration<? extends ZipEntry> e = zip.entries();
+               e.hasMoreElements();)
+          {
+            total += drain(zip.getInputStream(e.nextElement()), buffer);
+          }
+        } finally {
+          zip.close();
+        }
+      }
+      report("ZipFile entries, " + bufferSize + " byte reads", total,
+             System.currentTimeMillis() - start);
+    } finally {
+      file.delete();
+    }
+  }
+
+  public static void main(String[] args) throws Exception {
+    byte[] data = data(DataSize);
+
+    System.out.println
+      ("decompressing " + (DataSize / (1024 * 1024)) + " MB "
+       + Rounds + " times:");
+
+    for (int bufferSize: new int[] { 512, 8192, 65536 }) {
+      inflaterInputStream(data, bufferSize);
+    }
+
+    for (int bufferSize: new int[] { 512, 8192, 65536 }) {
+      zipFile(data, bufferSize);
+    }
+  }
+}
@@ -0,0 +1,196 @@
+package extra;
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.channels.ServerSocketChannel;
+import java.nio.channels.SocketChannel;
+
+public class FileThroughput {
+  private static final int Port = 8991;
+  private static final long FileSize = 256L * 1024 * 1024;
+  private static final int[] BufferSizes = { 4 * 1024, 64 * 1024 };
+
+  private static void report(String name, long bytes, long elapsed) {
+    System.out.println
+      ("  " + name + ": " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : (bytes / (1024 * 1024)) * 1000 / elapsed)
+       + " MB/s)");
+  }
+
+  private static void write(File file, int bufferSize) throws IOException {
+    byte[] buffer = new byte[bufferSize];
+    for (int i = 0; i < bufferSize; ++i) {
+      buffer[i] = (byte) i;
+    }
+
+    long start = System.currentTimeMillis();
+    FileOutputStream out = new FileOutputStream(file);
+    try {
+      for (long n = 0; n < FileSize; n += bufferSize) {
+        out.write(buffer, 0, bufferSize);
+      }
+    } finally {
+      out.close();
+    }
+    report("FileOutputStream, " + bufferSize + " byte writes", FileSize,
+           System.currentTimeMillis() - start);
+  }
+
+  private static void read(File file, int bufferSize) throws IOException {
+    byte[] buffer = new byte[bufferSize];
+    long total = 0;
+
+    long start = System.currentTimeMillis();
+    FileInputStream in = new FileInputStream(file);
+    try {
+      int c;
+      while ((c = in.read(buffer, 0, bufferSize)) > 0) {
+        total += c;
+      }
+    } finally {
+      in.close();
+    }
+    report("FileInputStream, " + bufferSize + " byte reads", total,
+           System.currentTimeMillis() - start);
+  }
+
+  private static void randomAccessRead(File file, int bufferSize)
+    throws IOException
+  {
+    byte[] buffer = new byte[bufferSize];
+    long total = 0;
+
+    long start = System.currentTimeMillis();
+    RandomAccessFile in = new RandomAccessFile(file, "r");
+    try {
+      while (total < FileSize) {
+        in.readFully(buffer, 0, bufferSize);
+        total += bufferSize;
+      }
+    } finally {
+      in.close();
+    }
+    report("RandomAccessFile, " + bufferSize + " byte reads", total,
+           System.currentTimeMillis() - start);
+  }
+
+  private static void copyByHand(File from, File to, int bufferSize)
+    throws IOException
+  {
+    byte[] buffer = new byte[bufferSize];
+    long total = 0;
+
+    long start = System.currentTimeMillis();
+    FileInputStream in = new FileInputStream(from);
+    FileOutputStream out = new FileOutputStream(to);
+    try {
+      int c;
+      while ((c = in.read(buffer, 0, bufferSize)) > 0) {
+        out.write(buffer, 0, c);
+        total += c;
+      }
+    } finally {
+      in.close();
+      out.close();
+    }
+    report("copy via streams, " + bufferSize + " byte buffer", total,
+           System.currentTimeMillis() - start);
+  }
+
+  private static void copyByTransfer(File from, File to) throws IOException {
+    to.delete();
+    long total = 0;
+
+    long start = System.currentTimeMillis();
+    RandomAccessFile in = new RandomAccessFile(from, "r");
+    RandomAccessFile out = new RandomAccessFile(to, "rw");
+    try {
+      FileChannel inChannel = in.getChannel();
+      FileChannel outChannel = out.getChannel();
+      while (total < FileSize) {
+        total += inChannel.transferTo(total, FileSize - total, outChannel);
+      }
+    } finally {
+      in.close();
+      out.close();
+    }
+    report("copy via FileChannel.transferTo", total,
+           System.currentTimeMillis() - start);
+  }
+
+  private static void sendByTransfer(File from) throws Exception {
+    ServerSocketChannel server = ServerSocketChannel.open();
+    try {
+      server.socket().bind(new InetSocketAddress("127.0.0.1", Port));
+
+      final SocketChannel client = SocketChannel.open();
+      client.connect(new InetSocketAddress("127.0.0.1", Port));
+      SocketChannel accepted = server.accept();
+
+      final long[] received = new long[1];
+      Thread reader = new Thread() {
+          public void run() {
+            try {
+              ByteBuffer buffer = ByteBuffer.allocateDirect(64 * 1024);
+              int c;
+              while ((c = client.read(buffer)) >= 0) {
+                received[0] += c;
+                buffer.clear();
+              }
+            } catch (IOException e) {
+              e.printStackTrace();
+            }
+          }
+        };
+
+      long start = System.currentTimeMillis();
+      reader.start();
+
+      RandomAccessFile in = new RandomAccessFile(from, "r");
+      try {
+        FileChannel channel = in.getChannel();
+        long total = 0;
+        while (total < FileSize) {
+          total += channel.transferTo(total, FileSize - total, accepted);
+        }
+      } finally {
+        in.close();
+        accepted.close();
+      }
+
+      reader.join();
+      client.close();
+      report("send via FileChannel.transferTo", received[0],
+             System.currentTimeMillis() - start);
+    } finally {
+      server.close();
+    }
+  }
+
+  public static void main(String[] args) throws Exception {
+    File file = File.createTempFile("throughput", ".bin");
+    File copy = File.createTempFile("throughput", ".copy");
+    try {
+      System.out.println((FileSize / (1024 * 1024)) + " MB file:");
+
+      for (int bufferSize: BufferSizes) {
+        write(file, bufferSize);
+        read(file, bufferSize);
+        randomAccessRead(file, bufferSize);
+        copyByHand(file, copy, bufferSize);
+      }
+
+      copyByTransfer(file, copy);
+      sendByTransfer(file);
+    } finally {
+      file.delete();
+      copy.delete();
+    }
+  }
+}
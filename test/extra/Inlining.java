@@ -0,0 +1,82 @@
+package extra;
+
+public class Inlining {
+  private static final int Iterations = 10000000;
+
+  private static final class Point {
+    private int x;
+    private long weight;
+    private Object tag;
+
+    public int getX() { return x; }
+
+    public void setX(int x) { this.x = x; }
+
+    public long getWeight() { return weight; }
+
+    public void setWeight(long weight) { this.weight = weight; }
+
+    public Object getTag() { return tag; }
+
+    public void setTag(Object tag) { this.tag = tag; }
+  }
+
+  private static int count;
+
+  private static int getCount() { return count; }
+
+  private static void setCount(int value) { count = value; }
+
+  private static int accessors(Point p, int iterations) {
+    for (int i = 0; i < iterations; ++i) {
+      p.setX(p.getX() + i);
+      p.setWeight(p.getWeight() + p.getX());
+      p.setTag(p.getTag());
+    }
+    return p.getX();
+  }
+
+  private static int fields(Point p, int iterations) {
+    for (int i = 0; i < iterations; ++i) {
+      p.x = p.x + i;
+      p.weight = p.weight + p.x;
+      p.tag = p.tag;
+    }
+    return p.x;
+  }
+
+  private static int statics(int iterations) {
+    for (int i = 0; i < iterations; ++i) {
+      setCount(getCount() + 1);
+    }
+    return getCount();
+  }
+
+  private static void report(String name, long elapsed, int result) {
+    System.out.println(name + ": " + elapsed + " ms for " + Iterations
+                       + " iterations ("
+                       + ((elapsed * 1000000L) / Iterations)
+                       + " ns/iteration, result " + result + ")");
+  }
+
+  public static void main(String[] args) {
+    Point p = new Point();
+
+    // warm up:
+    accessors(p, Iterations / 10);
+    fields(p, Iterations / 10);
+    statics(Iterations / 10);
+
+    long start = System.currentTimeMillis();
+    int result = fields(p, Iterations);
+    report("direct field access", System.currentTimeMillis() - start, result);
+
+    start = System.currentTimeMillis();
+    result = accessors(p, Iterations);
+    report("instance accessors", System.currentTimeMillis() - start, result);
+
+    start = System.currentTimeMillis();
+    result = statics(Iterations);
+    report("static accessors", System.currentTimeMillis() - start, result);
+  }
+}
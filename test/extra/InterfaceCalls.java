@@ -0,0 +1,58 @@
+package extra;
+
+public class InterfaceCalls {
+  private static final int Iterations = 10000000;
+
+  private interface Value {
+    int value();
+  }
+
+  private static class A implements Value { public int value() { return 1; } }
+  private static class B implements Value { public int value() { return 2; } }
+  private static class C implements Value { public int value() { return 3; } }
+  private static class D implements Value { public int value() { return 4; } }
+  private static class E implements Value { public int value() { return 5; } }
+  private static class F implements Value { public int value() { return 6; } }
+  private static class G implements Value { public int value() { return 7; } }
+  private static class H implements Value { public int value() { return 8; } }
+
+  private static final Value[] prototypes = {
+    new A(), new B(), new C(), new D(), new E(), new F(), new G(), new H()
+  };
+
+  private static int sum(Value[] values, int iterations) {
+    int sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+      sum += values[i & (values.length - 1)].value();
+    }
+    return sum;
+  }
+
+  private static void run(int typeCount) {
+    // always use 8 receivers so the loop overhead is the same no
+    // matter how many distinct classes we cycle through:
+    Value[] values = new Value[8];
+    for (int i = 0; i < values.length; ++i) {
+      values[i] = prototypes[i % typeCount];
+    }
+
+    // warm up:
+    sum(values, Iterations / 10);
+
+    long start = System.currentTimeMillis();
+    int sum = sum(values, Iterations);
+    long elapsed = System.currentTimeMillis() - start;
+
+    System.out.println(typeCount + " receiver type(s): " + elapsed + " ms for "
+                       + Iterations + " calls ("
+                       + ((elapsed * 1000000L) / Iterations) + " ns/call, sum "
+                       + sum + ")");
+  }
+
+  public static void main(String[] args) {
+    run(1);
+    run(2);
+    run(4);
+    run(8);
+  }
+}
@@ -0,0 +1,109 @@
+package extra;
+
+import avian.Machine;
+
+import java.io.BufferedReader;
+import java.io.FileReader;
+import java.io.IOException;
+
+public class LargeArrays {
+  private static final int Megabyte = 1024 * 1024;
+  private static final long BytesPerSize = 1024L * Megabyte;
+
+  // how much we keep alive at once, so that each array survives a few
+  // collections before being dropped.  Sizes bigger than this are
+  // dropped as soon as they've been used:
+  private static final int LiveBytes = 32 * Megabyte;
+
+  private static String memoryStatus() {
+    StringBuilder sb = new StringBuilder();
+    try {
+      BufferedReader in = new BufferedReader
+        (new FileReader("/proc/self/status"));
+      try {
+        String line;
+        while ((line = in.readLine()) != null) {
+          if (line.startsWith("VmHWM:") || line.startsWith("VmRSS:")) {
+            if (sb.length() != 0) {
+              sb.append(", ");
+            }
+            sb.append(line.replaceAll("\\s+", " "));
+          }
+        }
+      } finally {
+        in.close();
+      }
+    } catch (IOException e) {
+      // not Linux, presumably
+    }
+    return sb.length() == 0 ? "unavailable" : sb.toString();
+  }
+
+  // touches one element per page, as a real buffer would be filled:
+  private static long use(Object array) {
+    if (array instanceof byte[]) {
+      byte[] a = (byte[]) array;
+      for (int i = 0; i < a.length; i += 4096) {
+        a[i] = (byte) i;
+      }
+      return a[a.length - 1] + a.length;
+    } else {
+      long[] a = (long[]) array;
+      for (int i = 0; i < a.length; i += 512) {
+        a[i] = i;
+      }
+      return a[a.length - 1] + a.length;
+    }
+  }
+
+  private static long run(int size) {
+    Object[] live = new Object[LiveBytes / size];
+    int count = (int) (BytesPerSize / size);
+    long sum = 0;
+
+    long start = System.currentTimeMillis();
+    for (int i = 0; i < count; ++i) {
+      Object array = (i & 1) == 0 ? new byte[size] : new long[size / 8];
+      sum += use(array);
+      if (live.length != 0) {
+        live[i % live.length] = array;
+      }
+    }
+    long elapsed = System.currentTimeMillis() - start;
+
+    System.out.println
+      ("  " + (size / Megabyte) + " MB: " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : (BytesPerSize / Megabyte) * 1000 / elapsed)
+       + " MB/s, " + count + " arrays)");
+
+    return sum;
+  }
+
+  public static void main(String[] args) {
+    String threshold = System.getProperty("avian.gc.large.threshold");
+
+    System.out.println
+      ("large object threshold: "
+       + (threshold == null ? "default" : threshold));
+
+    long sum = 0;
+    for (int size = Megabyte; size <= 64 * Megabyte; size *= 2) {
+      sum += run(size);
+    }
+
+    long[] statistics = new long[8];
+    Machine.collectionStatistics(statistics);
+
+    System.out.println("(" + sum + ")");
+    System.out.println
+      ("  minor: " + statistics[0] + " collections, "
+       + statistics[2] + " ms total, " + statistics[4] + " ms max");
+    System.out.println
+      ("  major: " + statistics[1] + " collections, "
+       + statistics[3] + " ms total, " + statistics[5] + " ms max");
+    System.out.println
+      ("  heap: " + (statistics[6] / 1024) + " KB now, "
+       + (statistics[7] / 1024) + " KB peak");
+    System.out.println("  process: " + memoryStatus());
+  }
+}
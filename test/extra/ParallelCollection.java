@@ -0,0 +1,100 @@
+package extra;
+
+public class ParallelCollection {
+  private static final int LiveNodes = 256 * 1024;
+  private static final int Iterations = 4000000;
+  private static final int PauseThresholdMillis = 1;
+
+  private static final class Node {
+    public Node left;
+    public Node right;
+    public final int value;
+
+    public Node(int value) {
+      this.value = value;
+    }
+  }
+
+  private static Node build(int depth, int[] counter) {
+    if (depth == 0) {
+      return null;
+    }
+
+    Node n = new Node(counter[0]++);
+    n.left = build(depth - 1, counter);
+    n.right = build(depth - 1, counter);
+    return n;
+  }
+
+  private static int depthFor(int nodes) {
+    int depth = 0;
+    while ((1 << depth) - 1 < nodes) {
+      ++depth;
+    }
+    return depth;
+  }
+
+  public static void main(String[] args) {
+    String threads = System.getProperty("avian.gc.threads");
+
+    // a live set which survives every minor collection and keeps
+    // being rewired, so each collection has a large graph to trace:
+    Node[] live = new Node[64];
+    int[] counter = new int[1];
+    int depth = depthFor(LiveNodes / live.length);
+    for (int i = 0; i < live.length; ++i) {
+      live[i] = build(depth, counter);
+    }
+
+    long start = System.currentTimeMillis();
+    long last = start;
+    long maxPause = 0;
+    long totalPause = 0;
+    int pauses = 0;
+    int sum = 0;
+
+    for (int i = 0; i < Iterations; ++i) {
+      Node n = new Node(i);
+      Node slot = live[i & (live.length - 1)];
+      if ((i & 1) == 0) {
+        n.left = slot.left;
+        slot.left = n;
+      } else {
+        n.right = slot.right;
+        slot.right = n;
+      }
+
+      if ((i & 4095) == 0) {
+        // replace a whole subtree now and then so the graph keeps
+        // turning over rather than just growing:
+        live[(i >> 12) & (live.length - 1)] = build(depth, counter);
+      }
+
+      sum += n.value;
+
+      if ((i & 255) == 0) {
+        long now = System.currentTimeMillis();
+        long pause = now - last;
+        if (pause > PauseThresholdMillis) {
+          ++pauses;
+          totalPause += pause;
+          if (pause > maxPause) {
+            maxPause = pause;
+          }
+        }
+        last = now;
+      }
+    }
+
+    long elapsed = System.currentTimeMillis() - start;
+
+    System.out.println
+      ("gc threads: " + (threads == null ? "1" : threads)
+       + ", elapsed: " + elapsed + " ms"
+       + ", pauses over " + PauseThresholdMillis + " ms: " + pauses
+       + ", total " + totalPause + " ms"
+       + ", average " + (pauses == 0 ? 0 : totalPause / pauses) + " ms"
+       + ", max " + maxPause + " ms"
+       + " (" + sum + ")");
+  }
+}
@@ -0,0 +1,65 @@
+package extra;
+
+public class Quickening {
+  private static final int Iterations = 10000000;
+
+  private static abstract class Shape {
+    public int x;
+    public long area;
+    public Object tag;
+
+    public abstract int sides();
+  }
+
+  private static class Triangle extends Shape {
+    public int sides() { return 3; }
+  }
+
+  private static class Square extends Shape {
+    public int sides() { return 4; }
+  }
+
+  private static int counter;
+
+  private static int fields(Shape s, int iterations) {
+    for (int i = 0; i < iterations; ++i) {
+      s.x = s.x + i;
+      s.area = s.area + s.x;
+      s.tag = s;
+      counter = counter + 1;
+    }
+    return s.x;
+  }
+
+  private static int calls(Shape[] shapes, int iterations) {
+    int sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+      sum += shapes[i & 1].sides();
+    }
+    return sum;
+  }
+
+  private static void report(String name, long elapsed, int result) {
+    System.out.println(name + ": " + elapsed + " ms for " + Iterations
+                       + " iterations ("
+                       + ((elapsed * 1000000L) / Iterations)
+                       + " ns/iteration, result " + result + ")");
+  }
+
+  public static void main(String[] args) {
+    Shape s = new Square();
+    Shape[] shapes = new Shape[] { new Triangle(), new Square() };
+
+    // warm up:
+    fields(s, Iterations / 10);
+    calls(shapes, Iterations / 10);
+
+    long start = System.currentTimeMillis();
+    int result = fields(s, Iterations);
+    report("field access", System.currentTimeMillis() - start, result);
+
+    start = System.currentTimeMillis();
+    result = calls(shapes, Iterations);
+    report("virtual calls", System.currentTimeMillis() - start, result);
+  }
+}
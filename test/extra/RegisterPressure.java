@@ -0,0 +1,106 @@
+package extra;
+
+public class RegisterPressure {
+  private static final int Size = 4096;
+  private static final int Iterations = 20000;
+
+  // more values live across the loop body than there are registers to
+  // hold them, so the allocator has to keep choosing what to evict:
+  private static long mix(int[] array) {
+    long a = 1, b = 2, c = 3, d = 4, e = 5, f = 6, g = 7, h = 8;
+    for (int i = 0; i < array.length; ++i) {
+      int v = array[i];
+      a += v ^ b;
+      b += a * 3 + c;
+      c ^= b - d;
+      d += c + (v << 1);
+      e += d ^ f;
+      f -= e + g;
+      g += f ^ h;
+      h += g + a;
+    }
+    return a + b + c + d + e + f + g + h;
+  }
+
+  // a, b, c, and d are only needed outside the inner loop, so they're
+  // the ones to evict while it runs:
+  private static long nested(int[] array) {
+    long a = 1, b = 2, c = 3, d = 4;
+    for (int i = 0; i < array.length; i += 64) {
+      long w = array[i], x = w ^ 5, y = w * 7, z = w + 11;
+      for (int j = i; j < i + 64 && j < array.length; ++j) {
+        int v = array[j];
+        w += v ^ x;
+        x += w * 3 + y;
+        y ^= x - z;
+        z += y + (v << 1);
+      }
+      a += w;
+      b ^= x;
+      c += y ^ a;
+      d -= z + b;
+    }
+    return a + b + c + d;
+  }
+
+  // values live across calls:
+  private static int identity(int v) {
+    return v;
+  }
+
+  private static int acrossCalls(int[] array) {
+    int sum = 0;
+    for (int i = 0; i < array.length; ++i) {
+      int x = array[i];
+      int y = identity(x + 1);
+      int z = identity(y ^ x);
+      sum += x + y + z;
+    }
+    return sum;
+  }
+
+  private static void report(String name, long start, long elements) {
+    long elapsed = System.currentTimeMillis() - start;
+    System.out.println
+      (name + ": " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : elements / elapsed) + " elements/ms)");
+  }
+
+  public static void main(String[] args) {
+    int[] ints = new int[Size];
+    for (int i = 0; i < Size; ++i) {
+      ints[i] = i * 0x9E3779B9;
+    }
+
+    long elements = (long) Size * Iterations;
+    long result = 0;
+
+    System.out.println
+      ("evictFurthest: " + System.getProperty("avian.jit.evictFurthest"));
+
+    // warm up:
+    for (int i = 0; i < Iterations / 10; ++i) {
+      result += mix(ints) + nested(ints) + acrossCalls(ints);
+    }
+
+    long start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      result += mix(ints);
+    }
+    report("mix", start, elements);
+
+    start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      result += nested(ints);
+    }
+    report("nested loops", start, elements);
+
+    start = System.currentTimeMillis();
+    for (int i = 0; i < Iterations; ++i) {
+      result += acrossCalls(ints);
+    }
+    report("across calls", start, elements);
+
+    System.out.println("(" + result + ")");
+  }
+}
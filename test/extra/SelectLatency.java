@@ -0,0 +1,104 @@
+package extra;
+
+import java.io.IOException;
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.channels.SelectionKey;
+import java.nio.channels.Selector;
+import java.nio.channels.ServerSocketChannel;
+import java.nio.channels.SocketChannel;
+import java.util.ArrayList;
+import java.util.List;
+
+public class SelectLatency {
+  private static final int Port = 8989;
+  private static final int Rounds = 1000;
+
+  private static void close(List<SocketChannel> channels) throws IOException {
+    for (SocketChannel c: channels) {
+      c.close();
+    }
+  }
+
+  // Opens the specified number of loopback connections, registers the
+  // accepted end of each with a selector, then measures how long it
+  // takes a select to report a single byte written to one of them.
+  private static void run(ServerSocketChannel server, int count)
+    throws IOException
+  {
+    List<SocketChannel> clients = new ArrayList();
+    List<SocketChannel> accepted = new ArrayList();
+    Selector selector = Selector.open();
+    try {
+      try {
+        for (int i = 0; i < count; ++i) {
+          SocketChannel client = SocketChannel.open();
+          clients.add(client);
+          client.connect(new InetSocketAddress("127.0.0.1", Port));
+
+          SocketChannel c = server.accept();
+          accepted.add(c);
+          c.configureBlocking(false);
+          c.register(selector, SelectionKey.OP_READ, null);
+        }
+      } catch (IOException e) {
+        System.out.println(count + " sockets: only opened " + accepted.size()
+                           + " (" + e.getMessage() + ")");
+        return;
+      }
+
+      ByteBuffer out = ByteBuffer.allocate(1);
+      ByteBuffer in = ByteBuffer.allocate(16);
+
+      long total = 0;
+      long worst = 0;
+      for (int i = 0; i < Rounds; ++i) {
+        SocketChannel client = clients.get((i * 7919) % count);
+        out.clear();
+        out.put((byte) i);
+        out.flip();
+        client.write(out);
+
+        long start = System.nanoTime();
+        int ready = 0;
+        while (ready == 0) {
+          ready = selector.select(1000);
+        }
+        long elapsed = System.nanoTime() - start;
+        total += elapsed;
+        if (elapsed > worst) {
+          worst = elapsed;
+        }
+
+        for (SelectionKey key: selector.selectedKeys()) {
+          in.clear();
+          ((SocketChannel) key.channel()).read(in);
+        }
+        selector.selectedKeys().clear();
+      }
+
+      System.out.println(count + " sockets: " + (total / Rounds / 1000)
+                         + " us average, " + (worst / 1000)
+                         + " us worst select latency over " + Rounds
+                         + " rounds");
+    } finally {
+      selector.close();
+      close(accepted);
+      close(clients);
+    }
+  }
+
+  public static void main(String[] args) throws Exception {
+    ServerSocketChannel server = ServerSocketChannel.open();
+    try {
+      server.socket().bind(new InetSocketAddress("127.0.0.1", Port));
+
+      int[] counts = new int[] { 100, 1000, 10000 };
+      for (int count: counts) {
+        run(server, count);
+      }
+    } finally {
+      server.close();
+    }
+  }
+}
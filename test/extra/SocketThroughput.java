@@ -0,0 +1,128 @@
+package extra;
+
+import java.io.IOException;
+import java.net.InetSocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.channels.ServerSocketChannel;
+import java.nio.channels.SocketChannel;
+
+public class SocketThroughput {
+  private static final int Port = 8990;
+  private static final long TotalBytes = 1024L * 1024 * 1024;
+  private static final int BufferSize = 64 * 1024;
+  private static final int VectorCount = 4;
+
+  private static ByteBuffer[] buffers(boolean direct, int count, int size) {
+    ByteBuffer[] buffers = new ByteBuffer[count];
+    for (int i = 0; i < count; ++i) {
+      buffers[i] = direct
+        ? ByteBuffer.allocateDirect(size) : ByteBuffer.allocate(size);
+    }
+    return buffers;
+  }
+
+  private static boolean hasRemaining(ByteBuffer[] buffers) {
+    return buffers[buffers.length - 1].hasRemaining();
+  }
+
+  private static void clear(ByteBuffer[] buffers) {
+    for (ByteBuffer b: buffers) {
+      b.clear();
+    }
+  }
+
+  private static long transfer(SocketChannel c, ByteBuffer[] buffers,
+                               boolean write)
+    throws IOException
+  {
+    if (buffers.length == 1) {
+      return write ? c.write(buffers[0]) : c.read(buffers[0]);
+    } else {
+      return write ? c.write(buffers) : c.read(buffers);
+    }
+  }
+
+  // Sends TotalBytes from one end of a loopback connection to the
+  // other, using buffers of the specified kind on both ends, and
+  // reports how long it took.
+  private static void run(ServerSocketChannel server, final String name,
+                          final boolean direct, final int count)
+    throws Exception
+  {
+    final SocketChannel client = SocketChannel.open();
+    client.connect(new InetSocketAddress("127.0.0.1", Port));
+    SocketChannel accepted = server.accept();
+
+    final IOException[] error = new IOException[1];
+    Thread writer = new Thread() {
+        public void run() {
+          try {
+            ByteBuffer[] out = buffers(direct, count, BufferSize / count);
+            long remaining = TotalBytes;
+            while (remaining > 0) {
+              clear(out);
+              while (hasRemaining(out)) {
+                remaining -= transfer(client, out, true);
+              }
+            }
+          } catch (IOException e) {
+            error[0] = e;
+          } finally {
+            try {
+              client.close();
+            } catch (IOException e) { }
+          }
+        }
+      };
+
+    long start = System.currentTimeMillis();
+    writer.start();
+
+    ByteBuffer[] in = buffers(direct, count, BufferSize / count);
+    long received = 0;
+    while (true) {
+      clear(in);
+      long r = transfer(accepted, in, false);
+      if (r < 0) {
+        break;
+      }
+      received += r;
+    }
+
+    writer.join();
+    long elapsed = System.currentTimeMillis() - start;
+    accepted.close();
+
+    if (error[0] != null) {
+      throw error[0];
+    }
+
+    if (received != TotalBytes) {
+      throw new RuntimeException
+        ("expected " + TotalBytes + " bytes; got " + received);
+    }
+
+    System.out.println
+      ("  " + name + ": " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : (TotalBytes / (1024 * 1024)) * 1000 / elapsed)
+       + " MB/s)");
+  }
+
+  public static void main(String[] args) throws Exception {
+    ServerSocketChannel server = ServerSocketChannel.open();
+    try {
+      server.socket().bind(new InetSocketAddress("127.0.0.1", Port));
+
+      System.out.println
+        ((TotalBytes / (1024 * 1024)) + " MB over loopback in "
+         + (BufferSize / 1024) + " KB chunks:");
+
+      run(server, "heap", false, 1);
+      run(server, "direct", true, 1);
+      run(server, "heap, " + VectorCount + " buffers", false, VectorCount);
+      run(server, "direct, " + VectorCount + " buffers", true, VectorCount);
+    } finally {
+      server.close();
+    }
+  }
+}
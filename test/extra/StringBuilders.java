@@ -0,0 +1,112 @@
+package extra;
+
+public class StringBuilders {
+  private static final int Rounds = 200000;
+
+  private static abstract class Workload {
+    public final String name;
+
+    public Workload(String name) {
+      this.name = name;
+    }
+
+    public abstract int run(int i);
+  }
+
+  private static void run(Workload workload) {
+    int sum = 0;
+
+    // warm up, so as to measure compiled code:
+    for (int i = 0; i < 1000; ++i) {
+      sum += workload.run(i);
+    }
+
+    long start = System.currentTimeMillis();
+    for (int i = 0; i < Rounds; ++i) {
+      sum += workload.run(i);
+    }
+    long elapsed = System.currentTimeMillis() - start;
+
+    System.out.println
+      ("  " + workload.name + ": " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : ((long) Rounds * 1000) / elapsed)
+       + " ops/s) (" + sum + ")");
+  }
+
+  public static void main(String[] args) {
+    final String foo = "foobar";
+    final char[] fooChars = foo.toCharArray();
+
+    Workload[] workloads = new Workload[] {
+      // these two mirror test/StringBuilderTest.java, scaled down:
+      new Workload("append 100 strings") {
+        public int run(int i) {
+          StringBuilder sb = new StringBuilder();
+          for (int j = 0; j < 100; ++j) {
+            sb.append(foo);
+          }
+          return sb.toString().length();
+        }
+      },
+
+      new Workload("append 600 chars") {
+        public int run(int i) {
+          StringBuilder sb = new StringBuilder();
+          for (int j = 0; j < 100; ++j) {
+            for (int k = 0; k < fooChars.length; ++k) {
+              sb.append(fooChars[k]);
+            }
+          }
+          return sb.toString().length();
+        }
+      },
+
+      // what javac emits for "a" + b + "c" + d:
+      new Workload("concatenation") {
+        public int run(int i) {
+          return new StringBuilder().append("key").append(i).append('=')
+            .append(foo).toString().length();
+        }
+      },
+
+      new Workload("log line") {
+        public int run(int i) {
+          StringBuilder sb = new StringBuilder();
+          sb.append("2015-06-01 12:00:00 INFO [worker-").append(i % 16)
+            .append("] request ").append(i).append(" took ")
+            .append(i % 1000).append(" ms");
+          return sb.toString().length();
+        }
+      },
+
+      new Workload("JSON object") {
+        public int run(int i) {
+          StringBuilder sb = new StringBuilder();
+          sb.append('{');
+          for (int j = 0; j < 8; ++j) {
+            if (j > 0) sb.append(',');
+            sb.append("\"field").append(j).append("\":").append(i * j);
+          }
+          sb.append('}');
+          return sb.toString().length();
+        }
+      },
+
+      new Workload("insert and delete") {
+        public int run(int i) {
+          StringBuilder sb = new StringBuilder(foo);
+          for (int j = 0; j < 16; ++j) {
+            sb.insert(j, 'x');
+          }
+          sb.delete(0, 8);
+          return sb.toString().length();
+        }
+      },
+    };
+
+    System.out.println(Rounds + " rounds each:");
+    for (Workload workload: workloads) {
+      run(workload);
+    }
+  }
+}
@@ -0,0 +1,148 @@
+package extra;
+
+import java.util.Arrays;
+
+public class StringKernels {
+  private static final long CharsPerRun = 256L * 1024 * 1024;
+  private static final int[] Lengths = { 16, 256, 4096 };
+
+  private static abstract class Kernel {
+    public final String name;
+
+    public Kernel(String name) {
+      this.name = name;
+    }
+
+    public abstract int run(String[] a, String[] b);
+  }
+
+  // builds count distinct strings of the specified length, each
+  // differing from the others only in its last few characters, so that
+  // comparisons have to look at nearly all of them.  Strings built
+  // from ASCII bytes are stored as byte arrays; the others as char
+  // arrays:
+  private static String[] strings(int count, int length, boolean wide)
+    throws Exception
+  {
+    String[] strings = new String[count];
+    byte[] bytes = new byte[length];
+    for (int i = 0; i < length; ++i) {
+      bytes[i] = (byte) ('a' + (i % 26));
+    }
+    for (int i = 0; i < count; ++i) {
+      bytes[length - 1] = (byte) ('A' + (i % 26));
+      bytes[length - 2] = (byte) ('A' + ((i / 26) % 26));
+      String s = new String(bytes, "UTF-8");
+      strings[i] = wide ? new String(s.toCharArray()) : s;
+    }
+    return strings;
+  }
+
+  private static void run(Kernel kernel, int length, boolean wide)
+    throws Exception
+  {
+    int count = 64;
+    String[] a = strings(count, length, wide);
+    String[] b = strings(count, length, wide);
+
+    long rounds = CharsPerRun / (count * length);
+    int sum = 0;
+
+    // warm up, so as to measure compiled code:
+    sum += kernel.run(a, b);
+
+    long start = System.currentTimeMillis();
+    for (long i = 0; i < rounds; ++i) {
+      sum += kernel.run(a, b);
+    }
+    long elapsed = System.currentTimeMillis() - start;
+
+    System.out.println
+      ("  " + kernel.name + ", " + length + " " + (wide ? "chars" : "bytes")
+       + ": " + elapsed + " ms ("
+       + (elapsed == 0 ? 0 : (CharsPerRun / 1024 / 1024) * 1000 / elapsed)
+       + " M chars/s) (" + sum + ")");
+  }
+
+  public static void main(String[] args) throws Exception {
+    Kernel[] kernels = new Kernel[] {
+      new Kernel("equals") {
+        public int run(String[] a, String[] b) {
+          int n = 0;
+          for (int i = 0; i < a.length; ++i) {
+            if (a[i].equals(b[i])) ++n;
+          }
+          return n;
+        }
+      },
+
+      new Kernel("compareTo") {
+        public int run(String[] a, String[] b) {
+          int n = 0;
+          for (int i = 0; i < a.length; ++i) {
+            n += a[i].compareTo(b[a.length - i - 1]);
+          }
+          return n;
+        }
+      },
+
+      // hash codes are cached, so we need fresh strings each time:
+      new Kernel("hashCode") {
+        public int run(String[] a, String[] b) {
+          int n = 0;
+          for (int i = 0; i < a.length; ++i) {
+            n += new String(a[i].toCharArray()).hashCode();
+          }
+          return n;
+        }
+      },
+
+      new Kernel("indexOf(char)") {
+        public int run(String[] a, String[] b) {
+          int n = 0;
+          for (int i = 0; i < a.length; ++i) {
+            n += a[i].indexOf(a[i].charAt(a[i].length() - 1));
+          }
+          return n;
+        }
+      },
+
+      new Kernel("indexOf(String)") {
+        public int run(String[] a, String[] b) {
+          int n = 0;
+          for (int i = 0; i < a.length; ++i) {
+            n += a[i].indexOf(b[i].substring(b[i].length() - 4));
+          }
+          return n;
+        }
+      },
+    };
+
+    for (Kernel kernel: kernels) {
+      System.out.println(kernel.name + ":");
+      for (int length: Lengths) {
+        run(kernel, length, false);
+        run(kernel, length, true);
+      }
+    }
+
+    System.out.println("Arrays.equals and Arrays.fill:");
+    for (int length: Lengths) {
+      int[] a = new int[length];
+      int[] b = new int[length];
+      long rounds = CharsPerRun / length;
+      int sum = 0;
+
+      long start = System.currentTimeMillis();
+      for (long i = 0; i < rounds; ++i) {
+        Arrays.fill(a, (int) i);
+        Arrays.fill(b, (int) i);
+        if (Arrays.equals(a, b)) ++sum;
+      }
+      long elapsed = System.currentTimeMillis() - start;
+
+      System.out.println
+        ("  " + length + " ints: " + elapsed + " ms (" + sum + ")");
+    }
+  }
+}
@@ -226,3 +226,25 @@ extern "C" JNIEXPORT void JNICALL
 {
   free(e->GetDirectBufferAddress(b));
 }
+
+// stands in for a long-running codec: adds each index to the byte at
+// that index, rounds times over, all within a single critical region:
+extern "C" JNIEXPORT jboolean JNICALL
+    Java_CriticalRegions_fill(JNIEnv* e, jclass, jbyteArray array, jint rounds)
+{
+  jsize length = e->GetArrayLength(array);
+
+  jboolean isCopy;
+  volatile jbyte* p
+      = static_cast<jbyte*>(e->GetPrimitiveArrayCritical(array, &isCopy));
+
+  for (jint r = 0; r < rounds; ++r) {
+    for (jsize i = 0; i < length; ++i) {
+      p[i] += static_cast<jbyte>(i);
+    }
+  }
+
+  e->ReleasePrimitiveArrayCritical(array, const_cast<jbyte*>(p), 0);
+
+  return isCopy;
+}
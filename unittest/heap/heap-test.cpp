@@ -0,0 +1,642 @@
+/* Copyright (c) 2008-2015, Avian Contributors
+
+   Permission to use, copy, modify, and/or distribute this software
+   for any purpose with or without fee is hereby granted, provided
+   that the above copyright notice and this permission notice appear
+   in all copies.
+
+   There is NO WARRANTY for this software.  See license.txt for
+   details. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "avian/common.h"
+#include <avian/heap/heap.h>
+#include <avian/system/system.h>
+
+#include "test-harness.h"
+
+using namespace vm;
+
+namespace {
+
+// objects in these tests look like this:
+//
+//   [0] header: size in words << 3, plus HashTaken or Extended, plus
+//       Fixed for large objects
+//   [1] number of references
+//   [2, 2 + references) references
+//   [2 + references] id
+//   [3 + references, size) ballast
+//   [size] identity hash, if Extended
+
+const uintptr_t HashTaken = 1;
+const uintptr_t Extended = 2;
+const uintptr_t FlagMask = 3;
+const uintptr_t Fixed = 4;
+
+const unsigned RootCount = 64;
+const unsigned MaxObjects = 16 * 1024;
+const unsigned MaxReferences = 4;
+const unsigned Rounds = 40;
+
+// concurrent marking only starts once gen2 is mostly full, so objects
+// in that test carry this many words of ballast to fill it sooner:
+const unsigned Ballast = 1024;
+
+uintptr_t* words(void* o)
+{
+  return static_cast<uintptr_t*>(o);
+}
+
+unsigned baseSize(void* o)
+{
+  return words(o)[0] >> 3;
+}
+
+uintptr_t flags(void* o)
+{
+  return words(o)[0] & FlagMask;
+}
+
+unsigned references(void* o)
+{
+  return words(o)[1];
+}
+
+void*& reference(void* o, unsigned i)
+{
+  return reinterpret_cast<void**>(o)[2 + i];
+}
+
+uintptr_t id(void* o)
+{
+  return words(o)[2 + references(o)];
+}
+
+uintptr_t address(void* o)
+{
+  return reinterpret_cast<uintptr_t>(o) / BytesPerWord;
+}
+
+class Client : public Heap::Client {
+ public:
+  Client(Heap* heap)
+      : heap(heap), copiedWhileClaimed(false), forwardedWhileCopying(false)
+  {
+    memset(roots, 0, sizeof(roots));
+  }
+
+  virtual void collect(void*, Heap::CollectionType)
+  {
+    abort();
+  }
+
+  virtual void visitRoots(Heap::Visitor* v)
+  {
+    for (unsigned i = 0; i < RootCount; ++i) {
+      v->visit(roots + i);
+    }
+  }
+
+  virtual bool isFixed(void* p)
+  {
+    return (words(p)[0] & Fixed) != 0;
+  }
+
+  virtual unsigned sizeInWords(void* p)
+  {
+    void* o = heap->follow(p);
+    return baseSize(o) + (flags(o) == Extended);
+  }
+
+  virtual unsigned copiedSizeInWords(void* p)
+  {
+    void* o = heap->follow(p);
+    return copiedSizeInWords(o, words(o)[0]);
+  }
+
+  virtual unsigned copiedSizeInWords(void* p, uintptr_t header)
+  {
+    check(p, header);
+    return (header >> 3) + ((header & FlagMask) != 0);
+  }
+
+  virtual void copy(void* srcp, void* dst)
+  {
+    void* src = heap->follow(srcp);
+    copy(src, dst, words(src)[0]);
+  }
+
+  virtual void copy(void* src, void* dst, uintptr_t header)
+  {
+    check(src, header);
+    unsigned base = header >> 3;
+
+    memcpy(dst,
+           src,
+           (base + ((header & FlagMask) == Extended)) * BytesPerWord);
+    words(dst)[0] = header;
+
+    if ((header & FlagMask) == HashTaken) {
+      words(dst)[0] = (base << 3) | Extended;
+      words(dst)[base] = address(src);
+    }
+  }
+
+  // like the VM, we ask the heap about the original while copying it,
+  // and it had better not have been forwarded by another collector
+  // thread in the meantime:
+  void check(void* original, uintptr_t header)
+  {
+    if (words(original)[0] != header) {
+      copiedWhileClaimed = true;
+    }
+    if (heap->follow(original) != original) {
+      forwardedWhileCopying = true;
+    }
+  }
+
+  virtual void extend(void* original, void* moved, unsigned sizeInWords)
+  {
+    words(moved)[0] = (baseSize(moved) << 3) | Extended;
+    words(moved)[sizeInWords] = address(original);
+  }
+
+  virtual void walk(void* p, Heap::Walker* w)
+  {
+    void* o = heap->follow(p);
+    for (unsigned i = 0; i < references(o) and w->visit(2 + i); ++i) {
+    }
+  }
+
+  Heap* heap;
+  void* roots[RootCount];
+  bool copiedWhileClaimed;
+  bool forwardedWhileCopying;
+};
+
+// a little mutator which builds and rewires a random graph, keeping
+// track of what it ought to look like so we can tell whether the heap
+// has preserved it:
+class Mutator {
+ public:
+  Mutator(System* s, unsigned collectorCount, bool compact, bool concurrent)
+      : s(s),
+        heap(makeHeap(s,
+                      64 * 1024 * 1024,
+                      collectorCount,
+                      compact,
+                      concurrent)),
+        client(heap),
+        ballast(concurrent ? Ballast : 0),
+        seed(42),
+        nextId(1),
+        poolCount(0),
+        incoming(0)
+  {
+    heap->setClient(&client);
+    memset(hashes, 0, sizeof(hashes));
+  }
+
+  ~Mutator()
+  {
+    freePool();
+    heap->dispose();
+  }
+
+  unsigned random(unsigned limit)
+  {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) % limit;
+  }
+
+  void* make()
+  {
+    unsigned n = random(MaxReferences + 1);
+    unsigned size = 3 + n + ballast;
+    void* o = heap->allocate(size * BytesPerWord);
+
+    words(o)[0] = size << 3;
+    words(o)[1] = n;
+    for (unsigned i = 0; i < n; ++i) {
+      reference(o, i) = 0;
+    }
+    words(o)[2 + n] = nextId++;
+    memset(words(o) + 3 + n, 0, ballast * BytesPerWord);
+
+    pool[poolCount] = o;
+    poolSizes[poolCount++] = size;
+    incoming += size;
+
+    return o;
+  }
+
+  void freePool()
+  {
+    for (unsigned i = 0; i < poolCount; ++i) {
+      heap->free(pool[i], poolSizes[i] * BytesPerWord);
+    }
+    poolCount = 0;
+    incoming = 0;
+  }
+
+  void* randomObject()
+  {
+    void* o = client.roots[random(RootCount)];
+    for (unsigned depth = random(4); o and depth; --depth) {
+      if (references(o) == 0) {
+        break;
+      }
+      void* next = reference(o, random(references(o)));
+      if (next == 0) {
+        break;
+      }
+      o = next;
+    }
+    return o;
+  }
+
+  uintptr_t hashCode(void* o)
+  {
+    if (flags(o) == Extended) {
+      return words(o)[baseSize(o)];
+    } else {
+      if (flags(o) == 0) {
+        words(o)[0] |= HashTaken;
+        heap->pad(o);
+      }
+      return address(o);
+    }
+  }
+
+  void step()
+  {
+    void* o = make();
+    for (unsigned i = 0; i < references(o); ++i) {
+      reference(o, i) = randomObject();
+    }
+
+    // usually splice the new object in without losing whatever it
+    // displaces, so that a good part of the graph lives long enough
+    // to be tenured:
+    void* target = randomObject();
+    if (target and references(target) and references(o) and random(16)) {
+      unsigned i = random(references(target));
+      reference(o, 0) = reference(target, i);
+      reference(target, i) = o;
+      heap->mark(target, 2 + i, 1);
+    } else {
+      client.roots[random(RootCount)] = o;
+    }
+
+    if (random(8) == 0) {
+      void* h = randomObject();
+      if (h) {
+        hashes[id(h)] = hashCode(h);
+      }
+    }
+
+    if (random(128) == 0) {
+      client.roots[random(RootCount)] = 0;
+    }
+  }
+
+  void collect(Heap::CollectionType type)
+  {
+    heap->collect(type, incoming, 0);
+    freePool();
+  }
+
+  // returns a checksum of everything reachable from the roots, and
+  // verifies every hash code we've handed out along the way:
+  uintptr_t checksum(bool* hashesMatch)
+  {
+    memset(visited, 0, sizeof(visited));
+    *hashesMatch = true;
+
+    uintptr_t sum = 0;
+    unsigned stackCount = 0;
+    for (unsigned i = 0; i < RootCount; ++i) {
+      if (client.roots[i]) {
+        sum += i * id(client.roots[i]);
+        stack[stackCount++] = client.roots[i];
+      }
+    }
+
+    while (stackCount) {
+      void* o = stack[--stackCount];
+      uintptr_t oid = id(o);
+      if (visited[oid]) {
+        continue;
+      }
+      visited[oid] = true;
+
+      sum = sum * 31 + oid;
+      for (unsigned i = 0; i < references(o); ++i) {
+        void* r = reference(o, i);
+        if (r) {
+          sum += (i + 1) * id(r);
+          stack[stackCount++] = r;
+        }
+      }
+
+      if (hashes[oid]) {
+        if (flags(o) == 0 or hashCode(o) != hashes[oid]) {
+          *hashesMatch = false;
+        }
+      }
+    }
+
+    return sum;
+  }
+
+  System* s;
+  Heap* heap;
+  Client client;
+  unsigned ballast;
+  unsigned seed;
+  unsigned nextId;
+  void* pool[MaxObjects];
+  unsigned poolSizes[MaxObjects];
+  unsigned poolCount;
+  unsigned incoming;
+  uintptr_t hashes[MaxObjects];
+  bool visited[MaxObjects];
+  void* stack[MaxObjects * MaxReferences + RootCount];
+};
+
+class Result {
+ public:
+  unsigned checksumFailures;
+  unsigned hashFailures;
+  bool copiedWhileClaimed;
+  bool forwardedWhileCopying;
+  Heap::Statistics statistics;
+  Heap::Record records[Heap::RecordCount];
+  unsigned recordCount;
+  unsigned recentCount;
+  uint64_t recentSequence;
+};
+
+void exercise(unsigned collectorCount,
+              bool compact,
+              bool concurrent,
+              Result* r)
+{
+  System* s = makeSystem();
+
+  Mutator* m = static_cast<Mutator*>(s->tryAllocate(sizeof(Mutator)));
+  new (m) Mutator(s, collectorCount, compact, concurrent);
+
+  r->checksumFailures = 0;
+  r->hashFailures = 0;
+
+  for (unsigned round = 0; round < Rounds; ++round) {
+    for (unsigned i = 0; i < MaxObjects / Rounds; ++i) {
+      m->step();
+    }
+
+    bool hashesMatch;
+    uintptr_t expected = m->checksum(&hashesMatch);
+    if (not hashesMatch) {
+      ++r->hashFailures;
+    }
+
+    m->collect((round % 8) == 7 ? Heap::MajorCollection
+                                : Heap::MinorCollection);
+
+    if (m->checksum(&hashesMatch) != expected) {
+      ++r->checksumFailures;
+    }
+    if (not hashesMatch) {
+      ++r->hashFailures;
+    }
+  }
+
+  r->copiedWhileClaimed = m->client.copiedWhileClaimed;
+  r->forwardedWhileCopying = m->client.forwardedWhileCopying;
+
+  m->heap->statistics(&(r->statistics));
+  r->recordCount = m->heap->records(0, r->records, Heap::RecordCount);
+
+  Heap::Record recent[Heap::RecordCount];
+  r->recentCount = m->heap->records(Rounds - 2, recent, Heap::RecordCount);
+  r->recentSequence = r->recentCount ? recent[0].sequence : 0;
+
+  m->~Mutator();
+  s->free(m);
+  s->dispose();
+}
+
+}  // namespace
+
+TEST(HeapCopyingCollection)
+{
+  Result r;
+  exercise(1, false, false, &r);
+
+  assertEqual(0u, r.checksumFailures);
+  assertEqual(0u, r.hashFailures);
+  assertEqual(Rounds,
+              r.statistics.collections[Heap::MinorCollection]
+              + r.statistics.collections[Heap::MajorCollection]);
+  assertTrue(r.statistics.collections[Heap::MajorCollection] >= Rounds / 8);
+}
+
+TEST(HeapCompactingCollection)
+{
+  Result r;
+  exercise(1, true, false, &r);
+
+  assertEqual(0u, r.checksumFailures);
+  assertEqual(0u, r.hashFailures);
+  assertEqual(Rounds,
+              r.statistics.collections[Heap::MinorCollection]
+              + r.statistics.collections[Heap::MajorCollection]);
+  assertTrue(r.statistics.collections[Heap::MajorCollection] >= Rounds / 8);
+}
+
+TEST(HeapConcurrentMarking)
+{
+  Result r;
+  exercise(1, true, true, &r);
+
+  assertEqual(0u, r.checksumFailures);
+  assertEqual(0u, r.hashFailures);
+  assertEqual(Rounds,
+              r.statistics.collections[Heap::MinorCollection]
+              + r.statistics.collections[Heap::MajorCollection]);
+  assertTrue(r.statistics.collections[Heap::MajorCollection] >= Rounds / 8);
+}
+
+TEST(HeapParallelCollection)
+{
+  Result r;
+  exercise(4, false, false, &r);
+
+  assertEqual(0u, r.checksumFailures);
+  assertEqual(0u, r.hashFailures);
+  assertEqual(Rounds,
+              r.statistics.collections[Heap::MinorCollection]
+              + r.statistics.collections[Heap::MajorCollection]);
+
+  // the heap only hands us an original whose first word it has
+  // overwritten when it's copying in parallel:
+  assertTrue(r.copiedWhileClaimed);
+  assertFalse(r.forwardedWhileCopying);
+}
+
+TEST(HeapCollectionRecords)
+{
+  Result r;
+  exercise(1, false, false, &r);
+
+  assertEqual(Rounds, r.recordCount);
+  assertEqual(2u, r.recentCount);
+  assertEqual(static_cast<uint64_t>(Rounds - 1), r.recentSequence);
+
+  unsigned types[2] = {0, 0};
+  unsigned causes = 0;
+  uint64_t promoted = 0;
+  for (unsigned i = 0; i < r.recordCount; ++i) {
+    Heap::Record* record = r.records + i;
+    assertEqual(static_cast<uint64_t>(i + 1), record->sequence);
+    assertTrue(record->footprintAfter > 0);
+    assertTrue(record->milliseconds >= 0);
+    if (record->type == Heap::MinorCollection) {
+      assertEqual(record->gen2Before + record->promoted, record->gen2After);
+    }
+
+    ++types[record->type];
+    promoted += record->promoted;
+  }
+
+  for (unsigned i = 0; i < Heap::CauseCount; ++i) {
+    causes += r.statistics.causes[i];
+  }
+
+  assertEqual(r.statistics.collections[Heap::MinorCollection],
+              types[Heap::MinorCollection]);
+  assertEqual(r.statistics.collections[Heap::MajorCollection],
+              types[Heap::MajorCollection]);
+  assertEqual(Rounds, causes);
+  assertEqual(r.statistics.promoted, promoted);
+  assertTrue(promoted > 0);
+}
+
+TEST(HeapLargeObjects)
+{
+  const uint64_t Megabyte = 1024 * 1024;
+  const unsigned SizeInWords = (4 * Megabyte) / BytesPerWord;
+
+  System* s = makeSystem();
+  Heap* heap = makeHeap(s, 64 * Megabyte, 1, false, false, 64 * 1024);
+  Client client(heap);
+  heap->setClient(&client);
+
+  assertEqual(64u * 1024, heap->largeObjectThreshold());
+
+  void* objects[2];
+  for (unsigned i = 0; i < 2; ++i) {
+    objects[i] = heap->tryAllocateLarge(SizeInWords, false);
+    assertTrue(objects[i] != 0);
+
+    bool zeroed = true;
+    for (unsigned j = 0; j < SizeInWords; ++j) {
+      zeroed = zeroed and words(objects[i])[j] == 0;
+    }
+    assertTrue(zeroed);
+
+    words(objects[i])[0] = (SizeInWords << 3) | Fixed;
+    words(objects[i])[1] = 0;
+    words(objects[i])[2] = i + 1;
+  }
+
+  // more than the limit allows:
+  assertTrue(heap->tryAllocateLarge((64 * Megabyte) / BytesPerWord, false)
+             == 0);
+
+  // only the rooted object should survive, and stay where it is:
+  client.roots[0] = objects[0];
+  heap->collect(Heap::MinorCollection, 0, 0);
+
+  Heap::Statistics statistics;
+  heap->statistics(&statistics);
+
+  assertTrue(client.roots[0] == objects[0]);
+  assertEqual(static_cast<uintptr_t>(1), id(client.roots[0]));
+  assertTrue(statistics.footprint >= 4 * Megabyte);
+  assertTrue(statistics.footprint < 8 * Megabyte);
+
+  heap->collect(Heap::MajorCollection, 0, 0);
+  heap->statistics(&statistics);
+  uint64_t footprint = statistics.footprint;
+
+  assertTrue(client.roots[0] == objects[0]);
+
+  // and once it's unreachable, its pages go back to the system:
+  client.roots[0] = 0;
+  heap->collect(Heap::MajorCollection, 0, 0);
+
+  heap->statistics(&statistics);
+  assertTrue(footprint - statistics.footprint >= 4 * Megabyte);
+  assertTrue(statistics.peakFootprint >= 8 * Megabyte);
+
+  heap->dispose();
+  s->dispose();
+}
+
+TEST(HeapLimitBeyondFourGigabytes)
+{
+  if (BytesPerWord < 8) {
+    return;
+  }
+
+  const uint64_t Gigabyte = 1024 * 1024 * 1024;
+  const uint64_t Limit = 6 * Gigabyte;
+  const unsigned ChunkSize = 256 * 1024 * 1024;
+  const unsigned ChunkCount = (5 * Gigabyte) / ChunkSize;
+
+  System* s = makeSystem();
+  Heap* heap = makeHeap(s, Limit);
+
+  assertEqual(Limit, heap->limit());
+  assertEqual(Limit, heap->remaining());
+  assertFalse(heap->limitExceeded(4 * Gigabyte + 1));
+  assertTrue(heap->limitExceeded(Limit + 1));
+
+  // we only touch the ends of each chunk, so this needs address space
+  // rather than memory:
+  void* chunks[ChunkCount];
+  unsigned count = 0;
+  for (; count < ChunkCount; ++count) {
+    chunks[count] = heap->tryAllocate(ChunkSize);
+    if (chunks[count] == 0) {
+      break;
+    }
+  }
+
+  assertEqual(ChunkCount, count);
+
+  Heap::Statistics statistics;
+  heap->statistics(&statistics);
+
+  assertTrue(statistics.footprint >= 5 * Gigabyte);
+  assertEqual(statistics.footprint, statistics.peakFootprint);
+  assertEqual(Limit - statistics.footprint, heap->remaining());
+  assertFalse(heap->limitExceeded());
+  assertTrue(heap->limitExceeded(Gigabyte + 1));
+  assertTrue(heap->tryAllocate(Gigabyte) == 0);
+
+  for (unsigned i = 0; i < count; ++i) {
+    heap->free(chunks[i], ChunkSize);
+  }
+
+  heap->statistics(&statistics);
+  assertEqual(static_cast<uint64_t>(0), statistics.footprint);
+
+  heap->dispose();
+  s->dispose();
+}